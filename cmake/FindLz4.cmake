@@ -0,0 +1,79 @@
+# Copyright (C) 2007-2013 Hypertable, Inc.
+#
+# This file is part of Hypertable.
+#
+# Hypertable is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 3
+# of the License, or any later version.
+#
+# Hypertable is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+#
+
+# - Find LZ4
+# Find the lz4 compression library and includes
+#
+#  LZ4_INCLUDE_DIR - where to find lz4.h, etc.
+#  LZ4_LIBRARIES   - List of libraries when using lz4.
+#  LZ4_FOUND       - True if lz4 found.
+
+find_path(LZ4_INCLUDE_DIR lz4.h NO_DEFAULT_PATH PATHS
+  ${HT_DEPENDENCY_INCLUDE_DIR}
+  /usr/include
+  /opt/local/include
+  /usr/local/include
+)
+
+set(LZ4_NAMES ${LZ4_NAMES} lz4)
+find_library(LZ4_LIBRARY NAMES ${LZ4_NAMES} NO_DEFAULT_PATH PATHS
+    ${HT_DEPENDENCY_LIB_DIR}
+    /usr/local/lib
+    /opt/local/lib
+    /usr/lib
+    )
+
+if (LZ4_INCLUDE_DIR AND LZ4_LIBRARY)
+  set(LZ4_FOUND TRUE)
+  set( LZ4_LIBRARIES ${LZ4_LIBRARY} )
+else ()
+  set(LZ4_FOUND FALSE)
+  set( LZ4_LIBRARIES )
+endif ()
+
+if (LZ4_FOUND)
+  message(STATUS "Found LZ4: ${LZ4_LIBRARY}")
+  try_run(LZ4_CHECK LZ4_CHECK_BUILD
+          ${HYPERTABLE_BINARY_DIR}${CMAKE_FILES_DIRECTORY}/CMakeTmp
+          ${HYPERTABLE_SOURCE_DIR}/cmake/CheckLz4.cc
+          CMAKE_FLAGS -DINCLUDE_DIRECTORIES=${LZ4_INCLUDE_DIR}
+                      -DLINK_LIBRARIES=${LZ4_LIBRARIES}
+          OUTPUT_VARIABLE LZ4_TRY_OUT)
+  if (LZ4_CHECK_BUILD AND NOT LZ4_CHECK STREQUAL "0")
+    string(REGEX REPLACE ".*\n(LZ4 .*)" "\\1" LZ4_TRY_OUT ${LZ4_TRY_OUT})
+    message(STATUS "${LZ4_TRY_OUT}")
+    message(FATAL_ERROR "Please fix the LZ4 installation and try again.")
+    set(LZ4_LIBRARIES)
+  endif ()
+  string(REGEX REPLACE ".*\n([0-9]+[^\n]+).*" "\\1" LZ4_VERSION ${LZ4_TRY_OUT})
+  if (NOT LZ4_VERSION MATCHES "^[0-9]+.*")
+    set(LZ4_VERSION "unknown") 
+  endif ()
+  message(STATUS "       version: ${LZ4_VERSION}")
+else ()
+  message(STATUS "Not Found LZ4: ${LZ4_LIBRARY}")
+  if (Lz4_FIND_REQUIRED)
+    message(STATUS "Looked for LZ4 libraries named ${LZ4_NAMES}.")
+    message(FATAL_ERROR "Could NOT find LZ4 library")
+  endif ()
+endif ()
+
+mark_as_advanced(
+  LZ4_LIBRARY
+  LZ4_INCLUDE_DIR
+  )
@@ -363,7 +363,7 @@ namespace Hypertable {
      * Returns all the thread IDs for this threadgroup
      * @return vector of Thread::id
      */
-    std::vector<Thread::id> get_thread_ids() const {
+    virtual std::vector<Thread::id> get_thread_ids() const {
       return m_thread_ids;
     }
 
@@ -372,7 +372,7 @@ namespace Hypertable {
      * out and then all threads exit.  #join can be called to wait for
      * completion of the shutdown.
      */
-    void shutdown() {
+    virtual void shutdown() {
       m_state.shutdown = true;
       m_state.cond.notify_all();
     }
@@ -384,7 +384,8 @@ namespace Hypertable {
      * @return <i>false</i> if <code>deadline</code> was reached before queue
      * became idle, <i>true</i> otherwise
      */
-    bool wait_for_idle(boost::xtime &deadline, int reserve_threads=0) {
+    virtual bool wait_for_idle(boost::xtime &deadline,
+                               int reserve_threads=0) {
       ScopedLock lock(m_state.mutex);
       while (m_state.threads_available < (m_state.threads_total-reserve_threads)) {
         if (!m_state.quiesce_cond.timed_wait(lock, deadline))
@@ -397,7 +398,7 @@ namespace Hypertable {
      * Waits for a shutdown to complete.  This method returns when all
      * application queue threads exit.
      */
-    void join() {
+    virtual void join() {
       if (!joined) {
         m_threads.join_all();
         joined = true;
@@ -406,7 +407,7 @@ namespace Hypertable {
 
     /** Starts application queue.
      */
-    void start() {
+    virtual void start() {
       ScopedLock lock(m_state.mutex);
       m_state.paused = false;
       m_state.cond.notify_all();
@@ -416,7 +417,7 @@ namespace Hypertable {
      * being executed.  Any requests that are being executed at the time of the
      * call are allowed to complete.
      */
-    void stop() {
+    virtual void stop() {
       ScopedLock lock(m_state.mutex);
       m_state.paused = true;
     }
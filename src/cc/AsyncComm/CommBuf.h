@@ -40,6 +40,7 @@
 #include "Common/Serialization.h"
 #include "Common/StaticBuffer.h"
 
+#include "CommBufPool.h"
 #include "CommHeader.h"
 
 namespace Hypertable {
@@ -75,6 +76,10 @@ namespace Hypertable {
    *   error = m_comm->send_response(m_event->addr, cbp);
    * </pre>
    *
+   * CommBuf objects and their primary buffers are allocated from
+   * CommBufPool and are returned to it when the last reference is dropped,
+   * which for outgoing messages is when IOHandlerData has finished sending
+   * them.  The primary buffer (#data) must therefore not be reassigned.
    */
   class CommBuf : public ReferenceCount {
   public:
@@ -88,7 +93,7 @@ namespace Hypertable {
      */
     CommBuf(CommHeader &hdr, uint32_t len=0) : header(hdr), ext_ptr(0) {
       len += header.encoded_length();
-      data.set(new uint8_t [len], len, true);
+      data.set((uint8_t *)CommBufPool::allocate(len), len, false);
       data_ptr = data.base + header.encoded_length();
       header.set_total_length(len);
     }
@@ -106,7 +111,7 @@ namespace Hypertable {
     CommBuf(CommHeader &hdr, uint32_t len, StaticBuffer &buffer)
       : ext(buffer), header(hdr) {
       len += header.encoded_length();
-      data.set(new uint8_t [len], len, true);
+      data.set((uint8_t *)CommBufPool::allocate(len), len, false);
       data_ptr = data.base + header.encoded_length();
       header.set_total_length(len+buffer.size);
       ext_ptr = ext.base;
@@ -128,7 +133,7 @@ namespace Hypertable {
 	    boost::shared_array<uint8_t> &ext_buffer, uint32_t ext_len) :
       header(hdr), ext_shared_array(ext_buffer) {
       len += header.encoded_length();
-      data.set(new uint8_t [len], len, true);
+      data.set((uint8_t *)CommBufPool::allocate(len), len, false);
       data_ptr = data.base + header.encoded_length();
       ext.base = ext_shared_array.get();
       ext.size = ext_len;
@@ -137,6 +142,28 @@ namespace Hypertable {
       ext_ptr = ext.base;
     }
 
+    /** Destructor.  Returns the primary buffer to CommBufPool.
+     */
+    virtual ~CommBuf() {
+      CommBufPool::deallocate(data.base, data.size);
+    }
+
+    /** Allocates a CommBuf object from CommBufPool.
+     * @param size Size of object
+     * @return Pointer to allocated memory
+     */
+    static void *operator new(size_t size) {
+      return CommBufPool::allocate(size);
+    }
+
+    /** Returns CommBuf object memory to CommBufPool.
+     * @param ptr Pointer to object memory
+     * @param size Size of object
+     */
+    static void operator delete(void *ptr, size_t size) {
+      CommBufPool::deallocate(ptr, size);
+    }
+
     /** Encodes the header at the beginning of the primary buffer.
      * This method resets the primary and extended data pointers to point to the
      * beginning of their respective buffers.  The AsyncComm layer
@@ -0,0 +1,207 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CommBufPool.
+ * This file contains method definitions for CommBufPool, a size-classed
+ * memory pool for CommBuf objects and their primary buffers.
+ */
+
+#include "Common/Compat.h"
+
+#include <boost/thread/once.hpp>
+#include <boost/thread/tss.hpp>
+
+#include "Common/Mutex.h"
+
+#include "CommBufPool.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  /// Free block, linked through its first bytes
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  /// Singly-linked list of free blocks of one size class
+  struct FreeList {
+    FreeList() : head(0), count(0) { }
+    FreeBlock *head;
+    size_t count;
+
+    void push(FreeBlock *block) {
+      block->next = head;
+      head = block;
+      count++;
+    }
+
+    FreeBlock *pop() {
+      FreeBlock *block = head;
+      head = block->next;
+      count--;
+      return block;
+    }
+  };
+
+  /// Shared free list of one size class
+  struct Depot {
+    Mutex mutex;
+    FreeList list;
+  };
+
+  /// Per-thread free lists
+  struct ThreadCache {
+    FreeList lists[CommBufPool::CLASSES];
+  };
+
+  /// Shared pool state.  Allocated on first use and never destroyed, since
+  /// reactor threads may still be releasing buffers during static
+  /// destruction.
+  struct PoolState {
+    Depot depots[CommBufPool::CLASSES];
+    boost::thread_specific_ptr<ThreadCache> *thread_cache;
+  };
+
+  PoolState *pool_state = 0;
+  boost::once_flag pool_state_once = BOOST_ONCE_INIT;
+
+  inline size_t class_size(int cls) {
+    return (size_t)1 << (cls + CommBufPool::MIN_SHIFT);
+  }
+
+  inline size_t thread_cache_limit(int cls) {
+    size_t limit = CommBufPool::THREAD_CACHE_BYTES / class_size(cls);
+    if (limit > CommBufPool::THREAD_CACHE_MAX)
+      limit = CommBufPool::THREAD_CACHE_MAX;
+    return limit ? limit : 1;
+  }
+
+  inline size_t depot_limit(int cls) {
+    return CommBufPool::DEPOT_BYTES / class_size(cls);
+  }
+
+  inline void free_block(FreeBlock *block) {
+    delete [] (uint8_t *)block;
+  }
+
+  /** Moves blocks from <code>list</code> into the depot for size class
+   * <code>cls</code> until <code>list</code> holds at most <code>keep</code>
+   * blocks.  Blocks that do not fit into the depot are freed.
+   */
+  void spill(PoolState *state, int cls, FreeList &list, size_t keep) {
+    Depot &depot = state->depots[cls];
+    size_t limit = depot_limit(cls);
+    ScopedLock lock(depot.mutex);
+    while (list.count > keep) {
+      FreeBlock *block = list.pop();
+      if (depot.list.count < limit)
+        depot.list.push(block);
+      else
+        free_block(block);
+    }
+  }
+
+  /// Returns the blocks of an exiting thread's cache to the depots
+  void release_thread_cache(ThreadCache *cache) {
+    for (int cls=0; cls<CommBufPool::CLASSES; cls++)
+      spill(pool_state, cls, cache->lists[cls], 0);
+    delete cache;
+  }
+
+  void create_pool_state() {
+    PoolState *state = new PoolState();
+    state->thread_cache =
+      new boost::thread_specific_ptr<ThreadCache>(release_thread_cache);
+    pool_state = state;
+  }
+
+  inline PoolState *get_pool_state() {
+    boost::call_once(create_pool_state, pool_state_once);
+    return pool_state;
+  }
+
+  ThreadCache *get_thread_cache(PoolState *state) {
+    ThreadCache *cache = state->thread_cache->get();
+    if (cache == 0) {
+      cache = new ThreadCache();
+      state->thread_cache->reset(cache);
+    }
+    return cache;
+  }
+
+}
+
+
+int CommBufPool::size_class(size_t len) {
+  int cls = 0;
+  if (len > ((size_t)1 << MAX_SHIFT))
+    return -1;
+  while (class_size(cls) < len)
+    cls++;
+  return cls;
+}
+
+
+void *CommBufPool::allocate(size_t len) {
+  int cls = size_class(len);
+
+  if (cls < 0)
+    return new uint8_t [len];
+
+  PoolState *state = get_pool_state();
+  FreeList &list = get_thread_cache(state)->lists[cls];
+
+  if (list.count == 0) {
+    Depot &depot = state->depots[cls];
+    size_t batch = thread_cache_limit(cls) / 2 + 1;
+    ScopedLock lock(depot.mutex);
+    while (depot.list.count > 0 && list.count < batch)
+      list.push(depot.list.pop());
+  }
+
+  if (list.count > 0)
+    return list.pop();
+
+  return new uint8_t [class_size(cls)];
+}
+
+
+void CommBufPool::deallocate(void *buf, size_t len) {
+  int cls = size_class(len);
+
+  if (buf == 0)
+    return;
+
+  if (cls < 0) {
+    delete [] (uint8_t *)buf;
+    return;
+  }
+
+  PoolState *state = get_pool_state();
+  FreeList &list = get_thread_cache(state)->lists[cls];
+
+  list.push((FreeBlock *)buf);
+
+  if (list.count > thread_cache_limit(cls))
+    spill(state, cls, list, thread_cache_limit(cls) / 2);
+}
@@ -0,0 +1,93 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CommBufPool.
+ * This file contains type declarations for CommBufPool, a size-classed
+ * memory pool for CommBuf objects and their primary buffers.
+ */
+
+#ifndef HYPERTABLE_COMMBUFPOOL_H
+#define HYPERTABLE_COMMBUFPOOL_H
+
+#include <cstddef>
+
+namespace Hypertable {
+
+  /** @addtogroup AsyncComm
+   *  @{
+   */
+
+  /** Size-classed, thread-cached memory pool for CommBuf allocations.
+   * Memory blocks are grouped into power-of-two size classes from
+   * 2<sup>#MIN_SHIFT</sup> to 2<sup>#MAX_SHIFT</sup> bytes; larger requests go
+   * straight to the heap.  Each thread keeps a small free list per size class
+   * that is accessed without locking.  When a thread's free list grows past
+   * its limit, half of it is moved to a mutex-protected depot shared by all
+   * threads, and an empty thread free list is refilled from the depot.  This
+   * lets buffers allocated by application threads and released by reactor
+   * threads, once IOHandlerData has finished sending them, flow back to the
+   * allocating threads.  The depot is bounded, and blocks that do not fit are
+   * returned to the heap.
+   *
+   * CommBuf routes both its own allocation (via class-specific operator
+   * new/delete) and its primary buffer through this pool, so every message
+   * builder that does <code>new CommBuf(...)</code> uses it transparently.
+   */
+  class CommBufPool {
+
+  public:
+
+    enum {
+      MIN_SHIFT = 6,          //!< log2 of smallest size class
+      MAX_SHIFT = 16,         //!< log2 of largest size class
+      CLASSES = MAX_SHIFT - MIN_SHIFT + 1, //!< Number of size classes
+      THREAD_CACHE_BYTES = 256 * 1024,     //!< Per class thread cache limit
+      DEPOT_BYTES = 4 * 1024 * 1024,       //!< Per class depot limit
+      THREAD_CACHE_MAX = 64   //!< Per class thread cache block limit
+    };
+
+    /** Allocates a block of at least <code>len</code> bytes.
+     * @param len Number of bytes required
+     * @return Pointer to allocated block
+     */
+    static void *allocate(size_t len);
+
+    /** Returns a block to the pool.
+     * @param buf Block previously returned by #allocate (may be 0)
+     * @param len Length passed to #allocate when the block was obtained
+     */
+    static void deallocate(void *buf, size_t len);
+
+  private:
+
+    /** Returns the size class for a block of <code>len</code> bytes.
+     * @param len Block length
+     * @return Size class index, or -1 if <code>len</code> exceeds the largest
+     * class
+     */
+    static int size_class(size_t len);
+  };
+
+  /** @}*/
+}
+
+#endif // HYPERTABLE_COMMBUFPOOL_H
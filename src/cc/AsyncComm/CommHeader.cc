@@ -36,6 +36,8 @@
 
 using namespace Hypertable;
 
+uint8_t CommHeader::request_version = 1;
+
 void CommHeader::encode(uint8_t **bufp) {
   uint8_t *base = *bufp;
   Serialization::encode_i8(bufp, version);
@@ -50,7 +52,7 @@ void CommHeader::encode(uint8_t **bufp) {
   Serialization::encode_i32(bufp, payload_checksum);
   Serialization::encode_i64(bufp, command);
   // compute and serialize header checksum
-  header_checksum = fletcher32(base, (*bufp)-base);
+  header_checksum = compute_checksum(checksum_type(), base, (*bufp)-base);
   base += 6;
   Serialization::encode_i32(&base, header_checksum);
 }
@@ -74,7 +76,7 @@ void CommHeader::decode(const uint8_t **bufp, size_t *remainp) {
          payload_checksum = Serialization::decode_i32(bufp, remainp);
          command = Serialization::decode_i64(bufp, remainp));
   memset((void *)(base+6), 0, 4);
-  uint32_t checksum = fletcher32(base, *bufp-base);
+  uint32_t checksum = compute_checksum(checksum_type(), base, *bufp-base);
   if (checksum != header_checksum)
     HT_THROWF(Error::COMM_HEADER_CHECKSUM_MISMATCH, "%u != %u", checksum,
               header_checksum);
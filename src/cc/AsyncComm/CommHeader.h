@@ -29,6 +29,8 @@
 #ifndef HYPERTABLE_COMMHEADER_H
 #define HYPERTABLE_COMMHEADER_H
 
+#include "Common/Checksum.h"
+
 namespace Hypertable {
 
   /** @addtogroup AsyncComm
@@ -41,7 +43,17 @@ namespace Hypertable {
 
   public:
 
-    static const uint8_t PROTOCOL_VERSION = 1;
+    /** Highest protocol version understood.  Version 2 headers are
+     * checksummed with CRC-32C, version 1 headers with fletcher32.
+     */
+    static const uint8_t PROTOCOL_VERSION = 2;
+
+    /** Protocol version of new request headers.  Peers that predate version
+     * 2 verify every header with fletcher32, so this stays at 1 until all
+     * peers have been upgraded (see Comm.ProtocolVersion).  Responses always
+     * use the version of the request they answer.
+     */
+    static uint8_t request_version;
 
     static const size_t FIXED_LENGTH = 38;
 
@@ -68,8 +80,8 @@ namespace Hypertable {
     /** Default constructor.
      */
     CommHeader()
-      : version(1), header_len(FIXED_LENGTH), alignment(0), flags(0),
-        header_checksum(0), id(0), gid(0), total_len(0),
+      : version(request_version), header_len(FIXED_LENGTH), alignment(0),
+        flags(0), header_checksum(0), id(0), gid(0), total_len(0),
         timeout_ms(0), payload_checksum(0), command(0) {  }
 
     /** Constructor taking command number and optional timeout.
@@ -77,8 +89,8 @@ namespace Hypertable {
      * @param timeout Request timeout
      */
     CommHeader(uint64_t cmd, uint32_t timeout=0)
-      : version(1), header_len(FIXED_LENGTH), alignment(0), flags(0),
-        header_checksum(0), id(0), gid(0), total_len(0),
+      : version(request_version), header_len(FIXED_LENGTH), alignment(0),
+        flags(0), header_checksum(0), id(0), gid(0), total_len(0),
         timeout_ms(timeout), payload_checksum(0),
         command(cmd) {  }
 
@@ -113,6 +125,14 @@ namespace Hypertable {
      */
     void decode(const uint8_t **bufp, size_t *remainp);
 
+    /** Returns the checksum algorithm used for this header's version.
+     * @return CHECKSUM_CRC32C for version 2 and later, CHECKSUM_FLETCHER32
+     * otherwise
+     */
+    int checksum_type() const {
+      return version >= 2 ? CHECKSUM_CRC32C : CHECKSUM_FLETCHER32;
+    }
+
     /** Set total length of message (header + payload).
      * @param len Total length of message (header + payload)
      */
@@ -120,10 +140,12 @@ namespace Hypertable {
 
     /** Initializes header from <code>req_header</code>.
      * This method is typically used to initialize a response header
-     * from a corresponding request header.
+     * from a corresponding request header.  The version is carried over so
+     * that the response is checksummed the way the requester expects.
      * @param req_header Request header from which to initialize
      */
     void initialize_from_request_header(CommHeader &req_header) {
+      version = req_header.version;
       flags = req_header.flags;
       id = req_header.id;
       gid = req_header.gid;
@@ -27,6 +27,7 @@
 
 #include "Common/Compat.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 
@@ -40,6 +41,10 @@ extern "C" {
 #include <sys/event.h>
 #endif
 #include <sys/uio.h>
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <linux/errqueue.h>
+#endif
 }
 
 #include "Common/Error.h"
@@ -105,6 +110,27 @@ namespace {
     return nwritten;
   }
 
+#if defined(HT_WITH_ZEROCOPY_SEND)
+  ssize_t
+  et_socket_sendmsg_zerocopy(int fd, const iovec *vector, int count,
+                             int *errnop) {
+    struct msghdr msg;
+    ssize_t nwritten;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = (iovec *)vector;
+    msg.msg_iovlen = count;
+    while ((nwritten = sendmsg(fd, &msg, MSG_ZEROCOPY)) <= 0) {
+      if (errno == EINTR) {
+        nwritten = 0; /* and call sendmsg() again */
+        continue;
+      }
+      *errnop = errno;
+      return -1;
+    }
+    return nwritten;
+  }
+#endif
+
 } // local namespace
 
 
@@ -304,7 +330,7 @@ IOHandlerData::handle_event(struct epoll_event *event, time_t arrival_time) {
       }
     }
 
-    if (event->events & EPOLLERR) {
+    if ((event->events & EPOLLERR) && handle_error_queue()) {
       HT_INFOF("Received EPOLLERR on descriptor %d (%s:%d)", m_sd,
                inet_ntoa(m_addr.sin_addr), ntohs(m_addr.sin_port));
       handle_disconnect();
@@ -324,6 +350,15 @@ IOHandlerData::handle_event(struct epoll_event *event, time_t arrival_time) {
     return true;
   }
 
+#if defined(HT_WITH_IO_URING)
+  if (ReactorFactory::use_io_uring && m_connected && !m_ring_attached) {
+    if (attach_to_ring() != Error::OK) {
+      handle_disconnect();
+      return true;
+    }
+  }
+#endif
+
   return false;
 }
 
@@ -719,6 +754,27 @@ IOHandlerData::send_message(CommBufPtr &cbp, uint32_t timeout_ms,
 
   m_send_queue.push_back(cbp);
 
+#if defined(HT_WITH_IO_URING)
+  if (m_ring_attached) {
+    // A writev owned by the ring picks up this message when it completes,
+    // otherwise write inline and hand whatever doesn't fit to the reactor
+    if (m_send_in_flight || m_send_scheduled)
+      return Error::OK;
+    if ((error = flush_send_queue()) != Error::OK) {
+      HT_WARNF("Problem flushing send queue - %s", Error::get_text(error));
+      ReactorRunner::handler_map->decomission_handler(this);
+      if (m_error == Error::OK)
+        m_error = error;
+      return error;
+    }
+    if (!m_send_queue.empty()) {
+      m_send_scheduled = true;
+      m_reactor->schedule_send(this);
+    }
+    return Error::OK;
+  }
+#endif
+
   if (m_connected) {
     if ((error = flush_send_queue()) != Error::OK) {
       HT_WARNF("Problem flushing send queue - %s", Error::get_text(error));
@@ -779,6 +835,21 @@ int IOHandlerData::flush_send_queue() {
       }
     }
 
+#if defined(HT_WITH_ZEROCOPY_SEND)
+    if (use_zerocopy(cbp.get())) {
+      nwritten = et_socket_sendmsg_zerocopy(m_sd, vec, count, &error);
+      if (nwritten > 0) {
+        m_zerocopy_front = true;
+        m_zerocopy_next++;
+      }
+      else if (error == ENOBUFS) {
+        // Out of pinned page budget, copy this one
+        error = 0;
+        nwritten = et_socket_writev(m_sd, vec, count, &error);
+      }
+    }
+    else
+#endif
     nwritten = et_socket_writev(m_sd, vec, count, &error);
     if (nwritten == (ssize_t)-1) {
       if (error == EAGAIN)
@@ -821,6 +892,16 @@ int IOHandlerData::flush_send_queue() {
       }
     }
 
+#if defined(HT_WITH_ZEROCOPY_SEND)
+    // The kernel may still reference a zero-copy buffer, so hold on to it
+    // until the completion notification arrives
+    if (m_zerocopy_front) {
+      if ((int32_t)(m_zerocopy_next - 1 - m_zerocopy_completed) >= 0)
+        m_zerocopy_pending.push_back(std::make_pair(m_zerocopy_next - 1, cbp));
+      m_zerocopy_front = false;
+    }
+#endif
+
     // buffer written successfully, now remove from queue (destroys buffer)
     m_send_queue.pop_front();
   }
@@ -828,6 +909,88 @@ int IOHandlerData::flush_send_queue() {
   return Error::OK;
 }
 
+
+bool IOHandlerData::handle_error_queue() {
+#if defined(HT_WITH_ZEROCOPY_SEND)
+  ScopedLock lock(m_mutex);
+  char control[128];
+  struct msghdr msg;
+  struct cmsghdr *cm;
+  struct sock_extended_err *serr;
+  int sockerr = 0;
+  socklen_t sockerr_len = sizeof(sockerr);
+
+  // Without zero-copy sends there is nothing but errors in the queue
+  if (m_zerocopy == 0)
+    return true;
+
+  while (true) {
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(m_sd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno == EAGAIN)
+        break;
+      HT_INFOF("recvmsg(%d, MSG_ERRQUEUE) failed - %s", m_sd, strerror(errno));
+      return true;
+    }
+    for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+      if (!(cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) &&
+          !(cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+        continue;
+      serr = (struct sock_extended_err *)CMSG_DATA(cm);
+      if (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY || serr->ee_errno != 0) {
+        HT_INFOF("Error queue on descriptor %d reported %s", m_sd,
+                 strerror(serr->ee_errno));
+        return true;
+      }
+      // The kernel had to copy (e.g. loopback), so zero-copy only adds
+      // notification overhead on this connection
+      if (serr->ee_code & SO_EE_CODE_ZEROCOPY_COPIED)
+        m_zerocopy = -1;
+      // Sends in [ee_info, ee_data] have completed.  TCP completes them in
+      // order, so everything up to ee_data can be released.
+      m_zerocopy_completed = serr->ee_data + 1;
+      while (!m_zerocopy_pending.empty() &&
+             (int32_t)(m_zerocopy_pending.front().first -
+                       m_zerocopy_completed) < 0)
+        m_zerocopy_pending.pop_front();
+    }
+  }
+
+  if (getsockopt(m_sd, SOL_SOCKET, SO_ERROR, &sockerr, &sockerr_len) < 0) {
+    HT_INFOF("getsockopt(SO_ERROR) failed - %s", strerror(errno));
+    return true;
+  }
+  return sockerr != 0;
+#else
+  return true;
+#endif
+}
+
+#if defined(HT_WITH_ZEROCOPY_SEND)
+bool IOHandlerData::use_zerocopy(CommBuf *cbuf) {
+  if (ReactorFactory::zero_copy_threshold == 0 || m_zerocopy < 0 ||
+      cbuf->ext.base == 0 ||
+      cbuf->ext.size - (cbuf->ext_ptr - cbuf->ext.base) <
+      ReactorFactory::zero_copy_threshold)
+    return false;
+
+  if (m_zerocopy == 0) {
+    int one = 1;
+    if (setsockopt(m_sd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) < 0) {
+      HT_INFOF("setsockopt(SO_ZEROCOPY) failed - %s", strerror(errno));
+      m_zerocopy = -1;
+      return false;
+    }
+    m_zerocopy = 1;
+  }
+  return true;
+}
+#endif
+
 #elif defined(__APPLE__) || defined (__sun__) || defined(__FreeBSD__)
 
 int IOHandlerData::flush_send_queue() {
@@ -894,3 +1057,270 @@ int IOHandlerData::flush_send_queue() {
 #else
   ImplementMe;
 #endif
+
+
+#if defined(HT_WITH_IO_URING)
+
+namespace {
+  /// Maximum number of I/O vectors in a single send queue writev
+  const size_t MAX_SEND_IOV = 64;
+}
+
+int IOHandlerData::attach_to_ring() {
+  ScopedLock lock(m_mutex);
+  struct epoll_event event;
+
+  memset(&event, 0, sizeof(struct epoll_event));
+  if (epoll_ctl(m_reactor->poll_fd, EPOLL_CTL_DEL, m_sd, &event) < 0) {
+    HT_ERRORF("epoll_ctl(%d, EPOLL_CTL_DEL, %d) failed : %s",
+              m_reactor->poll_fd, m_sd, strerror(errno));
+    return Error::COMM_POLL_ERROR;
+  }
+  m_poll_interest = 0;
+  m_ring_attached = true;
+
+  if (!arm_recv())
+    return Error::COMM_POLL_ERROR;
+
+  if (!m_send_queue.empty() && !m_send_in_flight)
+    submit_send();
+
+  return Error::OK;
+}
+
+
+bool IOHandlerData::arm_recv() {
+  IOUring *ring = m_reactor->ring();
+  struct io_uring_sqe *sqe = ring->get_sqe();
+
+  if (sqe == 0) {
+    HT_ERRORF("Unable to get io_uring submission entry for recv on %d", m_sd);
+    return false;
+  }
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = m_sd;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = IOUring::BUFFER_GROUP;
+  if (m_recv_multishot)
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+  else
+    sqe->len = ring->buffer_size();
+  sqe->user_data = (uint64_t)(uintptr_t)this | Reactor::RING_OP_RECV;
+  m_ring_operations++;
+  return true;
+}
+
+
+void IOHandlerData::handle_received_data(const uint8_t *data, size_t len,
+                                         time_t arrival_time) {
+  size_t n;
+
+  while (true) {
+    if (!m_got_header) {
+      if (len == 0)
+        break;
+      n = std::min(len, m_message_header_remaining);
+      memcpy(m_message_header_ptr, data, n);
+      m_message_header_ptr += n;
+      m_message_header_remaining -= n;
+      data += n;
+      len -= n;
+      if (m_message_header_remaining == 0)
+        handle_message_header(arrival_time);
+    }
+    else {
+      n = std::min(len, m_message_remaining);
+      memcpy(m_message_ptr, data, n);
+      m_message_ptr += n;
+      m_message_remaining -= n;
+      data += n;
+      len -= n;
+      if (m_message_remaining > 0)
+        break;
+      handle_message_body();
+    }
+  }
+}
+
+
+bool IOHandlerData::handle_recv_completion(int res, uint32_t flags,
+                                           time_t arrival_time) {
+  IOUring *ring = m_reactor->ring();
+  bool more = (flags & IORING_CQE_F_MORE) != 0;
+
+  if (res == -ENOBUFS) {
+    // Ran out of provided buffers; they are handed back as the completions
+    // queued ahead of this one are processed
+    if (!more && !arm_recv()) {
+      handle_disconnect();
+      return true;
+    }
+    return false;
+  }
+
+  if (res == -EINVAL && m_recv_multishot) {
+    HT_INFO("Multishot recv not supported, falling back to single shot");
+    m_recv_multishot = false;
+    if (!arm_recv()) {
+      handle_disconnect();
+      return true;
+    }
+    return false;
+  }
+
+  if (res < 0) {
+    if (res != -ECONNREFUSED)
+      HT_INFOF("socket recv(%d) failure : %s", m_sd, strerror(-res));
+    else
+      test_and_set_error(Error::COMM_CONNECT_ERROR);
+    handle_disconnect();
+    return true;
+  }
+
+  if (res == 0) {
+    HT_DEBUGF("Received EOF on descriptor %d (%s:%d)", m_sd,
+              inet_ntoa(m_addr.sin_addr), ntohs(m_addr.sin_port));
+    handle_disconnect();
+    return true;
+  }
+
+  HT_ASSERT(flags & IORING_CQE_F_BUFFER);
+  uint16_t bid = (uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT);
+
+  try {
+    handle_received_data(ring->buffer(bid), (size_t)res, arrival_time);
+  }
+  catch (Hypertable::Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    ring->recycle_buffer(bid);
+    handle_disconnect();
+    return true;
+  }
+  ring->recycle_buffer(bid);
+
+  if (!more && !arm_recv()) {
+    handle_disconnect();
+    return true;
+  }
+  return false;
+}
+
+
+void IOHandlerData::submit_send() {
+  IOUring *ring = m_reactor->ring();
+  ssize_t remaining;
+
+  m_send_iov.clear();
+  for (std::list<CommBufPtr>::iterator iter = m_send_queue.begin();
+       iter != m_send_queue.end() && m_send_iov.size() + 2 <= MAX_SEND_IOV;
+       ++iter) {
+    CommBufPtr &cbp = *iter;
+    struct iovec vec;
+    remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
+    if (remaining > 0) {
+      vec.iov_base = (void *)cbp->data_ptr;
+      vec.iov_len = remaining;
+      m_send_iov.push_back(vec);
+    }
+    if (cbp->ext.base != 0) {
+      remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
+      if (remaining > 0) {
+        vec.iov_base = (void *)cbp->ext_ptr;
+        vec.iov_len = remaining;
+        m_send_iov.push_back(vec);
+      }
+    }
+  }
+
+  if (m_send_iov.empty()) {
+    m_send_queue.clear();
+    return;
+  }
+
+  struct io_uring_sqe *sqe = ring->get_sqe();
+  if (sqe == 0) {
+    // Submission queue is backed up, try again on the next pass
+    if (!m_send_scheduled) {
+      m_send_scheduled = true;
+      m_reactor->schedule_send(this);
+    }
+    return;
+  }
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = m_sd;
+  sqe->addr = (uint64_t)(uintptr_t)&m_send_iov[0];
+  sqe->len = m_send_iov.size();
+  sqe->user_data = (uint64_t)(uintptr_t)this | Reactor::RING_OP_SEND;
+  m_send_in_flight = true;
+  m_ring_operations++;
+}
+
+
+void IOHandlerData::submit_scheduled_send() {
+  ScopedLock lock(m_mutex);
+  m_send_scheduled = false;
+  if (!m_send_in_flight && !m_send_queue.empty())
+    submit_send();
+}
+
+
+bool IOHandlerData::handle_send_completion(int res) {
+  ScopedLock lock(m_mutex);
+  size_t nwritten, remaining;
+
+  m_send_in_flight = false;
+
+  if (res < 0 && res != -EAGAIN && res != -EINTR) {
+    HT_WARNF("writev(%d) failed : %s", m_sd, strerror(-res));
+    test_and_set_error(Error::COMM_BROKEN_CONNECTION);
+    handle_disconnect();
+    return true;
+  }
+
+  nwritten = res > 0 ? (size_t)res : 0;
+
+  while (!m_send_queue.empty()) {
+    CommBufPtr &cbp = m_send_queue.front();
+    remaining = cbp->data.size - (cbp->data_ptr - cbp->data.base);
+    if (remaining > 0) {
+      if (nwritten < remaining) {
+        cbp->data_ptr += nwritten;
+        break;
+      }
+      cbp->data_ptr += remaining;
+      nwritten -= remaining;
+    }
+    if (cbp->ext.base != 0) {
+      remaining = cbp->ext.size - (cbp->ext_ptr - cbp->ext.base);
+      if (nwritten < remaining) {
+        cbp->ext_ptr += nwritten;
+        break;
+      }
+      cbp->ext_ptr += remaining;
+      nwritten -= remaining;
+    }
+    // buffer written successfully, now remove from queue (destroys buffer)
+    m_send_queue.pop_front();
+  }
+
+  if (!m_send_queue.empty())
+    submit_send();
+
+  return false;
+}
+
+
+void IOHandlerData::cancel_ring_operations() {
+  struct io_uring_sqe *sqe;
+
+  ::shutdown(m_sd, SHUT_RDWR);
+
+  if ((sqe = m_reactor->ring()->get_sqe()) != 0) {
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)this | Reactor::RING_OP_RECV;
+    sqe->user_data = Reactor::RING_OP_CANCEL;
+  }
+}
+
+#endif // HT_WITH_IO_URING
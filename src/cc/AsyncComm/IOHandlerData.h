@@ -29,13 +29,21 @@
 #define HYPERTABLE_IOHANDLERDATA_H
 
 #include <list>
+#include <utility>
+#include <vector>
 
 extern "C" {
 #include <netdb.h>
 #include <string.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 #include <time.h>
 }
 
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#define HT_WITH_ZEROCOPY_SEND 1
+#endif
+
 #include "Common/Error.h"
 #include "Common/atomic.h"
 
@@ -66,6 +74,19 @@ namespace Hypertable {
       memcpy(&m_addr, &addr, sizeof(InetAddr));
       m_connected = connected;
       reset_incoming_message_state();
+#if defined(HT_WITH_IO_URING)
+      m_ring_attached = false;
+      m_recv_multishot = true;
+      m_send_in_flight = false;
+      m_send_scheduled = false;
+      m_ring_operations = 0;
+#endif
+#if defined(HT_WITH_ZEROCOPY_SEND)
+      m_zerocopy = 0;
+      m_zerocopy_front = false;
+      m_zerocopy_next = 0;
+      m_zerocopy_completed = 0;
+#endif
     }
 
     /** Destructor */
@@ -119,7 +140,10 @@ namespace Hypertable {
      *   - An error is encountered during a write
      * The send queue holds a list of CommBuf objects that contain <i>next
      * write</i> pointers that are updated by this method and allow it to
-     * pick up where it left off in the event of EAGAIN.
+     * pick up where it left off in the event of EAGAIN.  Messages with a
+     * large extended payload may be written with <code>MSG_ZEROCOPY</code>
+     * (see #use_zerocopy), in which case they are moved to
+     * #m_zerocopy_pending instead of being destroyed once written.
      * @return Error::OK on success or EAGAIN, or Error::COMM_BROKEN_CONNECTION
      * if a write error was encountered.
      */
@@ -248,6 +272,66 @@ namespace Hypertable {
      */
     bool handle_write_readiness();
 
+#if defined(HT_WITH_IO_URING)
+    /** Moves the connection from epoll to the reactor's io_uring instance.
+     * This method is called by the reactor thread once the connection has
+     * been established.  It removes the socket from the epoll set, arms a
+     * multishot receive that reads into the reactor's provided buffers, and
+     * submits a writev for anything left in the send queue.  From then on
+     * incoming data is delivered through #handle_recv_completion and the
+     * send queue is drained by writev requests submitted on the ring.
+     * @return Error::OK on success, Error::COMM_POLL_ERROR on failure
+     */
+    int attach_to_ring();
+
+    /** Checks if connection has been moved to the reactor's io_uring.
+     * @return <i>true</i> if attached, <i>false</i> otherwise
+     */
+    bool is_ring_attached() { return m_ring_attached; }
+
+    /** Returns the number of io_uring requests still owned by the kernel.
+     * The handler must not be destroyed until this drops to zero.
+     * @return Number of outstanding io_uring requests
+     */
+    int ring_operations() { return m_ring_operations; }
+
+    /** Records that an outstanding io_uring request has finished. */
+    void ring_operation_completed() { m_ring_operations--; }
+
+    /** Handles a receive completion.  The received bytes are fed through
+     * the message header/payload state machine, the provided buffer is
+     * handed back to the ring, and the receive is re-armed if the kernel
+     * terminated it.
+     * @param res Completion result (bytes received or -errno)
+     * @param flags Completion flags
+     * @param arrival_time Time of event arrival
+     * @return <i>false</i> on success, <i>true</i> if error encountered and
+     * handler was decomissioned
+     */
+    bool handle_recv_completion(int res, uint32_t flags, time_t arrival_time);
+
+    /** Handles a writev completion.  Advances the <i>next write</i>
+     * pointers of the written CommBuf objects, removes the ones that have
+     * been completely written from the send queue, and submits another
+     * writev if the queue is not empty.
+     * @param res Completion result (bytes written or -errno)
+     * @return <i>false</i> on success, <i>true</i> if error encountered and
+     * handler was decomissioned
+     */
+    bool handle_send_completion(int res);
+
+    /** Submits a writev for a send scheduled with Reactor::schedule_send,
+     * unless one is already in flight.
+     */
+    void submit_scheduled_send();
+
+    /** Forces outstanding io_uring requests to complete.  Shuts down the
+     * socket and cancels the receive so that the handler can be purged
+     * once #ring_operations drops to zero.
+     */
+    void cancel_ring_operations();
+#endif
+
   private:
 
     /** Processes a message header.  This method is called when the fixed
@@ -281,6 +365,57 @@ namespace Hypertable {
      */
     void handle_disconnect();
 
+#if defined(__linux__)
+    /** Handles an <code>EPOLLERR</code> event.  Zero-copy send completion
+     * notifications are delivered through the socket error queue, which the
+     * kernel signals with <code>EPOLLERR</code>.  This method drains the
+     * error queue, releasing the CommBuf objects in #m_zerocopy_pending whose
+     * sends have completed, and then checks whether the socket itself is in
+     * an error state.
+     * @return <i>true</i> if the socket has an error and the handler should
+     * be disconnected, <i>false</i> otherwise
+     */
+    bool handle_error_queue();
+#endif
+
+#if defined(HT_WITH_ZEROCOPY_SEND)
+    /** Checks if the remainder of a message should be sent with
+     * <code>MSG_ZEROCOPY</code>.  Zero-copy is used if the unsent portion of
+     * the extended payload is at least ReactorFactory::zero_copy_threshold
+     * bytes.  <code>SO_ZEROCOPY</code> is enabled on the socket the first
+     * time it is needed.
+     * @param cbuf Message to be sent
+     * @return <i>true</i> if message should be sent with
+     * <code>MSG_ZEROCOPY</code>, <i>false</i> otherwise
+     */
+    bool use_zerocopy(CommBuf *cbuf);
+#endif
+
+#if defined(HT_WITH_IO_URING)
+    /** Feeds received bytes through the message receive state machine,
+     * calling #handle_message_header and #handle_message_body as headers
+     * and payloads are completed.
+     * @param data Received bytes
+     * @param len Number of received bytes
+     * @param arrival_time Time of event arrival
+     */
+    void handle_received_data(const uint8_t *data, size_t len,
+                              time_t arrival_time);
+
+    /** Submits a receive request that selects its buffer from the reactor's
+     * provided buffer ring.
+     * @return <i>true</i> on success, <i>false</i> if no submission queue
+     * entry was available
+     */
+    bool arm_recv();
+
+    /** Submits a single writev covering as much of the send queue as fits
+     * in #m_send_iov.  Must be called from the reactor thread with #m_mutex
+     * locked and no writev in flight.
+     */
+    void submit_send();
+#endif
+
     /// Flag indicating if socket connection has been completed
     bool m_connected;
 
@@ -310,6 +445,45 @@ namespace Hypertable {
 
     /// Send queue
     std::list<CommBufPtr> m_send_queue;
+
+#if defined(HT_WITH_IO_URING)
+    /// Set to <i>true</i> once connection has been moved to io_uring
+    bool m_ring_attached;
+
+    /// Set to <i>false</i> if kernel rejects multishot receives
+    bool m_recv_multishot;
+
+    /// Set to <i>true</i> while a writev is owned by the kernel
+    bool m_send_in_flight;
+
+    /// Set to <i>true</i> while waiting in Reactor::schedule_send
+    bool m_send_scheduled;
+
+    /// Number of io_uring requests owned by the kernel
+    int m_ring_operations;
+
+    /// I/O vectors of the writev in flight
+    std::vector<struct iovec> m_send_iov;
+#endif
+
+#if defined(HT_WITH_ZEROCOPY_SEND)
+    /// Zero-copy state (0 = not yet enabled, 1 = enabled, -1 = disabled)
+    int m_zerocopy;
+
+    /// Set to <i>true</i> if front of #m_send_queue was partially or
+    /// completely written with <code>MSG_ZEROCOPY</code>
+    bool m_zerocopy_front;
+
+    /// Sequence number the kernel will assign to the next zero-copy send
+    uint32_t m_zerocopy_next;
+
+    /// Sequence number of the first zero-copy send not yet completed
+    uint32_t m_zerocopy_completed;
+
+    /// Messages written with <code>MSG_ZEROCOPY</code> that the kernel may
+    /// still reference, paired with the sequence number of their last send
+    std::list<std::pair<uint32_t, CommBufPtr> > m_zerocopy_pending;
+#endif
   };
   /** @}*/
 }
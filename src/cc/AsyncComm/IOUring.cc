@@ -0,0 +1,303 @@
+/*
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for IOUring.
+ * This file contains method definitions for IOUring, a thin wrapper around
+ * a Linux io_uring instance and its provided buffer ring.
+ */
+
+#include "Common/Compat.h"
+
+#if defined(HT_WITH_IO_URING)
+
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include <errno.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+}
+
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include "IOUring.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  int sys_io_uring_setup(unsigned entries, struct io_uring_params *p) {
+    return (int)syscall(__NR_io_uring_setup, entries, p);
+  }
+
+  int sys_io_uring_enter(int fd, unsigned to_submit, unsigned min_complete,
+                         unsigned flags, void *arg, size_t argsz) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+                        flags, arg, argsz);
+  }
+
+  int sys_io_uring_register(int fd, unsigned opcode, void *arg,
+                            unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+  }
+
+} // local namespace
+
+
+IOUring::IOUring(unsigned entries, unsigned buffer_count, size_t buffer_size)
+  : m_fd(-1), m_sq_ring(MAP_FAILED), m_sq_ring_size(0), m_cq_ring(MAP_FAILED),
+    m_cq_ring_size(0), m_sqes((struct io_uring_sqe *)MAP_FAILED),
+    m_sq_tail_local(0), m_sq_pending(0), m_cq_head_local(0),
+    m_buf_ring((struct io_uring_buf_ring *)MAP_FAILED), m_buf_ring_size(0),
+    m_buf_mask(buffer_count - 1), m_buf_tail(0), m_buffers(0),
+    m_buffer_size(buffer_size), m_buffer_count(buffer_count) {
+
+  HT_ASSERT(buffer_count && (buffer_count & (buffer_count - 1)) == 0);
+
+  // Multishot receives can post many completions per submission, so give
+  // the completion queue some extra headroom
+  memset(&m_params, 0, sizeof(m_params));
+  m_params.flags = IORING_SETUP_CLAMP | IORING_SETUP_CQSIZE;
+  m_params.cq_entries = 4 * entries;
+
+  if ((m_fd = sys_io_uring_setup(entries, &m_params)) < 0)
+    HT_THROWF(Error::COMM_POLL_ERROR, "io_uring_setup(%u) failed - %s",
+              entries, strerror(errno));
+
+  m_sq_ring_size = m_params.sq_off.array
+    + m_params.sq_entries * sizeof(unsigned);
+  m_cq_ring_size = m_params.cq_off.cqes
+    + m_params.cq_entries * sizeof(struct io_uring_cqe);
+
+  if (m_params.features & IORING_FEAT_SINGLE_MMAP) {
+    if (m_cq_ring_size > m_sq_ring_size)
+      m_sq_ring_size = m_cq_ring_size;
+    m_cq_ring_size = 0;
+  }
+
+  m_sq_ring = mmap(0, m_sq_ring_size, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+  if (m_sq_ring == MAP_FAILED) {
+    int saved_errno = errno;
+    cleanup();
+    HT_THROWF(Error::COMM_POLL_ERROR, "mmap(IORING_OFF_SQ_RING) failed - %s",
+              strerror(saved_errno));
+  }
+
+  if (m_cq_ring_size) {
+    m_cq_ring = mmap(0, m_cq_ring_size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+    if (m_cq_ring == MAP_FAILED) {
+      int saved_errno = errno;
+      cleanup();
+      HT_THROWF(Error::COMM_POLL_ERROR, "mmap(IORING_OFF_CQ_RING) failed - %s",
+                strerror(saved_errno));
+    }
+  }
+
+  m_sqes = (struct io_uring_sqe *)mmap(0,
+             m_params.sq_entries * sizeof(struct io_uring_sqe),
+             PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+             IORING_OFF_SQES);
+  if (m_sqes == MAP_FAILED) {
+    int saved_errno = errno;
+    cleanup();
+    HT_THROWF(Error::COMM_POLL_ERROR, "mmap(IORING_OFF_SQES) failed - %s",
+              strerror(saved_errno));
+  }
+
+  uint8_t *sq = (uint8_t *)m_sq_ring;
+  uint8_t *cq = m_cq_ring_size ? (uint8_t *)m_cq_ring : sq;
+
+  m_sq_head = (unsigned *)(sq + m_params.sq_off.head);
+  m_sq_tail = (unsigned *)(sq + m_params.sq_off.tail);
+  m_sq_array = (unsigned *)(sq + m_params.sq_off.array);
+  m_sq_mask = *(unsigned *)(sq + m_params.sq_off.ring_mask);
+  m_sq_entries = *(unsigned *)(sq + m_params.sq_off.ring_entries);
+  m_sq_tail_local = *m_sq_tail;
+
+  m_cq_head = (unsigned *)(cq + m_params.cq_off.head);
+  m_cq_tail = (unsigned *)(cq + m_params.cq_off.tail);
+  m_cqes = (struct io_uring_cqe *)(cq + m_params.cq_off.cqes);
+  m_cq_mask = *(unsigned *)(cq + m_params.cq_off.ring_mask);
+  m_cq_head_local = *m_cq_head;
+
+  // Provided buffer ring; the ring itself must be page aligned
+  m_buf_ring_size = buffer_count * sizeof(struct io_uring_buf);
+  m_buf_ring = (struct io_uring_buf_ring *)mmap(0, m_buf_ring_size,
+                 PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (m_buf_ring == MAP_FAILED) {
+    int saved_errno = errno;
+    cleanup();
+    HT_THROWF(Error::COMM_POLL_ERROR, "mmap(buffer ring) failed - %s",
+              strerror(saved_errno));
+  }
+
+  struct io_uring_buf_reg reg;
+  memset(&reg, 0, sizeof(reg));
+  reg.ring_addr = (uint64_t)(uintptr_t)m_buf_ring;
+  reg.ring_entries = buffer_count;
+  reg.bgid = BUFFER_GROUP;
+  if (sys_io_uring_register(m_fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+    int saved_errno = errno;
+    cleanup();
+    HT_THROWF(Error::COMM_POLL_ERROR,
+              "io_uring_register(IORING_REGISTER_PBUF_RING) failed - %s",
+              strerror(saved_errno));
+  }
+
+  m_buffers = new uint8_t [buffer_count * buffer_size];
+  for (unsigned i=0; i<buffer_count; i++)
+    recycle_buffer((uint16_t)i);
+}
+
+
+IOUring::~IOUring() {
+  cleanup();
+}
+
+
+void IOUring::cleanup() {
+  delete [] m_buffers;
+  m_buffers = 0;
+  if (m_buf_ring != MAP_FAILED)
+    munmap(m_buf_ring, m_buf_ring_size);
+  m_buf_ring = (struct io_uring_buf_ring *)MAP_FAILED;
+  if (m_sqes != MAP_FAILED)
+    munmap(m_sqes, m_params.sq_entries * sizeof(struct io_uring_sqe));
+  m_sqes = (struct io_uring_sqe *)MAP_FAILED;
+  if (m_cq_ring != MAP_FAILED)
+    munmap(m_cq_ring, m_cq_ring_size);
+  m_cq_ring = MAP_FAILED;
+  if (m_sq_ring != MAP_FAILED)
+    munmap(m_sq_ring, m_sq_ring_size);
+  m_sq_ring = MAP_FAILED;
+  if (m_fd >= 0)
+    ::close(m_fd);
+  m_fd = -1;
+}
+
+
+bool IOUring::is_supported() {
+  try {
+    IOUring ring(8, 8, 64);
+
+    if ((ring.m_params.features & IORING_FEAT_EXT_ARG) == 0)
+      return false;
+
+    size_t len = sizeof(struct io_uring_probe)
+      + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = (struct io_uring_probe *)calloc(1, len);
+    if (sys_io_uring_register(ring.m_fd, IORING_REGISTER_PROBE, probe,
+                              256) < 0) {
+      free(probe);
+      return false;
+    }
+    int ops[] = { IORING_OP_RECV, IORING_OP_WRITEV, IORING_OP_POLL_ADD,
+                  IORING_OP_ASYNC_CANCEL };
+    bool supported = true;
+    for (size_t i=0; i<sizeof(ops)/sizeof(int); i++) {
+      if (ops[i] > probe->last_op ||
+          (probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED) == 0)
+        supported = false;
+    }
+    free(probe);
+    return supported;
+  }
+  catch (Exception &e) {
+    HT_DEBUGF("io_uring not available - %s", e.what());
+  }
+  return false;
+}
+
+
+struct io_uring_sqe *IOUring::get_sqe() {
+  unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+  if (m_sq_tail_local - head >= m_sq_entries) {
+    submit();
+    head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    if (m_sq_tail_local - head >= m_sq_entries)
+      return 0;
+  }
+  unsigned index = m_sq_tail_local & m_sq_mask;
+  m_sq_array[index] = index;
+  m_sq_tail_local++;
+  m_sq_pending++;
+  struct io_uring_sqe *sqe = &m_sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+
+int IOUring::submit() {
+  __atomic_store_n(m_sq_tail, m_sq_tail_local, __ATOMIC_RELEASE);
+  if (m_sq_pending == 0)
+    return 0;
+  int ret = sys_io_uring_enter(m_fd, m_sq_pending, 0, 0, 0, 0);
+  if (ret < 0)
+    return -errno;
+  m_sq_pending -= ret;
+  return ret;
+}
+
+
+int IOUring::submit_and_wait(PollTimeout &timeout) {
+  struct io_uring_getevents_arg arg;
+
+  __atomic_store_n(m_sq_tail, m_sq_tail_local, __ATOMIC_RELEASE);
+
+  memset(&arg, 0, sizeof(arg));
+  arg.sigmask_sz = _NSIG / 8;
+  arg.ts = (uint64_t)(uintptr_t)timeout.get_timespec();
+
+  int ret = sys_io_uring_enter(m_fd, m_sq_pending, 1,
+                               IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                               &arg, sizeof(arg));
+  if (ret < 0) {
+    // EBUSY means the completion queue needs to be drained before more
+    // entries can be submitted
+    if (errno == ETIME || errno == EINTR || errno == EBUSY || errno == EAGAIN)
+      return 0;
+    return -errno;
+  }
+  m_sq_pending -= ret;
+  return 0;
+}
+
+
+void IOUring::recycle_buffer(uint16_t bid) {
+  // The ring is indexed as a plain array rather than through the bufs
+  // member: in C++ the kernel header's flexible array wrapper contains an
+  // empty struct of size one, which moves bufs off the start of the ring
+  struct io_uring_buf *buf =
+    (struct io_uring_buf *)m_buf_ring + (m_buf_tail & m_buf_mask);
+  buf->addr = (uint64_t)(uintptr_t)buffer(bid);
+  buf->len = (uint32_t)m_buffer_size;
+  buf->bid = bid;
+  __atomic_store_n(&m_buf_ring->tail, ++m_buf_tail, __ATOMIC_RELEASE);
+}
+
+#endif // HT_WITH_IO_URING
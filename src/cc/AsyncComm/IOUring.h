@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for IOUring.
+ * This file contains type declarations for IOUring, a thin wrapper around
+ * a Linux io_uring instance and its provided buffer ring.
+ */
+
+#ifndef HYPERTABLE_IOURING_H
+#define HYPERTABLE_IOURING_H
+
+#if defined(HT_WITH_IO_URING)
+
+extern "C" {
+#include <linux/io_uring.h>
+#include <stdint.h>
+}
+
+#include "PollTimeout.h"
+
+namespace Hypertable {
+
+  /** @addtogroup AsyncComm
+   *  @{
+   */
+
+  /** Submission and completion rings of an io_uring instance.
+   * The rings are set up with the raw system call interface and are meant
+   * to be driven by a single reactor thread; none of the methods are thread
+   * safe.  A ring of fixed size receive buffers is registered with the
+   * kernel as buffer group #BUFFER_GROUP so that receive requests can be
+   * submitted with <code>IOSQE_BUFFER_SELECT</code> and have the kernel pick
+   * a buffer when data arrives.  Buffers handed out in completions must be
+   * given back with #recycle_buffer once their contents have been consumed.
+   */
+  class IOUring {
+
+  public:
+
+    enum {
+      BUFFER_GROUP = 0 //!< Buffer group ID of the provided buffer ring
+    };
+
+    /** Constructor.
+     * Creates the io_uring instance, maps its rings and registers the
+     * provided buffer ring.  Throws Exception with code
+     * Error::COMM_POLL_ERROR on failure.
+     * @param entries Number of submission queue entries
+     * @param buffer_count Number of receive buffers (power of two)
+     * @param buffer_size Size of each receive buffer
+     */
+    IOUring(unsigned entries, unsigned buffer_count, size_t buffer_size);
+
+    /** Destructor.  Unmaps the rings and closes the io_uring descriptor. */
+    ~IOUring();
+
+    /** Checks if the running kernel supports everything the io_uring
+     * reactor backend needs (extended wait arguments, provided buffer
+     * rings, and the receive, writev, poll and cancel operations).
+     * @return <i>true</i> if io_uring can be used, <i>false</i> otherwise
+     */
+    static bool is_supported();
+
+    /** Returns a zeroed submission queue entry.  If the submission queue is
+     * full, the pending entries are submitted first.
+     * @return Pointer to submission queue entry, or 0 if none is available
+     */
+    struct io_uring_sqe *get_sqe();
+
+    /** Submits pending submission queue entries without waiting.
+     * @return Number of entries submitted, or -errno on failure
+     */
+    int submit();
+
+    /** Submits pending entries and waits for at least one completion or
+     * until <code>timeout</code> expires.  A timeout or signal interruption
+     * is not treated as an error.
+     * @param timeout Wait timeout
+     * @return 0 on success, or -errno on failure
+     */
+    int submit_and_wait(PollTimeout &timeout);
+
+    /** Returns the next unconsumed completion queue entry.
+     * @return Pointer to completion queue entry, or 0 if there is none
+     */
+    struct io_uring_cqe *peek_cqe() {
+      unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+      if (m_cq_head_local == tail)
+        return 0;
+      return &m_cqes[m_cq_head_local & m_cq_mask];
+    }
+
+    /** Marks the entry returned by #peek_cqe as consumed. */
+    void cqe_seen() {
+      __atomic_store_n(m_cq_head, ++m_cq_head_local, __ATOMIC_RELEASE);
+    }
+
+    /** Returns pointer to provided buffer <code>bid</code>.
+     * @param bid Buffer ID taken from a completion's flags
+     * @return Pointer to buffer
+     */
+    uint8_t *buffer(uint16_t bid) {
+      return m_buffers + (size_t)bid * m_buffer_size;
+    }
+
+    /** Returns buffer <code>bid</code> to the provided buffer ring.
+     * @param bid Buffer ID
+     */
+    void recycle_buffer(uint16_t bid);
+
+    /** Returns size of each provided buffer.
+     * @return Buffer size
+     */
+    size_t buffer_size() const { return m_buffer_size; }
+
+  private:
+
+    /** Unmaps the rings and closes the io_uring descriptor. */
+    void cleanup();
+
+    /// io_uring descriptor
+    int m_fd;
+
+    /// io_uring_setup() parameters as filled in by the kernel
+    struct io_uring_params m_params;
+
+    /// Mapped submission queue ring and its size
+    void *m_sq_ring;
+    size_t m_sq_ring_size;
+
+    /// Mapped completion queue ring and its size (0 if it shares the
+    /// submission queue mapping)
+    void *m_cq_ring;
+    size_t m_cq_ring_size;
+
+    /// Mapped submission queue entry array
+    struct io_uring_sqe *m_sqes;
+
+    /// Submission queue ring fields
+    unsigned *m_sq_head;
+    unsigned *m_sq_tail;
+    unsigned *m_sq_array;
+    unsigned m_sq_mask;
+    unsigned m_sq_entries;
+
+    /// Submission queue tail including entries not yet published
+    unsigned m_sq_tail_local;
+
+    /// Entries published to the kernel but not yet submitted
+    unsigned m_sq_pending;
+
+    /// Completion queue ring fields
+    unsigned *m_cq_head;
+    unsigned *m_cq_tail;
+    struct io_uring_cqe *m_cqes;
+    unsigned m_cq_mask;
+    unsigned m_cq_head_local;
+
+    /// Provided buffer ring shared with the kernel and its size
+    struct io_uring_buf_ring *m_buf_ring;
+    size_t m_buf_ring_size;
+    unsigned m_buf_mask;
+
+    /// Provided buffer ring tail
+    uint16_t m_buf_tail;
+
+    /// Receive buffer memory
+    uint8_t *m_buffers;
+    size_t m_buffer_size;
+    unsigned m_buffer_count;
+  };
+
+  /** @}*/
+}
+
+#endif // HT_WITH_IO_URING
+
+#endif // HYPERTABLE_IOURING_H
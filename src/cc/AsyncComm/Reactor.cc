@@ -66,12 +66,27 @@ using namespace std;
 Reactor::Reactor() : m_interrupt_in_progress(false) {
   struct sockaddr_in addr;
 
+#if defined(HT_WITH_IO_URING)
+  m_ring = 0;
+#endif
+
   if (!ReactorFactory::use_poll) {
 #if defined(__linux__)
     if ((poll_fd = epoll_create(256)) < 0) {
       perror("epoll_create");
       exit(1);
     }
+#if defined(HT_WITH_IO_URING)
+    if (ReactorFactory::use_io_uring) {
+      try {
+        m_ring = new IOUring(RING_ENTRIES, RING_BUFFER_COUNT,
+                             RING_BUFFER_SIZE);
+      }
+      catch (Exception &e) {
+        HT_FATALF("Unable to create io_uring - %s", e.what());
+      }
+    }
+#endif
 #elif defined(__sun__)
     if ((poll_fd = port_create()) < 0) {
       perror("creation of event port failed");
@@ -173,8 +188,8 @@ Reactor::Reactor() : m_interrupt_in_progress(false) {
 void Reactor::handle_timeouts(PollTimeout &next_timeout) {
   vector<ExpireTimer> expired_timers;
   EventPtr event_ptr;
-  boost::xtime     now, next_req_timeout;
-  ExpireTimer timer;
+  boost::xtime     now, next_req_timeout, next_timer;
+  TimerNode *node;
 
   while(true) {
     {
@@ -191,32 +206,31 @@ void Reactor::handle_timeouts(PollTimeout &next_timeout) {
         handler->deliver_event(event, dh);
       }
 
-      if (next_req_timeout.sec != 0) {
-        next_timeout.set(now, next_req_timeout);
-        memcpy(&m_next_wakeup, &next_req_timeout, sizeof(m_next_wakeup));
-      }
-      else {
-        next_timeout.set_indefinite();
-        memset(&m_next_wakeup, 0, sizeof(m_next_wakeup));
+      while ((node = (TimerNode *)m_timer_wheel.next_expired(now)) != 0) {
+        expired_timers.push_back(node->timer);
+        unlink_timer(node);
+        delete node;
       }
 
-      if (!m_timer_heap.empty()) {
-        ExpireTimer timer;
-
-        while (!m_timer_heap.empty()) {
-          timer = m_timer_heap.top();
-          if (xtime_cmp(timer.expire_time, now) > 0) {
-            if (next_req_timeout.sec == 0
-                || xtime_cmp(timer.expire_time, next_req_timeout) < 0) {
-              next_timeout.set(now, timer.expire_time);
-              memcpy(&m_next_wakeup, &timer.expire_time, sizeof(m_next_wakeup));
-            }
-            break;
-          }
-          expired_timers.push_back(timer);
-          m_timer_heap.pop();
+      // Once no more timers have expired, compute the next wakeup from both
+      // wheels while still holding the lock
+      if (expired_timers.empty()) {
+        if (m_timer_wheel.next_wakeup(next_timer) &&
+            (next_req_timeout.sec == 0 ||
+             xtime_cmp(next_timer, next_req_timeout) < 0))
+          memcpy(&next_req_timeout, &next_timer, sizeof(next_req_timeout));
+
+        if (next_req_timeout.sec != 0) {
+          next_timeout.set(now, next_req_timeout);
+          memcpy(&m_next_wakeup, &next_req_timeout, sizeof(m_next_wakeup));
+        }
+        else {
+          next_timeout.set_indefinite();
+          memset(&m_next_wakeup, 0, sizeof(m_next_wakeup));
         }
 
+        poll_loop_continue();
+        break;
       }
     }
 
@@ -228,29 +242,34 @@ void Reactor::handle_timeouts(PollTimeout &next_timeout) {
       if (expired_timers[i].handler)
         expired_timers[i].handler->handle(event_ptr);
     }
+    expired_timers.clear();
+  }
 
-    {
-      ScopedLock lock(m_mutex);
-
-      if (!m_timer_heap.empty()) {
-        timer = m_timer_heap.top();
-
-        if (xtime_cmp(now, timer.expire_time) > 0)
-          continue;
+}
 
-        if (next_req_timeout.sec == 0
-            || xtime_cmp(timer.expire_time, next_req_timeout) < 0) {
-          next_timeout.set(now, timer.expire_time);
-          memcpy(&m_next_wakeup, &timer.expire_time, sizeof(m_next_wakeup));
-        }
-      }
 
-      poll_loop_continue();
-    }
+void Reactor::insert_timer(ExpireTimer &timer) {
+  TimerNode *node = new TimerNode;
+  node->timer = timer;
+  node->handler_prev = 0;
+  TimerNode *&head = m_timer_handlers[timer.handler.get()];
+  node->handler_next = head;
+  if (head)
+    head->handler_prev = node;
+  head = node;
+  m_timer_wheel.insert(node, timer.expire_time);
+}
 
-    break;
-  }
 
+void Reactor::unlink_timer(TimerNode *node) {
+  if (node->handler_next)
+    node->handler_next->handler_prev = node->handler_prev;
+  if (node->handler_prev)
+    node->handler_prev->handler_next = node->handler_next;
+  else if (node->handler_next)
+    m_timer_handlers[node->timer.handler.get()] = node->handler_next;
+  else
+    m_timer_handlers.erase(node->timer.handler.get());
 }
 
 
@@ -28,7 +28,7 @@
 #ifndef HYPERTABLE_REACTOR_H
 #define HYPERTABLE_REACTOR_H
 
-#include <queue>
+#include <algorithm>
 #include <set>
 #include <vector>
 
@@ -38,12 +38,15 @@ extern "C" {
 #include <poll.h>
 }
 
+#include "Common/HashMap.h"
 #include "Common/Mutex.h"
 #include "Common/ReferenceCount.h"
 
+#include "IOUring.h"
 #include "PollTimeout.h"
 #include "RequestCache.h"
 #include "ExpireTimer.h"
+#include "TimerWheel.h"
 
 namespace Hypertable {
 
@@ -60,6 +63,8 @@ namespace Hypertable {
     IOHandler *handler;
   } PollDescriptorT;
 
+  class IOHandlerData;
+
   /** Manages reactor (polling thread) state including poll interest, request cache,
    * and timers.
    */
@@ -76,6 +81,28 @@ namespace Hypertable {
       WRITE_READY = 0x02  /**< Write ready polling interest */
     };
 
+#if defined(HT_WITH_IO_URING)
+    /** Operation tags stored in the low bits of io_uring
+     * <code>user_data</code>; the remaining bits hold the IOHandlerData
+     * pointer the operation belongs to, if any.
+     */
+    enum RingOperation {
+      RING_OP_RECV   = 0x01, /**< Receive on a data connection */
+      RING_OP_SEND   = 0x02, /**< Send queue writev on a data connection */
+      RING_OP_EPOLL  = 0x03, /**< Readiness of #poll_fd */
+      RING_OP_CANCEL = 0x04, /**< Cancellation request */
+      RING_OP_MASK   = 0x07  /**< Mask of the operation tag bits */
+    };
+
+    /** Sizing of the per-reactor io_uring instance.
+     */
+    enum {
+      RING_ENTRIES      = 256,  /**< Submission queue entries */
+      RING_BUFFER_COUNT = 256,  /**< Provided receive buffers */
+      RING_BUFFER_SIZE  = 8192  /**< Size of each receive buffer */
+    };
+#endif
+
     /** Constructor.
      * Initializes polling interface and creates interrupt socket.
      * If ReactorFactory::use_poll is set to <i>true</i>, then the reactor will
@@ -92,6 +119,18 @@ namespace Hypertable {
      */
     ~Reactor() {
       poll_loop_interrupt();
+      for (TimerHandlerMap::iterator iter = m_timer_handlers.begin();
+           iter != m_timer_handlers.end(); ++iter) {
+        TimerNode *node = (*iter).second;
+        while (node) {
+          TimerNode *next = node->handler_next;
+          delete node;
+          node = next;
+        }
+      }
+#if defined(HT_WITH_IO_URING)
+      delete m_ring;
+#endif
     }
 
     /** Adds a request to request cache and adjusts poll timeout if necessary.
@@ -104,8 +143,7 @@ namespace Hypertable {
                      boost::xtime &expire) {
       ScopedLock lock(m_mutex);
       m_request_cache.insert(id, handler, dh, expire);
-      if (m_next_wakeup.sec == 0 || xtime_cmp(expire, m_next_wakeup) < 0)
-        poll_loop_interrupt();
+      wakeup_by(expire);
     }
 
     /** Removes request associated with <code>id</code>
@@ -127,14 +165,14 @@ namespace Hypertable {
     }
 
     /** Adds a timer.
-     * Pushes timer onto #m_timer_heap and interrupts the polling loop so that
-     * the poll timeout can be adjusted if necessary.
+     * Inserts timer into #m_timer_wheel and interrupts the polling loop if
+     * the timer expires before the current poll timeout.
      * @param timer Reference to ExpireTimer object
      */
     void add_timer(ExpireTimer &timer) {
       ScopedLock lock(m_mutex);
-      m_timer_heap.push(timer);
-      poll_loop_interrupt();
+      insert_timer(timer);
+      wakeup_by(timer.expire_time);
     }
 
     /** Cancels timers associated with <code>handler</code>.
@@ -143,18 +181,17 @@ namespace Hypertable {
      */
     void cancel_timer(DispatchHandler *handler) {
       ScopedLock lock(m_mutex);
-      typedef TimerHeap::container_type container_t;
-      container_t container;
-      container.reserve(m_timer_heap.size());
-      ExpireTimer timer;
-      while (!m_timer_heap.empty()) {
-        timer = m_timer_heap.top();
-        if (timer.handler != handler)
-          container.push_back(timer);
-        m_timer_heap.pop();
+      TimerHandlerMap::iterator iter = m_timer_handlers.find(handler);
+      if (iter == m_timer_handlers.end())
+        return;
+      TimerNode *node = (*iter).second;
+      while (node) {
+        TimerNode *next = node->handler_next;
+        m_timer_wheel.remove(node);
+        delete node;
+        node = next;
       }
-      foreach_ht (const ExpireTimer &t, container)
-        m_timer_heap.push(t);
+      m_timer_handlers.erase(iter);
     }
 
     /** Schedules <code>handler</code> for removal.
@@ -174,8 +211,8 @@ namespace Hypertable {
       boost::xtime_get(&timer.expire_time, boost::TIME_UTC_);
       timer.expire_time.nsec += 200000000LL;
       timer.handler = 0;
-      m_timer_heap.push(timer);
-      poll_loop_interrupt();
+      insert_timer(timer);
+      wakeup_by(timer.expire_time);
     }
 
     /** Returns set of I/O handlers scheduled for removal.
@@ -193,13 +230,56 @@ namespace Hypertable {
      * This method removes timed out requests from the request cache, delivering
      * ERROR events (with error == Error::REQUEST_TIMEOUT) via each request's
      * dispatch handler.  It also processes expired timers by removing them from
-     * #m_timer_heap and delivering a TIMEOUT event via the timer handler if
+     * #m_timer_wheel and delivering a TIMEOUT event via the timer handler if
      * it exsists.
      * @param next_timeout Set to next earliest timeout of active requests and
      * timers
      */
     void handle_timeouts(PollTimeout &next_timeout);
 
+#if defined(HT_WITH_IO_URING)
+    /** Returns io_uring instance.  The ring is only allocated when
+     * ReactorFactory::use_io_uring is set and may only be used from the
+     * reactor thread.
+     * @return Pointer to io_uring instance, or 0 if not allocated
+     */
+    IOUring *ring() { return m_ring; }
+
+    /** Schedules a send queue writev for <code>handler</code>.
+     * Adds <code>handler</code> to #m_scheduled_sends and interrupts the
+     * polling loop, unless an interrupt is already in progress, so that the
+     * reactor thread submits the writev on its next pass.
+     * @param handler I/O handler with queued messages
+     */
+    void schedule_send(IOHandlerData *handler) {
+      ScopedLock lock(m_mutex);
+      m_scheduled_sends.push_back(handler);
+      if (!m_interrupt_in_progress)
+        poll_loop_interrupt();
+    }
+
+    /** Returns handlers with scheduled sends.
+     * This is a one shot method that swaps the contents of
+     * #m_scheduled_sends into <code>dst</code>.
+     * @param dst reference to vector filled in with handlers
+     */
+    void get_scheduled_sends(std::vector<IOHandlerData *> &dst) {
+      ScopedLock lock(m_mutex);
+      dst.clear();
+      dst.swap(m_scheduled_sends);
+    }
+
+    /** Removes <code>handler</code> from the scheduled sends.
+     * @param handler I/O handler being removed
+     */
+    void cancel_scheduled_send(IOHandlerData *handler) {
+      ScopedLock lock(m_mutex);
+      m_scheduled_sends.erase(std::remove(m_scheduled_sends.begin(),
+                                          m_scheduled_sends.end(), handler),
+                              m_scheduled_sends.end());
+    }
+#endif
+
 #if defined(__linux__) || defined (__sun__)
     /// Poll descriptor for <code>epoll</code> or <code>port_associate</code>
     int poll_fd;
@@ -266,15 +346,58 @@ namespace Hypertable {
 
   protected:
 
-    /** Priority queue for timers.
+    /** Timer wheel entry.  Entries for the same dispatch handler are chained
+     * together so that they can be cancelled without searching the wheel.
+     */
+    struct TimerNode : public TimerWheel::Node {
+      ExpireTimer timer;         //!< Timer state
+      TimerNode *handler_prev;   //!< Previous timer with same handler
+      TimerNode *handler_next;   //!< Next timer with same handler
+    };
+
+    /** Hash functor for dispatch handler pointers
+     */
+    struct TimerHandlerHash {
+      size_t operator()(const DispatchHandler *handler) const {
+        return (size_t)handler;
+      }
+    };
+
+    /** Dispatch handler to timer chain map
+     */
+    typedef hash_map<DispatchHandler *, TimerNode *, TimerHandlerHash>
+            TimerHandlerMap;
+
+    /** Inserts a timer into #m_timer_wheel and #m_timer_handlers.
+     * @param timer Timer to insert
+     */
+    void insert_timer(ExpireTimer &timer);
+
+    /** Unlinks a timer from its chain in #m_timer_handlers.
+     * @param node Timer to unlink
+     */
+    void unlink_timer(TimerNode *node);
+
+    /** Interrupts the polling loop if <code>expire</code> falls before the
+     * currently scheduled wakeup.  Deadlines that fall in or after the tick
+     * of the scheduled wakeup are picked up by that wakeup, as are all
+     * deadlines added while an interrupt is already in progress.
+     * @param expire Absolute expiration time of new request or timer
      */
-    typedef std::priority_queue<ExpireTimer,
-      std::vector<ExpireTimer>, LtTimerHeap> TimerHeap;
+    void wakeup_by(const boost::xtime &expire) {
+      if (m_interrupt_in_progress)
+        return;
+      if (m_next_wakeup.sec == 0 ||
+          TimerWheel::to_tick(expire, true) <
+          TimerWheel::to_tick(m_next_wakeup, false))
+        poll_loop_interrupt();
+    }
 
     Mutex m_mutex;                //!< Mutex to protect members
     Mutex m_polldata_mutex;       //!< Mutex to protect #m_polldata member
     RequestCache m_request_cache; //!< Request cache
-    TimerHeap m_timer_heap;       //!< ExpireTimer heap
+    TimerWheel m_timer_wheel;     //!< ExpireTimer wheel
+    TimerHandlerMap m_timer_handlers; //!< Timer chains by dispatch handler
     int m_interrupt_sd;           //!< Interrupt socket
 
     /// Set to <i>true</i> if poll loop interrupt in progress
@@ -289,6 +412,14 @@ namespace Hypertable {
 
     /// Set of IOHandler objects scheduled for removal
     std::set<IOHandler *> m_removed_handlers;
+
+#if defined(HT_WITH_IO_URING)
+    /// io_uring instance (io_uring backend only)
+    IOUring *m_ring;
+
+    /// Handlers waiting for the reactor thread to submit a writev
+    std::vector<IOHandlerData *> m_scheduled_sends;
+#endif
   };
 
   /// Smart pointer to Reactor
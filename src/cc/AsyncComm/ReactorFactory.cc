@@ -22,10 +22,14 @@
 #include "Common/Compat.h"
 
 #include "Common/Config.h"
+#include "Common/Logger.h"
 #include "Common/System.h"
 #include "Common/SystemInfo.h"
 
+#include "CommHeader.h"
 #include "HandlerMap.h"
+#include "IOHandlerData.h"
+#include "IOUring.h"
 #include "ReactorFactory.h"
 #include "ReactorRunner.h"
 using namespace Hypertable;
@@ -43,6 +47,8 @@ Mutex        ReactorFactory::ms_mutex;
 atomic_t     ReactorFactory::ms_next_reactor = ATOMIC_INIT(0);
 bool         ReactorFactory::ms_epollet = true;
 bool         ReactorFactory::use_poll = false;
+bool         ReactorFactory::use_io_uring = false;
+uint32_t     ReactorFactory::zero_copy_threshold = 0;
 bool         ReactorFactory::proxy_master = false;
 
 /**
@@ -58,20 +64,51 @@ void ReactorFactory::initialize(uint16_t reactor_count) {
   assert(reactor_count > 0);
 
 #if defined(__linux__)
-  if (System::os_info().version_major < 2 ||
-      System::os_info().version_minor < 6 ||
-      (System::os_info().version_major == 2 &&
-       System::os_info().version_minor == 6 &&
-       System::os_info().version_micro < 17))
+  const OsInfo &os_info = System::os_info();
+  if (os_info.version_major < 2 ||
+      (os_info.version_major == 2 &&
+       (os_info.version_minor < 6 ||
+        (os_info.version_minor == 6 && os_info.version_micro < 17))))
     ms_epollet = false;
-  if (System::os_info().version_major < 2 ||
-      System::os_info().version_minor < 5)
+  if (os_info.version_major < 2 ||
+      (os_info.version_major == 2 && os_info.version_minor < 5))
     use_poll = true;
 #endif
 
   if (Config::properties->get_bool("Comm.UsePoll") == true)
     use_poll = true;
 
+  int32_t protocol_version = Config::properties->get_i32("Comm.ProtocolVersion");
+  if (protocol_version < 1 || protocol_version > CommHeader::PROTOCOL_VERSION)
+    HT_THROWF(Error::CONFIG_BAD_VALUE, "Comm.ProtocolVersion must be between "
+              "1 and %d", (int)CommHeader::PROTOCOL_VERSION);
+  CommHeader::request_version = (uint8_t)protocol_version;
+
+  if (Config::properties->get_bool("Comm.UseIoUring") && !use_poll) {
+#if defined(HT_WITH_IO_URING)
+    if (IOUring::is_supported())
+      use_io_uring = true;
+    else
+      HT_WARN("io_uring not supported by this kernel, falling back to epoll");
+#else
+    HT_WARN("io_uring support not compiled in, falling back to default "
+            "polling interface");
+#endif
+  }
+
+  // Zero-copy sends complete through the socket error queue, which is only
+  // drained by the epoll event loop
+  if (Config::properties->get_i32("Comm.ZeroCopySendThreshold") > 0 &&
+      !use_poll && !use_io_uring) {
+#if defined(HT_WITH_ZEROCOPY_SEND)
+    zero_copy_threshold =
+      (uint32_t)Config::properties->get_i32("Comm.ZeroCopySendThreshold");
+#else
+    HT_WARN("MSG_ZEROCOPY not supported on this platform, ignoring "
+            "Comm.ZeroCopySendThreshold");
+#endif
+  }
+
   for (uint16_t i=0; i<=reactor_count; i++) {
     reactor = new Reactor();
     ms_reactors.push_back(reactor);
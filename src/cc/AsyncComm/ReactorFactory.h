@@ -58,9 +58,12 @@ namespace Hypertable {
     /** Initializes I/O reactors.  This method creates and initializes
      * <code>reactor_count</code> reactors, plus an additional dedicated timer
      * reactor.  It also initializes the #use_poll member based on the
-     * <code>Comm.UsePoll</code> property and sets the #ms_epollet
-     * ("edge triggered") flag to <i>false</i> if running on Linux version older
-     * than 2.6.17.  It also allocates a HandlerMap and initializes
+     * <code>Comm.UsePoll</code> property, the #use_io_uring member based on
+     * the <code>Comm.UseIoUring</code> property and kernel support, the
+     * #zero_copy_threshold member based on the
+     * <code>Comm.ZeroCopySendThreshold</code> property, and
+     * sets the #ms_epollet ("edge triggered") flag to <i>false</i> if
+     * running on Linux version older than 2.6.17.  It also allocates a HandlerMap and initializes
      * ReactorRunner::handler_map to point to it.
      * @param reactor_count number of reactor threads to create
      */
@@ -100,6 +103,11 @@ namespace Hypertable {
     static boost::mt19937 rng; //!< Pseudo random number generator
     static bool ms_epollet;    //!< Use "edge triggered" epoll
     static bool use_poll;      //!< Use POSIX poll() as polling mechanism
+    static bool use_io_uring;  //!< Use io_uring for data connections
+
+    /// Minimum extended payload size sent with <code>MSG_ZEROCOPY</code>
+    /// (0 disables zero-copy sends)
+    static uint32_t zero_copy_threshold;
 
     /// Set to <i>true</i> if this process is acting as "Proxy Master"
     static bool proxy_master;
@@ -135,6 +135,13 @@ void ReactorRunner::operator()() {
     return;
   }
 
+#if defined(HT_WITH_IO_URING)
+  if (ReactorFactory::use_io_uring) {
+    io_uring_loop(dispatch_delay);
+    return;
+  }
+#endif
+
 #if defined(__linux__)
   struct epoll_event events[256];
 
@@ -299,6 +306,26 @@ ReactorRunner::cleanup_and_remove_handlers(std::set<IOHandler *> &handlers) {
 
     m_reactor->cancel_requests(handler);
 
+#if defined(HT_WITH_IO_URING)
+    // Handlers on the ring can only be deleted once the kernel is done
+    // with all of their requests
+    if (ReactorFactory::use_io_uring) {
+      IOHandlerData *data_handler = dynamic_cast<IOHandlerData *>(handler);
+      if (data_handler && data_handler->is_ring_attached()) {
+        if (m_draining_handlers.count(data_handler))
+          continue;
+        m_reactor->cancel_scheduled_send(data_handler);
+        if (data_handler->ring_operations() > 0) {
+          data_handler->cancel_ring_operations();
+          m_draining_handlers.insert(data_handler);
+        }
+        else
+          handler_map->purge_handler(handler);
+        continue;
+      }
+    }
+#endif
+
     if (ReactorFactory::use_poll)
       m_reactor->remove_poll_interest(handler->get_sd());
     else {
@@ -326,3 +353,150 @@ ReactorRunner::cleanup_and_remove_handlers(std::set<IOHandler *> &handlers) {
     handler_map->purge_handler(handler);
   }
 }
+
+
+#if defined(HT_WITH_IO_URING)
+
+void ReactorRunner::io_uring_loop(uint32_t dispatch_delay) {
+  IOUring *ring = m_reactor->ring();
+  struct io_uring_cqe *cqe;
+  struct io_uring_sqe *sqe;
+  struct epoll_event events[256];
+  std::set<IOHandler *> removed_handlers;
+  std::vector<IOHandlerData *> scheduled_sends;
+  IOHandler *handler;
+  IOHandlerData *data_handler;
+  PollTimeout timeout;
+  bool did_delay = false;
+  time_t arrival_time = 0;
+  bool got_arrival_time = false;
+  bool epoll_armed = false;
+  int n, ret;
+
+  while (true) {
+
+    // Sockets that stay on epoll (accept, datagram, interrupt, and
+    // connections being established) are serviced whenever the multishot
+    // poll on the epoll descriptor fires
+    if (!epoll_armed) {
+      if ((sqe = ring->get_sqe()) == 0) {
+        HT_ERROR("Unable to get io_uring submission entry for epoll poll");
+        return;
+      }
+      sqe->opcode = IORING_OP_POLL_ADD;
+      sqe->fd = m_reactor->poll_fd;
+      sqe->poll32_events = POLLIN;
+      sqe->len = IORING_POLL_ADD_MULTI;
+      sqe->user_data = Reactor::RING_OP_EPOLL;
+      epoll_armed = true;
+    }
+
+    if ((ret = ring->submit_and_wait(timeout)) < 0) {
+      if (!shutdown)
+        HT_ERRORF("io_uring_enter() failed : %s", strerror(-ret));
+      return;
+    }
+
+    if (record_arrival_time)
+      got_arrival_time = false;
+
+    if (dispatch_delay)
+      did_delay = false;
+
+    m_reactor->get_removed_handlers(removed_handlers);
+
+    while ((cqe = ring->peek_cqe()) != 0) {
+      uint64_t user_data = cqe->user_data;
+      int res = cqe->res;
+      uint32_t flags = cqe->flags;
+      int op = (int)(user_data & Reactor::RING_OP_MASK);
+
+      ring->cqe_seen();
+
+      if (op == Reactor::RING_OP_EPOLL) {
+        if ((flags & IORING_CQE_F_MORE) == 0)
+          epoll_armed = false;
+        do {
+          n = epoll_wait(m_reactor->poll_fd, events, 256, 0);
+          for (int i=0; i<n; i++) {
+            handler = (IOHandler *)events[i].data.ptr;
+            if (handler && removed_handlers.count(handler) == 0) {
+              // dispatch delay for testing
+              if (dispatch_delay && !did_delay && (events[i].events & EPOLLIN)) {
+                poll(0, 0, (int)dispatch_delay);
+                did_delay = true;
+              }
+              if (record_arrival_time && !got_arrival_time
+                  && (events[i].events & EPOLLIN)) {
+                arrival_time = time(0);
+                got_arrival_time = true;
+              }
+              if (handler->handle_event(&events[i], arrival_time))
+                removed_handlers.insert(handler);
+            }
+          }
+        } while (n == 256);
+        continue;
+      }
+
+      if (op == Reactor::RING_OP_CANCEL)
+        continue;
+
+      data_handler = (IOHandlerData *)(uintptr_t)(user_data
+                       & ~(uint64_t)Reactor::RING_OP_MASK);
+
+      if (op == Reactor::RING_OP_SEND || (flags & IORING_CQE_F_MORE) == 0)
+        data_handler->ring_operation_completed();
+
+      if (m_draining_handlers.count(data_handler) ||
+          removed_handlers.count(data_handler)) {
+        if (flags & IORING_CQE_F_BUFFER)
+          ring->recycle_buffer((uint16_t)(flags >> IORING_CQE_BUFFER_SHIFT));
+        continue;
+      }
+
+      if (op == Reactor::RING_OP_RECV) {
+        if (res > 0) {
+          // dispatch delay for testing
+          if (dispatch_delay && !did_delay) {
+            poll(0, 0, (int)dispatch_delay);
+            did_delay = true;
+          }
+          if (record_arrival_time && !got_arrival_time) {
+            arrival_time = time(0);
+            got_arrival_time = true;
+          }
+        }
+        if (data_handler->handle_recv_completion(res, flags, arrival_time))
+          removed_handlers.insert(data_handler);
+      }
+      else if (data_handler->handle_send_completion(res))
+        removed_handlers.insert(data_handler);
+    }
+
+    if (!removed_handlers.empty())
+      cleanup_and_remove_handlers(removed_handlers);
+
+    std::set<IOHandlerData *>::iterator iter = m_draining_handlers.begin();
+    while (iter != m_draining_handlers.end()) {
+      if ((*iter)->ring_operations() == 0) {
+        handler_map->purge_handler(*iter);
+        m_draining_handlers.erase(iter++);
+      }
+      else
+        ++iter;
+    }
+
+    m_reactor->handle_timeouts(timeout);
+    if (shutdown)
+      return;
+
+    // Writevs for all connections with scheduled sends go out with the
+    // next submit
+    m_reactor->get_scheduled_sends(scheduled_sends);
+    foreach_ht (IOHandlerData *h, scheduled_sends)
+      h->submit_scheduled_send();
+  }
+}
+
+#endif // HT_WITH_IO_URING
@@ -28,6 +28,8 @@
 #ifndef HYPERTABLE_REACTORRUNNER_H
 #define HYPERTABLE_REACTORRUNNER_H
 
+#include <set>
+
 #include "HandlerMap.h"
 #include "Reactor.h"
 
@@ -38,6 +40,7 @@ namespace Hypertable {
    */
 
   class IOHandler;
+  class IOHandlerData;
 
   /** Thread functor class for reacting to I/O events.
    * The AsyncComm layer is initialized with some number of <i>reactor</i>
@@ -80,6 +83,26 @@ namespace Hypertable {
      */
     void cleanup_and_remove_handlers(std::set<IOHandler *> &handlers);
 
+#if defined(HT_WITH_IO_URING)
+    /** Event loop for the io_uring backend.
+     * Waits on the reactor's io_uring instance instead of the polling
+     * interface.  The epoll descriptor, which still holds the accept,
+     * datagram and interrupt sockets and connections that are being
+     * established, is watched with a multishot poll request and its events
+     * are dispatched as in the epoll loop.  Receive and writev completions
+     * of connections that have been moved to the ring are dispatched to
+     * IOHandlerData::handle_recv_completion and
+     * IOHandlerData::handle_send_completion, and writevs for sends
+     * scheduled with Reactor::schedule_send are submitted together before
+     * the next wait.
+     * @param dispatch_delay Testing delay applied before reading
+     */
+    void io_uring_loop(uint32_t dispatch_delay);
+
+    /// Removed handlers waiting for outstanding io_uring requests
+    std::set<IOHandlerData *> m_draining_handlers;
+#endif
+
     ReactorPtr m_reactor; //!< Smart pointer to reactor state object
   };
   /** @}*/
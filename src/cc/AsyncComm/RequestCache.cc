@@ -39,6 +39,13 @@
 using namespace Hypertable;
 using namespace std;
 
+RequestCache::~RequestCache() {
+  for (IdHandlerMap::iterator iter = m_id_map.begin();
+       iter != m_id_map.end(); ++iter)
+    delete (*iter).second;
+}
+
+
 void
 RequestCache::insert(uint32_t id, IOHandler *handler, DispatchHandler *dh,
                      boost::xtime &expire) {
@@ -53,18 +60,8 @@ RequestCache::insert(uint32_t id, IOHandler *handler, DispatchHandler *dh,
   node->id = id;
   node->handler = handler;
   node->dh = dh;
-  memcpy(&node->expire, &expire, sizeof(expire));
 
-  if (m_head == 0) {
-    node->next = node->prev = 0;
-    m_head = m_tail = node;
-  }
-  else {
-    node->next = m_tail;
-    node->next->prev = node;
-    node->prev = 0;
-    m_tail = node;
-  }
+  m_wheel.insert(node, expire);
 
   m_id_map[id] = node;
 }
@@ -83,15 +80,7 @@ DispatchHandler *RequestCache::remove(uint32_t id) {
 
   CacheNode *node = (*iter).second;
 
-  if (node->prev == 0)
-    m_tail = node->next;
-  else
-    node->prev->next = node->next;
-
-  if (node->next == 0)
-    m_head = node->prev;
-  else
-    node->next->prev = node->prev;
+  m_wheel.remove(node);
 
   m_id_map.erase(iter);
 
@@ -105,19 +94,12 @@ DispatchHandler *RequestCache::remove(uint32_t id) {
 DispatchHandler *
 RequestCache::get_next_timeout(boost::xtime &now, IOHandler *&handlerp,
                                boost::xtime *next_timeout) {
+  CacheNode *node;
 
-  while (m_head && xtime_cmp(m_head->expire, now) <= 0) {
+  while ((node = static_cast<CacheNode *>(m_wheel.next_expired(now))) != 0) {
 
-    IdHandlerMap::iterator iter = m_id_map.find(m_head->id);
+    IdHandlerMap::iterator iter = m_id_map.find(node->id);
     assert (iter != m_id_map.end());
-    CacheNode *node = m_head;
-    if (m_head->prev) {
-      m_head = m_head->prev;
-      m_head->next = 0;
-    }
-    else
-      m_head = m_tail = 0;
-
     m_id_map.erase(iter);
 
     if (node->handler != 0) {
@@ -129,9 +111,7 @@ RequestCache::get_next_timeout(boost::xtime &now, IOHandler *&handlerp,
     delete node;
   }
 
-  if (m_head)
-    memcpy(next_timeout, &m_head->expire, sizeof(boost::xtime));
-  else
+  if (!m_wheel.next_wakeup(*next_timeout))
     memset(next_timeout, 0, sizeof(boost::xtime));
 
   return 0;
@@ -140,7 +120,9 @@ RequestCache::get_next_timeout(boost::xtime &now, IOHandler *&handlerp,
 
 
 void RequestCache::purge_requests(IOHandler *handler, int32_t error) {
-  for (CacheNode *node = m_tail; node != 0; node = node->next) {
+  for (IdHandlerMap::iterator iter = m_id_map.begin();
+       iter != m_id_map.end(); ++iter) {
+    CacheNode *node = (*iter).second;
     if (node->handler == handler) {
       String proxy = handler->get_proxy();
       Event *event;
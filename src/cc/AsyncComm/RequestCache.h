@@ -33,6 +33,7 @@
 #include "Common/HashMap.h"
 
 #include "DispatchHandler.h"
+#include "TimerWheel.h"
 
 namespace Hypertable {
 
@@ -47,14 +48,14 @@ namespace Hypertable {
    * an entry, which includes the response handler, is inserted into the
    * RequestCache.  When the corresponding response is receive, the response
    * handler is obtained by looking up the corresponding request ID in this cache.
+   * Request expiration is tracked with a TimerWheel, so insertion and removal
+   * are constant time regardless of how many requests are outstanding.
    */
   class RequestCache {
 
     /** Internal cache node structure.
      */
-    struct CacheNode {
-      struct CacheNode  *prev, *next;  //!< Doubly-linked list pointers
-      boost::xtime       expire;  //!< Absolute expiration time
+    struct CacheNode : public TimerWheel::Node {
       uint32_t           id;      //!< Request ID
       IOHandler         *handler; //!< IOHandler associated with this request
       /// Callback handler to which MESSAGE, TIMEOUT, ERROR, and DISCONNECT
@@ -68,7 +69,10 @@ namespace Hypertable {
   public:
 
     /// Constructor.
-    RequestCache() : m_id_map(), m_head(0), m_tail(0) { return; }
+    RequestCache() : m_id_map() { return; }
+
+    /// Destructor.
+    ~RequestCache();
 
     /** Inserts pending request callback handler into cache.
      * @param id Request ID
@@ -86,16 +90,16 @@ namespace Hypertable {
      */
     DispatchHandler *remove(uint32_t id);
 
-    /** Removes next request that has timed out.  This method finds the first
-     * request starting from the head of the list and removes it and returns
-     * it's associated handler information if it has timed out.  During the
-     * search, it physically removes any cache nodes corresponding to requests
-     * that have been purged.
+    /** Removes next request that has timed out.  This method takes expired
+     * requests off the timer wheel and removes and returns the associated
+     * handler information of the first one that has not been purged.  Cache
+     * nodes corresponding to requests that have been purged are physically
+     * removed along the way.
      * @param now Current time
      * @param handlerp Return parameter to hold pointer to associated IOHandler
      *                 of timed out request
-     * @param next_timeout Pointer to xtime variable to hold expiration time
-     * of next request <b>after</b> timed out request, set to 0 if cache is empty
+     * @param next_timeout Pointer to xtime variable to hold the time at which
+     * the cache should next be checked for timeouts, set to 0 if cache is empty
      * @return Pointer to timed out dispatch handler, or 0 if none
      */
     DispatchHandler *get_next_timeout(boost::xtime &now, IOHandler *&handlerp,
@@ -113,8 +117,7 @@ namespace Hypertable {
 
   private:
     IdHandlerMap  m_id_map; //!< RequestID-to-CacheNode map
-    CacheNode    *m_head;   //!< Head of doubly-linked list
-    CacheNode    *m_tail;   //!< Tail of doubly-linked list
+    TimerWheel    m_wheel;  //!< Expiration timer wheel
   };
 }
 
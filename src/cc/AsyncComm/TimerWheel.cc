@@ -0,0 +1,278 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for TimerWheel.
+ * This file contains method definitions for TimerWheel, a hierarchical timing
+ * wheel used to track request timeouts and timers.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstring>
+
+#include "Common/Logger.h"
+
+#include "TimerWheel.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  /// Initializes <code>head</code> as an empty circular list
+  inline void list_init(TimerWheel::Node *head) {
+    head->prev = head->next = head;
+  }
+
+  /// Returns <i>true</i> if list headed by <code>head</code> is empty
+  inline bool list_empty(const TimerWheel::Node *head) {
+    return head->next == head;
+  }
+
+  /// Appends <code>node</code> to the list headed by <code>head</code>
+  inline void list_append(TimerWheel::Node *head, TimerWheel::Node *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+  }
+
+  /// Unlinks <code>node</code> from whatever list it is in
+  inline void list_unlink(TimerWheel::Node *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = 0;
+  }
+
+}
+
+
+TimerWheel::TimerWheel() : m_count(0) {
+  boost::xtime now;
+  for (size_t l=0; l<LEVELS; l++)
+    for (size_t s=0; s<SLOTS; s++)
+      list_init(&m_slots[l][s]);
+  list_init(&m_expired);
+  memset(m_level_count, 0, sizeof(m_level_count));
+  boost::xtime_get(&now, boost::TIME_UTC_);
+  m_current_tick = to_tick(now, false);
+}
+
+
+void TimerWheel::insert(Node *node, const boost::xtime &expire) {
+  HT_ASSERT(node->next == 0);
+
+  // Don't walk ticks that passed while the wheel sat empty
+  if (m_count == 0) {
+    boost::xtime now;
+    boost::xtime_get(&now, boost::TIME_UTC_);
+    int64_t now_tick = to_tick(now, false);
+    if (now_tick > m_current_tick)
+      m_current_tick = now_tick;
+  }
+
+  node->tick = to_tick(expire, true);
+  link(node);
+  m_count++;
+}
+
+
+void TimerWheel::remove(Node *node) {
+  if (node->next == 0)
+    return;
+  list_unlink(node);
+  m_level_count[node->level]--;
+  m_count--;
+}
+
+
+TimerWheel::Node *TimerWheel::next_expired(const boost::xtime &now) {
+  int64_t target = to_tick(now, false);
+
+  if (m_count == 0) {
+    if (target > m_current_tick)
+      m_current_tick = target;
+    return 0;
+  }
+
+  while (m_current_tick < target) {
+    // With nothing in level 0, skip straight to the tick before the next
+    // cascade
+    if (m_level_count[0] == 0) {
+      int64_t boundary = ((m_current_tick >> SLOT_BITS) + 1) << SLOT_BITS;
+      if (boundary - 1 > m_current_tick) {
+        m_current_tick = (target < boundary - 1) ? target : boundary - 1;
+        if (m_current_tick == target)
+          break;
+      }
+    }
+    advance();
+  }
+
+  if (list_empty(&m_expired))
+    return 0;
+
+  Node *node = m_expired.next;
+  list_unlink(node);
+  m_level_count[LEVELS]--;
+  m_count--;
+  return node;
+}
+
+
+bool TimerWheel::next_wakeup(boost::xtime &expire) {
+  int64_t tick = 0;
+
+  if (m_count == 0)
+    return false;
+
+  if (!list_empty(&m_expired)) {
+    from_tick(m_current_tick, expire);
+    return true;
+  }
+
+  if (m_level_count[0]) {
+    for (int64_t j=1; j<=SLOTS; j++) {
+      if (!list_empty(&m_slots[0][(m_current_tick + j) & (SLOTS-1)])) {
+        tick = m_current_tick + j;
+        break;
+      }
+    }
+  }
+
+  for (int l=1; l<LEVELS; l++) {
+    if (m_level_count[l] == 0)
+      continue;
+    int shift = l * SLOT_BITS;
+    int64_t base = m_current_tick >> shift;
+    for (int64_t j=1; j<=SLOTS; j++) {
+      if (!list_empty(&m_slots[l][(base + j) & (SLOTS-1)])) {
+        int64_t cascade_tick = (base + j) << shift;
+        if (tick == 0 || cascade_tick < tick)
+          tick = cascade_tick;
+        break;
+      }
+    }
+  }
+
+  HT_ASSERT(tick > m_current_tick);
+  from_tick(tick, expire);
+  return true;
+}
+
+
+int64_t TimerWheel::to_tick(const boost::xtime &t, bool round_up) {
+  int64_t nanos = (int64_t)t.sec * 1000000000LL + t.nsec;
+  int64_t tick_nanos = (int64_t)TICK_MILLIS * 1000000LL;
+  int64_t tick = nanos / tick_nanos;
+  if (round_up && (nanos % tick_nanos) != 0)
+    tick++;
+  return tick;
+}
+
+
+void TimerWheel::from_tick(int64_t tick, boost::xtime &t) {
+  int64_t millis = tick * TICK_MILLIS;
+  t.sec = millis / 1000;
+  t.nsec = (millis % 1000) * 1000000;
+}
+
+
+void TimerWheel::link(Node *node) {
+  int64_t delta = node->tick - m_current_tick;
+  int level;
+
+  if (delta <= 0) {
+    node->level = LEVELS;
+    list_append(&m_expired, node);
+    m_level_count[LEVELS]++;
+    return;
+  }
+
+  for (level=0; level<LEVELS-1; level++) {
+    if (delta < ((int64_t)1 << ((level+1) * SLOT_BITS)))
+      break;
+  }
+
+  int shift = level * SLOT_BITS;
+  int64_t slot;
+  if (delta < ((int64_t)1 << ((level+1) * SLOT_BITS)))
+    slot = (node->tick >> shift) & (SLOTS-1);
+  else  // beyond the wheel horizon, park in the farthest slot
+    slot = ((m_current_tick >> shift) + SLOTS - 1) & (SLOTS-1);
+
+  node->level = level;
+  list_append(&m_slots[level][slot], node);
+  m_level_count[level]++;
+}
+
+
+void TimerWheel::advance() {
+  m_current_tick++;
+
+  if ((m_current_tick & (SLOTS-1)) == 0) {
+    for (int l=1; l<LEVELS; l++) {
+      cascade(l);
+      if (((m_current_tick >> (l * SLOT_BITS)) & (SLOTS-1)) != 0)
+        break;
+    }
+  }
+
+  expire_slot(m_current_tick & (SLOTS-1));
+}
+
+
+void TimerWheel::cascade(int level) {
+  Node *head = &m_slots[level][(m_current_tick >> (level * SLOT_BITS))
+                               & (SLOTS-1)];
+  Node list;
+
+  if (list_empty(head))
+    return;
+
+  // Detach the slot's entries before relinking; a parked entry may map
+  // back to the same slot
+  list.prev = head->prev;
+  list.next = head->next;
+  list.prev->next = &list;
+  list.next->prev = &list;
+  list_init(head);
+
+  while (!list_empty(&list)) {
+    Node *node = list.next;
+    list_unlink(node);
+    m_level_count[level]--;
+    link(node);
+  }
+}
+
+
+void TimerWheel::expire_slot(size_t slot) {
+  Node *head = &m_slots[0][slot];
+  while (!list_empty(head)) {
+    Node *node = head->next;
+    list_unlink(node);
+    m_level_count[0]--;
+    node->level = LEVELS;
+    list_append(&m_expired, node);
+    m_level_count[LEVELS]++;
+  }
+}
@@ -0,0 +1,176 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for TimerWheel.
+ * This file contains type declarations for TimerWheel, a hierarchical timing
+ * wheel used to track request timeouts and timers.
+ */
+
+#ifndef HYPERTABLE_TIMERWHEEL_H
+#define HYPERTABLE_TIMERWHEEL_H
+
+#include <boost/thread/xtime.hpp>
+
+namespace Hypertable {
+
+  /** @addtogroup AsyncComm
+   *  @{
+   */
+
+  /** Hierarchical timing wheel.
+   * Time is divided into ticks of #TICK_MILLIS milliseconds.  The wheel
+   * consists of #LEVELS levels of #SLOTS slots each; a slot at level
+   * <i>l</i> spans SLOTS<sup>l</sup> ticks.  An entry is placed in the lowest
+   * level whose range covers its expiration tick, so insertion and removal
+   * are O(1).  As the current tick advances past a slot boundary at level
+   * <i>l</i>, the entries of the corresponding slot at level <i>l+1</i> are
+   * redistributed (cascaded) into the lower levels.  Entries are never
+   * reported as expired before their expiration time, and may be reported up
+   * to one tick late, which coalesces wakeups for nearby deadlines.  Entries
+   * expiring in the same tick are reported in insertion order.
+   *
+   * The wheel does not own its entries.  Objects to be tracked derive from
+   * TimerWheel::Node.  This class is not thread safe.
+   */
+  class TimerWheel {
+
+  public:
+
+    enum {
+      TICK_MILLIS = 10, //!< Length of a tick in milliseconds
+      SLOT_BITS = 8,    //!< log2 of #SLOTS
+      SLOTS = 256,      //!< Slots per level
+      LEVELS = 4        //!< Number of levels
+    };
+
+    /** Wheel entry.  Entries are linked into circular doubly-linked slot
+     * lists so that they can be unlinked without knowing which slot they
+     * live in.
+     */
+    struct Node {
+      Node() : prev(0), next(0), tick(0), level(0) { }
+      Node *prev;    //!< Previous entry in slot list
+      Node *next;    //!< Next entry in slot list
+      int64_t tick;  //!< Expiration tick
+      int level;     //!< Wheel level, or #LEVELS if expired
+    };
+
+    /// Constructor.
+    TimerWheel();
+
+    /** Inserts an entry.
+     * @param node Entry to insert (must not already be in the wheel)
+     * @param expire Absolute expiration time
+     */
+    void insert(Node *node, const boost::xtime &expire);
+
+    /** Removes an entry.  Does nothing if <code>node</code> is not in the
+     * wheel.
+     * @param node Entry to remove
+     */
+    void remove(Node *node);
+
+    /** Removes and returns the next expired entry.  Advances the wheel to
+     * <code>now</code>, cascading higher level slots as needed, then unlinks
+     * and returns the first entry whose expiration time is at or before
+     * <code>now</code>.
+     * @param now Current time
+     * @return Expired entry, or 0 if there are none
+     */
+    Node *next_expired(const boost::xtime &now);
+
+    /** Returns the time at which the wheel next needs attention.  This is
+     * either the expiration tick of the earliest entry in the lowest level
+     * or, if the lowest level is empty, the tick at which the earliest
+     * non-empty higher level slot gets cascaded.  It is always later than
+     * the time passed to the last call to #next_expired.
+     * @param expire Set to the next wakeup time
+     * @return <i>false</i> if the wheel is empty, <i>true</i> otherwise
+     */
+    bool next_wakeup(boost::xtime &expire);
+
+    /** Checks if the wheel is empty.
+     * @return <i>true</i> if there are no entries in the wheel
+     */
+    bool empty() const { return m_count == 0; }
+
+    /** Returns the number of entries in the wheel.
+     * @return Entry count
+     */
+    size_t size() const { return m_count; }
+
+    /** Converts an absolute time into a tick.
+     * @param t Absolute time
+     * @param round_up Round up to the next tick boundary
+     * @return Tick corresponding to <code>t</code>
+     */
+    static int64_t to_tick(const boost::xtime &t, bool round_up);
+
+    /** Converts a tick into an absolute time.
+     * @param tick Tick
+     * @param t Set to the time at which <code>tick</code> begins
+     */
+    static void from_tick(int64_t tick, boost::xtime &t);
+
+  private:
+
+    /** Links an entry into the slot for its tick.
+     * @param node Entry to link
+     */
+    void link(Node *node);
+
+    /** Advances #m_current_tick by one tick, cascading higher level slots
+     * and moving expired entries to #m_expired.
+     */
+    void advance();
+
+    /** Redistributes the entries of the current slot at <code>level</code>.
+     * @param level Wheel level to cascade
+     */
+    void cascade(int level);
+
+    /** Moves all entries in slot <code>slot</code> of level 0 to the tail
+     * of #m_expired.
+     * @param slot Slot index
+     */
+    void expire_slot(size_t slot);
+
+    /// Slot list heads
+    Node m_slots[LEVELS][SLOTS];
+
+    /// Entries that have expired and not yet been returned
+    Node m_expired;
+
+    /// Current tick
+    int64_t m_current_tick;
+
+    /// Number of entries in each level (last element counts #m_expired)
+    size_t m_level_count[LEVELS+1];
+
+    /// Number of entries in the wheel
+    size_t m_count;
+  };
+
+  /** @}*/
+}
+
+#endif // HYPERTABLE_TIMERWHEEL_H
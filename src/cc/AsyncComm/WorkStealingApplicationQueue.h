@@ -0,0 +1,537 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for WorkStealingApplicationQueue.
+ * This file contains type declarations for WorkStealingApplicationQueue, an
+ * application queue that distributes requests over per-worker deques.
+ */
+
+#ifndef HYPERTABLE_WORKSTEALINGAPPLICATIONQUEUE_H
+#define HYPERTABLE_WORKSTEALINGAPPLICATIONQUEUE_H
+
+#include <cassert>
+#include <deque>
+#include <list>
+#include <vector>
+
+#include <boost/thread/condition.hpp>
+#include <boost/thread/xtime.hpp>
+
+#include "Common/atomic.h"
+#include "Common/Thread.h"
+#include "Common/Mutex.h"
+#include "Common/HashMap.h"
+#include "Common/Logger.h"
+
+#include "ApplicationQueue.h"
+#include "ApplicationHandler.h"
+
+namespace Hypertable {
+
+  /** @addtogroup AsyncComm
+   *  @{
+   */
+
+  /**
+   * Work-stealing application queue.
+   * Drop-in replacement for ApplicationQueue that avoids funneling every
+   * request through a single mutex and condition variable.  Each worker
+   * thread owns a deque of pending requests.  Incoming requests are
+   * distributed round-robin over the worker deques, a worker takes requests
+   * from the front of its own deque and, when that deque is empty, steals
+   * from the back of the other workers' deques.  The shared mutex and
+   * condition are only touched when a worker runs out of work and goes to
+   * sleep, or when a request is added while some worker is asleep.
+   *
+   * <b>Groups</b>
+   *
+   * Requests with the same group ID are executed in series, in arrival order,
+   * as with ApplicationQueue.  Only one request per group is ever present in
+   * the worker deques; the rest wait in the GroupState pending list and are
+   * handed to the completing worker's own deque, one at a time, as their
+   * predecessor finishes.  Expired requests waiting behind a running group
+   * member are discarded.
+   *
+   * <b>Prioritization</b>
+   *
+   * Urgent requests are placed on a separate shared queue that every worker
+   * checks before its own deque.  They are executed even when the queue is
+   * paused, and if no worker is idle when one arrives a temporary thread is
+   * created to carry it out (unless dynamic threads are disabled).
+   */
+  class WorkStealingApplicationQueue : public ApplicationQueue {
+
+    class RequestRec;
+
+    /** Tracks group execution state.
+     * A GroupState object exists for each group that has a request either
+     * queued in a worker deque or executing.  Requests that arrive for the
+     * group in the meantime are held in #pending.
+     */
+    class GroupState {
+    public:
+      GroupState() : group_id(0) { return; }
+      uint64_t group_id;    //!< Group ID
+      /// Requests waiting for the currently scheduled group member to finish
+      std::list<RequestRec *> pending;
+    };
+
+    /** Hash map of thread group ID to GroupState
+     */
+    typedef hash_map<uint64_t, GroupState *> GroupStateMap;
+
+    /** Request record.
+     */
+    class RequestRec {
+    public:
+      RequestRec(ApplicationHandler *arh) : handler(arh), group_state(0) { return; }
+      ~RequestRec() { delete handler; }
+      ApplicationHandler *handler; //!< Pointer to ApplicationHandler
+      GroupState *group_state;     //!< Pointer to GroupState to which request belongs
+    };
+
+    /** Request deque
+     */
+    typedef std::deque<RequestRec *> RequestDeque;
+
+    /** Per-worker request deque.
+     */
+    class WorkerDeque {
+    public:
+      /// %Mutex protecting #requests
+      Mutex mutex;
+      /// Pending requests
+      RequestDeque requests;
+    };
+
+    /** Application queue state shared among worker threads.
+     */
+    class ApplicationQueueState {
+    public:
+      ApplicationQueueState() : threads_total(0), shutdown(false),
+                                paused(false) {
+        atomic_set(&pending, 0);
+        atomic_set(&urgent_pending, 0);
+        atomic_set(&threads_available, 0);
+        atomic_set(&next_deque, 0);
+      }
+
+      /// Per-worker request deques
+      std::vector<WorkerDeque *> deques;
+
+      /// Number of requests in #deques
+      atomic_t pending;
+
+      /// Round-robin counter for distributing new requests over #deques
+      atomic_t next_deque;
+
+      /// Urgent request queue
+      RequestDeque urgent_queue;
+
+      /// %Mutex protecting #urgent_queue
+      Mutex urgent_mutex;
+
+      /// Number of requests in #urgent_queue
+      atomic_t urgent_pending;
+
+      /// Group ID to group state map
+      GroupStateMap group_state_map;
+
+      /// %Mutex protecting #group_state_map and GroupState objects
+      Mutex group_mutex;
+
+      /// %Mutex for idle worker bookkeeping
+      Mutex mutex;
+
+      /// Condition variable to signal pending handlers to idle workers
+      boost::condition cond;
+
+      /// Condition variable used to signal <i>quiesced</i> queue
+      boost::condition quiesce_cond;
+
+      /// Idle thread count
+      atomic_t threads_available;
+
+      /// Total initial threads
+      size_t threads_total;
+
+      /// Flag indicating if shutdown is in progress
+      volatile bool shutdown;
+
+      /// Flag indicating if queue has been paused
+      volatile bool paused;
+
+      /** Checks if there is work an idle worker could pick up.
+       * @return <i>true</i> if an urgent request is queued or the queue is
+       * not paused and a normal request is queued
+       */
+      bool has_work() {
+        return atomic_read(&urgent_pending) > 0 ||
+          (!paused && atomic_read(&pending) > 0);
+      }
+
+      /** Wakes up an idle worker, if there is one.
+       */
+      void wakeup() {
+        if (atomic_read(&threads_available) > 0) {
+          ScopedLock lock(mutex);
+          cond.notify_one();
+        }
+      }
+
+      /** Queues a request that is ready to run.  Urgent requests are added
+       * to #urgent_queue, others to the deque with index <code>index</code>.
+       * @param rec Request record to enqueue
+       * @param index Index of deque to add <code>rec</code> to
+       * @param front Add to the front of the deque instead of the back
+       */
+      void enqueue(RequestRec *rec, size_t index, bool front=false) {
+        if (rec->handler->is_urgent()) {
+          ScopedLock lock(urgent_mutex);
+          urgent_queue.push_back(rec);
+          atomic_inc(&urgent_pending);
+        }
+        else {
+          WorkerDeque *deque = deques[index % deques.size()];
+          ScopedLock lock(deque->mutex);
+          if (front)
+            deque->requests.push_front(rec);
+          else
+            deque->requests.push_back(rec);
+          atomic_inc(&pending);
+        }
+        wakeup();
+      }
+
+      /** Fetches the next request to run.  The urgent queue is checked
+       * first, then (if not paused) the front of deque <code>index</code>,
+       * then the back of every other deque.
+       * @param index Index of calling worker's deque
+       * @param urgent_only Only consider urgent requests
+       * @return Request record, or 0 if none available
+       */
+      RequestRec *dequeue(size_t index, bool urgent_only) {
+        RequestRec *rec;
+
+        if (atomic_read(&urgent_pending) > 0) {
+          ScopedLock lock(urgent_mutex);
+          if (!urgent_queue.empty()) {
+            rec = urgent_queue.front();
+            urgent_queue.pop_front();
+            atomic_dec(&urgent_pending);
+            return rec;
+          }
+        }
+
+        if (urgent_only || paused)
+          return 0;
+
+        for (size_t i=0; i<deques.size(); i++) {
+          if (atomic_read(&pending) == 0)
+            break;
+          WorkerDeque *deque = deques[(index+i) % deques.size()];
+          ScopedLock lock(deque->mutex);
+          if (!deque->requests.empty()) {
+            if (i == 0) {
+              rec = deque->requests.front();
+              deque->requests.pop_front();
+            }
+            else {
+              rec = deque->requests.back();
+              deque->requests.pop_back();
+            }
+            atomic_dec(&pending);
+            return rec;
+          }
+        }
+        return 0;
+      }
+    };
+
+    /** Application queue worker thread function (functor)
+     */
+    class Worker {
+
+    public:
+      Worker(ApplicationQueueState &qstate, size_t index, bool one_shot=false)
+        : m_state(qstate), m_index(index), m_one_shot(one_shot) { return; }
+
+      /** Thread run method
+       */
+      void operator()() {
+        RequestRec *rec;
+
+        while (!m_state.shutdown) {
+
+          if ((rec = m_state.dequeue(m_index, m_one_shot)) != 0) {
+            if (rec->handler)
+              rec->handler->run();
+            remove(rec);
+            if (m_one_shot)
+              return;
+            continue;
+          }
+
+          if (m_one_shot)
+            return;
+
+          {
+            ScopedLock lock(m_state.mutex);
+            atomic_inc(&m_state.threads_available);
+            while (!m_state.shutdown && !m_state.has_work()) {
+              if ((size_t)atomic_read(&m_state.threads_available) ==
+                  m_state.threads_total)
+                m_state.quiesce_cond.notify_all();
+              m_state.cond.wait(lock);
+            }
+            atomic_dec(&m_state.threads_available);
+          }
+        }
+      }
+
+    private:
+
+      /** Removes and deletes a request.  If <code>rec</code> belongs to a
+       * group, the next non-expired request waiting in the group's pending
+       * list is pushed onto the front of this worker's deque.  If there is
+       * none, the group state record is removed from
+       * ApplicationQueueState::group_state_map and is deleted.
+       * @param rec Request record to remove
+       */
+      void remove(RequestRec *rec) {
+        RequestRec *next = 0;
+        if (rec->group_state) {
+          ScopedLock lock(m_state.group_mutex);
+          GroupState *group_state = rec->group_state;
+          while (!group_state->pending.empty()) {
+            next = group_state->pending.front();
+            group_state->pending.pop_front();
+            if (next->handler && !next->handler->is_expired())
+              break;
+            delete next;
+            next = 0;
+          }
+          if (next == 0) {
+            m_state.group_state_map.erase(group_state->group_id);
+            delete group_state;
+          }
+        }
+        delete rec;
+        if (next)
+          m_state.enqueue(next, m_index, true);
+      }
+
+      /// Shared application queue state object
+      ApplicationQueueState &m_state;
+
+      /// Index of this worker's deque
+      size_t m_index;
+
+      /// Set to <i>true</i> if thread should exit after executing request
+      bool m_one_shot;
+    };
+
+    /// Application queue state object
+    ApplicationQueueState m_state;
+
+    /// Boost thread group for managing threads
+    ThreadGroup m_threads;
+
+    /// Vector of thread IDs
+    std::vector<Thread::id> m_thread_ids;
+
+    /// Flag indicating if threads have joined after a shutdown
+    bool m_joined;
+
+    /** Set to <i>true</i> if queue is configured to allow dynamic thread
+     * creation
+     */
+    bool m_dynamic_threads;
+
+  public:
+
+    /**
+     * Constructor initialized with worker thread count.
+     * This constructor sets up the application queue with a number of worker
+     * threads specified by <code>worker_count</code>, each with its own
+     * request deque.
+     * @param worker_count Number of worker threads to create
+     * @param dynamic_threads Dynamically create temporary thread to carry out
+     * urgent requests if none available.
+     */
+    WorkStealingApplicationQueue(int worker_count, bool dynamic_threads=true)
+      : m_joined(false), m_dynamic_threads(dynamic_threads) {
+      assert (worker_count > 0);
+      m_state.threads_total = worker_count;
+      for (int i=0; i<worker_count; ++i)
+        m_state.deques.push_back(new WorkerDeque());
+      for (int i=0; i<worker_count; ++i) {
+        Worker worker(m_state, i);
+        m_thread_ids.push_back(m_threads.create_thread(worker)->get_id());
+      }
+    }
+
+    /** Destructor.  Shuts down and joins the worker threads if necessary
+     * and deletes any requests that were never carried out.
+     */
+    virtual ~WorkStealingApplicationQueue() {
+      if (!m_joined) {
+        shutdown();
+        join();
+      }
+      foreach_ht (WorkerDeque *deque, m_state.deques) {
+        foreach_ht (RequestRec *rec, deque->requests)
+          delete rec;
+        delete deque;
+      }
+      foreach_ht (RequestRec *rec, m_state.urgent_queue)
+        delete rec;
+      for (GroupStateMap::iterator iter = m_state.group_state_map.begin();
+           iter != m_state.group_state_map.end(); ++iter) {
+        foreach_ht (RequestRec *rec, iter->second->pending)
+          delete rec;
+        delete iter->second;
+      }
+    }
+
+    /**
+     * Returns all the thread IDs for this threadgroup
+     * @return vector of Thread::id
+     */
+    virtual std::vector<Thread::id> get_thread_ids() const {
+      return m_thread_ids;
+    }
+
+    /**
+     * Shuts down the application queue.  Worker threads exit after finishing
+     * the request they are currently executing.  #join can be called to wait
+     * for completion of the shutdown.
+     */
+    virtual void shutdown() {
+      ScopedLock lock(m_state.mutex);
+      m_state.shutdown = true;
+      m_state.cond.notify_all();
+    }
+
+    /** Wait for queue to become idle (with timeout).
+     * @param deadline Return by this time if queue does not become idle
+     * @param reserve_threads Number of threads that can be active when queue is
+     * idle
+     * @return <i>false</i> if <code>deadline</code> was reached before queue
+     * became idle, <i>true</i> otherwise
+     */
+    virtual bool wait_for_idle(boost::xtime &deadline,
+                               int reserve_threads=0) {
+      ScopedLock lock(m_state.mutex);
+      while ((size_t)atomic_read(&m_state.threads_available) <
+             (m_state.threads_total-reserve_threads)) {
+        if (!m_state.quiesce_cond.timed_wait(lock, deadline))
+          return false;
+      }
+      return true;
+    }
+
+    /**
+     * Waits for a shutdown to complete.  This method returns when all
+     * application queue threads exit.
+     */
+    virtual void join() {
+      if (!m_joined) {
+        m_threads.join_all();
+        m_joined = true;
+      }
+    }
+
+    /** Starts application queue.
+     */
+    virtual void start() {
+      ScopedLock lock(m_state.mutex);
+      m_state.paused = false;
+      m_state.cond.notify_all();
+    }
+
+    /** Stops (pauses) application queue, preventing non-urgent requests from
+     * being executed.  Any requests that are being executed at the time of the
+     * call are allowed to complete.
+     */
+    virtual void stop() {
+      ScopedLock lock(m_state.mutex);
+      m_state.paused = true;
+    }
+
+    /** Adds a request (application request handler) to the application queue.
+     * If the request belongs to a group that already has a request queued or
+     * executing, it is appended to the group's pending list.  Otherwise it
+     * is added to the urgent queue or to one of the worker deques.
+     * @param app_handler Pointer to request to add
+     */
+    virtual void add(ApplicationHandler *app_handler) {
+      GroupStateMap::iterator uiter;
+      uint64_t group_id;
+      bool urgent;
+      RequestRec *rec;
+
+      HT_ASSERT(app_handler);
+
+      group_id = app_handler->get_group_id();
+      urgent = app_handler->is_urgent();
+      rec = new RequestRec(app_handler);
+
+      if (group_id != 0) {
+        ScopedLock ulock(m_state.group_mutex);
+        if ((uiter = m_state.group_state_map.find(group_id))
+            != m_state.group_state_map.end()) {
+          rec->group_state = (*uiter).second;
+          rec->group_state->pending.push_back(rec);
+          return;
+        }
+        rec->group_state = new GroupState();
+        rec->group_state->group_id = group_id;
+        m_state.group_state_map[group_id] = rec->group_state;
+      }
+
+      // rec may be carried out and deleted as soon as it is enqueued
+      m_state.enqueue(rec, (unsigned)atomic_inc_return(&m_state.next_deque));
+
+      if (urgent && m_dynamic_threads &&
+          atomic_read(&m_state.threads_available) == 0) {
+        Worker worker(m_state, 0, true);
+        Thread t(worker);
+      }
+    }
+
+    /** Adds a request (application request handler) to the application queue.
+     * @note This method is defined for symmetry and just calls #add
+     * @param app_handler Pointer to request to add
+     */
+    virtual void add_unlocked(ApplicationHandler *app_handler) {
+      add(app_handler);
+    }
+  };
+
+  /// Smart pointer to WorkStealingApplicationQueue object
+  typedef boost::intrusive_ptr<WorkStealingApplicationQueue>
+          WorkStealingApplicationQueuePtr;
+  /** @}*/
+} // namespace Hypertable
+
+#endif // HYPERTABLE_WORKSTEALINGAPPLICATIONQUEUE_H
@@ -71,6 +71,7 @@ namespace {
     "  --reactors=<n>  Specifies the number of reactors (default=1)",
     "  --delay=<ms>    Milliseconds to wait before echoing message (default=0)",
     "  --udp           Operate in UDP mode instead of TCP",
+    "  --io-uring      Use io_uring for data connections",
     "  --verbose,-v    Generate verbose output",
     ""
     "This is a sample program to test the AsyncComm library.  It establishes",
@@ -256,6 +257,8 @@ int main(int argc, char **argv) {
       g_delay = atoi(&argv[i][8]);
     else if (!strcmp(argv[i], "--udp"))
       udp = true;
+    else if (!strcmp(argv[i], "--io-uring"))
+      Config::properties->set("Comm.UseIoUring", true);
     else if (!strcmp(argv[i], "--verbose") || !strcmp(argv[i], "-v"))
       g_verbose = true;
     else
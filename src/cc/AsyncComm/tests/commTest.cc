@@ -51,7 +51,7 @@ using namespace Hypertable;
 
 namespace {
   const char *usage[] = {
-    "usage: commTest",
+    "usage: commTest [--Comm.UseIoUring=true]",
     "",
     "This program ...",
     0
@@ -62,10 +62,10 @@ namespace {
 
   class ServerLauncher {
   public:
-    ServerLauncher() {
+    ServerLauncher(bool io_uring) {
       if ((m_child_pid = fork()) == 0) {
         execl("./testServer", "./testServer", DEFAULT_PORT_ARG, "--app-queue",
-              (char *)0);
+              io_uring ? "--io-uring" : (char *)0, (char *)0);
       }
       poll(0,0,2000);
     }
@@ -83,15 +83,18 @@ namespace {
 int main(int argc, char **argv) {
   boost::thread  *thread1, *thread2;
   struct sockaddr_in addr;
-  ServerLauncher slauncher;
   Comm *comm;
   ConnectionManagerPtr conn_mgr;
 
   Config::init(argc, argv);
 
-  if (argc != 1)
+  bool io_uring = Config::properties->get_bool("Comm.UseIoUring");
+
+  if (argc != (io_uring ? 2 : 1))
     Usage::dump_and_exit(usage);
 
+  ServerLauncher slauncher(io_uring);
+
   srand(8876);
 
   System::initialize(System::locate_install_dir(argv[0]));
@@ -0,0 +1,196 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+
+extern "C" {
+#include <poll.h>
+}
+
+#include "Common/Init.h"
+#include "Common/Logger.h"
+#include "Common/Mutex.h"
+#include "Common/Usage.h"
+
+#include "AsyncComm/ApplicationQueue.h"
+#include "AsyncComm/WorkStealingApplicationQueue.h"
+#include "AsyncComm/Event.h"
+
+using namespace std;
+using namespace Hypertable;
+
+namespace {
+  const char *usage[] = {
+    "usage: commTestApplicationQueue",
+    "",
+    "This program tests ApplicationQueue and WorkStealingApplicationQueue",
+    "request execution, group serialization and urgent requests.",
+    0
+  };
+
+  const int GROUPS = 8;
+  const int REQUESTS_PER_GROUP = 250;
+
+  /** Shared state updated by the test handlers
+   */
+  struct TestState {
+    TestState() : completed(0), failed(false) {
+      for (int i=0; i<=GROUPS; i++) {
+        last_seq[i] = -1;
+        running[i] = false;
+      }
+    }
+    Mutex mutex;
+    int completed;
+    int last_seq[GROUPS+1];
+    bool running[GROUPS+1];
+    bool failed;
+  };
+
+  /** Handler that verifies it runs in series, and in order, with the
+   * other handlers of its group.
+   */
+  class TestHandler : public ApplicationHandler {
+  public:
+    TestHandler(EventPtr &event, TestState &state, int group, int seq)
+      : ApplicationHandler(event), m_state(state), m_group(group),
+        m_seq(seq) { }
+
+    TestHandler(TestState &state, bool urgent)
+      : ApplicationHandler(urgent), m_state(state), m_group(0), m_seq(0) { }
+
+    virtual void run() {
+      if (m_group) {
+        ScopedLock lock(m_state.mutex);
+        if (m_state.running[m_group] ||
+            m_state.last_seq[m_group] != m_seq-1) {
+          HT_ERRORF("Group %d request %d out of order (last=%d running=%s)",
+                    m_group, m_seq, m_state.last_seq[m_group],
+                    m_state.running[m_group] ? "true" : "false");
+          m_state.failed = true;
+        }
+        m_state.running[m_group] = true;
+      }
+      if ((m_seq % 16) == 0)
+        poll(0, 0, 1);
+      ScopedLock lock(m_state.mutex);
+      if (m_group) {
+        m_state.running[m_group] = false;
+        m_state.last_seq[m_group] = m_seq;
+      }
+      m_state.completed++;
+    }
+
+  private:
+    TestState &m_state;
+    int m_group;
+    int m_seq;
+  };
+
+  bool wait_for_completed(TestState &state, int count) {
+    for (int i=0; i<10000; i++) {
+      {
+        ScopedLock lock(state.mutex);
+        if (state.completed >= count)
+          return state.completed == count;
+      }
+      poll(0, 0, 1);
+    }
+    return false;
+  }
+
+  void test_groups(ApplicationQueuePtr app_queue) {
+    TestState state;
+    int total = 0;
+
+    for (int seq=0; seq<REQUESTS_PER_GROUP; seq++) {
+      for (int group=0; group<=GROUPS; group++) {
+        EventPtr event = new Event(Event::MESSAGE);
+        event->group_id = group;
+        app_queue->add(new TestHandler(event, state, group, seq));
+        total++;
+      }
+    }
+
+    HT_ASSERT(wait_for_completed(state, total));
+    HT_ASSERT(!state.failed);
+    for (int group=1; group<=GROUPS; group++)
+      HT_ASSERT(state.last_seq[group] == REQUESTS_PER_GROUP-1);
+  }
+
+  void test_urgent(ApplicationQueuePtr app_queue) {
+    TestState state;
+
+    app_queue->stop();
+    for (int i=0; i<10; i++)
+      app_queue->add(new TestHandler(state, false));
+    for (int i=0; i<5; i++)
+      app_queue->add(new TestHandler(state, true));
+
+    // Only urgent requests run while the queue is stopped
+    HT_ASSERT(wait_for_completed(state, 5));
+    poll(0, 0, 100);
+    {
+      ScopedLock lock(state.mutex);
+      HT_ASSERT(state.completed == 5);
+    }
+
+    app_queue->start();
+    HT_ASSERT(wait_for_completed(state, 15));
+  }
+
+  void test_idle(ApplicationQueuePtr app_queue) {
+    boost::xtime deadline;
+    boost::xtime_get(&deadline, boost::TIME_UTC_);
+    deadline.sec += 10;
+    HT_ASSERT(app_queue->wait_for_idle(deadline));
+  }
+
+  void run_tests(ApplicationQueuePtr app_queue) {
+    test_groups(app_queue);
+    test_urgent(app_queue);
+    test_idle(app_queue);
+    app_queue->shutdown();
+    app_queue->join();
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  Config::init(argc, argv);
+
+  if (argc > 1)
+    Usage::dump_and_exit(usage);
+
+  HT_INFO("Testing ApplicationQueue");
+  run_tests(new ApplicationQueue(4));
+
+  HT_INFO("Testing WorkStealingApplicationQueue");
+  run_tests(new WorkStealingApplicationQueue(4));
+
+  HT_INFO("Testing WorkStealingApplicationQueue (single worker)");
+  run_tests(new WorkStealingApplicationQueue(1, false));
+
+  return 0;
+}
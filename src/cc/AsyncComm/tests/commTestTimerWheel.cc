@@ -0,0 +1,156 @@
+/* -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <vector>
+
+#include "Common/Init.h"
+#include "Common/Logger.h"
+#include "Common/Usage.h"
+
+#include "AsyncComm/TimerWheel.h"
+
+using namespace std;
+using namespace Hypertable;
+
+namespace {
+  const char *usage[] = {
+    "usage: commTestTimerWheel",
+    "",
+    "This program tests the TimerWheel used for request timeouts and timers.",
+    0
+  };
+
+  struct TestNode : public TimerWheel::Node {
+    boost::xtime expire;
+    bool removed;
+    bool fired;
+  };
+
+  void add_millis(boost::xtime &t, int64_t millis) {
+    int64_t nanos = (int64_t)t.nsec + (millis % 1000) * 1000000LL;
+    t.sec += millis / 1000 + nanos / 1000000000LL;
+    t.nsec = nanos % 1000000000LL;
+  }
+
+  /**
+   * Inserts nodes with random expiration times spread over several wheel
+   * levels, removes a random subset, then steps simulated time forward and
+   * checks that each remaining node fires exactly once, never early and at
+   * most one tick late, and that next_wakeup never skips past a deadline.
+   */
+  void test_random(int count, int64_t max_millis) {
+    vector<TestNode> nodes(count);
+    TimerWheel wheel;
+    boost::xtime start, now, wakeup;
+    int expected = 0, fired = 0;
+
+    boost::xtime_get(&start, boost::TIME_UTC_);
+
+    for (int i=0; i<count; i++) {
+      nodes[i].expire = start;
+      add_millis(nodes[i].expire, 1 + random() % max_millis);
+      nodes[i].removed = false;
+      nodes[i].fired = false;
+      wheel.insert(&nodes[i], nodes[i].expire);
+    }
+
+    for (int i=0; i<count; i++) {
+      if ((random() % 4) == 0) {
+        wheel.remove(&nodes[i]);
+        nodes[i].removed = true;
+      }
+      else
+        expected++;
+    }
+
+    HT_ASSERT(wheel.size() == (size_t)expected);
+
+    now = start;
+    while (!wheel.empty()) {
+      HT_ASSERT(wheel.next_wakeup(wakeup));
+      HT_ASSERT(xtime_cmp(wakeup, now) > 0);
+
+      // Jump straight to the reported wakeup; nothing may expire before it
+      now = wakeup;
+
+      TimerWheel::Node *node;
+      while ((node = wheel.next_expired(now)) != 0) {
+        TestNode *tn = static_cast<TestNode *>(node);
+        HT_ASSERT(!tn->removed && !tn->fired);
+        HT_ASSERT(xtime_cmp(tn->expire, now) <= 0);
+        boost::xtime late = tn->expire;
+        add_millis(late, TimerWheel::TICK_MILLIS);
+        HT_ASSERT(xtime_cmp(now, late) <= 0);
+        tn->fired = true;
+        fired++;
+      }
+    }
+
+    HT_ASSERT(fired == expected);
+  }
+
+  /**
+   * Checks that entries expiring in the same tick come out in insertion
+   * order, including after being cascaded from a higher level.
+   */
+  void test_order() {
+    TestNode nodes[4];
+    TimerWheel wheel;
+    boost::xtime start, expire, now;
+
+    boost::xtime_get(&start, boost::TIME_UTC_);
+    expire = start;
+    add_millis(expire, 60000);
+
+    for (int i=0; i<4; i++) {
+      nodes[i].fired = false;
+      wheel.insert(&nodes[i], expire);
+    }
+
+    now = expire;
+    add_millis(now, TimerWheel::TICK_MILLIS);
+    for (int i=0; i<4; i++)
+      HT_ASSERT(wheel.next_expired(now) == &nodes[i]);
+    HT_ASSERT(wheel.next_expired(now) == 0);
+    HT_ASSERT(wheel.empty());
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  Config::init(argc, argv);
+
+  if (argc > 1)
+    Usage::dump_and_exit(usage);
+
+  srandom(8876);
+
+  test_order();
+  test_random(1000, 2000);
+  test_random(10000, 600000);
+  test_random(1000, 86400000);
+
+  return 0;
+}
@@ -24,6 +24,8 @@
  * A bloom filter is a probabilistic datastructure (see
  * http://en.wikipedia.org/wiki/Bloom_filter). It's used in CellStores to speed
  * up database queries. This bloom filter stores additional checksums.
+ * It can optionally be "blocked", i.e. all bits of a key are placed in the
+ * same 64-byte block so that a lookup touches a single cache line.
  */
 
 #ifndef HYPERTABLE_BLOOM_FILTER_WITH_CHECKSUM_H
@@ -40,6 +42,10 @@
 #include "Common/StringExt.h"
 #include "Common/System.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace Hypertable {
 
 /** @addtogroup Common
@@ -53,14 +59,24 @@ namespace Hypertable {
 template <class HasherT = MurmurHash2>
 class BasicBloomFilterWithChecksum {
 public:
+  /** Bit layout of the filter */
+  enum Mode {
+    /** Probes of a key are spread over the whole bit array */
+    STANDARD = 0,
+    /** Probes of a key are confined to one 64-byte block (cache line) */
+    BLOCKED = 1
+  };
+
   /**
    * Constructor
    *
    * @param items_estimate An estimated number of items that will be inserted
    * @param false_positive_prob The probability for false positives
+   * @param mode Bit layout of the filter
    */
   BasicBloomFilterWithChecksum(size_t items_estimate,
-          float false_positive_prob) {
+          float false_positive_prob, Mode mode = STANDARD) {
+    m_blocked = mode == BLOCKED;
     m_items_actual = 0;
     m_items_estimate = items_estimate;
     m_false_positive_prob = false_positive_prob;
@@ -72,10 +88,7 @@ public:
               "Num elements=%lu false_positive_prob=%.3f",
               (Lu)items_estimate, false_positive_prob);
     }
-    m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
-    m_bloom_base = new uint8_t[total_size()];
-    m_bloom_bits = m_bloom_base + 4;
-    memset(m_bloom_base, 0, total_size());
+    allocate();
 
     HT_DEBUG_OUT << "num funcs=" << m_num_hash_functions << " num bits="
         << m_num_bits << " num bytes= " << m_num_bytes << " bits per element="
@@ -88,9 +101,11 @@ public:
    * @param items_estimate An estimated number of items that will be inserted
    * @param bits_per_item Average bits per item
    * @param num_hashes Number of hash functions for the filter
+   * @param mode Bit layout of the filter
    */
   BasicBloomFilterWithChecksum(size_t items_estimate, float bits_per_item,
-          size_t num_hashes) {
+          size_t num_hashes, Mode mode = STANDARD) {
+    m_blocked = mode == BLOCKED;
     m_items_actual = 0;
     m_items_estimate = items_estimate;
     m_false_positive_prob = 0.0;
@@ -100,10 +115,7 @@ public:
       HT_THROWF(Error::EMPTY_BLOOMFILTER, "Num elements=%lu bits_per_item=%.3f",
               (Lu)items_estimate, bits_per_item);
     }
-    m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
-    m_bloom_base = new uint8_t[total_size()];
-    m_bloom_bits = m_bloom_base + 4;
-    memset(m_bloom_base, 0, total_size());
+    allocate();
 
     HT_DEBUG_OUT << "num funcs=" << m_num_hash_functions << " num bits="
         << m_num_bits << " num bytes=" << m_num_bytes << " bits per element="
@@ -117,9 +129,11 @@ public:
    * @param items_actual Actual number of items
    * @param length Number of bits
    * @param num_hashes Number of hash functions for the filter
+   * @param mode Bit layout of the filter
    */
   BasicBloomFilterWithChecksum(size_t items_estimate, size_t items_actual,
-          int64_t length, size_t num_hashes) {
+          int64_t length, size_t num_hashes, Mode mode = STANDARD) {
+    m_blocked = mode == BLOCKED;
     m_items_actual = items_actual;
     m_items_estimate = items_estimate;
     m_false_positive_prob = 0.0;
@@ -130,10 +144,7 @@ public:
               "Estimated items=%lu actual items=%lu length=%lld num hashes=%lu",
               (Lu)items_estimate, (Lu)items_actual, (Lld)length, (Lu)num_hashes);
     }
-    m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
-    m_bloom_base = new uint8_t[total_size()];
-    m_bloom_bits = m_bloom_base + 4;
-    memset(m_bloom_base, 0, total_size());
+    allocate();
 
     HT_DEBUG_OUT << "num funcs=" << m_num_hash_functions << " num bits="
         << m_num_bits << " num bytes=" << m_num_bytes << " bits per element="
@@ -142,7 +153,7 @@ public:
 
   /** Destructor; releases resources */
   ~BasicBloomFilterWithChecksum() {
-    delete[] m_bloom_base;
+    delete[] m_bloom_alloc;
   }
 
   /* XXX/review static functions to expose the bloom filter parameters, given
@@ -160,6 +171,18 @@ public:
    * @param len Size of the data (in bytes)
    */
   void insert(const void *key, size_t len) {
+    if (m_blocked) {
+      uint32_t hash, delta;
+      uint8_t *block = block_for(key, len, &hash, &delta);
+      for (size_t i = 0; i < m_num_hash_functions; ++i) {
+        uint32_t bit = hash & (BLOCK_BITS - 1);
+        block[bit / CHAR_BIT] |= (1 << (bit % CHAR_BIT));
+        hash += delta;
+      }
+      m_items_actual++;
+      return;
+    }
+
     uint32_t hash = len;
 
     for (size_t i = 0; i < m_num_hash_functions; ++i) {
@@ -189,6 +212,9 @@ public:
    * @return true if the key "may" be contained, otherwise false
    */
   bool may_contain(const void *key, size_t len) const {
+    if (m_blocked)
+      return blocked_may_contain(key, len);
+
     uint32_t hash = len;
     uint8_t byte_mask;
     uint8_t byte;
@@ -217,11 +243,15 @@ public:
   /** Serializes the BloomFilter into a static memory buffer
    *
    * @param buf The static memory buffer
+   * @param checksum_type Checksum algorithm (see ChecksumType)
    */
-  void serialize(StaticBuffer &buf) {
+  void serialize(StaticBuffer &buf,
+                 int checksum_type = CHECKSUM_FLETCHER32) {
     buf.set(m_bloom_base, total_size(), false);
     uint8_t *ptr = buf.base;
-    Serialization::encode_i32(&ptr, fletcher32(m_bloom_bits, m_num_bytes));
+    Serialization::encode_i32(&ptr, compute_checksum(checksum_type,
+                                                     m_bloom_bits,
+                                                     m_num_bytes));
   }
 
   /** Getter for the serialized bloom filter data, including metadata and
@@ -235,14 +265,16 @@ public:
    *
    * @param filename The filename of this BloomFilter; required to calculate
    *        the checksum
+   * @param checksum_type Checksum algorithm the filter was serialized with
    * @throws Error::BLOOMFILTER_CHECKSUM_MISMATCH If the checksum does not
    *        match
    */
-  void validate(String &filename) {
+  void validate(String &filename, int checksum_type = CHECKSUM_FLETCHER32) {
     const uint8_t *ptr = m_bloom_base;
     size_t remain = 4;
     uint32_t stored_checksum = Serialization::decode_i32(&ptr, &remain);
-    uint32_t computed_checksum = fletcher32(m_bloom_bits, m_num_bytes);
+    uint32_t computed_checksum = compute_checksum(checksum_type, m_bloom_bits,
+                                                  m_num_bytes);
     if (stored_checksum != computed_checksum)
       HT_THROW(Error::BLOOMFILTER_CHECKSUM_MISMATCH, filename.c_str());
   }
@@ -286,7 +318,93 @@ public:
    */
   size_t get_items_actual() { return m_items_actual; }
 
+  /** Returns true if this is a cache-line-blocked filter
+   *
+   * @return true if all probes of a key fall into a single 64-byte block
+   */
+  bool is_blocked() { return m_blocked; }
+
 private:
+  /** Size of a block in a blocked filter, in bytes (one cache line) */
+  enum { BLOCK_BYTES = 64, BLOCK_BITS = 512 };
+
+  /** Sizes and allocates the bit array.  For blocked filters, the number
+   * of bits is rounded up to a whole number of blocks and the buffer is
+   * positioned so that the bit array starts on a cache line boundary.
+   */
+  void allocate() {
+    size_t pad = 0;
+    if (m_blocked) {
+      m_num_bits = ((m_num_bits + BLOCK_BITS - 1) / BLOCK_BITS) * BLOCK_BITS;
+      pad = BLOCK_BYTES;
+    }
+    m_num_bytes = (m_num_bits / CHAR_BIT) + (m_num_bits % CHAR_BIT ? 1 : 0);
+    m_bloom_alloc = new uint8_t[total_size() + pad];
+    m_bloom_base = m_bloom_alloc;
+    if (m_blocked) {
+      size_t misalign = (size_t)(m_bloom_alloc + 4) & (BLOCK_BYTES - 1);
+      if (misalign)
+        m_bloom_base += BLOCK_BYTES - misalign;
+    }
+    m_bloom_bits = m_bloom_base + 4;
+    memset(m_bloom_base, 0, total_size());
+  }
+
+  /** Selects the block for a key and computes the double hashing state
+   * used to derive the bit positions within that block.
+   *
+   * @param key Pointer to the key's data
+   * @param len Size of the data (in bytes)
+   * @param hashp Address of variable to hold the first bit hash
+   * @param deltap Address of variable to hold the hash increment
+   * @return Pointer to the 64-byte block for the key
+   */
+  uint8_t *block_for(const void *key, size_t len, uint32_t *hashp,
+                     uint32_t *deltap) const {
+    uint32_t h = m_hasher(key, len, len);
+    size_t block = h % (m_num_bits / BLOCK_BITS);
+    uint32_t hash = m_hasher(key, len, h);
+    *hashp = hash;
+    *deltap = (hash >> 17) | (hash << 15);
+    return m_bloom_bits + block * BLOCK_BYTES;
+  }
+
+  /** Blocked variant of may_contain().  Builds a mask of all of the key's
+   * bits and tests it against the block in one pass.
+   */
+  bool blocked_may_contain(const void *key, size_t len) const {
+    uint32_t hash, delta;
+    const uint8_t *block = block_for(key, len, &hash, &delta);
+#if defined(__SSE2__)
+    __m128i mask[BLOCK_BYTES / 16];
+    uint8_t *mask_bytes = (uint8_t *)mask;
+    memset(mask, 0, sizeof(mask));
+#else
+    uint8_t mask_bytes[BLOCK_BYTES];
+    memset(mask_bytes, 0, sizeof(mask_bytes));
+#endif
+    for (size_t i = 0; i < m_num_hash_functions; ++i) {
+      uint32_t bit = hash & (BLOCK_BITS - 1);
+      mask_bytes[bit / CHAR_BIT] |= (1 << (bit % CHAR_BIT));
+      hash += delta;
+    }
+#if defined(__SSE2__)
+    const __m128i *bits = (const __m128i *)block;
+    __m128i missing = _mm_setzero_si128();
+    for (size_t i = 0; i < BLOCK_BYTES / 16; ++i)
+      missing = _mm_or_si128(missing,
+                             _mm_andnot_si128(_mm_load_si128(bits + i),
+                                              mask[i]));
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(missing, _mm_setzero_si128()))
+        == 0xFFFF;
+#else
+    for (size_t i = 0; i < BLOCK_BYTES; ++i)
+      if ((block[i] & mask_bytes[i]) != mask_bytes[i])
+        return false;
+    return true;
+#endif
+  }
+
   /** The hash function implementation */
   HasherT    m_hasher;
 
@@ -313,6 +431,12 @@ private:
 
   /** The serialized bloom filter data, including metadata and checksums */
   uint8_t   *m_bloom_base;
+
+  /** Allocated buffer holding m_bloom_base */
+  uint8_t   *m_bloom_alloc;
+
+  /** True if all probes of a key fall into one cache line sized block */
+  bool       m_blocked;
 };
 
 typedef BasicBloomFilterWithChecksum<> BloomFilterWithChecksum;
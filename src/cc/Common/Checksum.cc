@@ -19,14 +19,22 @@
 
 /** @file
  * Implementation of checksum routines.
- * This file implements the fletcher32 checksum algorithm.
+ * This file implements the fletcher32 and CRC32C checksum algorithms.
  */
 
 #include "Compat.h"
 #include <arpa/inet.h>
+#include <cstring>
 #include <zlib.h>
 #include "Checksum.h"
 
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HT_CRC32C_HARDWARE 1
+#include <cpuid.h>
+#include <nmmintrin.h>
+#endif
+
 namespace Hypertable {
 
 #define HT_F32_DO1(buf,i) \
@@ -83,6 +91,235 @@ fletcher32(const void *data8, size_t len8) {
   return (sum2 << 16) | sum1;
 }
 
+namespace {
+
+  /// CRC-32C polynomial (reversed)
+  const uint32_t CRC32C_POLY = 0x82f63b78;
+
+  /// Block length of the long three-way parallel hardware loop
+  const size_t CRC32C_LONG = 8192;
+
+  /// Block length of the short three-way parallel hardware loop
+  const size_t CRC32C_SHORT = 256;
+
+  /** Multiplies 32x32 GF(2) matrix <code>mat</code> by vector
+   * <code>vec</code>. */
+  uint32_t gf2_matrix_times(const uint32_t *mat, uint32_t vec) {
+    uint32_t sum = 0;
+    while (vec) {
+      if (vec & 1)
+        sum ^= *mat;
+      vec >>= 1;
+      mat++;
+    }
+    return sum;
+  }
+
+  /// Sets <code>square</code> to the square of GF(2) matrix <code>mat</code>
+  void gf2_matrix_square(uint32_t *square, const uint32_t *mat) {
+    for (int n = 0; n < 32; n++)
+      square[n] = gf2_matrix_times(mat, mat[n]);
+  }
+
+  /** Constructs the operator that applies <code>len</code> zero bytes to a
+   * CRC.  <code>len</code> must be a power of two.
+   */
+  void crc32c_zeros_op(uint32_t *even, size_t len) {
+    uint32_t odd[32];
+    uint32_t row = 1;
+
+    // operator for one zero bit
+    odd[0] = CRC32C_POLY;
+    for (int n = 1; n < 32; n++) {
+      odd[n] = row;
+      row <<= 1;
+    }
+
+    gf2_matrix_square(even, odd);  // two zero bits
+    gf2_matrix_square(odd, even);  // four zero bits
+
+    // keep squaring until len bytes of zeros have been applied
+    do {
+      gf2_matrix_square(even, odd);
+      len >>= 1;
+      if (len == 0)
+        return;
+      gf2_matrix_square(odd, even);
+      len >>= 1;
+    } while (len);
+
+    memcpy(even, odd, sizeof(odd));
+  }
+
+  /** CRC-32C lookup tables.  Built once at static initialization time.
+   */
+  struct Crc32cTables {
+    Crc32cTables() {
+      uint32_t crc, op[32];
+
+      for (uint32_t n = 0; n < 256; n++) {
+        crc = n;
+        for (int k = 0; k < 8; k++)
+          crc = (crc & 1) ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+        slice[0][n] = crc;
+      }
+      for (uint32_t n = 0; n < 256; n++) {
+        crc = slice[0][n];
+        for (int k = 1; k < 8; k++) {
+          crc = slice[0][crc & 0xff] ^ (crc >> 8);
+          slice[k][n] = crc;
+        }
+      }
+
+      crc32c_zeros_op(op, CRC32C_LONG);
+      for (uint32_t n = 0; n < 256; n++)
+        for (int k = 0; k < 4; k++)
+          long_shift[k][n] = gf2_matrix_times(op, n << (8 * k));
+
+      crc32c_zeros_op(op, CRC32C_SHORT);
+      for (uint32_t n = 0; n < 256; n++)
+        for (int k = 0; k < 4; k++)
+          short_shift[k][n] = gf2_matrix_times(op, n << (8 * k));
+
+      hardware = false;
+#if defined(HT_CRC32C_HARDWARE)
+      unsigned int eax, ebx, ecx, edx;
+      if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2))
+        hardware = true;
+#endif
+    }
+
+    /// Slicing-by-8 tables for the software implementation
+    uint32_t slice[8][256];
+
+    /// Tables that apply CRC32C_LONG zero bytes to a CRC
+    uint32_t long_shift[4][256];
+
+    /// Tables that apply CRC32C_SHORT zero bytes to a CRC
+    uint32_t short_shift[4][256];
+
+    /// Set to true if the processor supports SSE4.2
+    bool hardware;
+  };
+
+  Crc32cTables crc32c_tables;
+
+  /** Applies the zero-byte operator in <code>table</code> to
+   * <code>crc</code>. */
+  inline uint32_t crc32c_shift(const uint32_t table[4][256], uint32_t crc) {
+    return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+      table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+  }
+
+  uint32_t crc32c_sw(const uint8_t *next, size_t len) {
+    const uint32_t (*slice)[256] = crc32c_tables.slice;
+    uint32_t crc = 0xffffffff;
+
+    while (len >= 8) {
+      crc ^= (uint32_t)next[0] | ((uint32_t)next[1] << 8) |
+        ((uint32_t)next[2] << 16) | ((uint32_t)next[3] << 24);
+      crc = slice[7][crc & 0xff] ^ slice[6][(crc >> 8) & 0xff] ^
+        slice[5][(crc >> 16) & 0xff] ^ slice[4][crc >> 24] ^
+        slice[3][next[4]] ^ slice[2][next[5]] ^
+        slice[1][next[6]] ^ slice[0][next[7]];
+      next += 8;
+      len -= 8;
+    }
+
+    while (len) {
+      crc = slice[0][(crc ^ *next++) & 0xff] ^ (crc >> 8);
+      len--;
+    }
+
+    return crc ^ 0xffffffff;
+  }
+
+#if defined(HT_CRC32C_HARDWARE)
+
+  inline uint64_t load64(const uint8_t *p) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+  }
+
+  /* The crc32 instruction has a latency of three cycles but a throughput of
+   * one per cycle, so large inputs are processed as three adjacent blocks in
+   * parallel and the three CRCs are combined with the zero-byte operators.
+   */
+  __attribute__((target("sse4.2")))
+  uint32_t crc32c_hw(const uint8_t *next, size_t len) {
+    uint64_t crc0 = 0xffffffff, crc1, crc2;
+    const uint8_t *end;
+
+    while (len && ((uintptr_t)next & 7) != 0) {
+      crc0 = _mm_crc32_u8((uint32_t)crc0, *next++);
+      len--;
+    }
+
+    while (len >= CRC32C_LONG * 3) {
+      crc1 = crc2 = 0;
+      end = next + CRC32C_LONG;
+      do {
+        crc0 = _mm_crc32_u64(crc0, load64(next));
+        crc1 = _mm_crc32_u64(crc1, load64(next + CRC32C_LONG));
+        crc2 = _mm_crc32_u64(crc2, load64(next + CRC32C_LONG * 2));
+        next += 8;
+      } while (next < end);
+      crc0 = crc32c_shift(crc32c_tables.long_shift, (uint32_t)crc0) ^ crc1;
+      crc0 = crc32c_shift(crc32c_tables.long_shift, (uint32_t)crc0) ^ crc2;
+      next += CRC32C_LONG * 2;
+      len -= CRC32C_LONG * 3;
+    }
+
+    while (len >= CRC32C_SHORT * 3) {
+      crc1 = crc2 = 0;
+      end = next + CRC32C_SHORT;
+      do {
+        crc0 = _mm_crc32_u64(crc0, load64(next));
+        crc1 = _mm_crc32_u64(crc1, load64(next + CRC32C_SHORT));
+        crc2 = _mm_crc32_u64(crc2, load64(next + CRC32C_SHORT * 2));
+        next += 8;
+      } while (next < end);
+      crc0 = crc32c_shift(crc32c_tables.short_shift, (uint32_t)crc0) ^ crc1;
+      crc0 = crc32c_shift(crc32c_tables.short_shift, (uint32_t)crc0) ^ crc2;
+      next += CRC32C_SHORT * 2;
+      len -= CRC32C_SHORT * 3;
+    }
+
+    while (len >= 8) {
+      crc0 = _mm_crc32_u64(crc0, load64(next));
+      next += 8;
+      len -= 8;
+    }
+
+    while (len) {
+      crc0 = _mm_crc32_u8((uint32_t)crc0, *next++);
+      len--;
+    }
+
+    return (uint32_t)crc0 ^ 0xffffffff;
+  }
+
+#endif
+
+} // local namespace
+
+uint32_t crc32c(const void *data, size_t len) {
+#if defined(HT_CRC32C_HARDWARE)
+  if (crc32c_tables.hardware)
+    return crc32c_hw((const uint8_t *)data, len);
+#endif
+  return crc32c_sw((const uint8_t *)data, len);
+}
+
+uint32_t crc32c_software(const void *data, size_t len) {
+  return crc32c_sw((const uint8_t *)data, len);
+}
+
+bool crc32c_hardware() {
+  return crc32c_tables.hardware;
+}
+
 } // namespace Hypertable
 
 /* vim: et sw=2
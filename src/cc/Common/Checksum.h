@@ -19,7 +19,7 @@
 
 /** @file
  * Implementation of checksum routines.
- * This file implements the fletcher32 checksum algorithm.
+ * This file implements the fletcher32 and CRC32C checksum algorithms.
  */
 
 #ifndef HYPERTABLE_CHECKSUM_H
@@ -41,6 +41,54 @@ namespace Hypertable {
    */
   extern uint32_t fletcher32(const void *data, size_t len);
 
+  /** Checksum algorithms.  These values are recorded in serialized formats
+   * (e.g. BlockCompressionHeader) and must not be changed.
+   */
+  enum ChecksumType {
+    CHECKSUM_FLETCHER32 = 0, //!< fletcher32
+    CHECKSUM_CRC32C     = 1  //!< CRC-32C (Castagnoli)
+  };
+
+  /** Compute CRC-32C (Castagnoli polynomial) checksum for arbitrary data.
+   * On x86-64 processors that support SSE4.2, the <code>crc32</code>
+   * instruction is used, running three independent streams in parallel over
+   * large inputs to hide its latency.  Otherwise a table driven
+   * (slicing-by-8) software implementation is used.
+   *
+   * @param data Pointer to the input data
+   * @param len Input data length in bytes
+   * @return The calculated checksum
+   */
+  extern uint32_t crc32c(const void *data, size_t len);
+
+  /** Compute CRC-32C checksum using the software implementation.  Produces
+   * the same result as crc32c() and is used for testing.
+   *
+   * @param data Pointer to the input data
+   * @param len Input data length in bytes
+   * @return The calculated checksum
+   */
+  extern uint32_t crc32c_software(const void *data, size_t len);
+
+  /** Checks if crc32c() uses the hardware implementation.
+   *
+   * @return true if CRC-32C is computed with the SSE4.2 crc32 instruction
+   */
+  extern bool crc32c_hardware();
+
+  /** Compute checksum for arbitrary data with the given algorithm.
+   *
+   * @param type Checksum algorithm (see ChecksumType)
+   * @param data Pointer to the input data
+   * @param len Input data length in bytes
+   * @return The calculated checksum
+   */
+  inline uint32_t compute_checksum(int type, const void *data, size_t len) {
+    if (type == CHECKSUM_CRC32C)
+      return crc32c(data, len);
+    return fletcher32(data, len);
+  }
+
   /** @}*/
 
 } // namespace Hypertable
@@ -167,6 +167,18 @@ void DefaultPolicy::init_options() {
     ("Comm.DispatchDelay", i32()->default_value(0), "[TESTING ONLY] "
         "Delay dispatching of read requests by this number of milliseconds")
     ("Comm.UsePoll", boo()->default_value(false), "Use POSIX poll() interface")
+    ("Comm.ProtocolVersion", i32()->default_value(1), "Protocol version of "
+        "request headers sent; version 2 checksums headers with CRC-32C but "
+        "is rejected by servers older than this release, so only raise it "
+        "once every server has been upgraded")
+    ("Comm.UseIoUring", boo()->default_value(false), "Use io_uring for "
+        "data connections if supported by the kernel (Linux only)")
+    ("Comm.UseWorkStealingQueue", boo()->default_value(false), "Use a "
+        "work-stealing application queue with per-worker request deques "
+        "in servers")
+    ("Comm.ZeroCopySendThreshold", i32()->default_value(0), "Send messages "
+        "whose extended payload is at least this many bytes with MSG_ZEROCOPY, "
+        "0 to disable (Linux epoll only)")
     ("Hypertable.Verbose", boo()->default_value(false),
         "Enable verbose output (system wide)")
     ("Hypertable.Silent", boo()->default_value(false),
@@ -305,8 +317,16 @@ void DefaultPolicy::init_options() {
         "all servers to trigger a scatter buffer flush")
     ("Hypertable.Scanner.QueueSize",
      i32()->default_value(5), "Size of Scanner ScanBlock queue")
+    ("Hypertable.Scanner.Parallel.MemoryBudget",
+     i64()->default_value(64*M), "Approximate amount of memory (bytes) a "
+        "parallel scanner may use for prefetched scan blocks; determines how "
+        "many ranges are scanned concurrently")
     ("Hypertable.LocationCache.MaxEntries", i64()->default_value(1*M),
         "Size of range location cache in number of entries")
+    ("Hypertable.LocationCache.Shards", i32()->default_value(16),
+        "Number of independently locked range location cache shards; "
+        "entries are assigned to shards by hashing the table ID, so a "
+        "lookup locks a single shard")
     ("Hypertable.Master.Host", str(),
         "Host on which Hypertable Master is running")
     ("Hypertable.Master.Port", i16()->default_value(38050),
@@ -355,6 +375,9 @@ void DefaultPolicy::init_options() {
      i32()->default_value(512*KiB), "Page size for CellCache pool allocator")
     ("Hypertable.RangeServer.AccessGroup.CellCache.ScannerCacheSize",
      i32()->default_value(1024), "CellCache scanner cache size")
+    ("Hypertable.RangeServer.AccessGroup.CellCache.DefaultType",
+     str()->default_value("map"), "Default CellCache type for access groups "
+     "that do not specify one (map or skiplist)")
     ("Hypertable.RangeServer.AccessGroup.ShadowCache",
      boo()->default_value(false), "Enable CellStore shadow caching")
     ("Hypertable.RangeServer.AccessGroup.MaxMemory", i64()->default_value(1*G),
@@ -364,10 +387,35 @@ void DefaultPolicy::init_options() {
     ("Hypertable.RangeServer.CellStore.TargetSize.Window",
         i64()->default_value(30*MiB), "Size window above target minimum for "
         "CellStores in which merges will be considered")
+    ("Hypertable.RangeServer.CellStore.Mmap", boo()->default_value(false),
+        "Memory map CellStore files from the local broker root directory "
+        "(DfsBroker.Local.Root) and read blocks directly from the mapping "
+        "instead of through the DFS broker; only valid if the RangeServer "
+        "runs on the same host as the local DFS broker")
     ("Hypertable.RangeServer.CellStore.Merge.RunLengthThreshold", i32()->default_value(10),
         "Trigger a merge if an adjacent run of merge candidate CellStores exceeds this length")
+    ("Hypertable.RangeServer.CellStore.Merge.Policy", str()->default_value("runlength"),
+        "Policy that chooses the CellStores to merge; runlength merges small "
+        "CellStores up to the target size, leveled keeps one CellStore per "
+        "size level (fewest CellStores), tiered merges CellStores of similar "
+        "size (lowest write amplification)")
+    ("Hypertable.RangeServer.CellStore.Merge.Leveled.Fanout", i32()->default_value(10),
+        "Size ratio between adjacent levels of the leveled merge policy")
+    ("Hypertable.RangeServer.CellStore.Merge.Tiered.MinThreshold", i32()->default_value(4),
+        "Minimum number of similarly sized CellStores merged by the tiered merge policy")
+    ("Hypertable.RangeServer.CellStore.Merge.Tiered.MaxThreshold", i32()->default_value(32),
+        "Maximum number of CellStores merged at once by the tiered merge policy")
+    ("Hypertable.RangeServer.CellStore.Merge.Tiered.BucketWindow", i32()->default_value(50),
+        "Percentage by which CellStore sizes may differ from the average size "
+        "of their tier in the tiered merge policy")
+    ("Hypertable.RangeServer.CellStore.Merge.Tiered.MaxAge", i32()->default_value(0),
+        "Seconds after which CellStores are no longer merged by the tiered "
+        "merge policy (0 disables)")
     ("Hypertable.RangeServer.CellStore.DefaultBlockSize",
         i32()->default_value(64*KiB), "Default block size for cell stores")
+    ("Hypertable.RangeServer.CellStore.RestartInterval",
+        i32()->default_value(16), "Number of key/value pairs between key "
+        "compression restart points within a cell store block")
     ("Hypertable.RangeServer.Data.DefaultReplication",
         i32()->default_value(-1), "Default replication for data")
     ("Hypertable.RangeServer.CellStore.DefaultCompressor",
@@ -386,6 +434,12 @@ void DefaultPolicy::init_options() {
         "Minimum size of block cache")
     ("Hypertable.RangeServer.BlockCache.MaxMemory", i64()->default_value(-1),
         "Maximum (target) size of block cache")
+    ("Hypertable.RangeServer.BlockCache.Shards", i32()->default_value(16),
+        "Number of independently locked shards in the block cache")
+    ("Hypertable.RangeServer.BlockCache.Admission",
+        str()->default_value("tinylfu"), "Block cache admission policy; "
+        "lru admits every block, tinylfu only admits a block if it has been "
+        "accessed more often than the block it would evict")
     ("Hypertable.RangeServer.QueryCache.MaxMemory", i64()->default_value(50*M),
         "Maximum size of query cache")
     ("Hypertable.RangeServer.Range.RowSize.Unlimited", boo()->default_value(false),
@@ -414,15 +468,23 @@ void DefaultPolicy::init_options() {
     ("Hypertable.RangeServer.CommitLog.PruneThreshold.Max.MemoryPercentage",
         i32()->default_value(50), "Upper threshold in terms of % RAM for "
         "amount of outstanding commit log before pruning")
+    ("Hypertable.RangeServer.CommitLog.ReplayThreads", i32(),
+        "Number of threads used to replay the commit logs during recovery.  "
+        "Default is number-of-cores.")
+    ("Hypertable.RangeServer.CommitLog.Streams", i32()->default_value(1),
+        "Number of independent streams (each with its own commit thread, "
+        "fragment file and sync) the user commit log is written through")
     ("Hypertable.RangeServer.CommitLog.RollLimit", i64()->default_value(100*M),
         "Roll commit log after this many bytes")
     ("Hypertable.RangeServer.CommitLog.Compressor",
         str()->default_value("quicklz"),
-       "Commit log compressor to use (zlib, lzo, quicklz, snappy, bmz, none)")
+       "Commit log compressor to use (zlib, lzo, quicklz, snappy, zstd, lz4, "
+       "bmz, none)")
     ("Hypertable.RangeServer.Testing.MaintenanceNeeded.PauseInterval", i32()->default_value(0),
         "TESTING:  After update, if range needs maintenance, pause for this number of milliseconds")
     ("Hypertable.RangeServer.UpdateCoalesceLimit", i64()->default_value(5*M),
-        "Amount of update data to coalesce into single commit log sync")
+        "Obsolete, ignored.  Updates waiting on a commit log sync are "
+        "grouped into a single sync automatically")
     ("Hypertable.RangeServer.Failover.FlushLimit.PerRange",
      i32()->default_value(10*M), "Amount of updates (bytes) accumulated for a "
         "single range to trigger a replay buffer flush")
@@ -434,7 +496,8 @@ void DefaultPolicy::init_options() {
     ("Hypertable.CommitLog.RollLimit", i64()->default_value(100*M),
         "Roll commit log after this many bytes")
     ("Hypertable.CommitLog.Compressor", str()->default_value("quicklz"),
-        "Commit log compressor to use (zlib, lzo, quicklz, snappy, bmz, none)")
+        "Commit log compressor to use (zlib, lzo, quicklz, snappy, zstd, lz4, "
+        "bmz, none)")
     ("Hypertable.CommitLog.SkipErrors", boo()->default_value(false),
         "Skip over any corruption encountered in the commit log")
     ("Hypertable.RangeServer.Scanner.Ttl", i32()->default_value(1800*K),
@@ -445,6 +508,26 @@ void DefaultPolicy::init_options() {
         "Timer interval in milliseconds (reaping scanners, purging commit logs, etc.)")
     ("Hypertable.RangeServer.Maintenance.Interval", i32()->default_value(30000),
         "Maintenance scheduling interval in milliseconds")
+    ("Hypertable.RangeServer.Maintenance.AccessGroupCompactionConcurrency", i32(),
+        "Maximum number of additional maintenance threads that may be compacting "
+        "access groups (or shards of access groups) of ranges that are already "
+        "being compacted.  Default is the number of maintenance threads.  0 "
+        "compacts the access groups of a range one at a time")
+    ("Hypertable.RangeServer.Maintenance.SubCompaction.MaxShards", i32()->default_value(4),
+        "Maximum number of row range shards a major compaction of a large access "
+        "group is split into, each one merged into a CellStore of its own (0 or "
+        "1 disables sub-compactions)")
+    ("Hypertable.RangeServer.Maintenance.SubCompaction.MinShardSize", i64()->default_value(256*MiB),
+        "Minimum amount of CellStore data (bytes) per sub-compaction shard")
+    ("Hypertable.RangeServer.Maintenance.IOThrottle.MaxRate", i64()->default_value(0),
+        "Maximum rate (bytes per second) of CellStore I/O performed by merging, "
+        "major and GC compactions, reduced by the rate of foreground scans "
+        "(0 means unlimited)")
+    ("Hypertable.RangeServer.Maintenance.IOThrottle.MinRate", i64()->default_value(8*MiB),
+        "Rate (bytes per second) of compaction I/O that is allowed no matter "
+        "how busy the server is with foreground scans")
+    ("Hypertable.RangeServer.Maintenance.IOThrottle.Burst", i64()->default_value(4*MiB),
+        "Number of bytes compactions may transfer at once after being idle")
     ("Hypertable.RangeServer.Maintenance.LowMemoryPrioritization", boo()->default_value(true),
         "Use low memory prioritization algorithm for freeing memory in low memory mode")
     ("Hypertable.RangeServer.Maintenance.MaxAppQueuePause", i32()->default_value(120000),
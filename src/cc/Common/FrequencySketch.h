@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * A count-min sketch with 4-bit saturating counters.
+ * Used to estimate how often a key has been accessed recently, e.g. for
+ * TinyLFU style cache admission.
+ */
+
+#ifndef HYPERTABLE_FREQUENCY_SKETCH_H
+#define HYPERTABLE_FREQUENCY_SKETCH_H
+
+#include <vector>
+
+namespace Hypertable {
+
+/** @addtogroup Common
+ *  @{
+ */
+
+/**
+ * Approximate access frequency counter.  Each key is hashed into one
+ * 4-bit counter in each of #DEPTH rows and its frequency is estimated as
+ * the minimum of those counters, so estimates may be too high but never too
+ * low.  Each row has four counters per key of capacity.  Once the number
+ * of recorded accesses reaches ten times the capacity, all counters are
+ * halved so that the estimates track recent history rather than all-time
+ * popularity.  This class is not thread safe.
+ */
+class FrequencySketch {
+public:
+  enum {
+    DEPTH = 4,
+    MAX_COUNT = 15
+  };
+
+  /**
+   * Constructor
+   *
+   * @param capacity Expected number of distinct keys being tracked
+   */
+  FrequencySketch(size_t capacity) : m_additions(0) {
+    if (capacity < 16)
+      capacity = 16;
+    m_width = 1;
+    while (m_width < 4 * capacity)
+      m_width <<= 1;
+    m_table.resize((m_width * DEPTH) / 16, 0);
+    m_sample_size = 10 * capacity;
+  }
+
+  /** Returns the estimated recent access count of <code>key</code> */
+  uint32_t frequency(uint64_t key) const {
+    uint32_t freq = MAX_COUNT;
+    for (size_t i=0; i<DEPTH; i++) {
+      size_t index = counter_index(key, i);
+      uint32_t count = (m_table[index >> 4] >> ((index & 15) << 2)) & 0xF;
+      if (count < freq)
+        freq = count;
+    }
+    return freq;
+  }
+
+  /** Records an access of <code>key</code> */
+  void increment(uint64_t key) {
+    bool added = false;
+    for (size_t i=0; i<DEPTH; i++) {
+      size_t index = counter_index(key, i);
+      uint64_t shift = (index & 15) << 2;
+      if (((m_table[index >> 4] >> shift) & 0xF) < MAX_COUNT) {
+        m_table[index >> 4] += (uint64_t)1 << shift;
+        added = true;
+      }
+    }
+    if (added && ++m_additions >= m_sample_size)
+      reset();
+  }
+
+  /** Halves every counter */
+  void reset() {
+    for (size_t i=0; i<m_table.size(); i++)
+      m_table[i] = (m_table[i] >> 1) & 0x7777777777777777ULL;
+    m_additions /= 2;
+  }
+
+private:
+
+  size_t counter_index(uint64_t key, size_t row) const {
+    static const uint64_t seeds[DEPTH] = {
+      0xC3A5C85C97CB3127ULL, 0xB492B66FBE98F273ULL,
+      0x9AE16A3B2F90404FULL, 0xCBF29CE484222325ULL
+    };
+    uint64_t h = (key + seeds[row]) * 0x9E3779B97F4A7C15ULL;
+    h ^= h >> 32;
+    return (row * m_width) + (size_t)(h & (m_width - 1));
+  }
+
+  std::vector<uint64_t> m_table;
+  size_t m_width;
+  size_t m_sample_size;
+  size_t m_additions;
+};
+
+/** @} */
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_FREQUENCY_SKETCH_H
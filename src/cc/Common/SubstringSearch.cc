@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+ */
+
+/** @file
+ * Definitions for SubstringSearch.
+ * This file contains the scalar, SSE2 and AVX2 implementations of
+ * SubstringSearch::find().
+ */
+
+#include "Compat.h"
+#include <cstring>
+#include "SubstringSearch.h"
+
+#if defined(__x86_64__) && (defined(__clang__) || __GNUC__ > 4 || \
+    (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HT_SUBSTRING_SEARCH_SIMD 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Hypertable {
+
+namespace {
+
+  /* All implementations take a pattern of at least two bytes that is no
+   * longer than the text.
+   */
+
+  const char *find_scalar(const char *text, size_t len,
+                          const char *pattern, size_t plen) {
+    const char *end = text + (len - plen) + 1;
+
+    while (text < end) {
+      text = (const char *)memchr(text, pattern[0], end - text);
+      if (text == 0)
+        return 0;
+      if (memcmp(text + 1, pattern + 1, plen - 1) == 0)
+        return text;
+      text++;
+    }
+    return 0;
+  }
+
+#if defined(HT_SUBSTRING_SEARCH_SIMD)
+
+  /* Compares the first pattern byte against 16 consecutive positions and the
+   * last pattern byte against the 16 positions plen - 1 bytes further on;
+   * only positions where both match are verified with memcmp().
+   */
+  const char *find_sse2(const char *text, size_t len,
+                        const char *pattern, size_t plen) {
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i last = _mm_set1_epi8(pattern[plen - 1]);
+    size_t i = 0;
+
+    for (; i + plen + 15 <= len; i += 16) {
+      __m128i block_first =
+        _mm_loadu_si128((const __m128i *)(text + i));
+      __m128i block_last =
+        _mm_loadu_si128((const __m128i *)(text + i + plen - 1));
+      unsigned mask = (unsigned)_mm_movemask_epi8(
+          _mm_and_si128(_mm_cmpeq_epi8(first, block_first),
+                        _mm_cmpeq_epi8(last, block_last)));
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (memcmp(text + i + bit + 1, pattern + 1, plen - 2) == 0)
+          return text + i + bit;
+        mask &= mask - 1;
+      }
+    }
+
+    if (i + plen > len)
+      return 0;
+    return find_scalar(text + i, len - i, pattern, plen);
+  }
+
+  /* Same as find_sse2() with 32 positions per step */
+  __attribute__((target("avx2")))
+  const char *find_avx2(const char *text, size_t len,
+                        const char *pattern, size_t plen) {
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i last = _mm256_set1_epi8(pattern[plen - 1]);
+    size_t i = 0;
+
+    for (; i + plen + 31 <= len; i += 32) {
+      __m256i block_first =
+        _mm256_loadu_si256((const __m256i *)(text + i));
+      __m256i block_last =
+        _mm256_loadu_si256((const __m256i *)(text + i + plen - 1));
+      unsigned mask = (unsigned)_mm256_movemask_epi8(
+          _mm256_and_si256(_mm256_cmpeq_epi8(first, block_first),
+                           _mm256_cmpeq_epi8(last, block_last)));
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (memcmp(text + i + bit + 1, pattern + 1, plen - 2) == 0)
+          return text + i + bit;
+        mask &= mask - 1;
+      }
+    }
+
+    if (i + plen > len)
+      return 0;
+    return find_sse2(text + i, len - i, pattern, plen);
+  }
+
+#endif
+
+  /** Detects the best implementation once at startup */
+  struct SubstringSearchSupport {
+    SubstringSearchSupport() : best(SubstringSearch::SCALAR) {
+#if defined(HT_SUBSTRING_SEARCH_SIMD)
+      best = SubstringSearch::SSE2;
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2"))
+        best = SubstringSearch::AVX2;
+#endif
+    }
+
+    /// Fastest implementation supported by the processor
+    SubstringSearch::Implementation best;
+  };
+
+  SubstringSearchSupport substring_search_support;
+
+} // local namespace
+
+SubstringSearch::Implementation SubstringSearch::best_implementation() {
+  return substring_search_support.best;
+}
+
+void SubstringSearch::set_implementation(Implementation impl) {
+  m_impl = (impl > best_implementation()) ? best_implementation() : impl;
+}
+
+const char *SubstringSearch::find(const char *text, size_t len) const {
+  const char *pattern = m_pattern.data();
+  size_t plen = m_pattern.length();
+
+  if (plen == 0)
+    return text;
+  if (plen > len)
+    return 0;
+  if (plen == 1)
+    return (const char *)memchr(text, pattern[0], len);
+
+#if defined(HT_SUBSTRING_SEARCH_SIMD)
+  if (m_impl == AVX2)
+    return find_avx2(text, len, pattern, plen);
+  if (m_impl == SSE2)
+    return find_sse2(text, len, pattern, plen);
+#endif
+  return find_scalar(text, len, pattern, plen);
+}
+
+} // namespace Hypertable
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Hypertable. If not, see <http://www.gnu.org/licenses/>
+ */
+
+/** @file
+ * Declarations for SubstringSearch.
+ * This file contains the declaration of SubstringSearch, a class for
+ * repeatedly searching for a fixed byte string.
+ */
+
+#ifndef HYPERTABLE_SUBSTRINGSEARCH_H
+#define HYPERTABLE_SUBSTRINGSEARCH_H
+
+#include "Common/String.h"
+
+namespace Hypertable {
+
+  /** @addtogroup Common
+   *  @{
+   */
+
+  /** Searches for a fixed pattern in byte strings.  The pattern is copied
+   * when it is set, so one object can be used for any number of searches.
+   * On x86-64 processors the search compares the first and last byte of the
+   * pattern against 32 (AVX2) or 16 (SSE2) candidate positions at a time and
+   * only verifies the positions where both match, which skips over
+   * non-matching input much faster than a byte-at-a-time search.  AVX2 is
+   * used if the processor supports it.
+   */
+  class SubstringSearch {
+  public:
+
+    /** Search implementations */
+    enum Implementation {
+      SCALAR = 0, //!< memchr() on the first byte followed by memcmp()
+      SSE2   = 1, //!< 16 candidate positions per step
+      AVX2   = 2  //!< 32 candidate positions per step
+    };
+
+    /** Default constructor.  The empty pattern matches every input. */
+    SubstringSearch() : m_impl(best_implementation()) { }
+
+    /** Constructor.
+     * @param pattern Pointer to pattern
+     * @param len Length of pattern
+     */
+    SubstringSearch(const char *pattern, size_t len)
+      : m_pattern(pattern, len), m_impl(best_implementation()) { }
+
+    /** Sets the pattern to search for.
+     * @param pattern Pointer to pattern
+     * @param len Length of pattern
+     */
+    void set_pattern(const char *pattern, size_t len) {
+      m_pattern.assign(pattern, len);
+    }
+
+    /** Returns the pattern */
+    const String &pattern() const { return m_pattern; }
+
+    /** Finds the first occurrence of the pattern.
+     * @param text Pointer to the data to search
+     * @param len Length of the data
+     * @return Pointer to the first occurrence of the pattern in
+     * <code>text</code>, or 0 if there is none
+     */
+    const char *find(const char *text, size_t len) const;
+
+    /** Checks if the pattern occurs in <code>text</code>.
+     * @param text Pointer to the data to search
+     * @param len Length of the data
+     * @return <i>true</i> if the pattern occurs in <code>text</code>
+     */
+    bool matches(const char *text, size_t len) const {
+      return find(text, len) != 0;
+    }
+
+    /** Selects the implementation used by find().  Implementations that
+     * the processor does not support are replaced with the best supported
+     * one; used for testing.
+     * @param impl Implementation to use
+     */
+    void set_implementation(Implementation impl);
+
+    /** Returns the implementation used by find() */
+    Implementation implementation() const { return m_impl; }
+
+    /** Returns the fastest implementation supported by the processor */
+    static Implementation best_implementation();
+
+  private:
+
+    /// Pattern to search for
+    String m_pattern;
+
+    /// Implementation used by find()
+    Implementation m_impl;
+  };
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif /* HYPERTABLE_SUBSTRINGSEARCH_H */
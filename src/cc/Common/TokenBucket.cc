@@ -0,0 +1,89 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for TokenBucket.
+ * This file contains the method definitions of TokenBucket, a thread-safe
+ * rate limiter.
+ */
+
+#include "Compat.h"
+
+#include <boost/thread/thread.hpp>
+
+#include "Time.h"
+#include "TokenBucket.h"
+
+using namespace Hypertable;
+
+TokenBucket::TokenBucket(int64_t rate, int64_t burst)
+  : m_rate(rate), m_burst(burst), m_tokens((double)burst),
+    m_last_refill(get_ts64()) {
+}
+
+
+void TokenBucket::set_rate(int64_t rate) {
+  ScopedLock lock(m_mutex);
+  refill();
+  m_rate = rate;
+}
+
+
+int64_t TokenBucket::get_rate() {
+  ScopedLock lock(m_mutex);
+  return m_rate;
+}
+
+
+int64_t TokenBucket::consume(int64_t amount) {
+  int64_t wait_micros = reserve(amount);
+  if (wait_micros > 0)
+    boost::this_thread::sleep(boost::posix_time::microseconds(wait_micros));
+  return wait_micros;
+}
+
+
+int64_t TokenBucket::reserve(int64_t amount) {
+  ScopedLock lock(m_mutex);
+  if (m_rate <= 0)
+    return 0;
+  refill();
+  m_tokens -= (double)amount;
+  if (m_tokens >= 0.0)
+    return 0;
+  return (int64_t)((-m_tokens * 1000000.0) / (double)m_rate);
+}
+
+
+void TokenBucket::refill() {
+  int64_t now = get_ts64();
+  // the wall clock may have been set back
+  if (now > m_last_refill) {
+    if (m_rate > 0) {
+      m_tokens += ((double)(now - m_last_refill) * (double)m_rate) / 1e9;
+      if (m_tokens > (double)m_burst)
+        m_tokens = (double)m_burst;
+    }
+    else
+      m_tokens = (double)m_burst;
+  }
+  m_last_refill = now;
+}
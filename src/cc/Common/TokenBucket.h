@@ -0,0 +1,103 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for TokenBucket.
+ * This file contains the declaration of TokenBucket, a thread-safe rate
+ * limiter.
+ */
+
+#ifndef HYPERTABLE_TOKENBUCKET_H
+#define HYPERTABLE_TOKENBUCKET_H
+
+#include "Common/Mutex.h"
+
+namespace Hypertable {
+
+  /** @addtogroup Common
+   *  @{
+   */
+
+  /** Limits the rate of a resource shared by several threads.
+   * Tokens (e.g. bytes) accumulate at a fixed rate up to a burst size.
+   * Consumers take the tokens they need and, if the bucket runs dry, sleep
+   * until the tokens they took have been replenished.  Because the bucket is
+   * allowed to go into debt, concurrent consumers queue up behind each other
+   * and the long-term throughput never exceeds the rate, no matter how large
+   * the individual requests are.
+   */
+  class TokenBucket {
+  public:
+
+    /** Constructor.
+     * @param rate Tokens added per second (0 means unlimited)
+     * @param burst Maximum number of tokens that can accumulate
+     */
+    TokenBucket(int64_t rate, int64_t burst);
+
+    /** Changes the rate.  Tokens accumulated so far (or the debt) are kept.
+     * @param rate Tokens added per second (0 means unlimited)
+     */
+    void set_rate(int64_t rate);
+
+    /** Returns the rate in tokens per second (0 means unlimited) */
+    int64_t get_rate();
+
+    /** Takes tokens from the bucket, sleeping until they are available.
+     * @param amount Number of tokens to take
+     * @return Number of microseconds slept
+     */
+    int64_t consume(int64_t amount);
+
+    /** Takes tokens from the bucket without sleeping.
+     * @param amount Number of tokens to take
+     * @return Number of microseconds the caller would have to sleep to stay
+     * within the rate
+     */
+    int64_t reserve(int64_t amount);
+
+  private:
+
+    /** Adds the tokens accumulated since the last call.  Must be called
+     * with #m_mutex locked. */
+    void refill();
+
+    /// %Mutex protecting the members
+    Mutex m_mutex;
+
+    /// Tokens added per second
+    int64_t m_rate;
+
+    /// Maximum number of tokens
+    int64_t m_burst;
+
+    /// Tokens available (negative if consumers are waiting)
+    double m_tokens;
+
+    /// Time of the last refill (nanoseconds since the epoch)
+    int64_t m_last_refill;
+  };
+
+  /** @} */
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_TOKENBUCKET_H
@@ -21,8 +21,8 @@
 
 /** @file
  * Application to calculate checksums.
- * This small helper application can calculate the fletcher32 checksum of
- * a file.
+ * This small helper application can calculate the fletcher32 or CRC32C
+ * checksum of a file.
  */
 
 #include "Common/Compat.h"
@@ -48,6 +48,7 @@ namespace {
     "Supported Algorithms:\n" \
     "\n" \
     "  fletcher32\n" \
+    "  crc32c\n" \
     "\n";
 }
 
@@ -63,6 +64,12 @@ int main(int argc, char **argv) {
     int32_t checksum = fletcher32(data, len);
     cout << checksum << endl;
   }
+  else if (!strcmp(argv[1], "crc32c")) {
+    off_t len;
+    char *data = FileUtils::file_to_buffer(argv[2], &len);
+    int32_t checksum = crc32c(data, len);
+    cout << checksum << endl;
+  }
   else {
     cout << usage_str << endl;
     exit(1);
@@ -0,0 +1,69 @@
+/**
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Checksum.h"
+#include "Common/Logger.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Hypertable;
+
+int main(int ac, char *av[]) {
+  const char *check = "123456789";
+  uint8_t zeros[32], ones[32];
+
+  // Known answers (RFC 3720, appendix B.4)
+  memset(zeros, 0, sizeof(zeros));
+  memset(ones, 0xff, sizeof(ones));
+  HT_ASSERT(crc32c(check, 9) == 0xe3069283);
+  HT_ASSERT(crc32c_software(check, 9) == 0xe3069283);
+  HT_ASSERT(crc32c(zeros, 32) == 0x8a9136aa);
+  HT_ASSERT(crc32c(ones, 32) == 0x62a8ab43);
+  HT_ASSERT(crc32c(check, 0) == 0);
+
+  HT_ASSERT(compute_checksum(CHECKSUM_CRC32C, check, 9) == 0xe3069283);
+  HT_ASSERT(compute_checksum(CHECKSUM_FLETCHER32, check, 9) ==
+            fletcher32(check, 9));
+
+  // Hardware and software implementations must agree for all lengths and
+  // alignments, including across the parallel block boundaries
+  std::vector<uint8_t> buf(3 * 8192 * 2 + 64);
+  srandom(1);
+  for (size_t i=0; i<buf.size(); i++)
+    buf[i] = (uint8_t)random();
+
+  for (size_t offset=0; offset<8; offset++) {
+    for (size_t len=0; len<2048; len++)
+      HT_ASSERT(crc32c(&buf[offset], len) ==
+                crc32c_software(&buf[offset], len));
+  }
+  for (size_t len=3*256-16; len<=buf.size()-8; len+=(random() % 997) + 1) {
+    size_t offset = random() % 8;
+    HT_ASSERT(crc32c(&buf[offset], len) == crc32c_software(&buf[offset], len));
+  }
+
+  printf("CRC32C %s implementation OK\n",
+         crc32c_hardware() ? "hardware" : "software");
+  return 0;
+}
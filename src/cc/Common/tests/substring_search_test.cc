@@ -0,0 +1,95 @@
+/**
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/SubstringSearch.h"
+#include "Common/Logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace Hypertable;
+
+namespace {
+
+  const char *reference_find(const char *text, size_t len,
+                             const char *pattern, size_t plen) {
+    const char *end = text + len;
+    const char *found = std::search(text, end, pattern, pattern + plen);
+    return (found == end && plen) ? 0 : found;
+  }
+
+  const char *impl_names[] = { "scalar", "SSE2", "AVX2" };
+
+}
+
+int main(int ac, char *av[]) {
+  SubstringSearch::Implementation best = SubstringSearch::best_implementation();
+
+  // Simple cases
+  {
+    SubstringSearch search("needle", 6);
+    const char *text = "haystack with a needle in it";
+    HT_ASSERT(search.find(text, strlen(text)) == text + 16);
+    HT_ASSERT(!search.matches(text, 16 + 5));
+    HT_ASSERT(!search.matches("needl", 5));
+    HT_ASSERT(search.matches("needle", 6));
+    search.set_pattern("", 0);
+    HT_ASSERT(search.find(text, 0) == text);
+    search.set_pattern("y", 1);
+    HT_ASSERT(search.find(text, strlen(text)) == text + 2);
+  }
+
+  // Every implementation must agree with std::search for all pattern
+  // lengths and match positions, including the tail after the last full
+  // vector step.  A small alphabet produces many partial matches.
+  std::vector<char> buf(4096);
+  srandom(1);
+  for (size_t i=0; i<buf.size(); i++)
+    buf[i] = 'a' + (random() % 4);
+
+  for (int impl=SubstringSearch::SCALAR; impl<=(int)best; impl++) {
+    SubstringSearch search;
+    search.set_implementation((SubstringSearch::Implementation)impl);
+    HT_ASSERT(search.implementation() == impl);
+    for (size_t plen=1; plen<=40; plen++) {
+      for (int trial=0; trial<200; trial++) {
+        size_t len = random() % 300;
+        size_t offset = random() % (buf.size() - len);
+        const char *text = &buf[offset];
+        char pattern[40];
+        if (trial % 2 && len >= plen)
+          memcpy(pattern, text + random() % (len - plen + 1), plen);
+        else
+          for (size_t i=0; i<plen; i++)
+            pattern[i] = 'a' + (random() % 4);
+        search.set_pattern(pattern, plen);
+        HT_ASSERT(search.find(text, len) ==
+                  reference_find(text, len, pattern, plen));
+      }
+    }
+    printf("SubstringSearch %s implementation OK\n", impl_names[impl]);
+  }
+
+  return 0;
+}
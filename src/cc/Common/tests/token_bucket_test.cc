@@ -0,0 +1,85 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Logger.h"
+#include "Common/Stopwatch.h"
+#include "Common/TokenBucket.h"
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+
+using namespace Hypertable;
+
+namespace {
+
+  const int64_t KB = 1024;
+  const int64_t MB = 1024 * 1024;
+
+  void consumer(TokenBucket *bucket, int64_t total, int64_t chunk) {
+    for (int64_t consumed = 0; consumed < total; consumed += chunk)
+      bucket->consume(chunk);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  // An unlimited bucket never makes anybody wait
+  {
+    TokenBucket bucket(0, 1*MB);
+    HT_ASSERT(bucket.reserve(100*MB) == 0);
+    HT_ASSERT(bucket.consume(100*MB) == 0);
+  }
+
+  // The burst is available right away, anything beyond it has to wait
+  {
+    TokenBucket bucket(1*MB, 1*MB);
+    HT_ASSERT(bucket.reserve(1*MB) == 0);
+    int64_t wait_micros = bucket.reserve(1*MB);
+    HT_ASSERT(wait_micros > 900000 && wait_micros <= 1000000);
+    // debt is kept, so the next consumer queues up behind the first one
+    wait_micros = bucket.reserve(1*MB);
+    HT_ASSERT(wait_micros > 1900000 && wait_micros <= 2000000);
+    // raising the rate shortens the wait
+    bucket.set_rate(4*MB);
+    HT_ASSERT(bucket.get_rate() == 4*MB);
+    wait_micros = bucket.reserve(0);
+    HT_ASSERT(wait_micros > 400000 && wait_micros <= 500000);
+  }
+
+  // Concurrent consumers together stay within the rate
+  {
+    TokenBucket bucket(16*MB, 1*MB);
+    Stopwatch stopwatch;
+    boost::thread_group threads;
+    for (int i=0; i<4; i++)
+      threads.create_thread(boost::bind(consumer, &bucket, 2*MB, 64*KB));
+    threads.join_all();
+    stopwatch.stop();
+    // 8MB at 16MB/s with 1MB up front takes at least 7/16 seconds
+    HT_ASSERT(stopwatch.elapsed() >= 0.4);
+    HT_ASSERT(stopwatch.elapsed() < 5.0);
+  }
+
+  return 0;
+}
@@ -34,6 +34,7 @@ extern "C" {
 
 #include "AsyncComm/ApplicationQueue.h"
 #include "AsyncComm/Comm.h"
+#include "AsyncComm/WorkStealingApplicationQueue.h"
 
 #include "DfsBroker/Lib/Config.h"
 #include "DfsBroker/Lib/ConnectionHandlerFactory.h"
@@ -77,7 +78,11 @@ int main (int argc, char **argv) {
       port = get_i16("CephBroker.Port");
 
     Comm *comm = Comm::instance();
-    ApplicationQueuePtr app_queue = new ApplicationQueue(worker_count);
+    ApplicationQueuePtr app_queue;
+    if (get_bool("Comm.UseWorkStealingQueue"))
+      app_queue = new WorkStealingApplicationQueue(worker_count);
+    else
+      app_queue = new ApplicationQueue(worker_count);
     HT_INFOF("attemping to create new CephBroker with address %s", properties->get_str("CephBroker.MonAddr").c_str());
     BrokerPtr broker = new CephBroker(properties);
     HT_INFO("Created CephBroker!");
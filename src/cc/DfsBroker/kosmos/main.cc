@@ -37,6 +37,7 @@ extern "C" {
 
 #include "AsyncComm/ApplicationQueue.h"
 #include "AsyncComm/Comm.h"
+#include "AsyncComm/WorkStealingApplicationQueue.h"
 
 #include "DfsBroker/Lib/Config.h"
 #include "DfsBroker/Lib/ConnectionHandlerFactory.h"
@@ -77,7 +78,11 @@ int main(int argc, char **argv) {
 
     int port = get_i16("DfsBroker.Port");
     int worker_count  = get_i32("Kfs.Broker.Workers");
-    ApplicationQueuePtr app_queue = new ApplicationQueue(worker_count);
+    ApplicationQueuePtr app_queue;
+    if (get_bool("Comm.UseWorkStealingQueue"))
+      app_queue = new WorkStealingApplicationQueue(worker_count);
+    else
+      app_queue = new ApplicationQueue(worker_count);
     DfsBroker::BrokerPtr broker = new KosmosBroker(properties);
     ConnectionHandlerFactoryPtr chf(new DfsBroker::ConnectionHandlerFactory(
         Comm::instance(), app_queue, broker));
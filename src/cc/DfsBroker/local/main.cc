@@ -40,6 +40,7 @@ extern "C" {
 #include "AsyncComm/ApplicationQueue.h"
 #include "AsyncComm/Comm.h"
 #include "AsyncComm/DispatchHandler.h"
+#include "AsyncComm/WorkStealingApplicationQueue.h"
 
 #include "DfsBroker/Lib/Config.h"
 #include "DfsBroker/Lib/ConnectionHandlerFactory.h"
@@ -81,7 +82,11 @@ int main(int argc, char **argv) {
 
     Comm *comm = Comm::instance();
 
-    ApplicationQueuePtr app_queue = new ApplicationQueue(worker_count);
+    ApplicationQueuePtr app_queue;
+    if (get_bool("Comm.UseWorkStealingQueue"))
+      app_queue = new WorkStealingApplicationQueue(worker_count);
+    else
+      app_queue = new ApplicationQueue(worker_count);
     BrokerPtr broker = new LocalBroker(properties);
     ConnectionHandlerFactoryPtr chfp =
         new DfsBroker::ConnectionHandlerFactory(comm, app_queue, broker);
@@ -39,6 +39,7 @@ extern "C" {
 
 #include "AsyncComm/ApplicationQueue.h"
 #include "AsyncComm/Comm.h"
+#include "AsyncComm/WorkStealingApplicationQueue.h"
 
 #include "DfsBroker/Lib/Config.h"
 #include "DfsBroker/Lib/ConnectionHandlerFactory.h"
@@ -79,7 +80,11 @@ int main(int argc, char **argv) {
       port = get_i16("port");
 
     Comm *comm = Comm::instance();
-    ApplicationQueuePtr app_queue = new ApplicationQueue(worker_count);
+    ApplicationQueuePtr app_queue;
+    if (get_bool("Comm.UseWorkStealingQueue"))
+      app_queue = new WorkStealingApplicationQueue(worker_count);
+    else
+      app_queue = new ApplicationQueue(worker_count);
     BrokerPtr broker = new MaprBroker(properties);
     ConnectionHandlerFactoryPtr chfp =
         new DfsBroker::ConnectionHandlerFactory(comm, app_queue, broker);
@@ -52,6 +52,8 @@ extern "C" {
 #include "Common/System.h"
 #include "Common/SystemInfo.h"
 
+#include "AsyncComm/WorkStealingApplicationQueue.h"
+
 #include "DfsBroker/Lib/Client.h"
 
 #include "Config.h"
@@ -222,7 +224,10 @@ Master::Master(ConnectionManagerPtr &conn_mgr, PropertiesPtr &props,
   }
 #endif
 
-  app_queue_ptr = new ApplicationQueue( get_i32("workers"), false );
+  if (get_bool("Comm.UseWorkStealingQueue"))
+    app_queue_ptr = new WorkStealingApplicationQueue(get_i32("workers"), false);
+  else
+    app_queue_ptr = new ApplicationQueue( get_i32("workers"), false );
   vector<Thread::id> thread_ids = app_queue_ptr->get_thread_ids();
   thread_ids.push_back(ThisThread::get_id());
 
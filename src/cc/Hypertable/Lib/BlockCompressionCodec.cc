@@ -31,7 +31,10 @@ namespace {
     "bmz",
     "zlib",
     "lzo",
-    "quicklz"
+    "quicklz",
+    "snappy",
+    "zstd",
+    "lz4"
   };
 }
 
@@ -33,13 +33,27 @@ namespace Hypertable {
 
   class DynamicBuffer;
 
+  /**
+   * Compression dictionary prepared by a codec for inflating blocks.  It is
+   * immutable once created, so a single instance can be shared by every
+   * codec of the same type that reads blocks compressed with it.
+   */
+  class BlockCompressionDictionary : public ReferenceCount {
+  public:
+    virtual ~BlockCompressionDictionary() { return; }
+
+    /** Returns the amount of memory consumed by the dictionary */
+    virtual size_t memory_used() const = 0;
+  };
+  typedef boost::intrusive_ptr<BlockCompressionDictionary> BlockCompressionDictionaryPtr;
+
   /**
    * Abstract base class for block compression codecs.
    */
   class BlockCompressionCodec : public ReferenceCount {
   public:
     enum Type { UNKNOWN=-1, NONE=0, BMZ=1, ZLIB=2, LZO=3, QUICKLZ=4,
-                SNAPPY=5, COMPRESSION_TYPE_LIMIT=6 };
+                SNAPPY=5, ZSTD=6, LZ4=7, COMPRESSION_TYPE_LIMIT=8 };
     typedef std::vector<String> Args;
 
     static const char *get_compressor_name(uint16_t algo);
@@ -55,6 +69,52 @@ namespace Hypertable {
 
     virtual void set_args(const Args &args) {}
 
+    /** Returns the size of the dictionary the codec wants trained from the
+     * data it compresses, or 0 if it does not use dictionaries.
+     */
+    virtual size_t get_dictionary_size() { return 0; }
+
+    /** Trains a dictionary from sample blocks.
+     *
+     * @param samples sample blocks stored back to back
+     * @param sample_sizes length of each sample block
+     * @param dictionary receives the dictionary
+     * @return <i>true</i> if a dictionary was trained, <i>false</i> otherwise
+     */
+    virtual bool train_dictionary(const DynamicBuffer &samples,
+                                  const std::vector<size_t> &sample_sizes,
+                                  DynamicBuffer &dictionary) { return false; }
+
+    /** Sets the dictionary used by subsequent calls to deflate.  The
+     * dictionary is copied.
+     *
+     * @param dictionary pointer to dictionary
+     * @param len length of dictionary
+     */
+    virtual void set_dictionary(const uint8_t *dictionary, size_t len) { }
+
+    /** Prepares a dictionary for inflating blocks that were compressed with
+     * it.  The result can be shared by any number of codecs of this type
+     * with set_inflate_dictionary().
+     *
+     * @param dictionary pointer to dictionary
+     * @param len length of dictionary
+     * @return prepared dictionary, or 0 if the codec does not use
+     * dictionaries
+     */
+    virtual BlockCompressionDictionary *
+    create_inflate_dictionary(const uint8_t *dictionary, size_t len) {
+      return 0;
+    }
+
+    /** Makes a dictionary created by create_inflate_dictionary() available
+     * to inflate for blocks that were compressed with it.
+     *
+     * @param dictionary prepared dictionary
+     */
+    virtual void
+    set_inflate_dictionary(BlockCompressionDictionaryPtr &dictionary) { }
+
     virtual int get_type() = 0;
 
     HT_THREAD_ID_DECL(m_creator_thread);
@@ -0,0 +1,156 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstdlib>
+
+extern "C" {
+#include <lz4.h>
+#include <lz4hc.h>
+}
+
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+#include "Common/Checksum.h"
+
+#include "BlockCompressionCodecLz4.h"
+
+using namespace Hypertable;
+
+
+BlockCompressionCodecLz4::BlockCompressionCodecLz4(const Args &args)
+  : m_high_compression(false), m_level(LZ4HC_CLEVEL_DEFAULT) {
+  if (!args.empty())
+    set_args(args);
+}
+
+
+BlockCompressionCodecLz4::~BlockCompressionCodecLz4() {
+}
+
+
+#define _NEXT_ARG(_code_) do { \
+  ++it; \
+  HT_EXPECT(it != arg_end, Error::BLOCK_COMPRESSOR_INVALID_ARG); \
+  _code_; \
+} while (0)
+
+void BlockCompressionCodecLz4::set_args(const Args &args) {
+  Args::const_iterator it = args.begin(), arg_end = args.end();
+
+  for (; it != arg_end; ++it) {
+    if (*it == "--hc")
+      m_high_compression = true;
+    else if (*it == "--level") {
+      _NEXT_ARG(m_level = atoi((*it).c_str()));
+      m_high_compression = true;
+    }
+    else
+      HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Unrecognized argument "
+                "to LZ4 codec: '%s'", (*it).c_str());
+  }
+}
+
+
+void
+BlockCompressionCodecLz4::deflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockCompressionHeader &header, size_t reserve) {
+  int avail_out = LZ4_compressBound((int)input.fill());
+  int zlen;
+
+  output.clear();
+  output.reserve(header.length() + avail_out + reserve);
+
+  if (m_high_compression)
+    zlen = LZ4_compress_HC((const char *)input.base,
+                           (char *)output.base + header.length(),
+                           (int)input.fill(), avail_out, m_level);
+  else
+    zlen = LZ4_compress_default((const char *)input.base,
+                                (char *)output.base + header.length(),
+                                (int)input.fill(), avail_out);
+
+  /* check for an incompressible block */
+  if (zlen <= 0 || (size_t)zlen >= input.fill()) {
+    header.set_compression_type(NONE);
+    memcpy(output.base+header.length(), input.base, input.fill());
+    header.set_data_length(input.fill());
+    header.set_data_zlength(input.fill());
+  }
+  else {
+    header.set_compression_type(LZ4);
+    header.set_data_length(input.fill());
+    header.set_data_zlength(zlen);
+  }
+
+  header.set_data_checksum(header.compute_checksum(output.base + header.length(),
+                header.get_data_zlength()));
+
+  output.ptr = output.base;
+  header.encode(&output.ptr);
+  output.ptr += header.get_data_zlength();
+}
+
+
+void
+BlockCompressionCodecLz4::inflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockCompressionHeader &header) {
+  const uint8_t *msg_ptr = input.base;
+  size_t remaining = input.fill();
+
+  header.decode(&msg_ptr, &remaining);
+
+  if (header.get_data_zlength() > remaining)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Block decompression error, "
+              "header zlength = %lu, actual = %lu",
+              (Lu)header.get_data_zlength(), (Lu)remaining);
+
+  uint32_t checksum = header.compute_checksum(msg_ptr, header.get_data_zlength());
+
+  if (checksum != header.get_data_checksum())
+    HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Compressed block "
+              "checksum mismatch header=%lx, computed=%lx",
+              (Lu)header.get_data_checksum(), (Lu)checksum);
+
+  try {
+    output.reserve(header.get_data_length());
+
+    // check compress bit
+    if (header.get_compression_type() == NONE)
+      memcpy(output.base, msg_ptr, header.get_data_length());
+    else {
+      int len = LZ4_decompress_safe((const char *)msg_ptr,
+                                    (char *)output.base,
+                                    (int)header.get_data_zlength(),
+                                    (int)header.get_data_length());
+      if (len < 0 || (size_t)len != header.get_data_length())
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error (return value = %d)", len);
+    }
+
+    output.ptr = output.base + header.get_data_length();
+  }
+  catch (Exception &e) {
+    output.free();
+    throw;
+  }
+}
@@ -0,0 +1,268 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstdlib>
+
+extern "C" {
+#include <zdict.h>
+}
+
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+#include "Common/Checksum.h"
+
+#include "BlockCompressionCodecZstd.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  /** Digested Zstd dictionary used for decompression */
+  class ZstdInflateDictionary : public BlockCompressionDictionary {
+  public:
+    ZstdInflateDictionary(ZSTD_DDict *ddict) : ddict(ddict) { }
+    virtual ~ZstdInflateDictionary() { ZSTD_freeDDict(ddict); }
+    virtual size_t memory_used() const { return ZSTD_sizeof_DDict(ddict); }
+    ZSTD_DDict *ddict;
+  };
+
+}
+
+
+BlockCompressionCodecZstd::BlockCompressionCodecZstd(const Args &args)
+  : m_cctx(0), m_dctx(0), m_cdict(0), m_ddict(0), m_dictionary_id(0),
+    m_level(ZSTD_CLEVEL_DEFAULT), m_dictionary_size(0) {
+  if (!args.empty())
+    set_args(args);
+}
+
+
+BlockCompressionCodecZstd::~BlockCompressionCodecZstd() {
+  ZSTD_freeCDict(m_cdict);
+  ZSTD_freeCCtx(m_cctx);
+  ZSTD_freeDCtx(m_dctx);
+}
+
+
+#define _NEXT_ARG(_code_) do { \
+  ++it; \
+  HT_EXPECT(it != arg_end, Error::BLOCK_COMPRESSOR_INVALID_ARG); \
+  _code_; \
+} while (0)
+
+void BlockCompressionCodecZstd::set_args(const Args &args) {
+  Args::const_iterator it = args.begin(), arg_end = args.end();
+
+  for (; it != arg_end; ++it) {
+    if (*it == "--level")
+      _NEXT_ARG(m_level = atoi((*it).c_str()));
+    else if (*it == "--dictionary-size")
+      _NEXT_ARG(m_dictionary_size = (size_t)strtoul((*it).c_str(), 0, 0));
+    else
+      HT_THROWF(Error::BLOCK_COMPRESSOR_INVALID_ARG, "Unrecognized argument "
+                "to Zstd codec: '%s'", (*it).c_str());
+  }
+}
+
+
+bool
+BlockCompressionCodecZstd::train_dictionary(const DynamicBuffer &samples,
+    const std::vector<size_t> &sample_sizes, DynamicBuffer &dictionary) {
+
+  if (m_dictionary_size == 0 || sample_sizes.empty())
+    return false;
+
+  dictionary.clear();
+  dictionary.reserve(m_dictionary_size);
+
+  size_t len = ZDICT_trainFromBuffer(dictionary.base, m_dictionary_size,
+                                     samples.base, &sample_sizes[0],
+                                     (unsigned)sample_sizes.size());
+  if (ZDICT_isError(len)) {
+    HT_WARNF("Unable to train Zstd dictionary from %u samples - %s",
+             (unsigned)sample_sizes.size(), ZDICT_getErrorName(len));
+    return false;
+  }
+
+  dictionary.ptr = dictionary.base + len;
+  return true;
+}
+
+
+void
+BlockCompressionCodecZstd::set_dictionary(const uint8_t *dictionary,
+                                          size_t len) {
+  ZSTD_freeCDict(m_cdict);
+  m_cdict = 0;
+
+  if (len == 0)
+    return;
+
+  if ((m_cdict = ZSTD_createCDict(dictionary, len, m_level)) == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+             "Unable to load Zstd compression dictionary");
+}
+
+
+BlockCompressionDictionary *
+BlockCompressionCodecZstd::create_inflate_dictionary(const uint8_t *dictionary,
+                                                     size_t len) {
+  ZSTD_DDict *ddict;
+
+  if (len == 0)
+    return 0;
+
+  if ((ddict = ZSTD_createDDict(dictionary, len)) == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+             "Unable to load Zstd decompression dictionary");
+  return new ZstdInflateDictionary(ddict);
+}
+
+
+void
+BlockCompressionCodecZstd::set_inflate_dictionary(BlockCompressionDictionaryPtr &dictionary) {
+  ZstdInflateDictionary *zdict =
+    dynamic_cast<ZstdInflateDictionary *>(dictionary.get());
+
+  if (dictionary && zdict == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+             "Dictionary was not created by the Zstd codec");
+
+  m_inflate_dictionary = dictionary;
+  m_ddict = zdict ? zdict->ddict : 0;
+  m_dictionary_id = m_ddict ? ZSTD_getDictID_fromDDict(m_ddict) : 0;
+}
+
+
+void
+BlockCompressionCodecZstd::deflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockCompressionHeader &header, size_t reserve) {
+  size_t avail_out = ZSTD_compressBound(input.fill());
+  size_t zlen;
+
+  if (m_cctx == 0 && (m_cctx = ZSTD_createCCtx()) == 0)
+    HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+             "Unable to create Zstd compression context");
+
+  output.clear();
+  output.reserve(header.length() + avail_out + reserve);
+
+  if (m_cdict)
+    zlen = ZSTD_compress_usingCDict(m_cctx, output.base + header.length(),
+                                    avail_out, input.base, input.fill(),
+                                    m_cdict);
+  else
+    zlen = ZSTD_compressCCtx(m_cctx, output.base + header.length(),
+                             avail_out, input.base, input.fill(), m_level);
+
+  if (ZSTD_isError(zlen))
+    HT_THROWF(Error::BLOCK_COMPRESSOR_DEFLATE_ERROR, "Zstd compression "
+              "error - %s", ZSTD_getErrorName(zlen));
+
+  /* check for an incompressible block */
+  if (zlen >= input.fill()) {
+    header.set_compression_type(NONE);
+    memcpy(output.base+header.length(), input.base, input.fill());
+    header.set_data_length(input.fill());
+    header.set_data_zlength(input.fill());
+  }
+  else {
+    header.set_compression_type(ZSTD);
+    header.set_data_length(input.fill());
+    header.set_data_zlength(zlen);
+  }
+
+  header.set_data_checksum(header.compute_checksum(output.base + header.length(),
+                header.get_data_zlength()));
+
+  output.ptr = output.base;
+  header.encode(&output.ptr);
+  output.ptr += header.get_data_zlength();
+}
+
+
+void
+BlockCompressionCodecZstd::inflate(const DynamicBuffer &input,
+    DynamicBuffer &output, BlockCompressionHeader &header) {
+  const uint8_t *msg_ptr = input.base;
+  size_t remaining = input.fill();
+
+  header.decode(&msg_ptr, &remaining);
+
+  if (header.get_data_zlength() > remaining)
+    HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Block decompression error, "
+              "header zlength = %lu, actual = %lu",
+              (Lu)header.get_data_zlength(), (Lu)remaining);
+
+  uint32_t checksum = header.compute_checksum(msg_ptr, header.get_data_zlength());
+
+  if (checksum != header.get_data_checksum())
+    HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Compressed block "
+              "checksum mismatch header=%lx, computed=%lx",
+              (Lu)header.get_data_checksum(), (Lu)checksum);
+
+  try {
+    output.reserve(header.get_data_length());
+
+    // check compress bit
+    if (header.get_compression_type() == NONE)
+      memcpy(output.base, msg_ptr, header.get_data_length());
+    else {
+      unsigned dictionary_id;
+      size_t len;
+
+      if (m_dctx == 0 && (m_dctx = ZSTD_createDCtx()) == 0)
+        HT_THROW(Error::BLOCK_COMPRESSOR_INIT_ERROR,
+                 "Unable to create Zstd decompression context");
+
+      dictionary_id = ZSTD_getDictID_fromFrame(msg_ptr,
+                                               header.get_data_zlength());
+      if (dictionary_id == 0)
+        len = ZSTD_decompressDCtx(m_dctx, output.base,
+                                  header.get_data_length(), msg_ptr,
+                                  header.get_data_zlength());
+      else if (dictionary_id == m_dictionary_id)
+        len = ZSTD_decompress_usingDDict(m_dctx, output.base,
+                                         header.get_data_length(), msg_ptr,
+                                         header.get_data_zlength(), m_ddict);
+      else
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "requires Zstd dictionary %u", dictionary_id);
+
+      if (ZSTD_isError(len))
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error - %s", ZSTD_getErrorName(len));
+
+      if (len != header.get_data_length())
+        HT_THROWF(Error::BLOCK_COMPRESSOR_INFLATE_ERROR, "Compressed block "
+                  "inflate error, expected %lu bytes, got %lu",
+                  (Lu)header.get_data_length(), (Lu)len);
+    }
+
+    output.ptr = output.base + header.get_data_length();
+  }
+  catch (Exception &e) {
+    output.free();
+    throw;
+  }
+}
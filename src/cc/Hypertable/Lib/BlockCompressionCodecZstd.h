@@ -0,0 +1,80 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_BLOCKCOMPRESSIONCODECZSTD_H
+#define HYPERTABLE_BLOCKCOMPRESSIONCODECZSTD_H
+
+extern "C" {
+#include <zstd.h>
+}
+
+#include "Common/DynamicBuffer.h"
+
+#include "BlockCompressionCodec.h"
+
+namespace Hypertable {
+
+  /**
+   * Zstandard block compression codec.  Recognized arguments are
+   * <code>--level N</code>, the compression level, and
+   * <code>--dictionary-size N</code>, the size of the dictionary that cell
+   * stores should train for blocks compressed with this codec (0, the
+   * default, disables dictionaries).  Each compressed block records the ID
+   * of the dictionary it was compressed with, so blocks compressed with and
+   * without a dictionary can be inflated by the same codec.
+   */
+  class BlockCompressionCodecZstd : public BlockCompressionCodec {
+
+  public:
+    BlockCompressionCodecZstd(const Args &args);
+    virtual ~BlockCompressionCodecZstd();
+
+    virtual void set_args(const Args &args);
+    virtual void deflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockCompressionHeader &header, size_t reserve=0);
+    virtual void inflate(const DynamicBuffer &input, DynamicBuffer &output,
+                         BlockCompressionHeader &header);
+    virtual int get_type() { return ZSTD; }
+
+    virtual size_t get_dictionary_size() { return m_dictionary_size; }
+    virtual bool train_dictionary(const DynamicBuffer &samples,
+                                  const std::vector<size_t> &sample_sizes,
+                                  DynamicBuffer &dictionary);
+    virtual void set_dictionary(const uint8_t *dictionary, size_t len);
+    virtual BlockCompressionDictionary *
+    create_inflate_dictionary(const uint8_t *dictionary, size_t len);
+    virtual void
+    set_inflate_dictionary(BlockCompressionDictionaryPtr &dictionary);
+
+  private:
+    ZSTD_CCtx   *m_cctx;
+    ZSTD_DCtx   *m_dctx;
+    ZSTD_CDict  *m_cdict;
+    ZSTD_DDict  *m_ddict;
+    unsigned     m_dictionary_id;
+    BlockCompressionDictionaryPtr m_inflate_dictionary;
+    int          m_level;
+    size_t       m_dictionary_size;
+  };
+
+}
+
+#endif // HYPERTABLE_BLOCKCOMPRESSIONCODECZSTD_H
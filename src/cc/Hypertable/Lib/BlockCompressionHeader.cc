@@ -33,6 +33,7 @@ using namespace Hypertable;
 using namespace Serialization;
 
 const size_t BlockCompressionHeader::LENGTH;
+const uint8_t BlockCompressionHeader::CRC32C_CHECKSUM_FLAG;
 
 
 /**
@@ -42,7 +43,8 @@ void BlockCompressionHeader::encode(uint8_t **bufp) {
   memcpy(*bufp, m_magic, 10);
   (*bufp) += 10;
   *(*bufp)++ = (uint8_t)length();
-  *(*bufp)++ = (uint8_t)m_compression_type;
+  *(*bufp)++ = (uint8_t)m_compression_type |
+    (m_checksum_type == CHECKSUM_CRC32C ? CRC32C_CHECKSUM_FLAG : 0);
   encode_i32(bufp, m_data_checksum);
   encode_i32(bufp, m_data_length);
   encode_i32(bufp, m_data_zlength);
@@ -53,7 +55,7 @@ void BlockCompressionHeader::encode(uint8_t **bufp) {
 
 void
 BlockCompressionHeader::write_header_checksum(uint8_t *base, uint8_t **bufp) {
-  uint16_t checksum16 = fletcher32(base, *bufp-base);
+  uint16_t checksum16 = compute_checksum(base, *bufp-base);
   encode_i16(bufp, checksum16);
 }
 
@@ -67,11 +69,13 @@ void BlockCompressionHeader::decode(const uint8_t **bufp, size_t *remainp) {
   if (*remainp < length())
     HT_THROW(Error::BLOCK_COMPRESSOR_TRUNCATED, "");
 
-  // verify checksum
+  // verify checksum, the algorithm is recorded in the compression type byte
   uint16_t header_checksum, header_checksum_computed;
   size_t remaining = 2;
   const uint8_t *ptr = *bufp + length() - 2;
-  header_checksum_computed = fletcher32(*bufp, length() - 2);
+  m_checksum_type = ((*bufp)[11] & CRC32C_CHECKSUM_FLAG) ?
+    CHECKSUM_CRC32C : CHECKSUM_FLETCHER32;
+  header_checksum_computed = compute_checksum(*bufp, length() - 2);
   header_checksum = decode_i16(&ptr, &remaining);
 
   if (header_checksum_computed != header_checksum)
@@ -88,7 +92,7 @@ void BlockCompressionHeader::decode(const uint8_t **bufp, size_t *remainp) {
     HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Unexpected header length"
               ": %lu, expecting: %lu", (Lu)header_length, (Lu)length());
 
-  m_compression_type = decode_byte(bufp, remainp);
+  m_compression_type = decode_byte(bufp, remainp) & ~CRC32C_CHECKSUM_FLAG;
 
   if (m_compression_type >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
     HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Unsupported compression type "
@@ -22,22 +22,35 @@
 #ifndef HYPERTABLE_BLOCKCOMPRESSIONHEADER_H
 #define HYPERTABLE_BLOCKCOMPRESSIONHEADER_H
 
+#include "Common/Checksum.h"
+
 namespace Hypertable {
 
   /**
    * Base class for compressed block header.
+   * The data and header checksums are computed with the algorithm given by
+   * #m_checksum_type, which defaults to CHECKSUM_CRC32C for newly written
+   * blocks.  The algorithm is recorded in the high bit of the serialized
+   * compression type byte (#CRC32C_CHECKSUM_FLAG); blocks written before
+   * this flag existed have it clear and are checksummed with fletcher32.
    */
   class BlockCompressionHeader {
   public:
 
     static const size_t LENGTH = 26;
 
+    /// Compression type byte flag indicating CRC-32C checksums
+    static const uint8_t CRC32C_CHECKSUM_FLAG = 0x80;
+
     BlockCompressionHeader() : m_data_length(0), m_data_zlength(0),
-        m_data_checksum(0), m_compression_type((uint16_t)-1) { }
+        m_data_checksum(0), m_compression_type((uint16_t)-1),
+        m_checksum_type(CHECKSUM_CRC32C) { }
 
     BlockCompressionHeader(const char *magic)
       : m_data_length(0), m_data_zlength(0), m_data_checksum(0),
-        m_compression_type((uint16_t)-1) { memcpy(m_magic, magic, 10); }
+        m_compression_type((uint16_t)-1), m_checksum_type(CHECKSUM_CRC32C) {
+      memcpy(m_magic, magic, 10);
+    }
 
     virtual ~BlockCompressionHeader() { return; }
 
@@ -58,6 +71,18 @@ namespace Hypertable {
     void     set_compression_type(uint16_t type) { m_compression_type = type; }
     uint16_t get_compression_type() { return m_compression_type; }
 
+    void     set_checksum_type(int type) { m_checksum_type = type; }
+    int      get_checksum_type() { return m_checksum_type; }
+
+    /** Computes a checksum with this header's checksum algorithm.
+     * @param data Pointer to the input data
+     * @param len Input data length in bytes
+     * @return The calculated checksum
+     */
+    uint32_t compute_checksum(const void *data, size_t len) {
+      return Hypertable::compute_checksum(m_checksum_type, data, len);
+    }
+
     virtual size_t length() { return LENGTH; }
     virtual void   encode(uint8_t **bufp);
     virtual void   write_header_checksum(uint8_t *base, uint8_t **bufp);
@@ -69,6 +94,7 @@ namespace Hypertable {
     uint32_t m_data_zlength;
     uint32_t m_data_checksum;
     uint16_t m_compression_type;
+    int m_checksum_type;
   };
 
 }
@@ -22,6 +22,8 @@
 #include "Common/Compat.h"
 #include <cassert>
 
+#include <boost/algorithm/string/predicate.hpp>
+
 #include "Common/Checksum.h"
 #include "Common/Config.h"
 #include "Common/DynamicBuffer.h"
@@ -51,24 +53,99 @@ const char CommitLog::MAGIC_LINK[10] =
 
 CommitLog::CommitLog(FilesystemPtr &fs, const String &log_dir, bool is_meta)
   : CommitLogBase(log_dir), m_fs(fs) {
-  initialize(log_dir, Config::properties, 0, is_meta);
+  initialize(log_dir, Config::properties, 0, is_meta, 1);
+}
+
+CommitLog::CommitLog(FilesystemPtr &fs, const String &log_dir,
+                     PropertiesPtr &props, bool is_meta,
+                     uint32_t fragment_num, uint32_t fragment_stride)
+  : CommitLogBase(log_dir), m_fs(fs) {
+  configure(props, is_meta);
+  m_cur_fragment_num = fragment_num;
+  m_fragment_stride = fragment_stride;
+  create_fragment();
 }
 
 CommitLog::~CommitLog() {
   delete m_compressor;
   close();
+  for (size_t i=0; i<m_streams.size(); i++)
+    delete m_streams[i];
 }
 
 void
 CommitLog::initialize(const String &log_dir, PropertiesPtr &props,
-                      CommitLogBase *init_log, bool is_meta) {
-  String compressor;
+                      CommitLogBase *init_log, bool is_meta,
+                      size_t stream_count) {
+
+  std::vector<String> listing;
+  bool stream_marker_found = false;
 
   m_log_dir = log_dir;
+  configure(props, is_meta);
+
+  if (init_log) {
+    if (m_range_reference_required)
+      m_range_reference_required = init_log->range_reference_required();
+    stitch_in(init_log);
+    foreach_ht (const CommitLogFileInfo *frag, m_fragment_queue) {
+      if (frag->num >= m_cur_fragment_num)
+        m_cur_fragment_num = frag->num + 1;
+    }
+    if (m_fs->exists(m_log_dir))
+      m_fs->readdir(m_log_dir, listing);
+  }
+  else {  // chose one past the max one found in the directory
+    uint32_t num;
+    m_fs->readdir(m_log_dir, listing);
+    for (size_t i=0; i<listing.size(); i++) {
+      num = atoi(listing[i].c_str());
+      if (num >= m_cur_fragment_num)
+        m_cur_fragment_num = num + 1;
+    }
+  }
+
+  for (size_t i=0; i<listing.size(); i++) {
+    if (boost::ends_with(listing[i], ".streams"))
+      stream_marker_found = true;
+  }
+
+  // Stream i starts at the i'th fragment number following the next multiple
+  // of the stream count
+  if (stream_count > 1) {
+    m_fragment_stride = stream_count;
+    if (m_cur_fragment_num % stream_count)
+      m_cur_fragment_num += stream_count - (m_cur_fragment_num % stream_count);
+  }
+
+  // Record where this run starts and how many streams it has, so the reader
+  // can regroup the interleaved fragments by stream.  A single-stream run
+  // only needs a marker if it follows a multi-stream one.
+  if (stream_count > 1 || stream_marker_found)
+    create_stream_marker(stream_count);
+
+  if (m_range_reference_required)
+    HT_INFOF("Range reference for '%s' is required", m_log_dir.c_str());
+  else
+    HT_INFOF("Range reference for '%s' is NOT required", m_log_dir.c_str());
+
+  create_fragment();
+
+  for (size_t i=1; i<stream_count; i++)
+    m_streams.push_back(new CommitLog(m_fs, m_log_dir, props, is_meta,
+                                      m_cur_fragment_num + i, stream_count));
+}
+
+
+void CommitLog::configure(PropertiesPtr &props, bool is_meta) {
+  String compressor;
+
   m_cur_fragment_length = 0;
   m_cur_fragment_num = 0;
+  m_fragment_stride = 1;
   m_needs_roll = false;
   m_replication = -1;
+  m_sync_fd = -1;
 
   if (is_meta)
     m_replication = props->get_i32("Hypertable.Metadata.Replication");
@@ -86,31 +163,31 @@ CommitLog::initialize(const String &log_dir, PropertiesPtr &props,
   boost::trim_right_if(m_log_dir, boost::is_any_of("/"));
 
   m_range_reference_required = props->get_bool("Hypertable.RangeServer.CommitLog.FragmentRemoval.RangeReferenceRequired");
+}
 
-  if (init_log) {
-    if (m_range_reference_required)
-      m_range_reference_required = init_log->range_reference_required();
-    stitch_in(init_log);
-    foreach_ht (const CommitLogFileInfo *frag, m_fragment_queue) {
-      if (frag->num >= m_cur_fragment_num)
-        m_cur_fragment_num = frag->num + 1;
-    }
+
+void CommitLog::create_stream_marker(size_t stream_count) {
+  String marker_fname = m_log_dir + "/" + m_cur_fragment_num + "."
+    + (uint32_t)stream_count + ".streams";
+
+  try {
+    m_fs->mkdirs(m_log_dir);
+    int fd = m_fs->create(marker_fname, Filesystem::OPEN_FLAG_OVERWRITE,
+                          -1, m_replication, -1);
+    StaticBuffer buf(1);
+    *buf.base = '0';
+    m_fs->append(fd, buf, Filesystem::O_FLUSH);
+    m_fs->close(fd);
   }
-  else {  // chose one past the max one found in the directory
-    uint32_t num;
-    std::vector<String> listing;
-    m_fs->readdir(m_log_dir, listing);
-    for (size_t i=0; i<listing.size(); i++) {
-      num = atoi(listing[i].c_str());
-      if (num >= m_cur_fragment_num)
-        m_cur_fragment_num = num + 1;
-    }
+  catch (Hypertable::Exception &e) {
+    HT_ERRORF("Problem creating stream marker '%s' - %s (%s)",
+              marker_fname.c_str(), e.what(), Error::get_text(e.code()));
+    throw;
   }
+}
 
-  if (m_range_reference_required)
-    HT_INFOF("Range reference for '%s' is required", m_log_dir.c_str());
-  else
-    HT_INFOF("Range reference for '%s' is NOT required", m_log_dir.c_str());
+
+void CommitLog::create_fragment() {
 
   m_cur_fragment_fname = m_log_dir + "/" + m_cur_fragment_num;
 
@@ -137,22 +214,49 @@ int64_t CommitLog::get_timestamp() {
 
 int
 CommitLog::sync() {
-  ScopedLock lock(m_mutex);
+  ScopedLock sync_lock(m_sync_mutex);
+  std::vector<int32_t> deferred_close_fds;
+  String fname;
+  int32_t fd;
   int error = Error::OK;
 
-  // Sync commit log update (protected by lock)
-  try {
+  // Only fetch the descriptor under the lock, so writes can proceed while
+  // the flush is in flight
+  {
+    ScopedLock lock(m_mutex);
     if (m_fd == -1)
       return Error::CLOSED;
-    m_fs->flush(m_fd);
+    fd = m_sync_fd = m_fd;
+    fname = m_cur_fragment_fname;
+  }
+
+  try {
+    m_fs->flush(fd);
     HT_DEBUG_OUT << "synced commit log explicitly" << HT_END;
   }
   catch (Exception &e) {
-    HT_ERRORF("Problem syncing commit log: %s: %s",
-              m_cur_fragment_fname.c_str(), e.what());
+    HT_ERRORF("Problem syncing commit log: %s: %s", fname.c_str(), e.what());
     error = e.code();
   }
 
+  {
+    ScopedLock lock(m_mutex);
+    m_sync_fd = -1;
+    deferred_close_fds.swap(m_deferred_close_fds);
+  }
+
+  // Close fragments that were rolled while they were being flushed
+  foreach_ht (int32_t deferred_fd, deferred_close_fds) {
+    try {
+      m_fs->close(deferred_fd);
+    }
+    catch (Exception &e) {
+      HT_ERRORF("Problem closing commit log fragment: %s", e.what());
+      if (error == Error::OK)
+        error = e.code();
+    }
+  }
+
   return error;
 }
 
@@ -218,7 +322,7 @@ int CommitLog::link_log(CommitLogBase *log_base) {
   header.set_compression_type(BlockCompressionCodec::NONE);
   header.set_data_length(log_dir.length() + 1);
   header.set_data_zlength(log_dir.length() + 1);
-  header.set_data_checksum(fletcher32(log_dir.c_str(), log_dir.length()+1));
+  header.set_data_checksum(header.compute_checksum(log_dir.c_str(), log_dir.length()+1));
 
   header.encode(&input.ptr);
   input.add(log_dir.c_str(), log_dir.length() + 1);
@@ -265,6 +369,16 @@ int CommitLog::link_log(CommitLogBase *log_base) {
 
 
 int CommitLog::close() {
+  int error = Error::OK;
+
+  for (size_t i=0; i<m_streams.size(); i++) {
+    int stream_error = m_streams[i]->close();
+    if (stream_error != Error::OK)
+      error = stream_error;
+  }
+
+  // Wait for an in-flight sync to finish
+  ScopedLock sync_lock(m_sync_mutex);
   ScopedLock lock(m_mutex);
 
   try {
@@ -280,12 +394,16 @@ int CommitLog::close() {
     return e.code();
   }
 
-  return Error::OK;
+  return error;
 }
 
 
 int CommitLog::purge(int64_t revision, StringSet &remove_ok_logs,
                      StringSet &removed_logs) {
+
+  for (size_t i=0; i<m_streams.size(); i++)
+    m_streams[i]->purge(revision, remove_ok_logs, removed_logs);
+
   ScopedLock lock(m_mutex);
 
   if (m_fd == -1)
@@ -391,7 +509,12 @@ int CommitLog::roll(CommitLogFileInfo **clfip) {
 
   if (m_fd >= 0) {
     try {
-      m_fs->close(m_fd);
+      // A fragment that is being flushed is closed by sync() once the
+      // flush completes
+      if (m_fd == m_sync_fd)
+        m_deferred_close_fds.push_back(m_fd);
+      else
+        m_fs->close(m_fd);
     }
     catch (Exception &e) {
       HT_ERRORF("Problem closing commit log fragment: %s: %s",
@@ -423,7 +546,7 @@ int CommitLog::roll(CommitLogFileInfo **clfip) {
     m_latest_revision = TIMESTAMP_MIN;
     m_cur_fragment_length = 0;
 
-    m_cur_fragment_num++;
+    m_cur_fragment_num += m_fragment_stride;
     m_cur_fragment_fname = m_log_dir + "/" + m_cur_fragment_num;
 
   }
@@ -479,9 +602,25 @@ CommitLog::compress_and_write(DynamicBuffer &input,
 
 
 void CommitLog::load_cumulative_size_map(CumulativeSizeMap &cumulative_size_map) {
-  ScopedLock lock(m_mutex);
   int64_t cumulative_total = 0;
   uint32_t distance = 0;
+
+  add_fragment_sizes(cumulative_size_map);
+  for (size_t i=0; i<m_streams.size(); i++)
+    m_streams[i]->add_fragment_sizes(cumulative_size_map);
+
+  for (CumulativeSizeMap::reverse_iterator riter = cumulative_size_map.rbegin();
+       riter != cumulative_size_map.rend(); riter++) {
+    (*riter).second.distance = distance++;
+    cumulative_total += (*riter).second.size;
+    (*riter).second.cumulative_size = cumulative_total;
+  }
+
+}
+
+
+void CommitLog::add_fragment_sizes(CumulativeSizeMap &cumulative_size_map) {
+  ScopedLock lock(m_mutex);
   CumulativeFragmentData frag_data;
 
   if (m_fd == -1)
@@ -501,18 +640,14 @@ void CommitLog::load_cumulative_size_map(CumulativeSizeMap &cumulative_size_map)
     frag_data.fragno = (*iter)->num;
     cumulative_size_map[(*iter)->revision] = frag_data;
   }
-
-  for (CumulativeSizeMap::reverse_iterator riter = cumulative_size_map.rbegin();
-       riter != cumulative_size_map.rend(); riter++) {
-    (*riter).second.distance = distance++;
-    cumulative_total += (*riter).second.size;
-    (*riter).second.cumulative_size = cumulative_total;
-  }
-
 }
 
 
 void CommitLog::get_stats(const String &prefix, String &result) {
+
+  for (size_t i=0; i<m_streams.size(); i++)
+    m_streams[i]->get_stats(prefix, result);
+
   ScopedLock lock(m_mutex);
 
   if (m_fd == -1)
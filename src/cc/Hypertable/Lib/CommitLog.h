@@ -25,6 +25,7 @@
 #include <deque>
 #include <map>
 #include <stack>
+#include <vector>
 
 #include <boost/thread/xtime.hpp>
 
@@ -77,12 +78,13 @@ namespace Hypertable {
      * @param props reference to properties map
      * @param init_log base log to pull fragments from
      * @param is_meta true for root, system and metadata logs
+     * @param stream_count number of independent write streams
      */
     CommitLog(FilesystemPtr &fs, const String &log_dir,
               PropertiesPtr &props, CommitLogBase *init_log = 0,
-              bool is_meta=true)
+              bool is_meta=true, size_t stream_count=1)
       : CommitLogBase(log_dir), m_fs(fs) {
-      initialize(log_dir, props, init_log, is_meta);
+      initialize(log_dir, props, init_log, is_meta, stream_count);
     }
 
     /**
@@ -112,7 +114,10 @@ namespace Hypertable {
      */
     int write(DynamicBuffer &buffer, int64_t revision, bool sync=true);
 
-    /** Sync previous updates written to commit log.
+    /** Sync previous updates written to commit log.  The log lock is not
+     * held while the flush is in flight, so writes issued from other threads
+     * proceed concurrently; a sync only covers writes that completed before
+     * it was called.  Syncs are serialized.
      *
      * @return Error::OK on success or error code on failure
      */
@@ -170,14 +175,40 @@ namespace Hypertable {
      * Returns total size of commit log
      */
     int64_t size() {
-      ScopedLock lock(m_mutex);
       int64_t total = 0;
-      for (LogFragmentQueue::iterator iter = m_fragment_queue.begin();
-           iter != m_fragment_queue.end(); iter++)
-        total += (*iter)->size;
+      {
+        ScopedLock lock(m_mutex);
+        for (LogFragmentQueue::iterator iter = m_fragment_queue.begin();
+             iter != m_fragment_queue.end(); iter++)
+          total += (*iter)->size;
+      }
+      for (size_t i=0; i<m_streams.size(); i++)
+        total += m_streams[i]->size();
       return total;
     }
 
+    /**
+     * Returns the number of write streams.  Each stream has its own
+     * fragment file, compressor and lock, so writes and syncs to different
+     * streams proceed independently.  The fragments of all streams live in
+     * the log directory; stream <i>i</i> of <i>n</i> uses the fragment
+     * numbers congruent to <i>i</i> modulo <i>n</i>.  A marker file named
+     * <code>&lt;first fragment&gt;.&lt;n&gt;.streams</code> records the
+     * layout, which the reader uses to merge the streams back into
+     * revision order.
+     */
+    size_t get_stream_count() { return m_streams.size() + 1; }
+
+    /**
+     * Returns a write stream.  Stream 0 is this log itself; the other
+     * streams may only be written to and synced.  Purging, statistics and
+     * linking go through this log, which covers all streams.
+     *
+     * @param i stream number
+     * @return pointer to stream
+     */
+    CommitLog *get_stream(size_t i) { return i ? m_streams[i-1] : this; }
+
     String get_current_fragment_file() {
       ScopedLock lock(m_mutex);
       return m_cur_fragment_fname;
@@ -187,8 +218,15 @@ namespace Hypertable {
     static const char MAGIC_LINK[10];
 
   private:
-    void initialize(const String &log_dir,
-                    PropertiesPtr &, CommitLogBase *init_log, bool is_meta);
+    CommitLog(FilesystemPtr &fs, const String &log_dir, PropertiesPtr &props,
+              bool is_meta, uint32_t fragment_num, uint32_t fragment_stride);
+    void initialize(const String &log_dir, PropertiesPtr &,
+                    CommitLogBase *init_log, bool is_meta,
+                    size_t stream_count);
+    void configure(PropertiesPtr &props, bool is_meta);
+    void create_stream_marker(size_t stream_count);
+    void create_fragment();
+    void add_fragment_sizes(CumulativeSizeMap &cumulative_size_map);
     int roll(CommitLogFileInfo **clfip=0);
     int compress_and_write(DynamicBuffer &input, BlockCompressionHeader *header,
                            int64_t revision, bool sync);
@@ -201,7 +239,12 @@ namespace Hypertable {
     int64_t                 m_cur_fragment_length;
     int64_t                 m_max_fragment_size;
     uint32_t                m_cur_fragment_num;
+    uint32_t                m_fragment_stride;
+    std::vector<CommitLog *> m_streams;
     int32_t                 m_fd;
+    Mutex                   m_sync_mutex;
+    int32_t                 m_sync_fd;
+    std::vector<int32_t>    m_deferred_close_fds;
     int32_t                 m_replication;
     bool                    m_needs_roll;
   };
@@ -20,6 +20,7 @@
  */
 
 #include "Common/Compat.h"
+#include <algorithm>
 #include <cassert>
 #include <vector>
 
@@ -66,7 +67,7 @@ namespace {
 
 CommitLogReader::CommitLogReader(FilesystemPtr &fs, const String &log_dir)
   : CommitLogBase(log_dir), m_fs(fs), m_fragment_queue_offset(0),
-    m_block_buffer(256), m_revision(TIMESTAMP_MIN), m_compressor(0),
+    m_group_end(0), m_cur_sequence(-1), m_block_buffer(256), m_compressor(0),
     m_last_fragment_id(-1), m_verbose(false) {
   if (get_bool("Hypertable.CommitLog.SkipErrors"))
     CommitLogBlockStream::ms_assert_on_error = false;
@@ -78,7 +79,7 @@ CommitLogReader::CommitLogReader(FilesystemPtr &fs, const String &log_dir)
 CommitLogReader::CommitLogReader(FilesystemPtr &fs, const String &log_dir,
         const std::vector<uint32_t> &fragment_filter)
   : CommitLogBase(log_dir), m_fs(fs), m_fragment_queue_offset(0),
-    m_block_buffer(256), m_revision(TIMESTAMP_MIN), m_compressor(0),
+    m_group_end(0), m_cur_sequence(-1), m_block_buffer(256), m_compressor(0),
     m_last_fragment_id(-1), m_verbose(false) {
   if (get_bool("Hypertable.CommitLog.SkipErrors"))
     CommitLogBlockStream::ms_assert_on_error = false;
@@ -93,59 +94,152 @@ CommitLogReader::CommitLogReader(FilesystemPtr &fs, const String &log_dir,
 bool
 CommitLogReader::next_raw_block(CommitLogBlockInfo *infop,
                                 BlockCompressionHeaderCommitLog *header) {
-  LogFragmentQueue::iterator fragment_queue_iter;
+  int next_sequence;
 
-  try_again:
-  fragment_queue_iter = m_fragment_queue.begin() + m_fragment_queue_offset;
-  if (fragment_queue_iter == m_fragment_queue.end())
+  // Fetch the block following the one last returned
+  if (m_cur_sequence != -1) {
+    advance(m_sequences[m_cur_sequence]);
+    m_cur_sequence = -1;
+  }
+
+  // The streams of a multi-stream log are written concurrently, so return
+  // the pending block with the lowest revision
+  while (true) {
+    next_sequence = -1;
+    for (size_t i=0; i<m_sequences.size(); i++) {
+      if (m_sequences[i].has_block &&
+          (next_sequence == -1 || m_sequences[i].header.get_revision() <
+           m_sequences[next_sequence].header.get_revision()))
+        next_sequence = (int)i;
+    }
+    if (next_sequence != -1)
+      break;
+    if (!load_merge_group())
+      return false;
+  }
+
+  FragmentSequence &seq = m_sequences[next_sequence];
+  CommitLogFileInfo *info = seq.fragments.front();
+  m_cur_sequence = next_sequence;
+  m_last_fragment_fname = info->block_stream->get_fname();
+  m_last_fragment_id = (int32_t)toplevel_fragment_id(info);
+  *infop = seq.block;
+  *header = seq.header;
+
+  if (m_verbose)
+    HT_INFOF("Replaying commit log fragment %s/%u", info->log_dir.c_str(),
+             info->num);
+
+  return true;
+}
+
+
+bool CommitLogReader::load_merge_group() {
+
+  // Drop the fragments of the finished group that had no valid blocks
+  for (uint64_t i = m_fragment_queue_offset; i < m_group_end; ) {
+    if (m_fragment_queue[i]->revision == TIMESTAMP_MIN) {
+      m_fragment_queue.erase(m_fragment_queue.begin() + i);
+      m_group_end--;
+    }
+    else
+      i++;
+  }
+
+  m_fragment_queue_offset = m_group_end;
+  m_sequences.clear();
+
+  if (m_fragment_queue_offset == m_fragment_queue.size())
     return false;
 
-  if ((*fragment_queue_iter)->block_stream == 0) {
-    (*fragment_queue_iter)->block_stream =
-      new CommitLogBlockStream(m_fs, (*fragment_queue_iter)->log_dir,
-                               format("%u", (*fragment_queue_iter)->num));
-    m_last_fragment_fname = (*fragment_queue_iter)->block_stream->get_fname();
-    m_last_fragment_id = (int32_t)toplevel_fragment_id(*fragment_queue_iter);
+  // The group is the run of queued fragments of one log directory that were
+  // written with the same stream layout, split into one sequence per stream
+  CommitLogFileInfo *first = m_fragment_queue[m_fragment_queue_offset];
+  uint32_t start, count, fragment_start, fragment_count;
+
+  get_stream_layout(first->log_dir, first->num, &start, &count);
+  m_sequences.resize(count);
+
+  for (; m_group_end < m_fragment_queue.size(); m_group_end++) {
+    CommitLogFileInfo *info = m_fragment_queue[m_group_end];
+    if (info->log_dir != first->log_dir)
+      break;
+    get_stream_layout(info->log_dir, info->num, &fragment_start,
+                      &fragment_count);
+    if (fragment_start != start)
+      break;
+    m_sequences[(info->num - start) % count].fragments.push_back(info);
   }
 
-  if (!(*fragment_queue_iter)->block_stream->next(infop, header)) {
-    CommitLogFileInfo *info = *fragment_queue_iter;
-    delete info->block_stream;
-    info->block_stream = 0;
+  for (size_t i=0; i<m_sequences.size(); i++)
+    advance(m_sequences[i]);
 
-    if (m_revision == TIMESTAMP_MIN) {
-      if (m_verbose)
+  return true;
+}
+
+
+void CommitLogReader::advance(FragmentSequence &seq) {
+
+  while (!seq.fragments.empty()) {
+    CommitLogFileInfo *info = seq.fragments.front();
+
+    if (info->block_stream == 0)
+      info->block_stream = new CommitLogBlockStream(m_fs, info->log_dir,
+                                                    format("%u", info->num));
+
+    if (!info->block_stream->next(&seq.block, &seq.header)) {
+      delete info->block_stream;
+      info->block_stream = 0;
+
+      // Fragments left at TIMESTAMP_MIN are dropped with their group
+      if (seq.revision == TIMESTAMP_MIN && m_verbose)
         HT_INFOF("Skipping log fragment '%s/%u' because unable to read any "
                  " valid blocks", info->log_dir.c_str(), info->num);
-      m_fragment_queue.erase(fragment_queue_iter);
+      info->revision = seq.revision;
+      seq.revision = TIMESTAMP_MIN;
+      seq.fragments.pop_front();
+      continue;
     }
-    else {
-      info->revision = m_revision;
-      m_fragment_queue_offset++;
+
+    if (seq.header.check_magic(CommitLog::MAGIC_LINK)) {
+      assert(seq.header.get_compression_type() == BlockCompressionCodec::NONE);
+      String log_dir = (const char *)(seq.block.block_ptr + seq.header.length());
+      boost::trim_right_if(log_dir, boost::is_any_of("/"));
+      m_linked_log_hashes.insert(md5_hash(log_dir.c_str()));
+      m_linked_logs.insert(log_dir);
+      load_fragments(log_dir, info);
+      if (seq.header.get_revision() > m_latest_revision)
+        m_latest_revision = seq.header.get_revision();
+      if (seq.header.get_revision() > seq.revision)
+        seq.revision = seq.header.get_revision();
+      continue;
     }
-    m_revision = TIMESTAMP_MIN;
-    goto try_again;
-  }
 
-  if (header->check_magic(CommitLog::MAGIC_LINK)) {
-    assert(header->get_compression_type() == BlockCompressionCodec::NONE);
-    String log_dir = (const char *)(infop->block_ptr + header->length());
-    boost::trim_right_if(log_dir, boost::is_any_of("/"));
-    m_linked_log_hashes.insert(md5_hash(log_dir.c_str()));
-    m_linked_logs.insert(log_dir);
-    load_fragments(log_dir, *fragment_queue_iter);
-    if (header->get_revision() > m_latest_revision)
-      m_latest_revision = header->get_revision();
-    if (header->get_revision() > m_revision)
-      m_revision = header->get_revision();
-    goto try_again;
+    seq.has_block = true;
+    return;
   }
 
-  if (m_verbose)
-    HT_INFOF("Replaying commit log fragment %s/%u", (*fragment_queue_iter)->log_dir.c_str(),
-             (*fragment_queue_iter)->num);
+  seq.has_block = false;
+}
 
-  return true;
+
+void CommitLogReader::get_stream_layout(const String &log_dir, uint32_t num,
+                                        uint32_t *startp, uint32_t *countp) {
+  std::map<String, StreamLayout>::iterator iter;
+  StreamLayout::iterator run;
+
+  *startp = 0;
+  *countp = 1;
+
+  if ((iter = m_stream_layouts.find(log_dir)) == m_stream_layouts.end())
+    return;
+
+  run = iter->second.upper_bound(num);
+  if (run == iter->second.begin())
+    return;
+  --run;
+  *startp = run->first;
+  *countp = run->second;
 }
 
 void CommitLogReader::get_init_fragment_ids(vector<uint32_t> &ids) {
@@ -173,10 +267,9 @@ CommitLogReader::next(const uint8_t **blockp, size_t *lenp,
         m_compressor->inflate(zblock, m_block_buffer, *header);
       }
       catch (Exception &e) {
-        LogFragmentQueue::iterator iter = m_fragment_queue.begin() + m_fragment_queue_offset;
         HT_ERRORF("Inflate error in CommitLog fragment %s starting at "
                   "postion %lld (block len = %lld) - %s",
-                  (*iter)->block_stream->get_fname().c_str(),
+                  m_last_fragment_fname.c_str(),
                   (Lld)binfo.start_offset, (Lld)(binfo.end_offset
                   - binfo.start_offset), Error::get_text(e.code()));
         continue;
@@ -185,18 +278,52 @@ CommitLogReader::next(const uint8_t **blockp, size_t *lenp,
       if (header->get_revision() > m_latest_revision)
         m_latest_revision = header->get_revision();
 
-      if (header->get_revision() > m_revision)
-        m_revision = header->get_revision();
+      if (header->get_revision() > m_sequences[m_cur_sequence].revision)
+        m_sequences[m_cur_sequence].revision = header->get_revision();
 
       *blockp = m_block_buffer.base;
       *lenp = m_block_buffer.fill();
       return true;
     }
 
-    LogFragmentQueue::iterator iter = m_fragment_queue.begin() + m_fragment_queue_offset;
     HT_WARNF("Corruption detected in CommitLog fragment %s starting at "
              "postion %lld for %lld bytes - %s",
-             (*iter)->block_stream->get_fname().c_str(),
+             m_last_fragment_fname.c_str(),
+             (Lld)binfo.start_offset, (Lld)(binfo.end_offset
+             - binfo.start_offset), Error::get_text(binfo.error));
+  }
+
+  struct LtClfip swo;
+  sort(m_fragment_queue.begin(), m_fragment_queue.end(), swo);
+
+  return false;
+}
+
+
+bool
+CommitLogReader::next_compressed(DynamicBuffer &zblock,
+                                 BlockCompressionHeaderCommitLog *header) {
+  CommitLogBlockInfo binfo;
+
+  while (next_raw_block(&binfo, header)) {
+
+    if (binfo.error == Error::OK) {
+      zblock.clear();
+      zblock.ensure(binfo.block_len);
+      zblock.add_unchecked(binfo.block_ptr, binfo.block_len);
+
+      if (header->get_revision() > m_latest_revision)
+        m_latest_revision = header->get_revision();
+
+      if (header->get_revision() > m_sequences[m_cur_sequence].revision)
+        m_sequences[m_cur_sequence].revision = header->get_revision();
+
+      return true;
+    }
+
+    HT_WARNF("Corruption detected in CommitLog fragment %s starting at "
+             "postion %lld for %lld bytes - %s",
+             m_last_fragment_fname.c_str(),
              (Lld)binfo.start_offset, (Lld)(binfo.end_offset
              - binfo.start_offset), Error::get_text(binfo.error));
   }
@@ -210,6 +337,8 @@ CommitLogReader::next(const uint8_t **blockp, size_t *lenp,
 
 void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent) {
   vector<string> listing;
+  vector<uint32_t> fragments;
+  std::map<uint32_t, String> stream_markers;
   CommitLogFileInfo *fi;
   int mark = -1;
 
@@ -247,6 +376,23 @@ void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent)
     }
 
     char *endptr;
+
+    // <start>.<count>.streams marks a run of a multi-stream log
+    if (boost::ends_with(listing[i], ".streams")) {
+      uint32_t start = (uint32_t)strtoul(listing[i].c_str(), &endptr, 10);
+      uint32_t count = 0;
+      if (*endptr == '.')
+        count = (uint32_t)strtoul(endptr + 1, 0, 10);
+      if (count == 0)
+        HT_WARNF("Invalid file '%s' found in commit log directory '%s'",
+                 listing[i].c_str(), log_dir.c_str());
+      else {
+        m_stream_layouts[log_dir][start] = count;
+        stream_markers[start] = listing[i];
+      }
+      continue;
+    }
+
     long num = strtol(listing[i].c_str(), &endptr, 10);
     if (m_fragment_filter.size() && log_dir == m_log_dir &&
       m_fragment_filter.find(num) == m_fragment_filter.end()) {
@@ -276,6 +422,29 @@ void CommitLogReader::load_fragments(String log_dir, CommitLogFileInfo *parent)
         parent->references++;
       if (fi->size > 0) {
         m_fragment_queue.push_back(fi);
+        fragments.push_back(fi->num);
+      }
+    }
+  }
+
+  // A stream marker is no longer needed once the fragments of its run have
+  // all been purged and a later run has started
+  if (m_fragment_filter.empty() && stream_markers.size() > 1) {
+    std::map<uint32_t, String>::iterator iter, next_iter;
+    vector<uint32_t>::iterator fragment_iter;
+    next_iter = stream_markers.begin();
+    for (iter = next_iter++; next_iter != stream_markers.end(); iter = next_iter++) {
+      fragment_iter = lower_bound(fragments.begin(), fragments.end(),
+                                  iter->first);
+      if (fragment_iter != fragments.end() && *fragment_iter < next_iter->first)
+        continue;
+      String marker_filename = log_dir + "/" + iter->second;
+      try {
+        m_fs->remove(marker_filename);
+      }
+      catch (Hypertable::Exception &e) {
+        HT_WARNF("Problem removing stream marker '%s' - %s",
+                 marker_filename.c_str(), e.what());
       }
     }
   }
@@ -22,6 +22,8 @@
 #ifndef HYPERTABLE_COMMITLOGREADER_H
 #define HYPERTABLE_COMMITLOGREADER_H
 
+#include <deque>
+#include <map>
 #include <stack>
 #include <vector>
 
@@ -58,10 +60,27 @@ namespace Hypertable {
     bool next(const uint8_t **blockp, size_t *lenp,
               BlockCompressionHeaderCommitLog *);
 
+    /**
+     * Fetches the next block without inflating it.  The compressed block is
+     * copied into <code>zblock</code> so that it remains valid across calls,
+     * which allows the caller to inflate several blocks concurrently.  The
+     * block's revision is accounted to its fragment as soon as the block is
+     * read; if it later fails to inflate, the fragment is merely retained
+     * longer than necessary.
+     *
+     * @param zblock buffer to hold the compressed block
+     * @param header filled in with the block header
+     * @return true if a block was fetched, false at the end of the log
+     */
+    bool next_compressed(DynamicBuffer &zblock,
+                         BlockCompressionHeaderCommitLog *header);
+
     void reset() {
       m_fragment_queue_offset = 0;
+      m_group_end = 0;
+      m_sequences.clear();
+      m_cur_sequence = -1;
       m_block_buffer.clear();
-      m_revision = TIMESTAMP_MIN;
       m_latest_revision = TIMESTAMP_MIN;
       m_error_map.clear();
     }
@@ -78,13 +97,37 @@ namespace Hypertable {
 
   private:
 
+    /**
+     * The fragments written by one stream of a log directory, in fragment
+     * number order, along with the next block of the front fragment.
+     */
+    struct FragmentSequence {
+      FragmentSequence() : revision(TIMESTAMP_MIN), has_block(false) { }
+      std::deque<CommitLogFileInfo *> fragments;
+      CommitLogBlockInfo block;
+      BlockCompressionHeaderCommitLog header;
+      int64_t revision;
+      bool has_block;
+    };
+
+    /** Maps the first fragment number of a run of a multi-stream log to
+     * the number of streams of that run */
+    typedef std::map<uint32_t, uint32_t> StreamLayout;
+
     void load_fragments(String log_dir, CommitLogFileInfo *parent);
     void load_compressor(uint16_t ztype);
+    bool load_merge_group();
+    void advance(FragmentSequence &seq);
+    void get_stream_layout(const String &log_dir, uint32_t num,
+                           uint32_t *startp, uint32_t *countp);
 
     FilesystemPtr     m_fs;
     uint64_t          m_fragment_queue_offset;
+    uint64_t          m_group_end;
+    std::vector<FragmentSequence> m_sequences;
+    int               m_cur_sequence;
+    std::map<String, StreamLayout> m_stream_layouts;
     DynamicBuffer     m_block_buffer;
-    int64_t           m_revision;
 
     typedef hash_map<uint16_t, BlockCompressionCodecPtr> CompressorMap;
 
@@ -28,6 +28,8 @@
 #include "BlockCompressionCodecLzo.h"
 #include "BlockCompressionCodecQuicklz.h"
 #include "BlockCompressionCodecSnappy.h"
+#include "BlockCompressionCodecZstd.h"
+#include "BlockCompressionCodecLz4.h"
 
 using namespace Hypertable;
 using namespace std;
@@ -63,6 +65,12 @@ CompressorFactory::parse_block_codec_spec(const std::string &spec,
   if (name == "snappy")
     return BlockCompressionCodec::SNAPPY;
 
+  if (name == "zstd")
+    return BlockCompressionCodec::ZSTD;
+
+  if (name == "lz4")
+    return BlockCompressionCodec::LZ4;
+
   HT_ERRORF("unknown codec type: %s", name.c_str());
   return BlockCompressionCodec::UNKNOWN;
 }
@@ -83,6 +91,10 @@ CompressorFactory::create_block_codec(BlockCompressionCodec::Type type,
     return new BlockCompressionCodecQuicklz(args);
   case BlockCompressionCodec::SNAPPY:
     return new BlockCompressionCodecSnappy(args);
+  case BlockCompressionCodec::ZSTD:
+    return new BlockCompressionCodecZstd(args);
+  case BlockCompressionCodec::LZ4:
+    return new BlockCompressionCodecLz4(args);
   default:
     HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE, "Invalid compression "
               "type: '%d'", (int)type);
@@ -44,7 +44,8 @@ public:
   static BlockCompressionCodec *
   create_block_codec(const std::string& spec) {
     BlockCompressionCodec::Args args;
-    return create_block_codec(parse_block_codec_spec(spec, args));
+    BlockCompressionCodec::Type type = parse_block_codec_spec(spec, args);
+    return create_block_codec(type, args);
   }
 };
 
@@ -344,6 +344,7 @@ namespace {
     "      | REPLICATION int",
     "      | COMPRESSOR compressor_spec",
     "      | BLOOMFILTER bloom_filter_spec",
+    "      | CELLCACHE cell_cache_spec",
     "",
     "    compressor_spec:",
     "      bmz [ bmz_options ]",
@@ -351,6 +352,8 @@ namespace {
     "      | quicklz",
     "      | snappy",
     "      | zlib [ zlib_options ]",
+    "      | zstd [ zstd_options ]",
+    "      | lz4 [ lz4_options ]",
     "      | none",
     "",
     "    bmz_options:",
@@ -362,6 +365,14 @@ namespace {
     "      | --best",
     "      | --normal",
     "",
+    "    zstd_options:",
+    "      --level int",
+    "      | --dictionary-size int",
+    "",
+    "    lz4_options:",
+    "      --hc",
+    "      | --level int",
+    "",
     "    bloom_filter_spec:",
     "      rows [ bloom_filter_options ]",
     "      | rows+cols [ bloom_filter_options ]",
@@ -372,6 +383,7 @@ namespace {
     "      --bits-per-item float",
     "      --num-hashes int",
     "      --max-approx-items int",
+    "      --blocked",
     "",
     "Description",
     "-----------",
@@ -475,6 +487,7 @@ namespace {
     "      | REPLICATION int",
     "      | COMPRESSOR compressor_spec",
     "      | BLOOMFILTER bloom_filter_spec",
+    "      | CELLCACHE cell_cache_spec",
     "",
     "    compressor_spec:",
     "      bmz [ bmz_options ]",
@@ -482,6 +495,8 @@ namespace {
     "      | quicklz",
     "      | snappy",
     "      | zlib [ zlib_options ]",
+    "      | zstd [ zstd_options ]",
+    "      | lz4 [ lz4_options ]",
     "      | none",
     "",
     "    bmz_options:",
@@ -493,6 +508,14 @@ namespace {
     "      | --best",
     "      | --normal",
     "",
+    "    zstd_options:",
+    "      --level int",
+    "      | --dictionary-size int",
+    "",
+    "    lz4_options:",
+    "      --hc",
+    "      | --level int",
+    "",
     "    bloom_filter_spec:",
     "      rows [ bloom_filter_options ]",
     "      | rows+cols [ bloom_filter_options ]",
@@ -503,6 +526,11 @@ namespace {
     "      --bits-per-item float",
     "      --num-hashes int",
     "      --max-approx-items int",
+    "      --blocked",
+    "",
+    "    cell_cache_spec:",
+    "      map",
+    "      | skiplist",
     "",
     "    table_option:",
     "      MAX_VERSIONS int",
@@ -705,6 +733,7 @@ namespace {
     "  * REPLICATION int",
     "  * COMPRESSOR compressor_spec",
     "  * BLOOMFILTER bloom_filter_spec",
+    "  * CELLCACHE cell_cache_spec",
     "",
     "The COUNTER option makes all column families in the access group",
     "counter columns (see COUNTER description under Column Family Options",
@@ -780,6 +809,17 @@ namespace {
     "  --max-approx-items arg  Number of cell store items used to guess the number",
     "                          of actual bloom filter entries (default = 1000)",
     "",
+    "The CELLCACHE option selects the in-memory data structure used for the",
+    "access group's cell cache.  The map form, which is the default, is a",
+    "balanced tree that serializes updates and scanners behind a single lock.",
+    "The skiplist form is a concurrent skip list that allows scanners to read",
+    "the cell cache without blocking concurrent updates.  The default is",
+    "defined by the config property:",
+    "Hypertable.RangeServer.AccessGroup.CellCache.DefaultType.",
+    "",
+    "  * map",
+    "  * skiplist",
+    "",
     "Compressors",
     "-----------",
     "",
@@ -792,6 +832,8 @@ namespace {
     "  * quicklz",
     "  * zlib",
     "  * snappy",
+    "  * zstd",
+    "  * lz4",
     "  * none",
     "",
     "The default code is snappy for cell store blocks.  The following list ",
@@ -801,6 +843,12 @@ namespace {
     "  bmz --offset arg    Starting fingerprint offset (default = 0)",
     "  zlib -9 [ --best ]  Highest compression ratio (at the cost of speed)",
     "  zlib --normal       Normal compression ratio",
+    "  zstd --level arg    Compression level (default = 3)",
+    "  zstd --dictionary-size arg",
+    "                      Size of the dictionary trained from the first",
+    "                      blocks of each cell store (default = 0, disabled)",
+    "  lz4 --hc            High compression mode",
+    "  lz4 --level arg     High compression level (default = 9)",
     "",
     0
   };
@@ -810,7 +858,9 @@ namespace {
     "SELECT",
     "======",
     "",
-    "    SELECT ('*' | (column_predicate [',' column_predicate]*))",
+    "    SELECT ('*' | (column_predicate [',' column_predicate]*)",
+    "            | aggregate_function '(' ('*' | (column_predicate",
+    "                                     [',' column_predicate]*)) ')')",
     "      FROM table_name",
     "      [where_clause]",
     "      [options_spec]",
@@ -827,6 +877,8 @@ namespace {
     "",
     "    relop: '=' | '<' | '<=' | '>' | '>=' | '=^'",
     "",
+    "    aggregate_function: COUNT | SUM | MIN | MAX",
+    "",
     "    column_predicate:",
     "      column_family",
     "    | column_family ':' column_qualifer",
@@ -871,7 +923,8 @@ namespace {
     "      | FS = '<char>'",
     "      | NO_ESCAPE",
     "      | RETURN_DELETES",
-    "      | SCAN_AND_FILTER_ROWS)*",
+    "      | SCAN_AND_FILTER_ROWS",
+    "      | GROUP BY ROW)*",
     "",
     "    timestamp:",
     "      'YYYY-MM-DD HH:MM:SS[.ss|:nanoseconds]'",
@@ -907,6 +960,16 @@ namespace {
     "    SELECT col, col2 FROM test WHERE col =^ \"prefix\";",
     "    SELECT foo FROM test WHERE bar = \"value\";",
     "",
+    "An aggregate function computes one value per selected column family instead",
+    "of returning the cells.  The aggregate is evaluated by the RangeServers, which",
+    "return a partial result for each range, and the client combines the partial",
+    "results.  COUNT counts the cells; SUM, MIN and MAX interpret the cell values",
+    "(or counter values) as decimal integers and ignore values that are not.  The",
+    "result is displayed as one line per column family with an empty row key.",
+    "With the GROUP BY ROW option the aggregate is computed for each row instead.",
+    "Aggregates cannot be combined with OFFSET, CELL_OFFSET, CELL_LIMIT or",
+    "RETURN_DELETES, and LIMIT is only allowed together with GROUP BY ROW.",
+    "",
     "Options",
     "-------",
     "",
@@ -1043,6 +1106,11 @@ namespace {
     "filter the requested rows at the range server, which will reduce the number of",
     "network roundtrips required when the number of rows requested is very large.",
     "",
+    "GROUP BY ROW",
+    "",
+    "Computes the aggregate function separately for each row.  Each output line",
+    "holds the row key, the column family and the aggregate value.",
+    "",
     "Examples",
     "--------",
     "",
@@ -1066,6 +1134,8 @@ namespace {
     "                              CELL = \"cow\",\"tag:Ab\" OR ",
     "                              CELL =^ \"foo\",\"tag:acya\");",
     "    SELECT * FROM test INTO FILE \"dfs:///tmp/foo\";",
+    "    SELECT COUNT(*) FROM test WHERE ROW =^ 'b';",
+    "    SELECT SUM(clicks) FROM test GROUP BY ROW;",
     "    SELECT col2:\"bird\" FROM RegexpTest WHERE ROW REGEXP \"http://.*\";",
     "    SELECT col1:/^w[^a-zA-Z]*$/ FROM RegexpTest WHERE ROW REGEXP \"m.*\\s\\S\";",
     "    SELECT CELLS col1:/^w[^a-zA-Z]*$/ FROM RegexpTest WHERE VALUE REGEXP \"l.*e\";",
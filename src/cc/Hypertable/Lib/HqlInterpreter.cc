@@ -317,6 +317,9 @@ cmd_select(NamespacePtr &ns, ConnectionManagerPtr &conn_manager,
   String dfs = "dfs://";
   String localfs = "file://";
   char fs = state.field_separator ? state.field_separator : '\t';
+  // aggregates are returned as values even for KEYS_ONLY scans
+  bool keys_only = state.scan.keys_only &&
+    state.scan.builder.get().aggregate == ScanSpec::AGGREGATE_NONE;
 
   table = ns->open_table(state.table_name);
   scanner = table->create_scanner(state.scan.builder.get(), 0, true);
@@ -340,13 +343,13 @@ cmd_select(NamespacePtr &ns, ConnectionManagerPtr &conn_manager,
       fout.push(boost::iostreams::file_descriptor_sink(state.scan.outfile));
 
     if (state.scan.display_timestamps) {
-      if (state.scan.keys_only)
+      if (keys_only)
         fout << "#timestamp" << fs << "row\n";
       else
         fout << "#timestamp" << fs << "row" << fs << "column" << fs << "value\n";
     }
     else {
-      if (state.scan.keys_only)
+      if (keys_only)
         fout << "#row\n";
       else
         fout << "#row" << fs << "column" << fs << "value\n";
@@ -405,7 +408,7 @@ cmd_select(NamespacePtr &ns, ConnectionManagerPtr &conn_manager,
              &row_unescaped_buf, &row_unescaped_len);
     else
       row_unescaped_buf = cell.row_key;
-    if (!state.scan.keys_only) {
+    if (!keys_only) {
       if (cell.column_family && *cell.column_family) {
         fout << row_unescaped_buf << fs << cell.column_family;
         if (cell.column_qualifier && *cell.column_qualifier) {
@@ -228,7 +228,7 @@ namespace Hypertable {
       ScanState() : display_timestamps(false), keys_only(false),
           current_rowkey_set(false), start_time_set(false),
           end_time_set(false), current_timestamp_set(false),
-	  current_relop(0), buckets(0) { }
+	  current_relop(0), buckets(0), aggregate(0) { }
 
       void set_time_interval(::int64_t start, ::int64_t end) {
         HQL_DEBUG("("<< start <<", "<< end <<")");
@@ -264,6 +264,7 @@ namespace Hypertable {
       bool    current_timestamp_set;
       int current_relop;
       int buckets;
+      ::uint32_t aggregate;
     };
 
     class ParserState {
@@ -755,6 +756,16 @@ namespace Hypertable {
       ParserState &state;
     };
 
+    struct set_access_group_cell_cache {
+      set_access_group_cell_cache(ParserState &state) : state(state) { }
+      void operator()(char const * str, char const *end) const {
+        state.ag->cell_cache = String(str, end-str);
+        trim_if(state.ag->cell_cache, boost::is_any_of("'\""));
+        to_lower(state.ag->cell_cache);
+      }
+      ParserState &state;
+    };
+
     struct access_group_add_column_family {
       access_group_add_column_family(ParserState &state) : state(state) { }
       void operator()(char const *str, char const *end) const {
@@ -1642,6 +1653,38 @@ namespace Hypertable {
       ParserState &state;
     };
 
+    struct scan_set_aggregate_function {
+      scan_set_aggregate_function(ParserState &state, ::uint32_t function)
+        : state(state), function(function) { }
+      void operator()(char const *str, char const *end) const {
+        state.scan.aggregate = function;
+      }
+      ParserState &state;
+      ::uint32_t function;
+    };
+
+    // applied once the whole aggregate selection has matched, so that a
+    // column named e.g. "counter" does not enable COUNT
+    struct scan_set_aggregate {
+      scan_set_aggregate(ParserState &state) : state(state) { }
+      void operator()(char const *str, char const *end) const {
+        state.scan.builder.set_aggregate(state.scan.aggregate);
+      }
+      ParserState &state;
+    };
+
+    struct scan_set_aggregate_by_row {
+      scan_set_aggregate_by_row(ParserState &state) : state(state) { }
+      void operator()(char const *str, char const *end) const {
+        ::uint32_t function = state.scan.builder.get().aggregate;
+        if (function == ScanSpec::AGGREGATE_NONE)
+          HT_THROW(Error::HQL_PARSE_ERROR, "GROUP BY ROW requires an "
+                   "aggregate function (COUNT, SUM, MIN or MAX)");
+        state.scan.builder.set_aggregate(function, true);
+      }
+      ParserState &state;
+    };
+
     struct set_insert_timestamp {
       set_insert_timestamp(ParserState &state) : state(state) { }
       void operator()(char const *str, char const *end) const {
@@ -1914,6 +1957,7 @@ namespace Hypertable {
           Token BLOCKSIZE    = as_lower_d["blocksize"];
           Token ACCESS       = as_lower_d["access"];
           Token GROUP        = as_lower_d["group"];
+          Token BY           = as_lower_d["by"];
           Token INDEX        = as_lower_d["index"];
           Token QUALIFIER    = as_lower_d["qualifier"];
           Token DESCRIBE     = as_lower_d["describe"];
@@ -1979,6 +2023,10 @@ namespace Hypertable {
           Token RETURN_DELETES = as_lower_d["return_deletes"];
           Token SCAN_AND_FILTER_ROWS = as_lower_d["scan_and_filter_rows"];
           Token KEYS_ONLY    = as_lower_d["keys_only"];
+          Token COUNT        = as_lower_d["count"];
+          Token SUM          = as_lower_d["sum"];
+          Token MIN          = as_lower_d["min"];
+          Token MAX          = as_lower_d["max"];
           Token RANGE        = as_lower_d["range"];
           Token UPDATE       = as_lower_d["update"];
           Token SCANNER      = as_lower_d["scanner"];
@@ -1994,6 +2042,7 @@ namespace Hypertable {
           Token COMMIT       = as_lower_d["commit"];
           Token LOG          = as_lower_d["log"];
           Token BLOOMFILTER  = as_lower_d["bloomfilter"];
+          Token CELLCACHE    = as_lower_d["cellcache"];
           Token TRUE         = as_lower_d["true"];
           Token FALSE        = as_lower_d["false"];
           Token YES          = as_lower_d["yes"];
@@ -2509,6 +2558,8 @@ namespace Hypertable {
             | COMPRESSOR >> *EQUAL >> string_literal[
                 set_access_group_compressor(self.state)]
             | bloom_filter_option
+            | CELLCACHE >> *EQUAL >> string_literal[
+                set_access_group_cell_cache(self.state)]
             ;
 
           bloom_filter_option
@@ -2532,7 +2583,8 @@ namespace Hypertable {
 
           select_statement
             = SELECT >> !(CELLS)
-              >> ('*' | (column_selection >> *(COMMA >> column_selection)))
+              >> (aggregate_selection[scan_set_aggregate(self.state)] | '*'
+                  | (column_selection >> *(COMMA >> column_selection)))
               >> FROM >> user_identifier[set_table_name(self.state)]
               >> !where_clause
               >> *(option_spec)
@@ -2555,6 +2607,23 @@ namespace Hypertable {
                         NO_QUALIFIER)])
             ;
 
+          aggregate_selection
+            = aggregate_function >> LPAREN
+              >> ('*' | (column_selection >> *(COMMA >> column_selection)))
+              >> RPAREN
+            ;
+
+          aggregate_function
+            = COUNT[scan_set_aggregate_function(self.state,
+                                                ScanSpec::AGGREGATE_COUNT)]
+            | SUM[scan_set_aggregate_function(self.state,
+                                              ScanSpec::AGGREGATE_SUM)]
+            | MIN[scan_set_aggregate_function(self.state,
+                                              ScanSpec::AGGREGATE_MIN)]
+            | MAX[scan_set_aggregate_function(self.state,
+                                              ScanSpec::AGGREGATE_MAX)]
+            ;
+
           where_clause
             = WHERE >> where_predicate >> *(AND >> where_predicate)
             ;
@@ -2652,6 +2721,7 @@ namespace Hypertable {
             | NOESCAPE[set_noescape(self.state)]
             | NO_ESCAPE[set_noescape(self.state)]
             | SCAN_AND_FILTER_ROWS[scan_set_scan_and_filter_rows(self.state)]
+            | GROUP >> BY >> ROW[scan_set_aggregate_by_row(self.state)]
             | FS >> EQUAL >> single_string_literal[set_field_separator(self.state)]
             ;
 
@@ -2747,6 +2817,8 @@ namespace Hypertable {
           BOOST_SPIRIT_DEBUG_RULE(column_option);
           BOOST_SPIRIT_DEBUG_RULE(column_predicate);
           BOOST_SPIRIT_DEBUG_RULE(column_selection);
+          BOOST_SPIRIT_DEBUG_RULE(aggregate_selection);
+          BOOST_SPIRIT_DEBUG_RULE(aggregate_function);
           BOOST_SPIRIT_DEBUG_RULE(create_definition);
           BOOST_SPIRIT_DEBUG_RULE(create_definitions);
           BOOST_SPIRIT_DEBUG_RULE(add_column_definition);
@@ -2871,7 +2943,8 @@ namespace Hypertable {
           describe_table_statement, show_statement, select_statement,
           where_clause, where_predicate,
           time_predicate, relop, row_interval, row_predicate, column_predicate,
-          value_predicate, column_selection,
+          value_predicate, column_selection, aggregate_selection,
+          aggregate_function,
           option_spec, date_expression, unused_tokens, datetime, date, time, year,
           load_data_statement, load_data_input, load_data_option, insert_statement,
           insert_value_list, insert_value, delete_statement,
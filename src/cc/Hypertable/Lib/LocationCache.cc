@@ -26,19 +26,26 @@
 #include <iostream>
 
 #include "Common/InetAddr.h"
+#include "Common/TclHash.h"
 
 #include "LocationCache.h"
 
 using namespace Hypertable;
 using namespace std;
 
+LocationCache::LocationCache(uint32_t max_entries, size_t shard_count)
+  : m_shard_count(shard_count ? shard_count : 1), m_max_entries(max_entries) {
+  m_shards = new Shard[m_shard_count];
+  atomic_set(&m_entry_count, 0);
+  atomic_set(&m_next_victim_shard, 0);
+}
+
 /**
  * Insert
  */
 void
 LocationCache::insert(const char *table_name, RangeLocationInfo &range_loc_info,
                       bool pegged) {
-  ScopedLock lock(m_mutex);
   Value *newval = new Value;
   LocationMap::iterator iter;
   LocationCacheKey key;
@@ -54,42 +61,33 @@ LocationCache::insert(const char *table_name, RangeLocationInfo &range_loc_info,
   newval->end_row = range_loc_info.end_row;
   newval->addrp = get_constant_address(range_loc_info.addr);
   newval->pegged = pegged;
+  newval->referenced = true;
 
-  key.table_name = m_strings.get(table_name);
   key.end_row = (range_loc_info.end_row == "") ? 0 : newval->end_row.c_str();
 
-  // remove old entry
-  if ((iter = m_location_map.find(key)) != m_location_map.end())
-    remove((*iter).second);
-
-  // make room for the new entry
-  while (m_location_map.size() >= m_max_entries) {
-    if (m_tail->pegged)
-      move_to_head(m_tail);
-    else
-      remove(m_tail);
-  }
+  Shard &shard = get_shard(table_name);
+  boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
 
-  // add to head
-  if (m_head == 0) {
-    assert(m_tail == 0);
-    newval->next = newval->prev = 0;
-    m_head = m_tail = newval;
-  }
-  else {
-    m_head->next = newval;
-    newval->prev = m_head;
-    newval->next = 0;
-    m_head = newval;
+  key.table_name = shard.strings.get(table_name);
+
+  // remove old entry
+  if ((iter = shard.location_map.find(key)) != shard.location_map.end())
+    remove(shard, iter);
+
+  // make room for the new entry; if everything is pegged or the other
+  // shards are busy, let the cache run over its limit for now
+  while (atomic_read(&m_entry_count) >= (int)m_max_entries) {
+    if (!evict(shard) && !evict_other(shard))
+      break;
   }
 
-  // Insert the new entry into the map, recording an iterator to the entry
+  // Insert the new entry into the map
   {
     std::pair<LocationMap::iterator, bool> old_entry;
     LocationMap::value_type map_value(key, newval);
-    old_entry = m_location_map.insert(map_value);
+    old_entry = shard.location_map.insert(map_value);
     assert(old_entry.second);
-    newval->map_iter = old_entry.first;
+    atomic_inc(&m_entry_count);
   }
 
 }
@@ -101,9 +99,13 @@ LocationCache::~LocationCache() {
   for (AddressSet::iterator iter = m_addresses.begin();
        iter != m_addresses.end(); ++iter)
     delete *iter;
-  for (LocationMap::iterator lm_it = m_location_map.begin();
-       lm_it != m_location_map.end(); ++lm_it)
-    delete (*lm_it).second;
+  for (size_t i=0; i<m_shard_count; i++) {
+    LocationMap &location_map = m_shards[i].location_map;
+    for (LocationMap::iterator lm_it = location_map.begin();
+         lm_it != location_map.end(); ++lm_it)
+      delete (*lm_it).second;
+  }
+  delete [] m_shards;
 }
 
 
@@ -113,7 +115,6 @@ LocationCache::~LocationCache() {
 bool
 LocationCache::lookup(const char * table_name, const char *rowkey,
                       RangeLocationInfo *rane_loc_infop, bool inclusive) {
-  ScopedLock lock(m_mutex);
   LocationMap::iterator iter;
   LocationCacheKey key;
 
@@ -122,7 +123,10 @@ LocationCache::lookup(const char * table_name, const char *rowkey,
   key.table_name = table_name;
   key.end_row = rowkey;
 
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
+  Shard &shard = get_shard(table_name);
+  boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+
+  if ((iter = shard.location_map.lower_bound(key)) == shard.location_map.end())
     return false;
 
   if (strcmp((*iter).first.table_name, table_name))
@@ -137,7 +141,10 @@ LocationCache::lookup(const char * table_name, const char *rowkey,
       return false;
   }
 
-  move_to_head((*iter).second);
+  // Only write the reference bit when it changes to avoid bouncing the
+  // entry's cache line between reader threads
+  if (!(*iter).second->referenced)
+    (*iter).second->referenced = true;
 
   rane_loc_infop->start_row = (*iter).second->start_row;
   rane_loc_infop->end_row   = (*iter).second->end_row;
@@ -146,8 +153,10 @@ LocationCache::lookup(const char * table_name, const char *rowkey,
   return true;
 }
 
+/**
+ * Invalidate
+ */
 bool LocationCache::invalidate(const char *table_name, const char *rowkey) {
-  ScopedLock lock(m_mutex);
   LocationMap::iterator iter;
   LocationCacheKey key;
 
@@ -158,101 +167,124 @@ bool LocationCache::invalidate(const char *table_name, const char *rowkey) {
   key.table_name = table_name;
   key.end_row = rowkey;
 
-  if ((iter = m_location_map.lower_bound(key)) == m_location_map.end())
+  Shard &shard = get_shard(table_name);
+  boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+
+  if ((iter = shard.location_map.lower_bound(key)) == shard.location_map.end())
     return false;
 
   if (strcmp((*iter).first.table_name, table_name))
     return false;
 
-#if 0
-  if (rowkey && strcmp(rowkey, (*iter).second->start_row.c_str()) < 0)
-    return false;
-#endif
   if ((rowkey == 0 && !(*iter).second->start_row.empty()) ||
       (rowkey && strcmp(rowkey, (*iter).second->start_row.c_str()) < 0))
     return false;
 
-  remove((*iter).second);
+  remove(shard, iter);
   return true;
 }
 
 void LocationCache::invalidate_host(const String &hostname) {
-  ScopedLock lock(m_mutex);
   CommAddress addr;
 
   addr.set_proxy(hostname);
   const CommAddress *addrp = get_constant_address(addr);
 
-  LocationMap::iterator iter = m_location_map.begin();
-  Value *val = 0;
-  while (iter != m_location_map.end()) {
-    val = 0;
-    if (iter->second->addrp == addrp)
-      val = iter->second;
-    ++iter;
-    if (val)
-      remove(val);
+  for (size_t i=0; i<m_shard_count; i++) {
+    Shard &shard = m_shards[i];
+    boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+    LocationMap::iterator iter = shard.location_map.begin();
+    while (iter != shard.location_map.end()) {
+      if (iter->second->addrp == addrp)
+        remove(shard, iter++);
+      else
+        ++iter;
+    }
   }
 }
 
 
 void LocationCache::display(std::ostream &out) {
-  for (Value *value = m_head; value; value = value->prev)
-    out << "DUMP: end=" << value->end_row << " start=" << value->start_row
-        << endl;
+  for (size_t i=0; i<m_shard_count; i++) {
+    Shard &shard = m_shards[i];
+    boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+    for (LocationMap::iterator iter = shard.location_map.begin();
+         iter != shard.location_map.end(); ++iter)
+      out << "DUMP: end=" << iter->second->end_row << " start="
+          << iter->second->start_row << endl;
+  }
 }
 
 
-/**
- * MoveToHead
- */
-void LocationCache::move_to_head(Value *cacheval) {
-
-  if (m_head == cacheval)
-    return;
-
-  // unstich entry from cache
-  cacheval->next->prev = cacheval->prev;
-  if (cacheval->prev == 0)
-    m_tail = cacheval->next;
-  else
-    cacheval->prev->next = cacheval->next;
-
-  cacheval->next = 0;
-  cacheval->prev = m_head;
-  m_head->next = cacheval;
-  m_head = cacheval;
+LocationCache::Shard &
+LocationCache::get_shard(const char *table_name) {
+  return m_shards[tcl_hash(table_name) % m_shard_count];
 }
 
 
 /**
- * remove
+ * Evicts one entry from <code>shard</code>, which must be exclusively
+ * locked.  Advances the clock hand over the shard's entries, skipping
+ * pegged entries and clearing reference bits, until it reaches an
+ * unreferenced entry.  Gives up after two full sweeps.
  */
-void LocationCache::remove(Value *cacheval) {
-  assert(cacheval);
-  if (m_tail == cacheval) {
-    m_tail = cacheval->next;
-    if (m_tail)
-      m_tail->prev = 0;
+bool LocationCache::evict(Shard &shard) {
+  size_t limit = 2 * shard.location_map.size();
+
+  for (size_t i=0; i<limit; i++) {
+    if (shard.hand == shard.location_map.end())
+      shard.hand = shard.location_map.begin();
+    Value *value = shard.hand->second;
+    if (value->pegged)
+      ++shard.hand;
+    else if (value->referenced) {
+      value->referenced = false;
+      ++shard.hand;
+    }
     else {
-      assert (m_head == cacheval);
-      m_head = 0;
+      remove(shard, shard.hand);
+      return true;
     }
   }
-  else if (m_head == cacheval) {
-    m_head = m_head->prev;
-    m_head->next = 0;
-  }
-  else {
-    cacheval->next->prev = cacheval->prev;
-    cacheval->prev->next = cacheval->next;
+  return false;
+}
+
+
+/**
+ * Evicts one entry from some shard other than <code>shard</code>, which
+ * is exclusively locked by the caller.  Other shards are only try-locked
+ * so that two inserters evicting from each other's shards cannot deadlock.
+ */
+bool LocationCache::evict_other(Shard &shard) {
+  for (size_t i=0; i<m_shard_count; i++) {
+    size_t n = (size_t)atomic_inc_return(&m_next_victim_shard) % m_shard_count;
+    Shard &victim = m_shards[n];
+    if (&victim == &shard)
+      continue;
+    boost::unique_lock<boost::shared_mutex> lock(victim.mutex,
+                                                 boost::try_to_lock);
+    if (lock.owns_lock() && evict(victim))
+      return true;
   }
-  m_location_map.erase(cacheval->map_iter);
+  return false;
+}
+
+
+/**
+ * remove
+ */
+void LocationCache::remove(Shard &shard, LocationMap::iterator iter) {
+  Value *cacheval = iter->second;
+  if (shard.hand == iter)
+    ++shard.hand;
+  shard.location_map.erase(iter);
+  atomic_dec(&m_entry_count);
   delete cacheval;
 }
 
 
 const CommAddress *LocationCache::get_constant_address(const CommAddress &addr) {
+  ScopedLock lock(m_address_mutex);
   AddressSet::iterator iter = m_addresses.find(&addr);
 
   if (iter != m_addresses.end())
@@ -262,4 +294,3 @@ const CommAddress *LocationCache::get_constant_address(const CommAddress &addr)
   m_addresses.insert(new_addr);
   return new_addr;
 }
-
@@ -27,6 +27,9 @@
 #include <map>
 #include <set>
 
+#include <boost/thread/shared_mutex.hpp>
+
+#include "Common/atomic.h"
 #include "Common/Mutex.h"
 #include "Common/FlyweightString.h"
 #include "Common/InetAddr.h"
@@ -81,23 +84,39 @@ namespace Hypertable {
 
 
   /**
-   *  This class acts as a cache of Range location information.  It
+   * Cache of range location information.  Entries are keyed by table name
+   * and range end row, and a lookup finds the range containing a row with a
+   * lower_bound() search of the table's entries.  The cache is split into
+   * independently locked shards selected by hashing the table name, so all
+   * of a table's entries live in one shard and a lookup, insert or
+   * invalidation touches exactly one shard.  Each shard is guarded by a
+   * reader/writer lock, so lookups, which are by far the most common
+   * operation, only take a shared lock and proceed in parallel with each
+   * other and with inserts into other shards.  Instead of maintaining an exact
+   * LRU list, which would require an exclusive lock on every lookup, each
+   * entry carries a CLOCK reference bit that lookups set.  When the cache is
+   * full, a clock hand sweeps the shard's entries in key order, clearing
+   * reference bits and evicting the first unreferenced, unpegged entry it
+   * finds, which approximates LRU.
    */
   class LocationCache : public ReferenceCount {
   public:
-    /**
-     */
+    /** Cache entry */
     struct Value {
-      struct Value *prev, *next;
-      std::map<LocationCacheKey, Value *>::iterator map_iter;
       std::string start_row;
       std::string end_row;
       const CommAddress *addrp;
       bool pegged;
+      /// CLOCK reference bit, set by lookups under a shared lock
+      volatile bool referenced;
     };
 
-    LocationCache(uint32_t max_entries) : m_mutex(), m_location_map(),
-        m_head(0), m_tail(0), m_max_entries(max_entries) { return; }
+    /**
+     * Constructor.
+     * @param max_entries Maximum number of entries in the cache
+     * @param shard_count Number of independently locked shards
+     */
+    LocationCache(uint32_t max_entries, size_t shard_count=1);
     ~LocationCache();
 
     void insert(const char * table_name, RangeLocationInfo &range_loc_info,
@@ -111,8 +130,26 @@ namespace Hypertable {
     void display(std::ostream &);
 
   private:
-    void move_to_head(Value *cacheval);
-    void remove(Value *cacheval);
+
+    typedef std::map<LocationCacheKey, Value *> LocationMap;
+
+    /** Cache shard.  Holds the entries of the tables whose names hash to
+     * it, along with the clock hand used to choose eviction victims.  Table
+     * name strings are interned per shard since they are only added under the
+     * shard's exclusive lock.
+     */
+    struct Shard {
+      Shard() : hand(location_map.end()) { }
+      boost::shared_mutex mutex;
+      LocationMap location_map;
+      LocationMap::iterator hand;
+      FlyweightString strings;
+    };
+
+    Shard &get_shard(const char *table_name);
+    bool evict(Shard &shard);
+    bool evict_other(Shard &shard);
+    void remove(Shard &shard, LocationMap::iterator iter);
 
     const CommAddress *get_constant_address(const CommAddress &addr);
 
@@ -123,16 +160,15 @@ namespace Hypertable {
       }
     };
 
-    typedef std::map<LocationCacheKey, Value *> LocationMap;
     typedef std::set<const CommAddress *, CommAddressPointerLt> AddressSet;
 
-    Mutex          m_mutex;
-    LocationMap    m_location_map;
-    AddressSet     m_addresses;
-    Value         *m_head;
-    Value         *m_tail;
+    Shard         *m_shards;
+    size_t         m_shard_count;
+    atomic_t       m_entry_count;
+    atomic_t       m_next_victim_shard;
     uint32_t       m_max_entries;
-    FlyweightString m_strings;
+    Mutex          m_address_mutex;
+    AddressSet     m_addresses;
   };
 
   typedef intrusive_ptr<LocationCache> LocationCachePtr;
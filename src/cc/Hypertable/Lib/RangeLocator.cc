@@ -121,12 +121,17 @@ RangeLocator::RangeLocator(PropertiesPtr &cfg, ConnectionManagerPtr &conn_mgr,
       = cfg->get_i32("Hypertable.RangeLocator.RootMetadataRetryInterval");
 
   int cache_size = cfg->get_i64("Hypertable.LocationCache.MaxEntries");
+  int cache_shards = cfg->get_i32("Hypertable.LocationCache.Shards");
+  if (cache_shards <= 0)
+    HT_THROWF(Error::CONFIG_BAD_VALUE, "Invalid value for "
+              "Hypertable.LocationCache.Shards (%d), must be positive",
+              cache_shards);
 
   m_toplevel_dir = cfg->get_str("Hypertable.Directory");
   boost::trim_if(m_toplevel_dir, boost::is_any_of("/"));
   m_toplevel_dir = String("/") + m_toplevel_dir;
 
-  m_cache = new LocationCache(cache_size);
+  m_cache = new LocationCache(cache_size, cache_shards);
   // register hyperspace session callback
   m_hyperspace_session_callback.m_rangelocator = this;
   m_hyperspace->add_callback(&m_hyperspace_session_callback);
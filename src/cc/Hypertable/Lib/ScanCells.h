@@ -38,6 +38,7 @@ namespace Hypertable {
 
 using namespace std;
 class IntervalScannerAsync;
+class TableScannerAsync;
 
 /**
  * This class takes allows vector access to a set of cells contained in an EventPtr without
@@ -82,6 +83,7 @@ protected:
 
   friend class IntervalScannerAsync;
   friend class IndexScannerCallback;
+  friend class TableScannerAsync;
 
   /**
    * @param event the event that contains the scan results
@@ -92,7 +94,8 @@ protected:
 
   /**
    * adds a new cell to the internal cell buffer
-   * this is an internal method required by IndexScannerCallback
+   * this is an internal method required by IndexScannerCallback and
+   * TableScannerAsync
    */
   void add(Cell &cell, bool own = true);
 
@@ -111,14 +111,15 @@ size_t ScanSpec::encoded_length() const {
                encoded_length_vstr(row_regexp) +
                encoded_length_vstr(value_regexp) +
                encoded_length_vi32(row_offset) +
-               encoded_length_vi32(cell_offset);
+               encoded_length_vi32(cell_offset) +
+               encoded_length_vi32(aggregate);
 
   foreach_ht(const char *c, columns) len += encoded_length_vstr(c);
   foreach_ht(const RowInterval &ri, row_intervals) len += ri.encoded_length();
   foreach_ht(const CellInterval &ci, cell_intervals) len += ci.encoded_length();
   foreach_ht(const ColumnPredicate &cp, column_predicates) len += cp.encoded_length();
 
-  return len + 8 + 8 + 3;
+  return len + 8 + 8 + 4;
 }
 
 void ScanSpec::encode(uint8_t **bufp) const {
@@ -143,6 +144,8 @@ void ScanSpec::encode(uint8_t **bufp) const {
   encode_bool(bufp, scan_and_filter_rows);
   encode_vi32(bufp, row_offset);
   encode_vi32(bufp, cell_offset);
+  encode_vi32(bufp, aggregate);
+  encode_bool(bufp, aggregate_by_row);
 }
 
 void ScanSpec::decode(const uint8_t **bufp, size_t *remainp) {
@@ -176,7 +179,16 @@ void ScanSpec::decode(const uint8_t **bufp, size_t *remainp) {
     value_regexp = decode_vstr(bufp, remainp);
     scan_and_filter_rows = decode_bool(bufp, remainp);
     row_offset = decode_vi32(bufp, remainp);
-    cell_offset = decode_vi32(bufp, remainp));
+    cell_offset = decode_vi32(bufp, remainp);
+    // older clients don't send the aggregation descriptor
+    if (*remainp > 0) {
+      aggregate = decode_vi32(bufp, remainp);
+      aggregate_by_row = decode_bool(bufp, remainp);
+    }
+    else {
+      aggregate = AGGREGATE_NONE;
+      aggregate_by_row = false;
+    });
 }
 
 
@@ -240,6 +252,10 @@ ostream &Hypertable::operator<<(ostream &os, const ScanSpec &scan_spec) {
   os <<" scan_and_filter_rows=" << scan_spec.scan_and_filter_rows;
   os <<" row_offset=" << scan_spec.row_offset;
   os <<" cell_offset=" << scan_spec.cell_offset;
+  if (scan_spec.aggregate != ScanSpec::AGGREGATE_NONE) {
+    os <<" aggregate=" << aggregate_function_name(scan_spec.aggregate);
+    os <<" aggregate_by_row=" << scan_spec.aggregate_by_row;
+  }
 
   if (!scan_spec.row_intervals.empty()) {
     os << "\n rows=";
@@ -281,7 +297,8 @@ ScanSpec::ScanSpec(CharArena &arena, const ScanSpec &ss)
     time_interval(ss.time_interval.first, ss.time_interval.second),
     return_deletes(ss.return_deletes), keys_only(ss.keys_only),
     row_regexp(arena.dup(ss.row_regexp)), value_regexp(arena.dup(ss.value_regexp)),
-    scan_and_filter_rows(ss.scan_and_filter_rows) {
+    scan_and_filter_rows(ss.scan_and_filter_rows),
+    aggregate(ss.aggregate), aggregate_by_row(ss.aggregate_by_row) {
   columns.reserve(ss.columns.size());
   row_intervals.reserve(ss.row_intervals.size());
   cell_intervals.reserve(ss.cell_intervals.size());
@@ -341,7 +358,38 @@ void ScanSpec::parse_column(const char *column_str, String &family,
   }
 }
 
+const char *Hypertable::aggregate_function_name(uint32_t aggregate) {
+  switch (aggregate) {
+  case ScanSpec::AGGREGATE_NONE:  return "NONE";
+  case ScanSpec::AGGREGATE_COUNT: return "COUNT";
+  case ScanSpec::AGGREGATE_SUM:   return "SUM";
+  case ScanSpec::AGGREGATE_MIN:   return "MIN";
+  case ScanSpec::AGGREGATE_MAX:   return "MAX";
+  default:
+    break;
+  }
+  return "UNKNOWN";
+}
+
 void ScanSpec::throw_if_invalid() const {
+  // limits and offsets are applied before aggregation on each range, so the
+  // only one that keeps its meaning is a row limit on per-row aggregates
+  if (aggregate != AGGREGATE_NONE) {
+    if (aggregate > AGGREGATE_MAX)
+      HT_THROWF(Error::BAD_SCAN_SPEC, "Invalid aggregation function (%u)",
+                (unsigned)aggregate);
+    if (keys_only && aggregate != AGGREGATE_COUNT)
+      HT_THROWF(Error::BAD_SCAN_SPEC, "%s not allowed in combination with "
+                "keys_only", aggregate_function_name(aggregate));
+    if (cell_limit || row_offset || cell_offset ||
+        (row_limit && !aggregate_by_row))
+      HT_THROW(Error::BAD_SCAN_SPEC, "Aggregation not allowed in combination "
+               "with limit or offset predicates");
+    if (return_deletes)
+      HT_THROW(Error::BAD_SCAN_SPEC, "Aggregation not allowed in combination "
+               "with return_deletes");
+  }
+
   // check if the ColumnPredicate column is identical to the retrieved column
   if (columns.empty() || column_predicates.empty())
     return;
@@ -143,12 +143,25 @@ typedef std::vector<ColumnPredicate, ColumnPredicateAlloc> ColumnPredicates;
  */
 class ScanSpec {
 public:
+  /**
+   * Aggregation functions that the range servers can evaluate in place of
+   * returning the scanned cells.
+   */
+  enum {
+    AGGREGATE_NONE = 0,
+    AGGREGATE_COUNT,
+    AGGREGATE_SUM,
+    AGGREGATE_MIN,
+    AGGREGATE_MAX
+  };
+
   ScanSpec()
     : row_limit(0), cell_limit(0), cell_limit_per_family(0), 
       row_offset(0), cell_offset(0), max_versions(0),
       time_interval(TIMESTAMP_MIN, TIMESTAMP_MAX),
       return_deletes(false), keys_only(false),
-      row_regexp(0), value_regexp(0), scan_and_filter_rows(false) { }
+      row_regexp(0), value_regexp(0), scan_and_filter_rows(false),
+      aggregate(AGGREGATE_NONE), aggregate_by_row(false) { }
   ScanSpec(CharArena &arena)
     : row_limit(0), cell_limit(0), cell_limit_per_family(0), 
       row_offset(0), cell_offset(0), max_versions(0), columns(CstrAlloc(arena)),
@@ -157,7 +170,8 @@ public:
       column_predicates(ColumnPredicateAlloc(arena)),
       time_interval(TIMESTAMP_MIN, TIMESTAMP_MAX),
       return_deletes(false), keys_only(false),
-      row_regexp(0), value_regexp(0), scan_and_filter_rows(false) { }
+      row_regexp(0), value_regexp(0), scan_and_filter_rows(false),
+      aggregate(AGGREGATE_NONE), aggregate_by_row(false) { }
   ScanSpec(CharArena &arena, const ScanSpec &);
   ScanSpec(const uint8_t **bufp, size_t *remainp) { decode(bufp, remainp); }
 
@@ -183,6 +197,8 @@ public:
     row_regexp = 0;
     value_regexp = 0;
     scan_and_filter_rows = false;
+    aggregate = AGGREGATE_NONE;
+    aggregate_by_row = false;
   }
 
   /** 
@@ -210,6 +226,8 @@ public:
     other.row_regexp = row_regexp;
     other.value_regexp = value_regexp;
     other.scan_and_filter_rows = scan_and_filter_rows;
+    other.aggregate = aggregate;
+    other.aggregate_by_row = aggregate_by_row;
     other.column_predicates = column_predicates;
   }
 
@@ -364,8 +382,18 @@ public:
   const char *row_regexp;
   const char *value_regexp;
   bool scan_and_filter_rows;
+  uint32_t aggregate;
+  bool aggregate_by_row;
 };
 
+/**
+ * Returns the HQL name of an aggregation function (e.g. "COUNT")
+ *
+ * @param aggregate one of the ScanSpec::AGGREGATE_XXX values
+ * @return name of the aggregation function
+ */
+const char *aggregate_function_name(uint32_t aggregate);
+
 /**
  * Helper class for building a ScanSpec.  This class manages the allocation
  * of all string members.
@@ -570,6 +598,26 @@ public:
     m_scan_spec.scan_and_filter_rows = val;
   }
 
+  /**
+   * Computes an aggregate over each selected column family on the range
+   * servers instead of returning the cells themselves.  The range servers
+   * return one partial aggregate per column family for each range, which
+   * the client combines into the final result.  If <code>by_row</code> is
+   * set, the aggregate is computed separately for every row.  SUM, MIN and
+   * MAX interpret the cell values as decimal integers and skip values that
+   * are not.
+   *
+   * @param function one of the ScanSpec::AGGREGATE_XXX values
+   * @param by_row compute one aggregate per row
+   */
+  void set_aggregate(uint32_t function, bool by_row = false) {
+    if (function > ScanSpec::AGGREGATE_MAX)
+      HT_THROWF(Error::BAD_SCAN_SPEC, "Invalid aggregation function (%u)",
+                (unsigned)function);
+    m_scan_spec.aggregate = function;
+    m_scan_spec.aggregate_by_row = by_row;
+  }
+
   /**
    * Clears the state.
    */
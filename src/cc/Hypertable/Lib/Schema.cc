@@ -72,7 +72,7 @@ Mutex desc_mutex;
 bool desc_inited = false;
 
 PropertiesDesc
-  compressor_desc("  bmz|lzo|quicklz|zlib|snappy|none [compressor_options]\n\n"
+  compressor_desc("  bmz|lzo|quicklz|zlib|snappy|zstd|lz4|none [compressor_options]\n\n"
       "compressor_options"),
   bloom_filter_desc("  rows|rows+cols|none [bloom_filter_options]\n\n"
       "  Default bloom filter is defined by the config property:\n"
@@ -93,10 +93,14 @@ void init_schema_options_desc() {
     ("normal", "Normal setting for zlib")
     ("fp-len", i16()->default_value(19), "Minimum fingerprint length for bmz")
     ("offset", i16()->default_value(0), "Starting fingerprint offset for bmz")
+    ("level", i32(), "Compression level for zstd and lz4 (implies --hc)")
+    ("dictionary-size", i32(), "Size of the dictionary zstd trains for "
+        "each cell store (0 disables)")
+    ("hc", "High compression mode for lz4")
     ;
   compressor_hidden_desc.add_options()
     ("compressor-type", str(), 
-        "Compressor type (bmz|lzo|quicklz|zlib|snappy|none)")
+        "Compressor type (bmz|lzo|quicklz|zlib|snappy|zstd|lz4|none)")
     ;
   compressor_pos_desc.add("compressor-type", 1);
 
@@ -109,6 +113,8 @@ void init_schema_options_desc() {
      "probability for the Bloom filter")
     ("max-approx-items", i32()->default_value(1000), "Number of cell store "
         "items used to guess the number of actual Bloom filter entries")
+    ("blocked", "Place all of the bits for an item in a single cache line "
+        "sized block of the Bloom filter")
     ;
   bloom_filter_hidden_desc.add_options()
     ("bloom-filter-mode", str(), "Bloom filter mode (rows|rows+cols|none)")
@@ -155,6 +161,7 @@ Schema::Schema(const Schema &src_schema)
     ag->blocksize = src_ag->blocksize;
     ag->compressor = src_ag->compressor;
     ag->bloom_filter = src_ag->bloom_filter;
+    ag->cell_cache = src_ag->cell_cache;
 
     m_access_group_map.insert(make_pair(ag->name, ag));
     m_access_groups.push_back(ag);
@@ -283,6 +290,17 @@ void Schema::validate_bloom_filter(const String &bloom_filter) {
 }
 
 
+void Schema::validate_cell_cache(const String &cell_cache) {
+  if (cell_cache.empty())
+    return;
+
+  if (strcasecmp(cell_cache.c_str(), "map") &&
+      strcasecmp(cell_cache.c_str(), "skiplist"))
+    set_error_string((String)"Invalid cell cache type '" + cell_cache
+                     + "' (must be map or skiplist)");
+}
+
+
 /**
  */
 void Schema::start_element_handler(void *userdata,
@@ -494,6 +512,11 @@ void Schema::set_access_group_parameter(const char *param, const char *value) {
       boost::trim(m_open_access_group->bloom_filter);
       validate_bloom_filter(m_open_access_group->bloom_filter);
     }
+    else if (!strcasecmp(param, "cellCache")) {
+      m_open_access_group->cell_cache = value;
+      boost::trim(m_open_access_group->cell_cache);
+      validate_cell_cache(m_open_access_group->cell_cache);
+    }
     else
       set_error_string((string)"Invalid AccessGroup attribute '" + param + "'");
   }
@@ -681,6 +704,9 @@ void Schema::render(String &output, bool with_ids) {
     if (ag->bloom_filter != "")
       output += (String)" bloomFilter=\"" + ag->bloom_filter + "\"";
 
+    if (ag->cell_cache != "")
+      output += format(" cellCache=\"%s\"", ag->cell_cache.c_str());
+
     output += ">\n";
 
     foreach_ht(const ColumnFamily *cf, ag->columns) {
@@ -809,6 +835,9 @@ void Schema::render_hql_create_table(const String &table_name, String &output) {
       ag_string += format(" BLOOMFILTER \"%s\"",
           ag->bloom_filter.c_str());
 
+    if (ag->cell_cache != "")
+      ag_string += format(" CELLCACHE \"%s\"", ag->cell_cache.c_str());
+
     if (!ag->columns.empty()) {
       bool display_comma = false;
       ag_string += " (";
@@ -70,7 +70,7 @@ namespace Hypertable {
     struct AccessGroup {
       AccessGroup() : name(), in_memory(false), counter(false), 
         replication(-1), blocksize(0),
-        bloom_filter(), columns() { }
+        bloom_filter(), cell_cache(), columns() { }
 
       String   name;
       bool     in_memory;
@@ -79,6 +79,7 @@ namespace Hypertable {
       uint32_t blocksize;
       String compressor;
       String bloom_filter;
+      String cell_cache;
       ColumnFamilies columns;
     };
 
@@ -98,6 +99,8 @@ namespace Hypertable {
     void validate_bloom_filter(const String &spec);
     static const PropertiesDesc &bloom_filter_spec_desc();
 
+    void validate_cell_cache(const String &spec);
+
     void open_access_group();
     void close_access_group();
     void open_column_family();
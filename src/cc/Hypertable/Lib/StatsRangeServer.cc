@@ -28,16 +28,18 @@ using namespace Hypertable;
 
 namespace {
   enum Group {
-    PRIMARY_GROUP = 0
+    PRIMARY_GROUP = 0,
+    MAINTENANCE_IO_GROUP = 1
   };
 }
 
-StatsRangeServer::StatsRangeServer() : StatsSerializable(RANGE_SERVER, 1), timestamp(TIMESTAMP_MIN) {
+StatsRangeServer::StatsRangeServer() : StatsSerializable(RANGE_SERVER, 2), timestamp(TIMESTAMP_MIN), maintenance_io_rate(0) {
   group_ids[0] = PRIMARY_GROUP;
+  group_ids[1] = MAINTENANCE_IO_GROUP;
 }
 
 
-StatsRangeServer::StatsRangeServer(PropertiesPtr &props) : StatsSerializable(RANGE_SERVER, 1), timestamp(TIMESTAMP_MIN) {
+StatsRangeServer::StatsRangeServer(PropertiesPtr &props) : StatsSerializable(RANGE_SERVER, 2), timestamp(TIMESTAMP_MIN), maintenance_io_rate(0) {
   const char *base, *ptr;
   String datadirs = props->get_str("Hypertable.RangeServer.Monitoring.DataDirectories");
   String dir;
@@ -60,6 +62,7 @@ StatsRangeServer::StatsRangeServer(PropertiesPtr &props) : StatsSerializable(RAN
                         StatsSystem::DISK|StatsSystem::SWAP|StatsSystem::NET|
                         StatsSystem::PROC | StatsSystem::FS, dirs);
   group_ids[0] = PRIMARY_GROUP;
+  group_ids[1] = MAINTENANCE_IO_GROUP;
 }
 
 StatsRangeServer::StatsRangeServer(const StatsRangeServer &other) : StatsSerializable(other.id, other.group_count) {
@@ -91,6 +94,8 @@ StatsRangeServer::StatsRangeServer(const StatsRangeServer &other) : StatsSeriali
   live = other.live;
   system = other.system;
   tables = other.tables;
+  maintenance_io_rate = other.maintenance_io_rate;
+  maintenance_io = other.maintenance_io;
 }
 
 bool StatsRangeServer::operator==(const StatsRangeServer &other) const {
@@ -119,7 +124,9 @@ bool StatsRangeServer::operator==(const StatsRangeServer &other) const {
       !Serialization::equal(cpu_user, other.cpu_user) ||
       !Serialization::equal(cpu_sys, other.cpu_sys) ||
       live != other.live ||
-      system != other.system)
+      system != other.system ||
+      maintenance_io_rate != other.maintenance_io_rate ||
+      maintenance_io != other.maintenance_io)
     return false;
   if (tables.size() != other.tables.size())
     return false;
@@ -143,6 +150,12 @@ size_t StatsRangeServer::encoded_length_group(int group) const {
       len += tables[i].encoded_length();
     return len;
   }
+  else if (group == MAINTENANCE_IO_GROUP) {
+    size_t len = 8 + Serialization::encoded_length_vi32(maintenance_io.size());
+    for (size_t i=0; i<maintenance_io.size(); i++)
+      len += Serialization::encoded_length_vstr(maintenance_io[i].task) + 8*3;
+    return len;
+  }
   else
     HT_FATALF("Invalid group number (%d)", group);
   return 0;
@@ -180,6 +193,16 @@ void StatsRangeServer::encode_group(int group, uint8_t **bufp) const {
     for (size_t i=0; i<tables.size(); i++)
       tables[i].encode(bufp);
   }
+  else if (group == MAINTENANCE_IO_GROUP) {
+    Serialization::encode_i64(bufp, maintenance_io_rate);
+    Serialization::encode_vi32(bufp, maintenance_io.size());
+    for (size_t i=0; i<maintenance_io.size(); i++) {
+      Serialization::encode_vstr(bufp, maintenance_io[i].task);
+      Serialization::encode_i64(bufp, maintenance_io[i].read_bytes);
+      Serialization::encode_i64(bufp, maintenance_io[i].write_bytes);
+      Serialization::encode_i64(bufp, maintenance_io[i].throttled_millis);
+    }
+  }
   else
     HT_FATALF("Invalid group number (%d)", group);
 }
@@ -220,6 +243,19 @@ void StatsRangeServer::decode_group(int group, uint16_t len, const uint8_t **buf
       tables.push_back(table);
     }
   }
+  else if (group == MAINTENANCE_IO_GROUP) {
+    maintenance_io_rate = Serialization::decode_i64(bufp, remainp);
+    size_t task_count = Serialization::decode_vi32(bufp, remainp);
+    maintenance_io.clear();
+    for (size_t i=0; i<task_count; i++) {
+      StatsMaintenanceIO io;
+      io.task = Serialization::decode_vstr(bufp, remainp);
+      io.read_bytes = Serialization::decode_i64(bufp, remainp);
+      io.write_bytes = Serialization::decode_i64(bufp, remainp);
+      io.throttled_millis = Serialization::decode_i64(bufp, remainp);
+      maintenance_io.push_back(io);
+    }
+  }
   else {
     HT_WARNF("Unrecognized StatsRangeServer group %d, skipping...", group);
     (*bufp) += len;
@@ -39,6 +39,28 @@ namespace Hypertable {
 
   typedef std::map<const char*, StatsTable *, LtCstr> StatsTableMap;
 
+  /** I/O performed by one type of maintenance task during a statistics
+   * period. */
+  struct StatsMaintenanceIO {
+    StatsMaintenanceIO() : read_bytes(0), write_bytes(0), throttled_millis(0) { }
+    bool operator==(const StatsMaintenanceIO &other) const {
+      return task == other.task && read_bytes == other.read_bytes &&
+        write_bytes == other.write_bytes &&
+        throttled_millis == other.throttled_millis;
+    }
+    bool operator!=(const StatsMaintenanceIO &other) const {
+      return !(*this == other);
+    }
+    /// Task name (e.g. "major compaction")
+    String task;
+    /// Bytes read from CellStores
+    uint64_t read_bytes;
+    /// Bytes written to CellStores
+    uint64_t write_bytes;
+    /// Time spent waiting for the maintenance I/O throttle
+    uint64_t throttled_millis;
+  };
+
   class StatsRangeServer : public StatsSerializable {
     
   public:
@@ -92,6 +114,10 @@ namespace Hypertable {
     std::vector<StatsTable> tables;
     StatsTableMap table_map;
 
+    /// Maintenance I/O throttle rate in bytes/s (0 if unlimited)
+    int64_t maintenance_io_rate;
+    std::vector<StatsMaintenanceIO> maintenance_io;
+
   protected:
     virtual size_t encoded_length_group(int group) const;
     virtual void encode_group(int group, uint8_t **bufp) const;
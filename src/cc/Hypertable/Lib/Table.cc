@@ -88,6 +88,16 @@ void Table::initialize() {
   m_scanner_queue_size = m_props->get_i32("Hypertable.Scanner.QueueSize");
   HT_ASSERT(m_scanner_queue_size > 0);
 
+  // Each range being scanned by a parallel scanner holds about two scan
+  // blocks, the one being consumed and the one being prefetched
+  int64_t scan_budget =
+    m_props->get_i64("Hypertable.Scanner.Parallel.MemoryBudget");
+  int64_t scan_block_size =
+    m_props->get_i64("Hypertable.RangeServer.Scanner.BufferSize");
+  m_parallel_scan_window = (size_t)(scan_budget / (2 * scan_block_size));
+  if (m_parallel_scan_window == 0)
+    m_parallel_scan_window = 1;
+
 
   // Convert table name to ID string
 
@@ -192,7 +202,7 @@ Table::create_scanner(const ScanSpec &scan_spec, uint32_t timeout_ms,
   scan_spec.throw_if_invalid();
 
   return new TableScanner(m_comm, this, m_range_locator, scan_spec,
-                          timeout_ms ? timeout_ms : m_timeout_ms);
+                          timeout_ms ? timeout_ms : m_timeout_ms, flags);
 }
 
 TableScannerAsync *
@@ -61,7 +61,11 @@ namespace Hypertable {
       OPEN_FLAG_REFRESH_TABLE_CACHE          = 0x02,
       OPEN_FLAG_NO_AUTO_TABLE_REFRESH        = 0x04,
 
-      SCANNER_FLAG_IGNORE_INDEX              = 0x01
+      SCANNER_FLAG_IGNORE_INDEX              = 0x01,
+      /// Scan ranges concurrently, results from different ranges interleaved
+      SCANNER_FLAG_PARALLEL                  = 0x02,
+      /// Scan ranges concurrently, results delivered in row order
+      SCANNER_FLAG_PARALLEL_ORDERED          = 0x04
     };
 
     enum {
@@ -240,6 +244,13 @@ namespace Hypertable {
 
     RangeLocatorPtr get_range_locator() { return m_range_locator; }
 
+    /**
+     * Returns the maximum number of ranges a parallel scanner scans
+     * concurrently.  Derived from Hypertable.Scanner.Parallel.MemoryBudget
+     * and the scan block size.
+     */
+    size_t parallel_scan_window() { return m_parallel_scan_window; }
+
   private:
     void initialize();
 
@@ -259,6 +270,7 @@ namespace Hypertable {
     bool                   m_stale;
     String                 m_toplevel_dir;
     size_t                 m_scanner_queue_size;
+    size_t                 m_parallel_scan_window;
     TablePtr               m_index_table;
     TablePtr               m_qualifier_index_table;
     Namespace             *m_namespace;
@@ -38,14 +38,14 @@ using namespace Hypertable;
 
 TableScanner::TableScanner(Comm *comm, Table *table,
     RangeLocatorPtr &range_locator, const ScanSpec &scan_spec,
-    uint32_t timeout_ms)
+    uint32_t timeout_ms, int flags)
   : m_callback(this), m_cur_cells(0), m_cur_cells_index(0), m_cur_cells_size(0),
     m_error(Error::OK), m_eos(false) {
 
   m_queue = new TableScannerQueue();
   ApplicationQueueInterfacePtr app_queue = (ApplicationQueueInterface *)m_queue.get();
   m_scanner = new TableScannerAsync(comm, app_queue, table, range_locator, 
-                                    scan_spec, timeout_ms, &m_callback);
+                                    scan_spec, timeout_ms, &m_callback, flags);
 }
 
 
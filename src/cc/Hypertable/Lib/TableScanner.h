@@ -46,9 +46,11 @@ namespace Hypertable {
      * @param scan_spec reference to scan specification object
      * @param timeout_ms maximum time in milliseconds to allow scanner
      *        methods to execute before throwing an exception
+     * @param flags Scanner flags
      */
     TableScanner(Comm *comm, Table *table,  RangeLocatorPtr &range_locator,
-                 const ScanSpec &scan_spec, uint32_t timeout_ms);
+                 const ScanSpec &scan_spec, uint32_t timeout_ms,
+                 int flags = 0);
 
     /**
      * Cancel asynchronous scanner and keep dealing with RangeServer responses
@@ -20,6 +20,8 @@
  */
 
 #include "Common/Compat.h"
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 #include "Common/Error.h"
@@ -36,6 +38,22 @@ extern "C" {
 
 using namespace Hypertable;
 
+namespace {
+
+  /** Checks if a scan can be split at range boundaries and carried out by
+   * several interval scanners concurrently.  Row and cell limits and offsets
+   * apply to the scan as a whole, so scans using them are carried out
+   * sequentially.
+   */
+  bool parallel_scan_supported(const ScanSpec &scan_spec) {
+    return scan_spec.row_intervals.size() <= 1 &&
+      scan_spec.cell_intervals.empty() && !scan_spec.scan_and_filter_rows &&
+      scan_spec.row_limit == 0 && scan_spec.cell_limit == 0 &&
+      scan_spec.row_offset == 0 && scan_spec.cell_offset == 0;
+  }
+
+}
+
 
 /**
  *
@@ -45,7 +63,12 @@ TableScannerAsync::TableScannerAsync(Comm *comm,
       RangeLocatorPtr &range_locator, const ScanSpec &scan_spec, 
       uint32_t timeout_ms, ResultCallback *cb, int flags)
   : m_bytes_scanned(0), m_current_scanner(0), m_outstanding(0), 
-    m_error(Error::OK), m_cancelled(false), m_use_index(false)
+    m_error(Error::OK), m_cancelled(false), m_use_index(false),
+    m_parallel(false), m_ordered(true), m_parallel_window(1), m_comm(comm),
+    m_app_queue(app_queue), m_range_locator(range_locator),
+    m_split_done(true), m_split_start_inclusive(true),
+    m_split_end_inclusive(false), m_activating(false),
+    m_activations_pending(0), m_combine_aggregates(false)
 {
   ScopedLock lock(m_mutex);
   ScanSpecBuilder index_spec;
@@ -80,6 +103,16 @@ TableScannerAsync::TableScannerAsync(Comm *comm,
   m_cb = cb;
   m_table = table;
   m_scan_spec_builder = *pspec;
+  m_combine_aggregates = pspec->aggregate != ScanSpec::AGGREGATE_NONE &&
+    !pspec->aggregate_by_row;
+
+  if ((flags & (Table::SCANNER_FLAG_PARALLEL |
+                Table::SCANNER_FLAG_PARALLEL_ORDERED)) &&
+      !m_use_index && parallel_scan_supported(*pspec)) {
+    m_parallel = true;
+    m_ordered = (flags & Table::SCANNER_FLAG_PARALLEL_ORDERED) != 0;
+    m_parallel_window = table->parallel_scan_window();
+  }
 
   init(comm, app_queue, table, range_locator, *pspec, timeout_ms, cb);
 }
@@ -93,6 +126,10 @@ bool TableScannerAsync::use_index(TablePtr table, const ScanSpec &primary_spec,
   if (primary_spec.row_intervals.size())
     return false;
 
+  // aggregates are computed by the range servers of the primary table
+  if (primary_spec.aggregate != ScanSpec::AGGREGATE_NONE)
+    return false;
+
   index_spec.set_keys_only(true);
   index_spec.add_column("v1");
 
@@ -227,11 +264,14 @@ void TableScannerAsync::init(Comm *comm, ApplicationQueueInterfacePtr &app_queue
   Timer timer(timeout_ms);
   bool current_set = false;
 
+  m_timeout_ms = timeout_ms;
   m_cb->increment_outstanding();
   m_cb->register_scanner(this);
 
   try {
-    if (scan_spec.row_intervals.empty()) {
+    if (m_parallel)
+      init_parallel(scan_spec);
+    else if (scan_spec.row_intervals.empty()) {
       if (scan_spec.cell_intervals.empty()) {
         ri_scanner = 0;
         ri_scanner = new IntervalScannerAsync(comm, app_queue, table, 
@@ -404,9 +444,21 @@ void TableScannerAsync::handle_error(int scanner_id, int error, const String &er
     if (next && scanner_id == m_current_scanner)
       move_to_next_interval_scanner(scanner_id);
   }
+  else if (next && m_parallel) {
+    // interval scanner finished without results to deliver
+    ScanCellsPtr cells;
+    maybe_callback_ok(scanner_id, next, false, cells);
+    if (scanner_id == m_current_scanner)
+      move_to_next_interval_scanner(scanner_id);
+  }
   else if (next && scanner_id == m_current_scanner) {
     move_to_next_interval_scanner(scanner_id);
   }
+
+  if (m_activations_pending) {
+    lock.unlock();
+    activate_interval_scanners();
+  }
 }
 
 void TableScannerAsync::handle_timeout(int scanner_id, const String &error_msg, bool is_create) {
@@ -476,8 +528,14 @@ void TableScannerAsync::handle_result(int scanner_id, EventPtr &event, bool is_c
     m_error_msg = e.what();
     next = !m_interval_scanners[current_scanner]->has_outstanding_requests();
     maybe_callback_error(current_scanner, next);
+    release_activation_slots();
     throw;
   }
+
+  if (m_activations_pending) {
+    lock.unlock();
+    activate_interval_scanners();
+  }
 }
 
 void TableScannerAsync::maybe_callback_error(int scanner_id, bool next) {
@@ -489,6 +547,9 @@ void TableScannerAsync::maybe_callback_error(int scanner_id, bool next) {
     m_interval_scanners[scanner_id] = 0;
   }
 
+  // don't start scanning any more ranges
+  m_split_done = true;
+
   if (m_outstanding == 0) {
     eos = true;
   }
@@ -507,14 +568,37 @@ void TableScannerAsync::maybe_callback_ok(int scanner_id, bool next, bool do_cal
   // ok to update m_outstanding since caller has locked mutex
   if (next) {
     HT_ASSERT(m_outstanding>0 && m_interval_scanners[scanner_id] != 0);
-    m_outstanding--;
     m_interval_scanners[scanner_id] = 0;
+    // hand the slot over to the interval scanner for the next range of a
+    // parallel scan; the caller starts it with activate_interval_scanners()
+    // once it has released the mutex
+    if (m_parallel && !m_split_done && m_error == Error::OK &&
+        !is_cancelled())
+      m_activations_pending++;
+    else
+      m_outstanding--;
   }
 
   if (m_outstanding == 0) {
     eos = true;
   }
 
+  // make sure the end of a parallel scan gets signalled, even if the last
+  // interval scanner finished without results to deliver
+  if (m_parallel && eos && !do_callback && m_error == Error::OK) {
+    do_callback = true;
+    cells = new ScanCells;
+  }
+
+  // hold back the partial aggregates until the whole scan has finished
+  if (m_combine_aggregates) {
+    if (do_callback && m_error == Error::OK)
+      combine_aggregates(cells);
+    do_callback = eos && m_error == Error::OK;
+    if (do_callback)
+      cells = combined_aggregates();
+  }
+
   if (do_callback) {
     if (eos)
       cells->set_eos();
@@ -529,6 +613,50 @@ void TableScannerAsync::maybe_callback_ok(int scanner_id, bool next, bool do_cal
   }
 }
 
+void TableScannerAsync::combine_aggregates(ScanCellsPtr &cells) {
+  uint32_t function = m_scan_spec_builder.get().aggregate;
+  Cells partials;
+  AggregateMap::iterator iter;
+  char buf[32];
+  char *end;
+  int64_t value;
+
+  cells->get(partials);
+
+  foreach_ht (const Cell &cell, partials) {
+    if (cell.value_len == 0 || cell.value_len >= sizeof(buf))
+      continue;
+    memcpy(buf, cell.value, cell.value_len);
+    buf[cell.value_len] = 0;
+    value = (int64_t)strtoll(buf, &end, 10);
+    if (*end)
+      continue;
+    iter = m_aggregates.find(cell.column_family);
+    if (iter == m_aggregates.end())
+      m_aggregates[cell.column_family] = value;
+    else if (function == ScanSpec::AGGREGATE_MIN)
+      iter->second = std::min(iter->second, value);
+    else if (function == ScanSpec::AGGREGATE_MAX)
+      iter->second = std::max(iter->second, value);
+    else
+      iter->second += value;
+  }
+}
+
+ScanCellsPtr TableScannerAsync::combined_aggregates() {
+  ScanCellsPtr cells = new ScanCells;
+  char buf[32];
+
+  foreach_ht (const AggregateMap::value_type &v, m_aggregates) {
+    sprintf(buf, "%lld", (Lld)v.second);
+    Cell cell("", v.first.c_str(), "", AUTO_ASSIGN, AUTO_ASSIGN,
+              (uint8_t *)buf, strlen(buf), FLAG_INSERT);
+    cells->add(cell, true);
+  }
+  m_aggregates.clear();
+  return cells;
+}
+
 void TableScannerAsync::wait_for_completion() {
   ScopedLock lock(m_mutex);
   while (m_outstanding != 0)
@@ -546,6 +674,10 @@ void TableScannerAsync::move_to_next_interval_scanner(int current_scanner) {
   ScanCellsPtr cells;
   bool abort = cancelled || (m_error != Error::OK);
 
+  // in unordered parallel mode all interval scanners are current
+  if (m_parallel && !m_ordered)
+    return;
+
   while (next && m_outstanding && current_scanner < ((int)m_interval_scanners.size())-1) {
     current_scanner++;
     // unless the scan has been aborted we should be going through scanners in order
@@ -576,6 +708,7 @@ void TableScannerAsync::move_to_next_interval_scanner(int current_scanner) {
   // is sent to the caller, and m_outstanding is decremented
   if (next 
       && m_outstanding == 1
+      && m_activations_pending == 0
       && current_scanner == ((int)m_interval_scanners.size() - 1) 
       && !cells) {
     cells = new ScanCells;
@@ -584,3 +717,202 @@ void TableScannerAsync::move_to_next_interval_scanner(int current_scanner) {
   }
 }
 
+
+
+void TableScannerAsync::init_parallel(const ScanSpec &scan_spec) {
+  SchemaPtr schema;
+
+  m_table->get(m_table_identifier, schema);
+
+  if (scan_spec.row_intervals.empty()) {
+    m_split_row = "";
+    m_split_start_inclusive = true;
+    m_split_end_row = Key::END_ROW_MARKER;
+    m_split_end_inclusive = false;
+  }
+  else {
+    const RowInterval &ri = scan_spec.row_intervals[0];
+    m_split_row = ri.start ? ri.start : "";
+    m_split_start_inclusive = ri.start_inclusive;
+    if (ri.end == 0 || *ri.end == 0) {
+      m_split_end_row = Key::END_ROW_MARKER;
+      m_split_end_inclusive = false;
+    }
+    else {
+      m_split_end_row = ri.end;
+      m_split_end_inclusive = ri.end_inclusive;
+    }
+  }
+  m_split_done = false;
+
+  // the caller holds the mutex, so nothing else can happen before the
+  // initial interval scanners are in place
+  RangeLocationInfo range_info;
+  String lookup_row;
+  Timer timer(m_timeout_ms);
+  while (next_interval_row(lookup_row)) {
+    timer.start();
+    m_range_locator->find_loop(&m_table_identifier, lookup_row.c_str(),
+                               &range_info, timer, false);
+    add_interval_scanner(range_info);
+  }
+}
+
+/**
+ * Starts interval scanners for the next ranges of a parallel scan until
+ * #m_parallel_window of them are outstanding.  Must be called without
+ * #m_mutex held: find_loop() may block on a METADATA lookup, so range
+ * locations are resolved with the mutex released and it is only taken to
+ * pick the next row and to register each new interval scanner.  One
+ * thread at a time resolves ranges; others leave their pending
+ * activations to it.
+ */
+void TableScannerAsync::activate_interval_scanners() {
+  RangeLocationInfo range_info;
+  String lookup_row;
+  Timer timer(m_timeout_ms);
+
+  {
+    ScopedLock lock(m_mutex);
+    if (m_activating)
+      return;
+    m_activating = true;
+  }
+
+  while (true) {
+    {
+      ScopedLock lock(m_mutex);
+      if (!next_interval_row(lookup_row)) {
+        m_activating = false;
+        release_activation_slots();
+        return;
+      }
+    }
+
+    try {
+      timer.start();
+      m_range_locator->find_loop(&m_table_identifier, lookup_row.c_str(),
+                                 &range_info, timer, false);
+      ScopedLock lock(m_mutex);
+      // the scan may have failed or been cancelled in the meantime
+      if (m_error == Error::OK && !is_cancelled())
+        add_interval_scanner(range_info);
+    }
+    catch (Exception &e) {
+      ScopedLock lock(m_mutex);
+      HT_ERROR_OUT << e << HT_END;
+      if (m_error == Error::OK) {
+        m_error = e.code();
+        m_error_msg = e.what();
+      }
+      m_split_done = true;
+      m_activating = false;
+      if (m_outstanding > m_activations_pending)
+        m_cb->scan_error(this, m_error, m_error_msg, false);
+      release_activation_slots();
+      return;
+    }
+  }
+}
+
+/**
+ * Computes the row to look up to find the next range of a parallel scan.
+ * Caller must hold #m_mutex.
+ * @param lookup_row Set to a row key inside the next range
+ * @return <i>false</i> if the scan interval is exhausted, the scan has
+ * failed or been cancelled, or the window is full
+ */
+bool TableScannerAsync::next_interval_row(String &lookup_row) {
+  if (m_error != Error::OK || is_cancelled())
+    m_split_done = true;
+
+  if (m_split_done || (m_activations_pending == 0 &&
+                       (size_t)m_outstanding >= m_parallel_window))
+    return false;
+
+  lookup_row = m_split_row;
+  if (!m_split_start_inclusive)
+    lookup_row.append(1, 1);  // construct row key in next range
+  return true;
+}
+
+/**
+ * Creates and registers the interval scanner for the part of the scan
+ * interval that falls into the range described by <code>range_info</code>,
+ * which contains #m_split_row.  Ranges that split in the meantime are
+ * handled by the interval scanner itself, which moves on to the next range
+ * when it reaches the end of one.  Caller must hold #m_mutex.
+ * @param range_info Location of the range containing #m_split_row
+ */
+void TableScannerAsync::add_interval_scanner(const RangeLocationInfo &range_info) {
+  ScanSpec interval_scan_spec;
+  String start_row, end_row;
+  bool start_inclusive, end_inclusive;
+
+  start_row = m_split_row;
+  start_inclusive = m_split_start_inclusive;
+  if (!strcmp(range_info.end_row.c_str(), Key::END_ROW_MARKER) ||
+      m_split_end_row.compare(range_info.end_row) <= 0) {
+    end_row = m_split_end_row;
+    end_inclusive = m_split_end_inclusive;
+    m_split_done = true;
+  }
+  else {
+    end_row = range_info.end_row;
+    end_inclusive = true;
+    m_split_row = range_info.end_row;
+    m_split_start_inclusive = false;
+  }
+
+  m_scan_spec_builder.get().base_copy(interval_scan_spec);
+  interval_scan_spec.row_intervals.push_back(
+      RowInterval(start_row.c_str(), start_inclusive,
+                  end_row.c_str(), end_inclusive));
+
+  // in ordered mode only the first interval scanner starts out current
+  bool current = !m_ordered || m_interval_scanners.empty();
+  IntervalScannerAsyncPtr ri_scanner =
+    new IntervalScannerAsync(m_comm, m_app_queue, m_table, m_range_locator,
+                             interval_scan_spec, m_timeout_ms, current,
+                             this, (int)m_interval_scanners.size());
+  m_interval_scanners.push_back(ri_scanner);
+  if (m_activations_pending)
+    m_activations_pending--;
+  else
+    m_outstanding++;
+
+  // in ordered mode the new scanner becomes current if all of the ones
+  // before it have already finished
+  if (m_ordered && m_interval_scanners.size() > 1 &&
+      m_current_scanner == (int)m_interval_scanners.size() - 2 &&
+      m_interval_scanners[m_current_scanner] == 0)
+    move_to_next_interval_scanner(m_current_scanner);
+}
+
+/**
+ * Gives up the slots of activations that will not start an interval
+ * scanner because the scan interval is exhausted or the scan failed or was
+ * cancelled, signalling the end of the scan if nothing else is
+ * outstanding.  Caller must hold #m_mutex.
+ */
+void TableScannerAsync::release_activation_slots() {
+  if (m_activations_pending == 0)
+    return;
+
+  m_outstanding -= m_activations_pending;
+  m_activations_pending = 0;
+
+  if (m_outstanding == 0) {
+    if (m_error != Error::OK)
+      m_cb->scan_error(this, m_error, m_error_msg, true);
+    else {
+      ScanCellsPtr cells =
+        m_combine_aggregates ? combined_aggregates() : new ScanCells;
+      cells->set_eos();
+      m_cb->scan_ok(this, cells);
+    }
+    m_cb->deregister_scanner(this);
+    m_cb->decrement_outstanding();
+    m_cond.notify_all();
+  }
+}
@@ -22,6 +22,8 @@
 #ifndef HYPERTABLE_TABLESCANNERASYNC_H
 #define HYPERTABLE_TABLESCANNERASYNC_H
 
+#include <map>
+
 #include "Common/ReferenceCount.h"
 
 #include "AsyncComm/DispatchHandlerSynchronizer.h"
@@ -40,6 +42,29 @@ namespace Hypertable {
 
   class Table;
 
+  /**
+   * Asynchronous table scanner.  The scan is carried out by one
+   * IntervalScannerAsync per row or cell interval.  Normally the interval
+   * scanners all issue their first create_scanner request up front, but only
+   * the current one fetches further scan blocks, so results are delivered in
+   * interval order and each interval is scanned one range at a time.
+   *
+   * With Table::SCANNER_FLAG_PARALLEL, a scan over at most one row interval
+   * and without row/cell limits or offsets is split at range boundaries into
+   * one interval scanner per range.  Up to Table::parallel_scan_window()
+   * of them are active at once, each with its next scan block prefetched,
+   * and results are delivered as they arrive, so rows from different ranges
+   * are interleaved.  With Table::SCANNER_FLAG_PARALLEL_ORDERED, results are
+   * delivered in row order; the active interval scanners beyond the current
+   * one have their first scan block prefetched.  The per-range interval
+   * scanners are created lazily as earlier ones finish, which bounds the
+   * memory held by prefetched scan blocks.
+   *
+   * If the scan spec requests an aggregate over the whole scan (see
+   * ScanSpecBuilder::set_aggregate), the partial per-range aggregates
+   * returned by the range servers are combined here and delivered as one
+   * cell per column family, with an empty row key, when the scan completes.
+   */
   class TableScannerAsync : public ReferenceCount {
 
   public:
@@ -138,9 +163,16 @@ namespace Hypertable {
     void maybe_callback_error(int scanner_id, bool next);
     void wait_for_completion();
     void move_to_next_interval_scanner(int current_scanner);
+    void init_parallel(const ScanSpec &scan_spec);
+    void activate_interval_scanners();
+    bool next_interval_row(String &lookup_row);
+    void add_interval_scanner(const RangeLocationInfo &range_info);
+    void release_activation_slots();
     bool use_index(TablePtr table, const ScanSpec &primary_spec, 
             ScanSpecBuilder &index_spec, bool *use_qualifier);
     void add_index_row(ScanSpecBuilder &ssb, const char *row);
+    void combine_aggregates(ScanCellsPtr &cells);
+    ScanCellsPtr combined_aggregates();
 
     std::vector<IntervalScannerAsyncPtr>  m_interval_scanners;
     uint32_t            m_timeout_ms;
@@ -159,6 +191,30 @@ namespace Hypertable {
     ScanSpecBuilder     m_scan_spec_builder;
     bool                m_cancelled;
     bool                m_use_index;
+
+    // Parallel scan state
+    bool                m_parallel;
+    bool                m_ordered;
+    size_t              m_parallel_window;
+    Comm               *m_comm;
+    ApplicationQueueInterfacePtr m_app_queue;
+    RangeLocatorPtr     m_range_locator;
+    TableIdentifierManaged m_table_identifier;
+    bool                m_split_done;
+    String              m_split_row;
+    bool                m_split_start_inclusive;
+    String              m_split_end_row;
+    bool                m_split_end_inclusive;
+    // True while a thread is resolving ranges in activate_interval_scanners()
+    bool                m_activating;
+    // Slots of finished interval scanners, still counted in m_outstanding,
+    // waiting to be handed to the scanner for the next range
+    int                 m_activations_pending;
+
+    // Combined partial aggregates, keyed by column family
+    typedef std::map<String, int64_t> AggregateMap;
+    bool                m_combine_aggregates;
+    AggregateMap        m_aggregates;
   };
 
   typedef intrusive_ptr<TableScannerAsync> TableScannerAsyncPtr;
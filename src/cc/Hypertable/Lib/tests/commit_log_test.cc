@@ -29,11 +29,13 @@
 #include "Common/Logger.h"
 #include "Common/System.h"
 #include "Common/String.h"
+#include "Common/Thread.h"
 #include "Common/Usage.h"
 
 #include "Hypertable/Lib/Config.h"
 #include "Hypertable/Lib/CommitLog.h"
 #include "Hypertable/Lib/CommitLogReader.h"
+#include "Hypertable/Lib/CompressorFactory.h"
 
 #include "DfsBroker/Lib/Client.h"
 
@@ -55,10 +57,14 @@ namespace {
 
   void test1(DfsBroker::Client *dfs_client);
   void test_link(DfsBroker::Client *dfs_client);
+  void test_streams(DfsBroker::Client *dfs_client);
+  void test_stream_order(DfsBroker::Client *dfs_client);
+  void test_sync(DfsBroker::Client *dfs_client);
   void write_entries(CommitLog *log, int num_entries, uint64_t *sump,
                      CommitLogBase *link_log);
   void read_entries(DfsBroker::Client *dfs_client, CommitLogReader *log_reader,
                     uint64_t *sump);
+  void read_compressed_entries(CommitLogReader *log_reader, uint64_t *sump);
 }
 
 
@@ -85,6 +91,9 @@ int main(int argc, char **argv) {
 
     //test1(dfs);
     test_link(dfs.get());
+    test_streams(dfs.get());
+    test_stream_order(dfs.get());
+    test_sync(dfs.get());
   }
   catch (Exception &e) {
     HT_ERROR_OUT << e << HT_END;
@@ -130,6 +139,16 @@ namespace {
     delete log_reader;
 
     HT_ASSERT(sum_read == sum_written);
+
+    sum_read = 0;
+
+    log_reader = new CommitLogReader(fs, fname);
+
+    read_compressed_entries(log_reader, &sum_read);
+
+    delete log_reader;
+
+    HT_ASSERT(sum_read == sum_written);
   }
 
   void test_link(DfsBroker::Client *dfs_client) {
@@ -205,6 +224,135 @@ namespace {
     HT_ASSERT(sum_read == sum_written);
   }
 
+  void test_streams(DfsBroker::Client *dfs_client) {
+    String fname = "/hypertable/test_log/s";
+    CommitLog *log;
+    CommitLogReader *log_reader;
+    uint64_t sum_written = 0;
+    uint64_t sum_read = 0;
+
+    dfs_client->rmdir(fname);
+    dfs_client->mkdirs(fname);
+
+    FilesystemPtr fs = dfs_client;
+
+    log = new CommitLog(fs, fname, properties, 0, true, 3);
+
+    HT_ASSERT(log->get_stream_count() == 3);
+
+    // each stream rolls on its own, all fragments land in the same directory
+    for (size_t i=0; i<log->get_stream_count(); i++)
+      write_entries(log->get_stream(i), 20, &sum_written, 0);
+
+    log->close();
+
+    delete log;
+
+    log_reader = new CommitLogReader(fs, fname);
+
+    read_compressed_entries(log_reader, &sum_read);
+
+    delete log_reader;
+
+    HT_ASSERT(sum_read == sum_written);
+  }
+
+  void test_stream_order(DfsBroker::Client *dfs_client) {
+    String fname = "/hypertable/test_log/order";
+    CommitLog *log;
+    CommitLogReader *log_reader;
+    uint32_t payload[101];
+    DynamicBuffer dbuf;
+    const uint8_t *block;
+    size_t block_len;
+    BlockCompressionHeaderCommitLog header;
+    int64_t last_revision = TIMESTAMP_MIN;
+    size_t block_count = 0;
+
+    dfs_client->rmdir(fname);
+    dfs_client->mkdirs(fname);
+
+    FilesystemPtr fs = dfs_client;
+
+    log = new CommitLog(fs, fname, properties, 0, true, 2);
+
+    // alternate between the two streams so their revisions interleave, and
+    // write enough for each stream to roll over several fragments
+    for (int64_t revision=1; revision<=200; revision++) {
+      size_t limit = (random() % 100) + 1;
+      for (size_t j=0; j<limit; j++)
+        payload[j] = random();
+      dbuf.base = (uint8_t *)payload;
+      dbuf.ptr = dbuf.base + (4*limit);
+      dbuf.own = false;
+      HT_ASSERT(log->get_stream(revision % 2)->write(dbuf, revision)
+                == Error::OK);
+    }
+
+    log->close();
+
+    delete log;
+
+    log_reader = new CommitLogReader(fs, fname);
+
+    while (log_reader->next(&block, &block_len, &header)) {
+      HT_ASSERT(header.get_revision() > last_revision);
+      last_revision = header.get_revision();
+      block_count++;
+    }
+
+    delete log_reader;
+
+    HT_ASSERT(block_count == 200);
+  }
+
+  struct Syncer {
+    Syncer(CommitLog *log, volatile bool *done) : log(log), done(done) { }
+    void operator()() {
+      while (!*done)
+        HT_ASSERT(log->sync() == Error::OK);
+    }
+    CommitLog *log;
+    volatile bool *done;
+  };
+
+  void test_sync(DfsBroker::Client *dfs_client) {
+    String fname = "/hypertable/test_log/sync";
+    CommitLog *log;
+    CommitLogReader *log_reader;
+    uint64_t sum_written = 0;
+    uint64_t sum_read = 0;
+    volatile bool done = false;
+
+    dfs_client->rmdir(fname);
+    dfs_client->mkdirs(fname);
+
+    FilesystemPtr fs = dfs_client;
+
+    log = new CommitLog(fs, fname, properties);
+
+    // sync continuously while writing, so fragments get rolled while a
+    // flush of them is in flight
+    Thread syncer(Syncer(log, &done));
+    write_entries(log, 50, &sum_written, 0);
+    done = true;
+    syncer.join();
+
+    HT_ASSERT(log->sync() == Error::OK);
+
+    log->close();
+
+    delete log;
+
+    log_reader = new CommitLogReader(fs, fname);
+
+    read_compressed_entries(log_reader, &sum_read);
+
+    delete log_reader;
+
+    HT_ASSERT(sum_read == sum_written);
+  }
+
   void
   write_entries(CommitLog *log, int num_entries, uint64_t *sump,
                 CommitLogBase *link_log) {
@@ -259,4 +407,26 @@ namespace {
         *sump += iptr[i];
     }
   }
+
+  void
+  read_compressed_entries(CommitLogReader *log_reader, uint64_t *sump) {
+    DynamicBuffer zblock;
+    DynamicBuffer block;
+    uint32_t *iptr;
+    size_t icount;
+    BlockCompressionHeaderCommitLog header;
+    BlockCompressionCodecPtr compressor;
+
+    while (log_reader->next_compressed(zblock, &header)) {
+      compressor = CompressorFactory::create_block_codec(
+          (BlockCompressionCodec::Type)header.get_compression_type());
+      block.clear();
+      compressor->inflate(zblock, block, header);
+      assert((block.fill() % 4) == 0);
+      icount = block.fill() / 4;
+      iptr = (uint32_t *)block.base;
+      for (size_t i=0; i<icount; i++)
+        *sump += iptr[i];
+    }
+  }
 }
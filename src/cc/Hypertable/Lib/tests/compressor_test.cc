@@ -44,6 +44,8 @@ namespace {
     "lzo",
     "quicklz",
     "snappy",
+    "zstd",
+    "lz4",
     "",
     0
   };
@@ -97,6 +99,77 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  // blocks checksummed with fletcher32 (written before CRC-32C became the
+  // default) must still decode, with the algorithm taken from the header
+  {
+    BlockCompressionHeaderCommitLog legacy_header(MAGIC, 0);
+    BlockCompressionHeaderCommitLog read_header;
+    legacy_header.set_checksum_type(CHECKSUM_FLETCHER32);
+    output2.free();
+    try {
+      compressor->deflate(input, output1, legacy_header);
+      compressor->inflate(output1, output2, read_header);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      return 1;
+    }
+    if (read_header.get_checksum_type() != CHECKSUM_FLETCHER32 ||
+        input.fill() != output2.fill() ||
+        memcmp(input.base, output2.base, input.fill())) {
+      HT_ERRORF("fletcher32 block mismatch after %s codec", argv[0]);
+      return 1;
+    }
+  }
+
+  // train a dictionary from the lines of the input and check that blocks
+  // compressed with it round trip, also through a codec that was only
+  // handed the dictionary
+  if (compressor->get_dictionary_size()) {
+    DynamicBuffer dictionary(0);
+    std::vector<size_t> sample_sizes;
+    const uint8_t *line = input.base;
+    BlockCompressionCodecPtr reader;
+
+    for (const uint8_t *ptr = input.base; ptr < input.ptr; ptr++) {
+      if (*ptr == '\n') {
+        sample_sizes.push_back(ptr + 1 - line);
+        line = ptr + 1;
+      }
+    }
+    if (line < input.ptr)
+      sample_sizes.push_back(input.ptr - line);
+
+    if (!compressor->train_dictionary(input, sample_sizes, dictionary)) {
+      HT_ERROR("Problem training dictionary");
+      return 1;
+    }
+
+    output2.free();
+
+    try {
+      compressor->set_dictionary(dictionary.base, dictionary.fill());
+      compressor->deflate(input, output1, header);
+      reader = CompressorFactory::create_block_codec(
+          (BlockCompressionCodec::Type)compressor->get_type());
+      BlockCompressionDictionaryPtr inflate_dictionary =
+        reader->create_inflate_dictionary(dictionary.base, dictionary.fill());
+      reader->set_inflate_dictionary(inflate_dictionary);
+      reader->inflate(output1, output2, header);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      return 1;
+    }
+
+    if (input.fill() != output2.fill() ||
+        memcmp(input.base, output2.base, input.fill())) {
+      HT_ERRORF("Input does not match output after %s codec with dictionary",
+                argv[0]);
+      return 1;
+    }
+  }
+
   // this should not compress ...
 
   memcpy(input.base, "foo", 3);
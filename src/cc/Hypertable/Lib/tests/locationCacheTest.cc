@@ -29,6 +29,8 @@ extern "C" {
 #  include <unistd.h>
 }
 
+#include <boost/thread/thread.hpp>
+
 #include "Common/StringExt.h"
 #include "Common/Usage.h"
 
@@ -252,6 +254,125 @@ namespace {
       outfile << "[NULL]" << endl;
   }
 
+  /**
+   * Repeatedly looks up every word in every table and checks that each
+   * lookup returns the same result it returned single-threaded.
+   */
+  struct LookupWorker {
+    LookupWorker(LocationCache *c, const vector<String> *e)
+      : cache(c), expected(e) { }
+    void operator()() {
+      RangeLocationInfo range_loc_info;
+      for (int iteration=0; iteration<50; iteration++) {
+        for (int t=0; t<4; t++) {
+          String table_id = String("") + t;
+          for (int w=0; w<MAX_WORDS; w++) {
+            const String &expect = (*expected)[t*MAX_WORDS + w];
+            if (cache->lookup(table_id.c_str(), words[w], &range_loc_info))
+              HT_ASSERT(range_loc_info.addr.proxy == expect);
+            else
+              HT_ASSERT(expect.empty());
+          }
+        }
+      }
+    }
+    LocationCache *cache;
+    const vector<String> *expected;
+  };
+
+  void load_tables(LocationCache &cache, int first, int last) {
+    RangeLocationInfo range_loc_info;
+    for (int t=first; t<last; t++) {
+      String table_id = String("") + t;
+      for (int r=0; r<MAX_RANGES; r++) {
+        range_loc_info.start_row = ranges[r].first;
+        range_loc_info.end_row = ranges[r].second;
+        range_loc_info.addr.set_proxy(server_ids[t % MAX_SERVERIDS]);
+        cache.insert(table_id.c_str(), range_loc_info);
+      }
+    }
+  }
+
+  /**
+   * Exercises a sharded cache: lookups within one table, concurrent
+   * lookups against a fully populated cache, host invalidation across
+   * shards, and eviction from other tables' shards, which must keep the
+   * cache within its limit while never evicting pegged entries.
+   */
+  void TestSharded() {
+    RangeLocationInfo range_loc_info;
+
+    {
+      LocationCache single(MAX_RANGES), cache(MAX_RANGES, 4);
+      load_tables(single, 0, 1);
+      load_tables(cache, 0, 1);
+      RangeLocationInfo expected_info;
+      for (int w=0; w<MAX_WORDS; w++) {
+        bool found = single.lookup("0", words[w], &expected_info);
+        HT_ASSERT(cache.lookup("0", words[w], &range_loc_info) == found);
+        if (found) {
+          HT_ASSERT(range_loc_info.start_row == expected_info.start_row);
+          HT_ASSERT(range_loc_info.end_row == expected_info.end_row);
+        }
+      }
+      HT_ASSERT(cache.invalidate("0", "mannan"));
+      HT_ASSERT(!cache.lookup("0", "mannan", &range_loc_info));
+      HT_ASSERT(cache.lookup("0", "labyrinthodontid", &range_loc_info));
+      HT_ASSERT(cache.lookup("0", "millstream", &range_loc_info));
+      HT_ASSERT(cache.lookup("0", "worldful", &range_loc_info));
+      HT_ASSERT(range_loc_info.end_row.empty());
+    }
+
+    {
+      LocationCache cache(4 * MAX_RANGES, 4);
+      load_tables(cache, 0, 4);
+
+      vector<String> expected;
+      for (int t=0; t<4; t++) {
+        String table_id = String("") + t;
+        for (int w=0; w<MAX_WORDS; w++) {
+          if (cache.lookup(table_id.c_str(), words[w], &range_loc_info)) {
+            HT_ASSERT(range_loc_info.addr.proxy == server_ids[t]);
+            expected.push_back(range_loc_info.addr.proxy);
+          }
+          else
+            expected.push_back("");
+        }
+      }
+
+      boost::thread_group threads;
+      for (int i=0; i<4; i++)
+        threads.create_thread(LookupWorker(&cache, &expected));
+      threads.join_all();
+
+      cache.invalidate_host(server_ids[1]);
+      HT_ASSERT(!cache.lookup("1", "mannan", &range_loc_info));
+      HT_ASSERT(cache.lookup("2", "mannan", &range_loc_info));
+    }
+
+    {
+      LocationCache cache(MAX_RANGES, 4);
+      range_loc_info.start_row = "";
+      range_loc_info.end_row = "";
+      range_loc_info.addr.set_proxy("root");
+      cache.insert("0", range_loc_info, true);
+      load_tables(cache, 1, 8);
+      HT_ASSERT(cache.lookup("0", "mannan", &range_loc_info));
+      HT_ASSERT(range_loc_info.addr.proxy == "root");
+      int entries = 0;
+      for (int t=1; t<8; t++) {
+        String table_id = String("") + t;
+        for (int r=0; r<MAX_RANGES; r++) {
+          const char *row = (r == 0) ? "" : ranges[r].first;
+          if (cache.lookup(table_id.c_str(), row, &range_loc_info, true) &&
+              range_loc_info.end_row == ranges[r].second)
+            entries++;
+        }
+      }
+      HT_ASSERT(entries > 0 && entries < MAX_RANGES);
+    }
+  }
+
 }
 
 
@@ -312,6 +433,8 @@ int main(int argc, char **argv) {
 
   outfile.close();
 
+  TestSharded();
+
   if (system("diff ./locationCacheTest.output ./locationCacheTest.golden"))
     return 1;
 
@@ -0,0 +1,159 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cstdlib>
+#include <iostream>
+#include <set>
+
+#include "Common/Usage.h"
+
+#include "Hypertable/Lib/Client.h"
+
+using namespace std;
+using namespace Hypertable;
+
+namespace {
+
+  const char *schema =
+  "<Schema>"
+  "  <AccessGroup name=\"default\">"
+  "    <ColumnFamily>"
+  "      <Name>data</Name>"
+  "    </ColumnFamily>"
+  "  </AccessGroup>"
+  "</Schema>";
+
+  const char *usage[] = {
+    "usage: parallel_scan_test",
+    "",
+    "Validates parallel table scans, both unordered and ordered.",
+    0
+  };
+
+  const int ROW_COUNT = 5000;
+
+  /**
+   * Scans the table with the given flags and checks that rows
+   * [<code>first</code>, <code>last</code>) are each returned exactly once,
+   * and in row order if <code>ordered</code> is set.
+   */
+  void check_scan(TablePtr &table, const ScanSpec &scan_spec, int32_t flags,
+                  int first, int last, bool ordered) {
+    TableScannerPtr scanner = table->create_scanner(scan_spec, 0, flags);
+    set<String> rows;
+    String last_row;
+    Cell cell;
+    int count = 0;
+
+    while (scanner->next(cell)) {
+      if (ordered && last_row.compare(cell.row_key) >= 0) {
+        cout << "Row " << cell.row_key << " returned after " << last_row
+             << endl;
+        _exit(1);
+      }
+      last_row = cell.row_key;
+      rows.insert(cell.row_key);
+      count++;
+    }
+
+    if (count != last - first || (int)rows.size() != last - first) {
+      cout << "Expected " << (last - first) << " rows, got " << count
+           << " cells in " << rows.size() << " rows (flags=" << flags << ")"
+           << endl;
+      _exit(1);
+    }
+
+    for (int i=first; i<last; i++) {
+      if (rows.count(format("row%05d", i)) == 0) {
+        cout << "Row " << format("row%05d", i) << " missing (flags=" << flags
+             << ")" << endl;
+        _exit(1);
+      }
+    }
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  if (argc > 1)
+    Usage::dump_and_exit(usage);
+
+  try {
+    Client *hypertable = new Client(argv[0], "./hypertable.cfg");
+    NamespacePtr ns = hypertable->open_namespace("/");
+    TablePtr table;
+    TableMutatorPtr mutator;
+    KeySpec key;
+    String row, value;
+
+    ns->drop_table("ParallelScanTest", true);
+    ns->create_table("ParallelScanTest", schema);
+
+    table = ns->open_table("ParallelScanTest");
+
+    mutator = table->create_mutator();
+    for (int i=0; i<ROW_COUNT; i++) {
+      row = format("row%05d", i);
+      value = format("value%d", i);
+      key.row = row.c_str();
+      key.row_len = row.length();
+      key.column_family = "data";
+      mutator->set(key, value.c_str(), value.length());
+    }
+    mutator->flush();
+    mutator = 0;
+
+    ScanSpec scan_spec;
+    int32_t parallel = Table::SCANNER_FLAG_PARALLEL;
+    int32_t ordered = Table::SCANNER_FLAG_PARALLEL_ORDERED;
+
+    // Full table scans
+    check_scan(table, scan_spec, parallel, 0, ROW_COUNT, false);
+    check_scan(table, scan_spec, ordered, 0, ROW_COUNT, true);
+
+    // Row interval scans
+    ScanSpecBuilder ssb;
+    ssb.add_row_interval("row01000", true, "row03000", false);
+    check_scan(table, ssb.get(), parallel, 1000, 3000, false);
+    check_scan(table, ssb.get(), ordered, 1000, 3000, true);
+
+    ssb.clear();
+    ssb.add_row_interval("row01000", false, "row03000", true);
+    check_scan(table, ssb.get(), parallel, 1001, 3001, false);
+    check_scan(table, ssb.get(), ordered, 1001, 3001, true);
+
+    // Scans with a row limit are carried out sequentially
+    ssb.clear();
+    ssb.set_row_limit(10);
+    check_scan(table, ssb.get(), parallel, 0, 10, true);
+
+    table = 0;
+  }
+  catch (Exception &e) {
+    HT_ERROR_OUT << e << HT_END;
+    _exit(1);
+  }
+
+  _exit(0);
+}
@@ -82,6 +82,17 @@ int main(int argc, char *argv[]) {
 
     stats1->tables.push_back(table_stat);
   }
+
+  stats1->maintenance_io_rate = Random::number64();
+  for (size_t i=0; i<3; i++) {
+    StatsMaintenanceIO io;
+    sprintf(idbuf, "task-%d", (int)i);
+    io.task = idbuf;
+    io.read_bytes = Random::number64();
+    io.write_bytes = Random::number64();
+    io.throttled_millis = Random::number64();
+    stats1->maintenance_io.push_back(io);
+  }
   
   
   size_t len = stats1->encoded_length();
@@ -21,6 +21,7 @@
 
 #include "Common/Compat.h"
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include "Common/md5.h"
@@ -81,5 +82,91 @@ int main(int argc, char **argv) {
   assert(fired==true);
   fired=false;
 
+  // aggregation descriptor survives encoding
+  {
+    ScanSpecBuilder ssb;
+    ssb.add_column("a");
+    ssb.set_row_limit(10);
+    ssb.set_aggregate(ScanSpec::AGGREGATE_SUM, true);
+    ScanSpec &ss = ssb.get();
+    ss.throw_if_invalid();
+    size_t len = ss.encoded_length();
+    StaticBuffer buf(len);
+    uint8_t *ptr = buf.base;
+    ss.encode(&ptr);
+    assert((size_t)(ptr - buf.base) == len);
+    const uint8_t *decode_ptr = buf.base;
+    size_t remain = len;
+    ScanSpec decoded(&decode_ptr, &remain);
+    assert(remain == 0);
+    assert(decoded.aggregate == ScanSpec::AGGREGATE_SUM);
+    assert(decoded.aggregate_by_row);
+    assert(decoded.row_limit == 10);
+
+    // copies keep the descriptor
+    ScanSpecBuilder copy(ss);
+    assert(copy.get().aggregate == ScanSpec::AGGREGATE_SUM);
+    assert(copy.get().aggregate_by_row);
+  }
+
+  // specs from older clients end before the aggregation descriptor
+  {
+    ScanSpecBuilder ssb;
+    ssb.add_column("a");
+    ssb.set_row_limit(10);
+    ssb.set_cell_offset(3);
+    ScanSpec &ss = ssb.get();
+    size_t len = ss.encoded_length();
+    StaticBuffer buf(len);
+    uint8_t *ptr = buf.base;
+    ss.encode(&ptr);
+    // strip the vi32 aggregate (one byte for AGGREGATE_NONE) and the bool
+    size_t old_len = len - 2;
+    const uint8_t *decode_ptr = buf.base;
+    size_t remain = old_len;
+    ScanSpec decoded(&decode_ptr, &remain);
+    assert(remain == 0);
+    assert((size_t)(decode_ptr - buf.base) == old_len);
+    assert(decoded.aggregate == ScanSpec::AGGREGATE_NONE);
+    assert(!decoded.aggregate_by_row);
+    assert(decoded.row_limit == 10);
+    assert(decoded.cell_offset == 3);
+    assert(decoded.columns.size() == 1 && !strcmp(decoded.columns[0], "a"));
+  }
+
+  // not allowed: a row limit on an aggregate over the whole scan
+  try {
+    ScanSpecBuilder ssb;
+    ssb.set_row_limit(10);
+    ssb.set_aggregate(ScanSpec::AGGREGATE_COUNT);
+    ssb.get().throw_if_invalid();
+  }
+  catch (Exception &e) {
+    if (e.code()!=Error::BAD_SCAN_SPEC) {
+      std::cout << e << std::endl;
+      _exit(1);
+    }
+    fired=true;
+  }
+
+  assert(fired==true);
+  fired=false;
+
+  // not allowed: an unknown aggregation function
+  try {
+    ScanSpecBuilder ssb;
+    ssb.set_aggregate(ScanSpec::AGGREGATE_MAX + 1);
+  }
+  catch (Exception &e) {
+    if (e.code()!=Error::BAD_SCAN_SPEC) {
+      std::cout << e << std::endl;
+      _exit(1);
+    }
+    fired=true;
+  }
+
+  assert(fired==true);
+  fired=false;
+
   _exit(0);
 }
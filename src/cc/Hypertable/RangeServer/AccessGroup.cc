@@ -26,16 +26,21 @@
 #include <iterator>
 #include <vector>
 
+#include <boost/algorithm/string/join.hpp>
+
 #include "Common/DynamicBuffer.h"
 #include "Common/Error.h"
 #include "Common/md5.h"
+#include "Common/Time.h"
 
 #include "AccessGroup.h"
 #include "CellCache.h"
 #include "CellCacheScanner.h"
 #include "CellStoreFactory.h"
 #include "CellStoreReleaseCallback.h"
-#include "CellStoreV6.h"
+#include "CellStoreV7.h"
+#include "CompactionPolicyRunLength.h"
+#include "CompactionShardSet.h"
 #include "Global.h"
 #include "MaintenanceFlag.h"
 #include "MergeScannerAccessGroup.h"
@@ -56,7 +61,8 @@ AccessGroup::AccessGroup(const TableIdentifier *identifier,
     m_latest_stored_revision(TIMESTAMP_MIN),
     m_latest_stored_revision_hint(TIMESTAMP_MIN),
     m_file_tracker(identifier, schema, range, ag->name), m_is_root(false),
-    m_recovering(false), m_needs_merging(false) {
+    m_recovering(false), m_needs_merging(false), m_bytes_ingested(0),
+    m_bytes_written(0), m_disk_bytes_written(0) {
 
   m_table_name = m_identifier.id;
   m_start_row = range->start_row;
@@ -64,7 +70,14 @@ AccessGroup::AccessGroup(const TableIdentifier *identifier,
   m_range_name = m_table_name + "[" + m_start_row + ".." + m_end_row + "]";
   m_full_name = m_range_name + "(" + m_name + ")";
 
-  m_cell_cache_manager = new CellCacheManager();
+  String cell_cache_type = ag->cell_cache;
+  if (cell_cache_type.empty()) {
+    assert(Config::properties); // requires Config::init* first
+    cell_cache_type = Config::get_str("Hypertable.RangeServer.AccessGroup"
+                                      ".CellCache.DefaultType");
+  }
+  m_cell_cache_manager =
+    new CellCacheManager(!strcasecmp(cell_cache_type.c_str(), "skiplist"));
 
   range_dir_initialize();
 
@@ -404,6 +417,9 @@ AccessGroup::MaintenanceData *AccessGroup::get_maintenance_data(ByteArena &arena
 
   mdata->gc_needed = m_garbage_tracker.check_needed(mdata->deletes, mdata->mem_used, now);
   mdata->needs_merging = m_needs_merging;
+  mdata->bytes_ingested = m_bytes_ingested;
+  mdata->bytes_written = m_bytes_written;
+  mdata->disk_bytes_written = m_disk_bytes_written;
 
   mdata->maintenance_flags = 0;
 
@@ -470,6 +486,8 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
   CellListScannerPtr scanner;
   MergeScanner *mscanner = 0;
   CellStorePtr cellstore;
+  std::vector<CellStorePtr> cellstores;
+  CompactionShardSetPtr shards;
   CellCachePtr filtered_cache, shadow_cache;
   String metadata_key_str;
   bool abort_loop = true;
@@ -479,7 +497,7 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
   bool gc = false;
   bool garbage_check_performed = false;
   size_t merge_offset=0, merge_length=0;
-  String added_file;
+  int64_t bytes_ingested = 0;
 
   hints->ag_name = m_name;
   m_file_tracker.get_file_list(hints->files);
@@ -495,7 +513,7 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
     else if (MaintenanceFlag::major_compaction(maintenance_flags) ||
              MaintenanceFlag::move_compaction(maintenance_flags)) {
       if ((m_cell_cache_manager->immutable_cache_empty()) &&
-          m_stores.size() <= (size_t)1 &&
+          logical_store_count() <= (size_t)1 &&
           (!MaintenanceFlag::split(maintenance_flags) &&
            !MaintenanceFlag::move_compaction(maintenance_flags)))
         break;
@@ -580,15 +598,23 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
         }
       }
 
-      cellstore = new CellStoreV6(Global::dfs.get(), m_schema.get());
+      cellstore = new CellStoreV7(Global::dfs.get(), m_schema.get());
 
       max_num_entries = m_cell_cache_manager->immutable_items();
 
+      if (!merging && m_cell_cache_manager->immutable_cache()) {
+        size_t cells = 0;
+        int64_t key_bytes = 0, value_bytes = 0;
+        m_cell_cache_manager->immutable_cache()->add_counts(&cells, &key_bytes,
+                                                            &value_bytes);
+        bytes_ingested = key_bytes + value_bytes;
+      }
+
       if (m_in_memory) {
         mscanner = new MergeScannerAccessGroup(m_table_name, scan_context);
         scanner = mscanner;
         m_cell_cache_manager->add_immutable_scanner(mscanner, scan_context);
-        filtered_cache = new CellCache();
+        filtered_cache = m_cell_cache_manager->new_cell_cache();
       }
       else if (merging) {
         mscanner = new MergeScannerAccessGroup(m_table_name, 
@@ -598,23 +624,30 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
         for (size_t i=merge_offset; i<merge_offset+merge_length; i++) {
           HT_ASSERT(m_stores[i].cs);
           mscanner->add_scanner(m_stores[i].cs->create_scanner(scan_context));
-          int divisor = (boost::any_cast<uint32_t>(m_stores[i].cs->get_trailer()->get("flags")) & CellStoreTrailerV6::SPLIT) ? 2: 1;
+          int divisor = (boost::any_cast<uint32_t>(m_stores[i].cs->get_trailer()->get("flags")) & CellStoreTrailerV7::SPLIT) ? 2: 1;
           max_num_entries += (boost::any_cast<int64_t>
               (m_stores[i].cs->get_trailer()->get("total_entries")))/divisor;
         }
       }
       else if (major || gc) {
-        mscanner = new MergeScannerAccessGroup(m_table_name, scan_context, 
-                        false, true);
-        scanner = mscanner;
-        m_cell_cache_manager->add_immutable_scanner(mscanner, scan_context);
         for (size_t i=0; i<m_stores.size(); i++) {
           HT_ASSERT(m_stores[i].cs);
-          mscanner->add_scanner(m_stores[i].cs->create_scanner(scan_context));
-          int divisor = (boost::any_cast<uint32_t>(m_stores[i].cs->get_trailer()->get("flags")) & CellStoreTrailerV6::SPLIT) ? 2: 1;
+          int divisor = (boost::any_cast<uint32_t>(m_stores[i].cs->get_trailer()->get("flags")) & CellStoreTrailerV7::SPLIT) ? 2: 1;
           max_num_entries += (boost::any_cast<int64_t>
               (m_stores[i].cs->get_trailer()->get("total_entries")))/divisor;
         }
+        shards = create_compaction_shards(major, maintenance_flags, cs_file,
+                                          max_num_entries);
+        if (shards)
+          cellstore = 0;
+        else {
+          mscanner = new MergeScannerAccessGroup(m_table_name, scan_context,
+                                                 false, true);
+          scanner = mscanner;
+          m_cell_cache_manager->add_immutable_scanner(mscanner, scan_context);
+          for (size_t i=0; i<m_stores.size(); i++)
+            mscanner->add_scanner(m_stores[i].cs->create_scanner(scan_context));
+        }
       }
       else {
         scanner = m_cell_cache_manager->create_immutable_scanner(scan_context);
@@ -622,33 +655,71 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
       }
     }
 
-    cellstore->create(cs_file.c_str(), max_num_entries, m_cellstore_props, &m_identifier);
-
-    while (scanner->get(key, value)) {
-      cellstore->add(key, value);
-      if (m_in_memory)
-        filtered_cache->add(key, value);
-      scanner->forward();
+    MaintenanceThrottle::Task task = MaintenanceThrottle::MINOR_COMPACTION;
+    if (m_in_memory)
+      task = MaintenanceThrottle::INMEMORY_COMPACTION;
+    else if (merging)
+      task = MaintenanceThrottle::MERGING_COMPACTION;
+    else if (major)
+      task = MaintenanceThrottle::MAJOR_COMPACTION;
+    else if (gc)
+      task = MaintenanceThrottle::GC_COMPACTION;
+
+    // Minor and in-memory compactions free memory, so they aren't delayed
+    MaintenanceThrottle::Scope throttle_scope(Global::maintenance_throttle.get(),
+        task, merging || major || gc);
+
+    if (shards) {
+      try {
+        shards->run();
+      }
+      catch (Exception &e) {
+        shards->remove_files();
+        throw;
+      }
+      shards->get_cellstores(cellstores);
     }
+    else {
+      cellstore->create(cs_file.c_str(), max_num_entries, m_cellstore_props, &m_identifier);
+
+      while (scanner->get(key, value)) {
+        cellstore->add(key, value);
+        if (m_in_memory)
+          filtered_cache->add(key, value);
+        scanner->forward();
+      }
 
-    CellStoreTrailerV6 *trailer = dynamic_cast<CellStoreTrailerV6 *>(cellstore->get_trailer());
+      CellStoreTrailerV7 *trailer = dynamic_cast<CellStoreTrailerV7 *>(cellstore->get_trailer());
 
-    if (major && mscanner)
-      trailer->flags |= CellStoreTrailerV6::MAJOR_COMPACTION;
+      if (major && mscanner)
+        trailer->flags |= CellStoreTrailerV7::MAJOR_COMPACTION;
 
-    if (maintenance_flags & MaintenanceFlag::SPLIT)
-      trailer->flags |= CellStoreTrailerV6::SPLIT;
+      if (maintenance_flags & MaintenanceFlag::SPLIT)
+        trailer->flags |= CellStoreTrailerV7::SPLIT;
 
-    cellstore->finalize(&m_identifier);
+      cellstore->finalize(&m_identifier);
+      cellstores.push_back(cellstore);
+    }
 
     /**
      * Install new CellCache and CellStore and update Live file tracker
      */
     std::vector<String> removed_files;
+    std::vector<String> added_files;
     int64_t total_index_entries = 0;
+    double write_amp;
     {
       ScopedLock lock(m_mutex);
 
+      m_bytes_ingested += bytes_ingested;
+      foreach_ht (CellStorePtr &cs, cellstores) {
+        CellStoreTrailer *trailer = cs->get_trailer();
+        m_bytes_written += boost::any_cast<int64_t>(trailer->get("key_bytes")) +
+          boost::any_cast<int64_t>(trailer->get("value_bytes"));
+        m_disk_bytes_written += cs->disk_usage();
+      }
+      write_amp = write_amplification();
+
       if (merging) {
         std::vector<CellStoreInfo> new_stores;
         new_stores.reserve(m_stores.size() - (merge_length-1));
@@ -658,7 +729,7 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
           removed_files.push_back(m_stores[i].cs->get_filename());
         if (cellstore->get_total_entries() > 0) {
           new_stores.push_back(cellstore);
-          added_file = cellstore->get_filename();
+          added_files.push_back(cellstore->get_filename());
         }
         for (size_t i=merge_offset+merge_length; i<m_stores.size(); i++)
           new_stores.push_back(m_stores[i]);
@@ -671,10 +742,13 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
          * check, then update the garbage tracker with statistics from
          * the MergeScanner.  Also clear the garbage tracker.
          */
-        if ((major || gc) && mscanner) {
+        if ((major || gc) && (mscanner || shards)) {
           if (!garbage_check_performed) {
             uint64_t input_bytes, output_bytes;
-            mscanner->get_io_accounting_data(&input_bytes, &output_bytes);
+            if (shards)
+              shards->get_io_accounting_data(&input_bytes, &output_bytes);
+            else
+              mscanner->get_io_accounting_data(&input_bytes, &output_bytes);
             m_garbage_tracker.set_garbage_stats(input_bytes, output_bytes);
           }
           m_garbage_tracker.clear();
@@ -682,8 +756,13 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
         else if (m_in_memory)
           m_garbage_tracker.clear();
 
-        m_latest_stored_revision = boost::any_cast<int64_t>
-          (cellstore->get_trailer()->get("revision"));
+        m_latest_stored_revision = TIMESTAMP_MIN;
+        foreach_ht (CellStorePtr &cs, cellstores) {
+          int64_t revision = boost::any_cast<int64_t>
+            (cs->get_trailer()->get("revision"));
+          if (revision > m_latest_stored_revision)
+            m_latest_stored_revision = revision;
+        }
         if (m_latest_stored_revision >= m_earliest_cached_revision)
           HT_ERROR("Revision (clock) skew detected! May result in data loss.");
 
@@ -709,15 +788,18 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
           }
         }
 
-        /** Add the new cell store to the table vector, or delete it if
-         * it contains no entries
+        /** Add the new cell stores to the table vector, or delete them if
+         * they contain no entries
          */
-        if (cellstore->get_total_entries() > 0) {
-          m_stores.push_back( CellStoreInfo(cellstore, shadow_cache, m_earliest_cached_revision_saved) );
-          m_needs_merging = find_merge_run();
-          m_garbage_tracker.accumulate_expirable( m_stores.back().expirable_data );
-          added_file = cellstore->get_filename();
+        foreach_ht (CellStorePtr &cs, cellstores) {
+          if (cs->get_total_entries() > 0) {
+            m_stores.push_back( CellStoreInfo(cs, shadow_cache, m_earliest_cached_revision_saved) );
+            m_garbage_tracker.accumulate_expirable( m_stores.back().expirable_data );
+            added_files.push_back(cs->get_filename());
+          }
         }
+        if (!added_files.empty())
+          m_needs_merging = find_merge_run();
       }
 
       recompute_compression_ratio(&total_index_entries);
@@ -725,18 +807,21 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
       hints->disk_usage = m_disk_usage;
     }
 
-    if (cellstore->get_total_entries() == 0) {
-      String fname = cellstore->get_filename();
-      cellstore = 0;
-      try {
-        Global::dfs->remove(fname);
-      }
-      catch (Hypertable::Exception &e) {
-        HT_ERROR_OUT << "Problem removing '" << fname << "' " << e << HT_END;
+    foreach_ht (CellStorePtr &cs, cellstores) {
+      if (cs->get_total_entries() == 0) {
+        String fname = cs->get_filename();
+        try {
+          Global::dfs->remove(fname);
+        }
+        catch (Hypertable::Exception &e) {
+          HT_ERROR_OUT << "Problem removing '" << fname << "' " << e << HT_END;
+        }
       }
     }
+    cellstore = 0;
+    cellstores.clear();
 
-    m_file_tracker.update_live(added_file, removed_files, m_next_cs_id, total_index_entries);
+    m_file_tracker.update_live(added_files, removed_files, m_next_cs_id, total_index_entries);
     m_file_tracker.update_files_column();
     m_file_tracker.get_file_list(hints->files);
 
@@ -745,8 +830,9 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
     else
       m_earliest_cached_revision_saved = TIMESTAMP_MAX;
 
-    HT_INFOF("Finished Compaction of %s(%s) to %s", m_range_name.c_str(),
-             m_name.c_str(), added_file.c_str());
+    HT_INFOF("Finished Compaction of %s(%s) to %s (write amplification %.2f)",
+             m_range_name.c_str(), m_name.c_str(),
+             boost::algorithm::join(added_files, ",").c_str(), write_amp);
 
   }
   catch (Exception &e) {
@@ -755,6 +841,83 @@ void AccessGroup::run_compaction(int maintenance_flags, Hints *hints) {
   }
 }
 
+CompactionShardSetPtr
+AccessGroup::create_compaction_shards(bool major, int maintenance_flags,
+                                      const String &first_file,
+                                      int64_t max_num_entries) {
+  if (Global::subcompaction_max_shards < 2 || m_in_memory || m_stores.empty())
+    return 0;
+
+  size_t shard_count = (size_t)(m_disk_usage / Global::subcompaction_min_shard_size);
+  if (shard_count > (size_t)Global::subcompaction_max_shards)
+    shard_count = Global::subcompaction_max_shards;
+  if (shard_count < 2)
+    return 0;
+
+  // Pick split rows from the block indexes
+  std::vector<String> split_rows;
+  {
+    StlArena arena(128000);
+    SplitRowDataMapT split_row_data =
+      SplitRowDataMapT(LtCstr(), SplitRowDataAlloc(arena));
+    foreach_ht (CellStoreInfo &csinfo, m_stores)
+      csinfo.cs->split_row_estimate_data(split_row_data);
+    CompactionShardSet::choose_split_rows(split_row_data, shard_count,
+                                          split_rows);
+  }
+  if (split_rows.empty())
+    return 0;
+
+  uint32_t trailer_flags = CellStoreTrailerV7::SHARD;
+  if (major)
+    trailer_flags |= CellStoreTrailerV7::MAJOR_COMPACTION;
+  if (maintenance_flags & MaintenanceFlag::SPLIT)
+    trailer_flags |= CellStoreTrailerV7::SPLIT;
+
+  CompactionShardSetPtr shards =
+    new CompactionShardSet(m_cellstore_props, &m_identifier, trailer_flags,
+                           major ? MaintenanceThrottle::MAJOR_COMPACTION
+                                 : MaintenanceThrottle::GC_COMPACTION);
+
+  size_t shard_entries = (size_t)(max_num_entries / (split_rows.size()+1)) + 1;
+
+  // Shard i holds the rows after split row i-1 up to and including split
+  // row i
+  for (size_t i=0; i<=split_rows.size(); i++) {
+    ScanSpecBuilder *spec = new ScanSpecBuilder();
+    ScanContextPtr scan_context;
+    try {
+      spec->add_row_interval((i == 0) ? "" : split_rows[i-1].c_str(), i == 0,
+                             (i == split_rows.size()) ? "" : split_rows[i].c_str(),
+                             true);
+      scan_context = new ScanContext(TIMESTAMP_MAX, &spec->get(), 0, m_schema);
+      scan_context->compaction = true;
+    }
+    catch (Exception &e) {
+      delete spec;
+      throw;
+    }
+    MergeScanner *mscanner =
+      new MergeScannerAccessGroup(m_table_name, scan_context, false, true);
+    CellStorePtr cellstore = new CellStoreV7(Global::dfs.get(), m_schema.get());
+    String filename = first_file;
+    if (i > 0)
+      filename = format("%s/tables/%s/%s/%s/cs%d", Global::toplevel_dir.c_str(),
+                        m_identifier.id, m_name.c_str(), m_range_dir.c_str(),
+                        m_next_cs_id++);
+    shards->add(spec, mscanner, cellstore, filename, shard_entries);
+    m_cell_cache_manager->add_immutable_scanner(mscanner, scan_context);
+    foreach_ht (CellStoreInfo &csinfo, m_stores)
+      mscanner->add_scanner(csinfo.cs->create_scanner(scan_context));
+  }
+
+  HT_INFOF("Splitting compaction of %s(%s) into %d shards",
+           m_range_name.c_str(), m_name.c_str(), (int)split_rows.size()+1);
+
+  return shards;
+}
+
+
 void AccessGroup::load_hints(Hints *hints) {
   hints->ag_name = m_name;
   m_file_tracker.get_file_list(hints->files);
@@ -776,7 +939,7 @@ void AccessGroup::purge_stored_cells_from_cache() {
 
   m_cell_cache_manager->get_read_cache(old_cell_cache);
 
-  CellCachePtr new_cell_cache = new CellCache();
+  CellCachePtr new_cell_cache = m_cell_cache_manager->new_cell_cache();
   new_cell_cache->lock();
   m_cell_cache_manager->install_new_cell_cache(new_cell_cache);
   
@@ -830,7 +993,7 @@ void AccessGroup::shrink(String &split_row, bool drop_high) {
 
     m_file_tracker.change_range(m_start_row, m_end_row);
 
-    CellCachePtr new_cell_cache = new CellCache();
+    CellCachePtr new_cell_cache = m_cell_cache_manager->new_cell_cache();
     new_cell_cache->lock();
     m_cell_cache_manager->install_new_cell_cache(new_cell_cache);
 
@@ -1028,47 +1191,46 @@ void AccessGroup::recompute_compression_ratio(int64_t *total_index_entriesp) {
 
 
 bool AccessGroup::find_merge_run(size_t *indexp, size_t *lenp) {
-  size_t index = 0;
-  size_t i = 0;
-  size_t count;
-  int64_t running_total = 0;
 
   if (m_in_memory || m_stores.size() == 0)
     return false;
 
-  std::vector<int64_t> disk_usage(m_stores.size());
-
-  do {
-    disk_usage[i] = m_stores[i].cs->disk_usage();
-    running_total += disk_usage[i];
-
-    if (running_total >= Global::cellstore_target_size_min) {
-      count = i - index;
-      if (running_total < Global::cellstore_target_size_max)
-        count++;
-      if (count >= (size_t)Global::merge_cellstore_run_length_threshold) {
-        if (indexp)
-          *indexp = index;
-        if (lenp)
-          *lenp = count;
-        return true;
-      }
-      // Otherwise, move the index forward by one and try again
-      running_total -= disk_usage[index];
-      index++;
-    }
-    i++;
-  } while (i < m_stores.size());
-
-  if ((i-index) > (size_t)Global::merge_cellstore_run_length_threshold) {
-    if (indexp)
-      *indexp = index;
-    if (lenp)
-      *lenp = i-index;
-    return true;
+  CompactionPolicyPtr policy = Global::compaction_policy;
+  if (!policy)
+    policy = new CompactionPolicyRunLength(Global::cellstore_target_size_min,
+                                           Global::cellstore_target_size_max,
+                                           Global::merge_cellstore_run_length_threshold);
+
+  std::vector<CompactionPolicy::StoreInfo> stores;
+  stores.reserve(m_stores.size());
+  for (size_t i=0; i<m_stores.size(); i++)
+    stores.push_back(CompactionPolicy::StoreInfo(m_stores[i].cs->disk_usage(),
+                                                 m_stores[i].timestamp_max,
+                                                 m_stores[i].shard));
+
+  return policy->choose_merge_run(stores, get_ts64(), indexp, lenp);
+}
+
+
+size_t AccessGroup::logical_store_count() {
+  size_t count = 0;
+  for (size_t i=0; i<m_stores.size(); i++) {
+    if (i == 0 || !m_stores[i].shard || !m_stores[i-1].shard)
+      count++;
   }
+  return count;
+}
 
-  return false;
+
+/**
+ * Returns the ratio of the key and value bytes written to CellStores by
+ * compactions to the key and value bytes compacted out of the cell cache,
+ * or 0 if nothing has been compacted out of the cell cache yet.
+ */
+double AccessGroup::write_amplification() {
+  if (m_bytes_ingested == 0)
+    return 0.0;
+  return (double)m_bytes_written / (double)m_bytes_ingested;
 }
 
 namespace {
@@ -1139,5 +1301,10 @@ std::ostream &Hypertable::operator<<(std::ostream &os, const AccessGroup::Mainte
   os << "in_memory=" << (mdata.in_memory ? "true" : "false") << "\n";
   os << "gc_needed=" << (mdata.gc_needed ? "true" : "false") << "\n";
   os << "needs_merging=" << (mdata.needs_merging ? "true" : "false") << "\n";
+  os << "bytes_ingested=" << mdata.bytes_ingested << "\n";
+  os << "bytes_written=" << mdata.bytes_written << "\n";
+  os << "disk_bytes_written=" << mdata.disk_bytes_written << "\n";
+  os << "write_amplification=" << (mdata.bytes_ingested ?
+      (double)mdata.bytes_written / (double)mdata.bytes_ingested : 0.0) << "\n";
   return os;
 }
@@ -43,8 +43,9 @@
 #include "AccessGroupGarbageTracker.h"
 #include "CellCacheManager.h"
 #include "CellStore.h"
-#include "CellStoreTrailerV6.h"
+#include "CellStoreTrailerV7.h"
 #include "CellStoreInfo.h"
+#include "CompactionShardSet.h"
 #include "LiveFileTracker.h"
 #include "MaintenanceFlag.h"
 
@@ -101,6 +102,9 @@ namespace Hypertable {
       bool     in_memory;
       bool     gc_needed;
       bool     needs_merging;
+      int64_t  bytes_ingested;
+      int64_t  bytes_written;
+      int64_t  disk_bytes_written;
     };
 
     class Hints {
@@ -233,8 +237,27 @@ namespace Hypertable {
     void range_dir_initialize();
     void recompute_compression_ratio(int64_t *total_index_entriesp=0);
     bool find_merge_run(size_t *indexp=0, size_t *lenp=0);
+
+    /** Returns the number of CellStores, counting the shard set left by a
+     * sharded compaction as a single CellStore.
+     */
+    size_t logical_store_count();
+
+    double write_amplification();
     void sort_cellstores_by_timestamp();
 
+    /** Splits a major or GC compaction into shards if the access group is
+     * large enough.  Must be called with #m_mutex locked.
+     * @param major <i>true</i> for a major compaction
+     * @param maintenance_flags Maintenance flags of the compaction
+     * @param first_file Name of CellStore file for the first shard
+     * @param max_num_entries Estimate of the number of cells compacted
+     * @return Shards to merge, or 0 if the compaction should not be split
+     */
+    CompactionShardSetPtr create_compaction_shards(bool major,
+        int maintenance_flags, const String &first_file,
+        int64_t max_num_entries);
+
     Mutex                m_mutex;
     Mutex                m_outstanding_scanner_mutex;
     boost::condition     m_outstanding_scanner_cond;
@@ -267,6 +290,13 @@ namespace Hypertable {
     bool                 m_bloom_filter_disabled;
     bool                 m_needs_merging;
 
+    /// Key and value bytes compacted out of the cell cache
+    int64_t              m_bytes_ingested;
+    /// Key and value bytes written to CellStores by compactions
+    int64_t              m_bytes_written;
+    /// Disk space of the CellStores written by compactions
+    int64_t              m_disk_bytes_written;
+
   };
   typedef boost::intrusive_ptr<AccessGroup> AccessGroupPtr;
 
@@ -0,0 +1,45 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for AccessGroupCompactionSet.
+ * This file contains the method definitions for AccessGroupCompactionSet, a
+ * class that runs the compactions of a range's access groups in parallel.
+ */
+
+#include "Common/Compat.h"
+
+#include "AccessGroupCompactionSet.h"
+
+using namespace Hypertable;
+
+void AccessGroupCompactionSet::run_job(size_t i) {
+  Job &job = m_jobs[i];
+  try {
+    job.ag->run_compaction(job.flags, job.hints);
+  }
+  catch (Exception &e) {
+    if (!m_recover)
+      throw;
+    job.ag->unstage_compaction();
+    job.ag->load_hints(job.hints);
+  }
+}
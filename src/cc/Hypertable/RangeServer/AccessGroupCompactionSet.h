@@ -0,0 +1,99 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for AccessGroupCompactionSet.
+ * This file contains the type declarations for AccessGroupCompactionSet, a
+ * class that runs the compactions of a range's access groups in parallel.
+ */
+
+#ifndef HYPERTABLE_ACCESSGROUPCOMPACTIONSET_H
+#define HYPERTABLE_ACCESSGROUPCOMPACTIONSET_H
+
+#include <vector>
+
+#include "AccessGroup.h"
+#include "MaintenanceJobSet.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Compacts several access groups of a range concurrently.
+   * The access groups of a range are independent of each other, so their
+   * compactions can run at the same time, each one a job of a
+   * MaintenanceJobSet.
+   */
+  class AccessGroupCompactionSet : public MaintenanceJobSet {
+  public:
+
+    /** Constructor.
+     * @param recover If <i>true</i>, a failed compaction is unstaged and its
+     * hints are loaded from the access group, the way Range::compact handles
+     * errors.  If <i>false</i>, the first error is thrown by run() and
+     * compactions that haven't been started yet are skipped.
+     */
+    AccessGroupCompactionSet(bool recover) : m_recover(recover) { }
+
+    /** Adds a compaction.
+     * @param ag Access group to compact
+     * @param flags Maintenance flags passed to AccessGroup::run_compaction
+     * @param hints Hints object to fill in, must remain valid until run()
+     * returns
+     */
+    void add(AccessGroupPtr &ag, int flags, AccessGroup::Hints *hints) {
+      m_jobs.push_back(Job(ag, flags, hints));
+    }
+
+  protected:
+
+    virtual size_t job_count() const { return m_jobs.size(); }
+
+    virtual void run_job(size_t i);
+
+  private:
+
+    /** A compaction. */
+    struct Job {
+      Job(AccessGroupPtr &_ag, int _flags, AccessGroup::Hints *_hints)
+        : ag(_ag), flags(_flags), hints(_hints) { }
+      AccessGroupPtr ag;
+      int flags;
+      AccessGroup::Hints *hints;
+    };
+
+    /// If errors are recovered from
+    bool m_recover;
+
+    /// Compactions
+    std::vector<Job> m_jobs;
+  };
+
+  /// Smart pointer to AccessGroupCompactionSet
+  typedef intrusive_ptr<AccessGroupCompactionSet> AccessGroupCompactionSetPtr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_ACCESSGROUPCOMPACTIONSET_H
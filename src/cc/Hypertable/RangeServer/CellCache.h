@@ -77,17 +77,17 @@ namespace Hypertable {
      */
     virtual CellListScanner *create_scanner(ScanContextPtr &scan_ctx);
 
-    void lock()   { if (!m_frozen) m_mutex.lock(); }
-    void unlock() { if (!m_frozen) m_mutex.unlock(); }
+    virtual void lock()   { if (!m_frozen) m_mutex.lock(); }
+    virtual void unlock() { if (!m_frozen) m_mutex.unlock(); }
 
-    size_t size() { return m_cell_map.size(); }
+    virtual size_t size() { return m_cell_map.size(); }
 
-    bool empty() {ScopedLock lock(m_mutex); return m_cell_map.empty(); }
+    virtual bool empty() {ScopedLock lock(m_mutex); return m_cell_map.empty(); }
 
     /** Returns the amount of memory used by the CellCache.  This is the
      * summation of the lengths of all the keys and values in the map.
      */
-    int64_t memory_used() {
+    virtual int64_t memory_used() {
       ScopedLock lock(m_mutex);
       int64_t used = m_arena.used();
       if (used < 0)
@@ -98,12 +98,13 @@ namespace Hypertable {
     /**
      * Returns the amount of memory allocated by the CellCache.
      */
-    uint64_t memory_allocated() {
+    virtual uint64_t memory_allocated() {
       ScopedLock lock(m_mutex);
       return m_arena.total();
     }
 
-    void add_counts(size_t *cellsp, int64_t *key_bytesp, int64_t *value_bytesp) {
+    virtual void add_counts(size_t *cellsp, int64_t *key_bytesp,
+                            int64_t *value_bytesp) {
       ScopedLock lock(m_mutex);
       *cellsp += m_cell_map.size();
       *key_bytesp += m_key_bytes;
@@ -115,9 +116,9 @@ namespace Hypertable {
     void freeze() { m_frozen = true; }
     void unfreeze() { m_frozen = false; }
 
-    void merge(CellCache *other);
+    virtual void merge(CellCache *other);
 
-    void populate_key_set(KeySet &keys) {
+    virtual void populate_key_set(KeySet &keys) {
       Key key;
       for (CellMap::const_iterator iter = m_cell_map.begin();
 	   iter != m_cell_map.end(); ++iter) {
@@ -28,15 +28,21 @@
 using namespace Hypertable;
 using namespace std;
 
-CellCacheManager::CellCacheManager() {
-  m_read_cache = new CellCache();
-  m_write_cache = new CellCache(m_read_cache->arena());
+CellCacheManager::CellCacheManager(bool skip_list) : m_skip_list(skip_list) {
+  m_read_cache = new_cell_cache();
+  if (m_skip_list)
+    m_write_cache = m_read_cache;
+  else
+    m_write_cache = new CellCache(m_read_cache->arena());
   m_immutable_cache = 0;
 }
 
 void CellCacheManager::install_new_cell_cache(CellCachePtr &cell_cache) {
   // 1st set write cache and free previous write cell cache
-  m_write_cache = new CellCache(cell_cache->arena());
+  if (m_skip_list)
+    m_write_cache = cell_cache;
+  else
+    m_write_cache = new CellCache(cell_cache->arena());
   // 2nd assign new read cache and free previous read cell cache including the shared arena
   m_read_cache = cell_cache;
 }
@@ -66,7 +72,7 @@ void CellCacheManager::merge_caches(SchemaPtr &schema) {
 
   Key key;
   ByteString value;
-  CellCachePtr merged_cache = new CellCache();
+  CellCachePtr merged_cache = new_cell_cache();
   ScanContextPtr scan_context = new ScanContext(schema);
   CellListScannerPtr scanner = m_immutable_cache->create_scanner(scan_context);
   while (scanner->get(key, value)) {
@@ -119,12 +125,14 @@ CellCacheManager::split_row_estimate_data(CellList::SplitRowDataMapT &split_row_
   if (m_immutable_cache)
     m_immutable_cache->split_row_estimate_data(split_row_data);
   m_read_cache->split_row_estimate_data(split_row_data);
-  m_write_cache->split_row_estimate_data(split_row_data);
+  if (!shared_write_cache())
+    m_write_cache->split_row_estimate_data(split_row_data);
 }
 
 
 int64_t CellCacheManager::get_total_entries() {
-  return m_read_cache->get_total_entries() + m_write_cache->get_total_entries() +
+  return m_read_cache->get_total_entries() +
+    (shared_write_cache() ? 0 : m_write_cache->get_total_entries()) +
     (m_immutable_cache ? m_immutable_cache->get_total_entries() : 0);
 }
 
@@ -177,7 +185,8 @@ uint64_t CellCacheManager::memory_allocated() {
 }
 
 int32_t CellCacheManager::get_delete_count() {
-  return m_read_cache->get_delete_count() + m_write_cache->get_delete_count() +
+  return m_read_cache->get_delete_count() +
+    (shared_write_cache() ? 0 : m_write_cache->get_delete_count()) +
     (m_immutable_cache ? m_immutable_cache->get_delete_count() : 0);
 }
 
@@ -185,7 +194,8 @@ void CellCacheManager::get_counts(size_t *cellsp, int64_t *key_bytesp, int64_t *
   *cellsp = 0;
   *key_bytesp = *value_bytesp = 0;
   m_read_cache->add_counts(cellsp, key_bytesp, value_bytesp);
-  m_write_cache->add_counts(cellsp, key_bytesp, value_bytesp);
+  if (!shared_write_cache())
+    m_write_cache->add_counts(cellsp, key_bytesp, value_bytesp);
   if (m_immutable_cache)
     m_immutable_cache->add_counts(cellsp, key_bytesp, value_bytesp);
 }
@@ -194,13 +204,17 @@ void CellCacheManager::freeze() {
   m_read_cache->merge(m_write_cache.get());
   m_immutable_cache = m_read_cache;
   m_immutable_cache->freeze();
-  m_read_cache = new CellCache();
-  m_write_cache = new CellCache(m_read_cache->arena());
+  m_read_cache = new_cell_cache();
+  if (m_skip_list)
+    m_write_cache = m_read_cache;
+  else
+    m_write_cache = new CellCache(m_read_cache->arena());
 }
 
 void CellCacheManager::populate_key_set(KeySet &keys) {
   if (m_immutable_cache)
     m_immutable_cache->populate_key_set(keys);
   m_read_cache->populate_key_set(keys);
-  m_write_cache->populate_key_set(keys);
+  if (!shared_write_cache())
+    m_write_cache->populate_key_set(keys);
 }
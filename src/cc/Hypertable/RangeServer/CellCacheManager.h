@@ -23,6 +23,7 @@
 #define HYPERTABLE_CELLCACHEMANAGER_H
 
 #include "CellCache.h"
+#include "CellCacheSkipList.h"
 #include "CellList.h"
 #include "CellListScanner.h"
 #include "MergeScanner.h"
@@ -35,9 +36,24 @@ namespace Hypertable {
   class CellCacheManager : public ReferenceCount {
 
   public:
-    CellCacheManager();
+    /**
+     * Constructor.  When <code>skip_list</code> is true, cell caches are
+     * CellCacheSkipList objects and a single cache serves as both the read
+     * and the write cache, since scanners can read it while it is being
+     * updated.
+     *
+     * @param skip_list use concurrent skip list cell caches
+     */
+    CellCacheManager(bool skip_list=false);
     virtual ~CellCacheManager() { }
 
+    /** Creates a new, empty cell cache of the type used by this manager */
+    CellCache *new_cell_cache() {
+      if (m_skip_list)
+        return new CellCacheSkipList();
+      return new CellCache();
+    }
+
     void install_new_cell_cache(CellCachePtr &cell_cache);
 
     void install_new_immutable_cache(CellCachePtr &cell_cache);
@@ -104,6 +120,9 @@ namespace Hypertable {
     void populate_key_set(KeySet &keys);
 
   private:
+    bool shared_write_cache() { return m_write_cache == m_read_cache; }
+
+    bool m_skip_list;
     CellCachePtr m_read_cache;
     CellCachePtr m_write_cache;
     CellCachePtr m_immutable_cache;
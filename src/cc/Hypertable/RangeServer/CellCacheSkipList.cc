@@ -0,0 +1,349 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cassert>
+
+#include "Common/Logger.h"
+#include "Common/Serialization.h"
+
+#include "Hypertable/Lib/Key.h"
+
+#include "CellCacheSkipList.h"
+#include "CellCacheSkipListScanner.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+  const size_t NODE_ALIGNMENT = sizeof(void *);
+}
+
+
+CellCacheSkipList::CellCacheSkipList()
+  : m_max_height(1), m_height_seed(0), m_count(0) {
+  m_head = new_node(0, MAX_HEIGHT);
+  m_head->entry = 0;
+  m_head->key_length = 0;
+}
+
+
+uint8_t *CellCacheSkipList::alloc(size_t len) {
+  ScopedLock lock(m_mutex);
+  return m_arena.alloc(len);
+}
+
+
+/**
+ * Allocates a node of the given height together with <code>entry_len</code>
+ * bytes of trailing space for its cell.  The arena does not align its
+ * allocations, so the node is aligned by hand to keep the next pointers
+ * naturally aligned for compare-and-swap.
+ */
+CellCacheSkipList::Node *
+CellCacheSkipList::new_node(size_t entry_len, int height) {
+  size_t node_len = sizeof(Node) + (height-1) * sizeof(Node *);
+  node_len = (node_len + NODE_ALIGNMENT - 1) & ~(NODE_ALIGNMENT - 1);
+  uint8_t *base = alloc(node_len + entry_len + NODE_ALIGNMENT - 1);
+  Node *node = (Node *)(((uintptr_t)base + NODE_ALIGNMENT - 1)
+                        & ~(uintptr_t)(NODE_ALIGNMENT - 1));
+  node->entry = (uint8_t *)node + node_len;
+  node->height = height;
+  for (int i=0; i<height; i++)
+    node->next[i] = 0;
+  return node;
+}
+
+
+/**
+ * Picks a node height with a geometric distribution (1/BRANCHING).  The
+ * seed is advanced atomically and mixed so that concurrent writers never
+ * need to share mutable random state.
+ */
+int CellCacheSkipList::random_height() {
+  uint32_t r = __sync_add_and_fetch(&m_height_seed, 0x9E3779B9U);
+  r ^= r >> 16;
+  r *= 0x85EBCA6BU;
+  r ^= r >> 13;
+  r *= 0xC2B2AE35U;
+  r ^= r >> 16;
+  int height = 1;
+  while (height < MAX_HEIGHT && (r % BRANCHING) == 0) {
+    height++;
+    r /= BRANCHING;
+  }
+  return height;
+}
+
+
+CellCacheSkipList::Node *
+CellCacheSkipList::find_greater_or_equal(const SerializedKey key,
+                                         Node **prev) const {
+  Node *x = m_head;
+  int level = m_max_height - 1;
+  while (true) {
+    Node *next = x->next[level];
+    if (next && SerializedKey(next->entry).compare(key) < 0)
+      x = next;
+    else {
+      if (prev)
+        prev[level] = x;
+      if (level == 0)
+        return next;
+      level--;
+    }
+  }
+}
+
+
+void CellCacheSkipList::replace_entry(Node *node, const uint8_t *entry) {
+  const uint8_t *old_entry;
+  do {
+    old_entry = node->entry;
+  } while (!__sync_bool_compare_and_swap(&node->entry, old_entry, entry));
+  __sync_fetch_and_add(&m_collisions, 1);
+  HT_WARNF("Collision detected key insert (row = %s)",
+           SerializedKey(entry).row());
+}
+
+
+/**
+ * Links <code>node</code> into the list bottom-up.  Once the node is linked
+ * at level 0 it is visible to scanners; the upper levels only speed up
+ * searches.  If another writer links an equal key first, the cell is
+ * installed into that node instead.
+ */
+void CellCacheSkipList::insert(Node *node, bool is_delete) {
+  SerializedKey key(node->entry);
+  Node *prev[MAX_HEIGHT];
+  Node *next;
+
+  // find_greater_or_equal() only fills in the levels below the height it
+  // read, and another writer may raise the height before it is read again
+  // below, so every level starts out at the head
+  for (int i=0; i<MAX_HEIGHT; i++)
+    prev[i] = m_head;
+
+  next = find_greater_or_equal(key, prev);
+  if (next && SerializedKey(next->entry).compare(key) == 0) {
+    replace_entry(next, node->entry);
+    return;
+  }
+
+  int max_height = m_max_height;
+  while (max_height < node->height &&
+         !__sync_bool_compare_and_swap(&m_max_height, max_height,
+                                       node->height))
+    max_height = m_max_height;
+
+  for (int i=0; i<node->height; i++) {
+    while (true) {
+      next = prev[i]->next[i];
+      while (next && SerializedKey(next->entry).compare(key) < 0) {
+        prev[i] = next;
+        next = next->next[i];
+      }
+      if (i == 0 && next && SerializedKey(next->entry).compare(key) == 0) {
+        replace_entry(next, node->entry);
+        return;
+      }
+      node->next[i] = next;
+      if (__sync_bool_compare_and_swap(&prev[i]->next[i], next, node))
+        break;
+    }
+  }
+
+  __sync_fetch_and_add(&m_count, 1);
+  if (is_delete)
+    __sync_fetch_and_add(&m_deletes, 1);
+}
+
+
+void CellCacheSkipList::add(const Key &key, const ByteString value) {
+  size_t total_len = key.length + value.length();
+
+  assert(!m_frozen);
+
+  Node *node = new_node(total_len, random_height());
+  uint8_t *ptr = (uint8_t *)node->entry;
+
+  memcpy(ptr, key.serial.ptr, key.length);
+  ptr += key.length;
+  value.write(ptr);
+  node->key_length = key.length;
+
+  __sync_fetch_and_add(&m_key_bytes, (int64_t)key.length);
+  __sync_fetch_and_add(&m_value_bytes, (int64_t)value.length());
+
+  insert(node, key.flag <= FLAG_DELETE_CELL_VERSION);
+}
+
+
+/**
+ * Same semantics as CellCache::add_counter, except that the combined cell
+ * is written into a fresh entry and swapped into the node so that
+ * concurrent scanners never observe a partially updated counter.
+ */
+void CellCacheSkipList::add_counter(const Key &key, const ByteString value) {
+
+  // Check for counter reset
+  if (*value.ptr == 9) {
+    HT_ASSERT(value.ptr[9] == '=');
+    add(key, value);
+    return;
+  }
+  else if (m_have_counter_deletes || key.flag != FLAG_INSERT) {
+    add(key, value);
+    m_have_counter_deletes = true;
+    return;
+  }
+
+  HT_ASSERT(*value.ptr == 8);
+
+  Node *node = lower_bound(key.serial);
+  uint8_t *new_entry = 0;
+
+  while (true) {
+
+    if (node == 0) {
+      add(key, value);
+      return;
+    }
+
+    const uint8_t *old_entry = node->entry;
+    const uint8_t *ptr;
+    size_t len = SerializedKey(old_entry).decode_length(&ptr);
+
+    // If the lengths differ, assume they're different keys and do a normal add
+    if (len + (ptr-old_entry) != key.length) {
+      add(key, value);
+      return;
+    }
+
+    if (memcmp(ptr+1, key.row, (key.flag_ptr+1)-(const uint8_t *)key.row)) {
+      add(key, value);
+      return;
+    }
+
+    ByteString old_value;
+    old_value.ptr = old_entry + node->key_length;
+
+    HT_ASSERT(*old_value.ptr == 8 || *old_value.ptr == 9);
+
+    // If old value was a reset, just insert the new value
+    if (*old_value.ptr == 9) {
+      add(key, value);
+      return;
+    }
+
+    // read old value
+    ptr = old_value.ptr+1;
+    size_t remaining = 8;
+    int64_t old_count = (int64_t)Serialization::decode_i64(&ptr, &remaining);
+
+    // read new value
+    ptr = value.ptr+1;
+    remaining = 8;
+    int64_t new_count = (int64_t)Serialization::decode_i64(&ptr, &remaining);
+
+    /*
+     * The new entry carries the timestamp/revision of the insert key and
+     * the summed counter value
+     */
+    if (new_entry == 0)
+      new_entry = alloc(key.length + 9);
+    memcpy(new_entry, key.serial.ptr, key.length);
+    uint8_t *write_ptr = new_entry + key.length;
+    *write_ptr++ = 8;
+    Serialization::encode_i64(&write_ptr, old_count+new_count);
+
+    if (__sync_bool_compare_and_swap(&node->entry, old_entry, new_entry))
+      return;
+  }
+}
+
+
+void CellCacheSkipList::split_row_estimate_data(SplitRowDataMapT &split_row_data) {
+  const char *row, *last_row = 0;
+  int64_t last_count = 0;
+  for (Node *node = first(); node; node = node->next[0]) {
+    row = SerializedKey(node->entry).row();
+    if (last_row == 0)
+      last_row = row;
+    if (strcmp(row, last_row) != 0) {
+      CstrToInt64MapT::iterator iter = split_row_data.find(last_row);
+      if (iter == split_row_data.end())
+        split_row_data[last_row] = last_count;
+      else
+        iter->second += last_count;
+      last_row = row;
+      last_count = 0;
+    }
+    last_count++;
+  }
+  if (last_count > 0) {
+    CstrToInt64MapT::iterator iter = split_row_data.find(last_row);
+    if (iter == split_row_data.end())
+      split_row_data[last_row] = last_count;
+    else
+      iter->second += last_count;
+  }
+}
+
+
+CellListScanner *CellCacheSkipList::create_scanner(ScanContextPtr &scan_ctx) {
+  CellCacheSkipListPtr cellcache(this);
+  return new CellCacheSkipListScanner(cellcache, scan_ctx);
+}
+
+
+/**
+ * Merging a skip list into itself is a no-op; this is what happens when
+ * CellCacheManager uses the same skip list as both read and write cache.
+ * Otherwise the entries of <code>other</code>, which must share this
+ * cache's arena, are linked into this list.
+ */
+void CellCacheSkipList::merge(CellCache *other) {
+  if (other == this)
+    return;
+
+  CellCacheSkipList *other_list = dynamic_cast<CellCacheSkipList *>(other);
+  HT_ASSERT(other_list && &m_arena == &(other->arena()));
+
+  for (Node *src = other_list->first(); src; src = src->next[0]) {
+    Node *node = new_node(0, random_height());
+    node->entry = src->entry;
+    node->key_length = src->key_length;
+    insert(node, false);
+  }
+  __sync_fetch_and_add(&m_deletes, other_list->get_delete_count());
+  __sync_fetch_and_add(&m_key_bytes, other_list->m_key_bytes);
+  __sync_fetch_and_add(&m_value_bytes, other_list->m_value_bytes);
+}
+
+
+void CellCacheSkipList::populate_key_set(KeySet &keys) {
+  Key key;
+  for (Node *node = first(); node; node = node->next[0]) {
+    key.load(SerializedKey(node->entry));
+    keys.insert(key);
+  }
+}
@@ -0,0 +1,121 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_CELLCACHESKIPLIST_H
+#define HYPERTABLE_CELLCACHESKIPLIST_H
+
+#include "CellCache.h"
+
+namespace Hypertable {
+
+  /**
+   * A CellCache backed by a concurrent skip list.  Nodes and cell data are
+   * allocated from the cache's arena and are never removed, so scanners walk
+   * the list without taking any lock while updates are linked in with
+   * compare-and-swap.  Multiple writers may add cells concurrently; the arena
+   * itself is protected by a short critical section on #m_mutex.  Cells that
+   * collide with an existing key, as well as combined counter values, are
+   * installed by atomically swapping the node's entry pointer, so readers
+   * always see either the old or the new cell, never a torn one.
+   */
+  class CellCacheSkipList : public CellCache {
+
+  public:
+
+    enum {
+      MAX_HEIGHT = 12,
+      BRANCHING  = 4
+    };
+
+    /**
+     * Skip list node.  <code>entry</code> points to the serialized key
+     * immediately followed by the serialized value; the value starts
+     * <code>key_length</code> bytes into the entry.
+     */
+    struct Node {
+      const uint8_t *volatile entry;
+      uint32_t key_length;
+      int32_t height;
+      Node *volatile next[1];
+    };
+
+    CellCacheSkipList();
+    virtual ~CellCacheSkipList() { }
+
+    virtual void add(const Key &key, const ByteString value);
+
+    virtual void add_counter(const Key &key, const ByteString value);
+
+    virtual void split_row_estimate_data(SplitRowDataMapT &split_row_data);
+
+    virtual int64_t get_total_entries() { return m_count; }
+
+    virtual CellListScanner *create_scanner(ScanContextPtr &scan_ctx);
+
+    /** Writers and readers do not need the cache lock */
+    virtual void lock() { }
+    virtual void unlock() { }
+
+    virtual size_t size() { return (size_t)m_count; }
+
+    virtual bool empty() { return m_count == 0; }
+
+    virtual void add_counts(size_t *cellsp, int64_t *key_bytesp,
+                            int64_t *value_bytesp) {
+      *cellsp += m_count;
+      *key_bytesp += m_key_bytes;
+      *value_bytesp += m_value_bytes;
+    }
+
+    virtual void merge(CellCache *other);
+
+    virtual void populate_key_set(KeySet &keys);
+
+    /** Returns the first node in the list, or 0 if the list is empty */
+    Node *first() const { return m_head->next[0]; }
+
+    /** Returns the first node whose key is greater than or equal to
+     * <code>key</code>, or 0 if there is none.
+     */
+    Node *lower_bound(const SerializedKey key) const {
+      return find_greater_or_equal(key, 0);
+    }
+
+  private:
+
+    uint8_t *alloc(size_t len);
+    Node *new_node(size_t entry_len, int height);
+    int random_height();
+    Node *find_greater_or_equal(const SerializedKey key, Node **prev) const;
+    void insert(Node *node, bool is_delete);
+    void replace_entry(Node *node, const uint8_t *entry);
+
+    Node             *m_head;
+    volatile int32_t  m_max_height;
+    volatile uint32_t m_height_seed;
+    volatile int64_t  m_count;
+  };
+
+  typedef intrusive_ptr<CellCacheSkipList> CellCacheSkipListPtr;
+
+} // namespace Hypertable;
+
+#endif // HYPERTABLE_CELLCACHESKIPLIST_H
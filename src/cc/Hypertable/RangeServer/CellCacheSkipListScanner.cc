@@ -0,0 +1,210 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include <cassert>
+
+#include "Common/Logger.h"
+
+#include "Hypertable/Lib/Key.h"
+
+#include "CellCacheSkipListScanner.h"
+#include "Global.h"
+
+using namespace Hypertable;
+
+/**
+ *
+ */
+CellCacheSkipListScanner::CellCacheSkipListScanner(CellCacheSkipListPtr &cellcache,
+                                                   ScanContextPtr &scan_ctx)
+  : CellListScanner(scan_ctx), m_cell_cache_ptr(cellcache), m_cur_node(0),
+    m_end_key(scan_ctx->end_serkey), m_entry_cache_next(0),
+    m_in_deletes(false), m_eos(false), m_keys_only(false) {
+  DynamicBuffer current_buf;
+  Key current;
+  Node *node;
+
+  m_keys_only = (scan_ctx->spec) ? (scan_ctx->spec->keys_only && !scan_ctx->spec->value_regexp) : false;
+
+  current_buf.grow(scan_ctx->start_key.row_len +
+                   scan_ctx->start_key.column_qualifier_len +
+                   scan_ctx->end_key.row_len +
+                   scan_ctx->end_key.column_qualifier_len + 32);
+
+  /**
+   * Collect potential start ROW and CF delete keys, see CellCacheScanner
+   */
+  if (scan_ctx->has_cell_interval) {
+
+    create_key_and_append(current_buf, FLAG_DELETE_ROW,
+                          scan_ctx->start_key.row, 0,
+                          "", TIMESTAMP_MAX, 0);
+
+    current.serial.ptr = current_buf.base;
+
+    for (node = m_cell_cache_ptr->lower_bound(current.serial);
+         node; node = node->next[0]) {
+      const uint8_t *entry = node->entry;
+      current.load(SerializedKey(entry));
+      if (current.flag != FLAG_DELETE_ROW ||
+          strcmp(current.row, scan_ctx->start_key.row))
+        break;
+      m_deletes.insert(CellCacheMap::value_type(SerializedKey(entry),
+                                                node->key_length));
+    }
+
+    if (scan_ctx->has_start_cf_qualifier) {
+
+      current_buf.clear();
+      create_key_and_append(current_buf, FLAG_DELETE_COLUMN_FAMILY,
+                            scan_ctx->start_key.row,
+                            scan_ctx->start_key.column_family_code,
+                            "", TIMESTAMP_MAX, 0);
+
+      current.serial.ptr = current_buf.base;
+
+      for (node = m_cell_cache_ptr->lower_bound(current.serial);
+           node; node = node->next[0]) {
+        const uint8_t *entry = node->entry;
+        current.load(SerializedKey(entry));
+        if (current.flag != FLAG_DELETE_COLUMN_FAMILY ||
+            current.column_family_code != scan_ctx->start_key.column_family_code ||
+            strcmp(current.row, scan_ctx->start_key.row))
+          break;
+        m_deletes.insert(CellCacheMap::value_type(SerializedKey(entry),
+                                                  node->key_length));
+      }
+    }
+  }
+
+  m_cur_node = m_cell_cache_ptr->lower_bound(scan_ctx->start_serkey);
+
+  if (!m_deletes.empty()) {
+    m_in_deletes = true;
+    m_delete_iter = m_deletes.begin();
+  }
+
+  skip_to_match();
+}
+
+
+/**
+ * Advances m_cur_node to the first node at or after its current position
+ * that passes the column family filter and is before the end key, loading
+ * it into m_cur_entry.  Sets m_eos if there is no such node.
+ */
+void CellCacheSkipListScanner::skip_to_match() {
+  while (m_cur_node) {
+    const uint8_t *entry = m_cur_node->entry;
+    if (SerializedKey(entry).compare(m_end_key) >= 0)
+      break;
+    m_cur_entry.key.load(SerializedKey(entry));
+    if (m_cur_entry.key.flag == FLAG_DELETE_ROW
+        || m_scan_context_ptr->family_mask[m_cur_entry.key.column_family_code]) {
+      m_cur_entry.value.ptr = entry + m_cur_node->key_length;
+      return;
+    }
+    m_cur_node = m_cur_node->next[0];
+  }
+  m_cur_node = 0;
+  m_eos = true;
+}
+
+
+bool CellCacheSkipListScanner::get(Key &key, ByteString &value) {
+
+ try_again:
+
+  if (m_entry_cache_next < m_entry_cache.size()) {
+    memcpy(&key, &m_entry_cache[m_entry_cache_next].key, sizeof(key));
+    memcpy(&value, &m_entry_cache[m_entry_cache_next].value, sizeof(value));
+    return true;
+  }
+
+  if (m_eos && !m_in_deletes)
+    return false;
+
+  load_entry_cache();
+  goto try_again;
+
+}
+
+void CellCacheSkipListScanner::forward() {
+  m_entry_cache_next++;
+}
+
+
+bool CellCacheSkipListScanner::internal_get() {
+
+  if (m_in_deletes) {
+    m_cur_entry.key.load( (*m_delete_iter).first );
+    m_cur_entry.value.ptr = m_cur_entry.key.serial.ptr + (*m_delete_iter).second;
+    return true;
+  }
+
+  if (!m_eos) {
+    if (m_keys_only)
+      m_cur_entry.value = (ByteString)0;
+    return true;
+  }
+
+  return false;
+}
+
+
+void CellCacheSkipListScanner::internal_forward() {
+
+  if (m_in_deletes) {
+    ++m_delete_iter;
+    if (m_delete_iter == m_deletes.end()) {
+      m_in_deletes = false;
+      // reset current entry since its loaded with the last entry in m_deletes
+      if (m_cur_node) {
+        m_cur_entry.key.load(SerializedKey(m_cur_node->entry));
+        m_cur_entry.value.ptr = m_cur_entry.key.serial.ptr + m_cur_node->key_length;
+      }
+    }
+    return;
+  }
+
+  m_cur_node = m_cur_node->next[0];
+  skip_to_match();
+}
+
+
+void CellCacheSkipListScanner::load_entry_cache() {
+
+  m_entry_cache_next = 0;
+  m_entry_cache.clear();
+
+  while (m_entry_cache.size() < (size_t)Global::cell_cache_scanner_cache_size) {
+
+    if (!internal_get()) {
+      m_eos = true;
+      break;
+    }
+    m_entry_cache.push_back(m_cur_entry);
+
+    internal_forward();
+  }
+
+}
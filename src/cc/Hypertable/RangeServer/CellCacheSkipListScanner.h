@@ -0,0 +1,84 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2012 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_CELLCACHESKIPLISTSCANNER_H
+#define HYPERTABLE_CELLCACHESKIPLISTSCANNER_H
+
+#include <map>
+#include <vector>
+
+#include "CellCacheSkipList.h"
+#include "CellListScanner.h"
+#include "ScanContext.h"
+
+
+namespace Hypertable {
+
+  /**
+   * Provides a scanning interface to a CellCacheSkipList.  Has the same
+   * semantics as CellCacheScanner but never locks the cache; the end of the
+   * scan is detected by comparing against the end key rather than a
+   * precomputed end position, since cells may be linked in while the
+   * scanner is running.
+   */
+  class CellCacheSkipListScanner : public CellListScanner {
+  public:
+    CellCacheSkipListScanner(CellCacheSkipListPtr &cellcache,
+                             ScanContextPtr &scan_ctx);
+    virtual ~CellCacheSkipListScanner() { return; }
+    virtual void forward();
+    virtual bool get(Key &key, ByteString &value);
+
+    virtual uint64_t get_disk_read() { return 0; }
+
+    typedef std::map<const SerializedKey, uint32_t> CellCacheMap;
+
+  private:
+
+    bool internal_get();
+    void internal_forward();
+    void load_entry_cache();
+    void skip_to_match();
+
+    class CellCacheEntry {
+    public:
+      CellCacheEntry() : value(0) { };
+      Key         key;
+      ByteString  value;
+    };
+
+    typedef CellCacheSkipList::Node Node;
+
+    CellCacheSkipListPtr           m_cell_cache_ptr;
+    Node                          *m_cur_node;
+    SerializedKey                  m_end_key;
+    CellCacheMap::iterator         m_delete_iter;
+    CellCacheEntry                 m_cur_entry;
+    std::vector<CellCacheEntry>    m_entry_cache;
+    size_t                         m_entry_cache_next;
+    CellCacheMap                   m_deletes;
+    bool                           m_in_deletes;
+    bool                           m_eos;
+    bool                           m_keys_only;
+  };
+}
+
+#endif // HYPERTABLE_CELLCACHESKIPLISTSCANNER_H
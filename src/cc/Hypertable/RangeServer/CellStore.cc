@@ -38,6 +38,8 @@ const char CellStore::INDEX_FIXED_BLOCK_MAGIC[10]    =
     { 'I','d','x','F','i','x','-','-','-','-' };
 const char CellStore::INDEX_VARIABLE_BLOCK_MAGIC[10] =
     { 'I','d','x','V','a','r','-','-','-','-' };
+const char CellStore::INDEX_STATS_BLOCK_MAGIC[10]    =
+    { 'I','d','x','S','t','a','t','-','-','-' };
 
 KeyDecompressor *CellStore::create_key_decompressor() {
   return new KeyDecompressorNone();
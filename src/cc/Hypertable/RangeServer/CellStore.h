@@ -42,6 +42,7 @@
 #include "CellList.h"
 #include "CellListScannerBuffer.h"
 #include "CellStoreBlockIndexArray.h"
+#include "CellStoreMapping.h"
 #include "CellStoreTrailer.h"
 #include "KeyDecompressor.h"
 
@@ -258,6 +259,14 @@ namespace Hypertable {
      */
     virtual int32_t reopen_fd() = 0;
 
+    /**
+     * Returns the memory mapping of the CellStore file.  The mapping remains
+     * valid for the lifetime of the CellStore.
+     *
+     * @return mapping of the CellStore file, or 0 if it isn't mapped
+     */
+    virtual CellStoreMapping *get_mapping() { return 0; }
+
     /**
      * Returns the amount of memory consumed by the bloom filter
      *
@@ -322,6 +331,7 @@ namespace Hypertable {
     static const char DATA_BLOCK_MAGIC[10];
     static const char INDEX_FIXED_BLOCK_MAGIC[10];
     static const char INDEX_VARIABLE_BLOCK_MAGIC[10];
+    static const char INDEX_STATS_BLOCK_MAGIC[10];
 
   protected:
 
@@ -33,6 +33,7 @@
 #include <iostream>
 #include <map>
 
+#include "Common/Serialization.h"
 #include "Common/StaticBuffer.h"
 
 #include "Hypertable/Lib/Key.h"
@@ -48,6 +49,64 @@ namespace Hypertable {
    * @{
    */
 
+  /** Timestamp and revision bounds of the inserts in a block, and whether
+   * the block holds any deletes.  Scanners use these to skip blocks that
+   * cannot contain a key inside the scan's time interval or at or below its
+   * revision.  Deletes are applied by the merge scanner regardless of their
+   * timestamp and revision, so a block holding one is never skipped.
+   */
+  struct CellStoreBlockStats {
+    CellStoreBlockStats() { clear(); }
+    void clear() {
+      timestamp_min = revision_min = TIMESTAMP_MAX;
+      timestamp_max = revision_max = TIMESTAMP_MIN;
+      has_deletes = false;
+    }
+    void update(const Key &key) {
+      if (key.flag != FLAG_INSERT) {
+        has_deletes = true;
+        return;
+      }
+      if (key.timestamp < timestamp_min)
+        timestamp_min = key.timestamp;
+      if (key.timestamp > timestamp_max)
+        timestamp_max = key.timestamp;
+      if (key.revision < revision_min)
+        revision_min = key.revision;
+      if (key.revision > revision_max)
+        revision_max = key.revision;
+    }
+    /** Returns <i>true</i> if none of the keys in the block can be returned
+     * by a scan over the time interval [<code>start</code>,<code>end</code>)
+     * at revision <code>revision</code>.  Blocks holding deletes are never
+     * excluded.
+     */
+    bool excludes(int64_t start, int64_t end, int64_t revision) const {
+      return !has_deletes && (timestamp_max < start ||
+                              revision_min > revision || timestamp_min >= end);
+    }
+    static const size_t ENCODED_LENGTH = 33;
+    void encode(uint8_t **bufp) const {
+      Serialization::encode_i64(bufp, timestamp_min);
+      Serialization::encode_i64(bufp, timestamp_max);
+      Serialization::encode_i64(bufp, revision_min);
+      Serialization::encode_i64(bufp, revision_max);
+      Serialization::encode_bool(bufp, has_deletes);
+    }
+    void decode(const uint8_t **bufp, size_t *remainp) {
+      timestamp_min = Serialization::decode_i64(bufp, remainp);
+      timestamp_max = Serialization::decode_i64(bufp, remainp);
+      revision_min = Serialization::decode_i64(bufp, remainp);
+      revision_max = Serialization::decode_i64(bufp, remainp);
+      has_deletes = Serialization::decode_bool(bufp, remainp);
+    }
+    int64_t timestamp_min;
+    int64_t timestamp_max;
+    int64_t revision_min;
+    int64_t revision_max;
+    bool has_deletes;
+  };
+
   template <typename OffsetT>
   class CellStoreBlockIndexElementArray {
   public:
@@ -66,6 +125,14 @@ namespace Hypertable {
     }
   };
 
+  template <typename OffsetT>
+  struct LtCellStoreBlockIndexElementArrayOffset {
+    bool operator()(const CellStoreBlockIndexElementArray<OffsetT> &x,
+                    int64_t offset) const {
+      return (int64_t)x.offset < offset;
+    }
+  };
+
   /**
    * Provides an STL-style iterator on CellStoreBlockIndex objects.
    */
@@ -108,13 +175,21 @@ namespace Hypertable {
 
     CellStoreBlockIndexArray() : m_disk_used(0) { }
 
+    /** Loads the index.  If <code>stats</code> is non-null, it holds the
+     * encoded CellStoreBlockStats of every block, in index order, and the
+     * stats of the in-scope blocks are kept alongside the index.
+     */
     void load(DynamicBuffer &fixed, DynamicBuffer &variable,int64_t end_of_data,
-              const String &start_row="", const String &end_row="") {
+              const String &start_row="", const String &end_row="",
+              DynamicBuffer *stats=0) {
       size_t total_entries = fixed.fill() / sizeof(OffsetT);
       SerializedKey key;
       OffsetT offset;
       ElementT ee;
+      CellStoreBlockStats block_stats;
       const uint8_t *key_ptr;
+      const uint8_t *stats_ptr = 0;
+      size_t stats_remaining = 0;
       bool in_scope = (start_row == "") ? true : false;
       bool check_for_end_row = end_row != "";
       const uint8_t *variable_start = variable.base;
@@ -127,6 +202,13 @@ namespace Hypertable {
       fixed.ptr = fixed.base;
       key_ptr   = variable.base;
 
+      m_stats.clear();
+      if (stats) {
+        HT_ASSERT(stats->fill() == total_entries * CellStoreBlockStats::ENCODED_LENGTH);
+        stats_ptr = stats->base;
+        stats_remaining = stats->fill();
+      }
+
       for (size_t i=0; i<total_entries; ++i) {
 
         // variable portion
@@ -137,6 +219,9 @@ namespace Hypertable {
         memcpy(&offset, fixed.ptr, sizeof(offset));
         fixed.ptr += sizeof(offset);
 
+        if (stats_ptr)
+          block_stats.decode(&stats_ptr, &stats_remaining);
+
         if (!in_scope) {
           if (strcmp(key.row(), start_row.c_str()) <= 0)
             continue;
@@ -148,6 +233,8 @@ namespace Hypertable {
           ee.key = key;
           ee.offset = offset;
           m_array.push_back(ee);
+          if (stats)
+            m_stats.push_back(block_stats);
           if (i+1 < total_entries) {
             key.ptr = key_ptr;
             key_ptr += key.length();
@@ -159,6 +246,8 @@ namespace Hypertable {
         ee.key = key;
         ee.offset = offset;
         m_array.push_back(ee);
+        if (stats)
+          m_stats.push_back(block_stats);
       }
 
       HT_ASSERT(key_ptr <= variable.ptr);
@@ -208,10 +297,31 @@ namespace Hypertable {
       // Populate fixed array
       foreach_ht (ElementT &element, m_array)
         fixed.add_unchecked(&element.offset, sizeof(OffsetT));
+
+      // Populate block stats
+      DynamicBuffer stats(m_stats.size() * CellStoreBlockStats::ENCODED_LENGTH);
+      foreach_ht (CellStoreBlockStats &block_stats, m_stats)
+        block_stats.encode(&stats.ptr);
+      bool have_stats = !m_stats.empty();
       m_array.clear();
 
       // Perform normal load
-      load(fixed, variable, m_end_of_last_block, start_row, end_row);
+      load(fixed, variable, m_end_of_last_block, start_row, end_row,
+           have_stats ? &stats : 0);
+    }
+
+    /** Returns the stats of the block starting at <code>offset</code>, or
+     * 0 if the CellStore has no block stats or no such block is in scope.
+     */
+    const CellStoreBlockStats *block_stats(int64_t offset) {
+      if (m_stats.empty())
+        return 0;
+      ArrayIteratorT iter =
+        std::lower_bound(m_array.begin(), m_array.end(), offset,
+                         LtCellStoreBlockIndexElementArrayOffset<OffsetT>());
+      if (iter == m_array.end() || (int64_t)(*iter).offset != offset)
+        return 0;
+      return &m_stats[iter - m_array.begin()];
     }
 
 
@@ -372,7 +482,8 @@ namespace Hypertable {
     }
 
     size_t memory_used() {
-      return m_keydata.size + (m_array.size() * (sizeof(ElementT)));
+      return m_keydata.size + (m_array.size() * (sizeof(ElementT))) +
+        (m_stats.size() * sizeof(CellStoreBlockStats));
     }
 
     int64_t disk_used() { return m_disk_used; }
@@ -403,6 +514,7 @@ namespace Hypertable {
 
     void clear() {
       m_array.clear();
+      m_stats.clear();
       m_keydata.free();
       m_middle_key.ptr = 0;
       m_fraction_covered = 0.0;
@@ -410,6 +522,7 @@ namespace Hypertable {
 
   private:
     ArrayT m_array;
+    std::vector<CellStoreBlockStats> m_stats;
     StaticBuffer m_keydata;
     SerializedKey m_middle_key;
     OffsetT m_end_of_last_block;
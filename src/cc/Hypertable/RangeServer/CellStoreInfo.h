@@ -23,7 +23,7 @@
 #define HYPERTABLE_CELLSTOREINFO_H
 
 #include "CellCache.h"
-#include "CellStoreV6.h"
+#include "CellStoreV7.h"
 
 namespace Hypertable {
 
@@ -46,12 +46,15 @@ namespace Hypertable {
     }
     CellStoreInfo() : cell_count(0), shadow_cache_ecr(TIMESTAMP_MAX),
                       shadow_cache_hits(0), bloom_filter_accesses(0),
-                      bloom_filter_maybes(0), bloom_filter_fps(0) { }
+                      bloom_filter_maybes(0), bloom_filter_fps(0),
+                      shard(false) { }
 
     void init_from_trailer() {
       int divisor = 0;
       try {
-        divisor = (boost::any_cast<uint32_t>(cs->get_trailer()->get("flags")) & CellStoreTrailerV6::SPLIT) ? 2 : 1;
+        uint32_t flags = boost::any_cast<uint32_t>(cs->get_trailer()->get("flags"));
+        divisor = (flags & CellStoreTrailerV7::SPLIT) ? 2 : 1;
+        shard = (flags & CellStoreTrailerV7::SHARD) != 0;
         cell_count = boost::any_cast<int64_t>(cs->get_trailer()->get("total_entries")) / divisor;
         timestamp_min = boost::any_cast<int64_t>(cs->get_trailer()->get("timestamp_min"));
         timestamp_max = boost::any_cast<int64_t>(cs->get_trailer()->get("timestamp_max"));
@@ -60,6 +63,7 @@ namespace Hypertable {
       }
       catch (std::exception &e) {
         divisor = 0;
+        shard = false;
         cell_count = 0;
         timestamp_min = TIMESTAMP_MAX;
         timestamp_max = TIMESTAMP_MIN;
@@ -91,6 +95,8 @@ namespace Hypertable {
     int64_t timestamp_max;
     int64_t expirable_data;
     int64_t total_data;
+    /// Written by one shard of a sharded compaction
+    bool shard;
   };
 
 } // namespace Hypertable
@@ -0,0 +1,90 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CellStoreMapping.
+ * This file contains the method definitions for CellStoreMapping, a
+ * read-only memory mapping of a CellStore file on the local filesystem.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+extern "C" {
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+#include "CellStoreMapping.h"
+
+using namespace Hypertable;
+
+
+CellStoreMapping::CellStoreMapping(const String &path, int64_t length)
+  : m_base(0), m_length(length) {
+  struct stat statbuf;
+  void *map;
+  int fd;
+
+  if ((fd = ::open(path.c_str(), O_RDONLY)) == -1)
+    HT_THROWF(Error::LOCAL_IO_ERROR, "Unable to open '%s' for memory "
+              "mapping - %s", path.c_str(), strerror(errno));
+
+  if (fstat(fd, &statbuf) != 0) {
+    int saved_errno = errno;
+    ::close(fd);
+    HT_THROWF(Error::LOCAL_IO_ERROR, "Unable to stat '%s' for memory "
+              "mapping - %s", path.c_str(), strerror(saved_errno));
+  }
+
+  if (length == 0 || (int64_t)statbuf.st_size < length) {
+    ::close(fd);
+    HT_THROWF(Error::LOCAL_IO_ERROR, "Unable to memory map '%s' - file length "
+              "%lld does not cover %lld bytes", path.c_str(),
+              (Lld)statbuf.st_size, (Lld)length);
+  }
+
+  map = ::mmap(0, length, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (map == MAP_FAILED)
+    HT_THROWF(Error::LOCAL_IO_ERROR, "Unable to memory map '%s' - %s",
+              path.c_str(), strerror(errno));
+
+  m_base = (const uint8_t *)map;
+}
+
+
+CellStoreMapping::~CellStoreMapping() {
+  if (::munmap((void *)m_base, m_length) != 0)
+    HT_WARNF("munmap(%p, %lld) failed - %s", m_base, (Lld)m_length,
+             strerror(errno));
+}
+
+
+String CellStoreMapping::local_path(const String &root, const String &fname) {
+  if (!fname.empty() && fname[0] == '/')
+    return root + fname;
+  return root + "/" + fname;
+}
@@ -0,0 +1,100 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CellStoreMapping.
+ * This file contains the type declarations for CellStoreMapping, a read-only
+ * memory mapping of a CellStore file on the local filesystem.
+ */
+
+#ifndef HYPERTABLE_CELLSTOREMAPPING_H
+#define HYPERTABLE_CELLSTOREMAPPING_H
+
+#include "Common/ReferenceCount.h"
+#include "Common/String.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Read-only memory mapping of a CellStore file.
+   * When the RangeServer runs on the same host as the local DFS broker,
+   * CellStore files can be mapped straight from the broker's root
+   * directory, letting scanners read blocks out of the page cache without a
+   * broker round trip or any copying.  CellStore files are immutable once
+   * written, and a mapping stays valid after its file has been removed, so
+   * the mapping lives as long as the CellStore that owns it.
+   */
+  class CellStoreMapping : public ReferenceCount {
+  public:
+
+    /** Constructor.
+     * Maps the first <code>length</code> bytes of <code>path</code>.
+     * @param path Absolute path of the CellStore file
+     * @param length Length of the CellStore file
+     * @throws Exception with code Error::LOCAL_IO_ERROR if the file can't be
+     * opened or mapped, or is shorter than <code>length</code>
+     */
+    CellStoreMapping(const String &path, int64_t length);
+
+    /** Destructor.  Unmaps the file. */
+    virtual ~CellStoreMapping();
+
+    /** Returns a pointer to the start of the mapped file. */
+    const uint8_t *base() const { return m_base; }
+
+    /** Returns the length of the mapping. */
+    int64_t length() const { return m_length; }
+
+    /** Checks if a region lies within the mapping.
+     * @param offset Offset of region
+     * @param length Length of region
+     * @return <i>true</i> if the region is mapped, <i>false</i> otherwise
+     */
+    bool contains(int64_t offset, int64_t length) const {
+      return offset >= 0 && length >= 0 && offset + length <= m_length;
+    }
+
+    /** Returns the absolute path of a CellStore file in the local broker
+     * root.
+     * @param root Root directory of the local DFS broker
+     * @param fname Name of the CellStore file in the DFS
+     * @return Absolute path of the file on the local filesystem
+     */
+    static String local_path(const String &root, const String &fname);
+
+  private:
+    /// Pointer to the start of the mapped file
+    const uint8_t *m_base;
+    /// Length of the mapping
+    int64_t m_length;
+  };
+
+  /// Smart pointer to CellStoreMapping
+  typedef intrusive_ptr<CellStoreMapping> CellStoreMappingPtr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_CELLSTOREMAPPING_H
@@ -137,6 +137,11 @@ CellStoreScanner<IndexT>::CellStoreScanner(CellStore *cellstore, ScanContextPtr
     if (scan_ctx->single_row)
       readahead = false;
 
+    // compactions read each block once, so read ahead even within a
+    // restricted range rather than going through the block cache
+    if (scan_ctx->compaction)
+      readahead = true;
+
     if (readahead)
       m_interval_scanners[m_interval_max++] = new CellStoreScannerIntervalReadahead<IndexT>(cellstore, index, start_key, end_key, scan_ctx);
     else {
@@ -38,7 +38,8 @@ template <typename IndexT>
 CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(CellStore *cellstore,
   IndexT *index, SerializedKey start_key, SerializedKey end_key, ScanContextPtr &scan_ctx) :
   m_cellstore(cellstore), m_index(index), m_start_key(start_key),
-  m_end_key(end_key), m_fd(-1), m_cached(false), m_check_for_range_end(false),
+  m_end_key(end_key), m_fd(-1), m_cached(false), m_mapped(false),
+  m_check_for_range_end(false),
   m_scan_ctx(scan_ctx), m_rowset(scan_ctx->rowset) {
 
   memset(&m_block, 0, sizeof(m_block));
@@ -59,6 +60,7 @@ CellStoreScannerIntervalBlockIndex<IndexT>::CellStoreScannerIntervalBlockIndex(C
 
   if (m_start_key) {
     const uint8_t *ptr;
+    m_cur_value.ptr = m_key_decompressor->seek(m_block.base, m_start_key);
     while (m_key_decompressor->less_than(m_start_key)) {
       ptr = m_cur_value.ptr + m_cur_value.length();
       if (ptr >= m_block.end) {
@@ -96,7 +98,7 @@ CellStoreScannerIntervalBlockIndex<IndexT>::~CellStoreScannerIntervalBlockIndex(
   if (m_block.base != 0) {
     if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
-    else
+    else if (!m_mapped)
       delete [] m_block.base;
   }
   delete m_zcodec;
@@ -179,7 +181,7 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
   if (m_block.base != 0 && eob) {
     if (m_cached)
       Global::block_cache->checkin(m_file_id, m_block.offset);
-    else
+    else if (!m_mapped)
       delete [] m_block.base;
     memset(&m_block, 0, sizeof(m_block));
     ++m_iter;
@@ -191,6 +193,9 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     }
   }
 
+  if (m_block.base == 0)
+    skip_excluded_blocks();
+
   if (m_block.base == 0 && m_iter != m_index->end()) {
     DynamicBuffer expand_buf;
     uint32_t len;
@@ -216,8 +221,18 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
     if (Global::block_cache == 0 || Global::block_cache->compressed() ||
         !Global::block_cache->checkout(m_file_id, m_block.offset,
 				       (uint8_t **)&m_block.base, &len)) {
+      CellStoreMapping *mapping = m_cellstore->get_mapping();
       bool second_try = false;
       bool checked_out = false;
+      bool mapped = false;
+
+      /** Serve uncompressed blocks straight from the mapping **/
+      if (mapping && load_mapped_block(mapping, &len)) {
+        m_cached = false;
+        m_mapped = true;
+        goto loaded;
+      }
+
     try_again:
       try {
         DynamicBuffer buf;
@@ -225,10 +240,22 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
 	if (Global::block_cache == 0 || !Global::block_cache->compressed() ||
             !Global::block_cache->checkout(m_file_id, m_block.offset,
 				           (uint8_t **)&buf.base, &len)) {
-	  buf.grow(m_block.zlength, true);
-
-	  /** Read compressed block **/
-	  Global::dfs->pread(m_fd, buf.base, m_block.zlength, m_block.offset, second_try);
+	  if (mapping && !second_try &&
+              mapping->contains(m_block.offset, m_block.zlength)) {
+	    /** Inflate compressed block from the mapping **/
+	    buf.base = (uint8_t *)mapping->base() + m_block.offset;
+	    buf.size = m_block.zlength;
+	    buf.own = false;
+	    mapped = true;
+	  }
+	  else {
+	    buf.grow(m_block.zlength, true);
+
+	    /** Read compressed block **/
+	    Global::dfs->pread(m_fd, buf.base, m_block.zlength, m_block.offset, second_try);
+	    mapped = false;
+	  }
+	  MaintenanceThrottle::read(m_block.zlength);
 
 	  checked_out = false;
 	}
@@ -257,7 +284,7 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
         if (Global::block_cache && Global::block_cache->compressed()) {
           if (checked_out)
             Global::block_cache->checkin(m_file_id, m_block.offset);
-          else if (Global::block_cache->insert(m_file_id, m_block.offset, (uint8_t *)buf.base, m_block.zlength))
+          else if (!mapped && Global::block_cache->insert(m_file_id, m_block.offset, (uint8_t *)buf.base, m_block.zlength))
             buf.own = false;
         }
 
@@ -281,17 +308,22 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
       size_t fill;
       m_block.base = expand_buf.release(&fill);
       len = fill;
+      m_mapped = false;
 
       /** Insert uncompressed block into cache  **/
       m_cached = Global::block_cache && !Global::block_cache->compressed() &&
           Global::block_cache->insert(m_file_id, m_block.offset,
 				      (uint8_t *)m_block.base, len, true);
     }
-    else
+    else {
       m_cached = true;
+      m_mapped = false;
+    }
 
+  loaded:
     m_key_decompressor->reset();
-    m_block.end = m_block.base + len;
+    m_block.end = m_key_decompressor->load_block(m_block.base,
+                                                 m_block.base + len);
     m_cur_value.ptr = m_key_decompressor->add(m_block.base);
 
     return true;
@@ -300,5 +332,93 @@ bool CellStoreScannerIntervalBlockIndex<IndexT>::fetch_next_block(bool eob) {
 }
 
 
+/**
+ * Points m_block.base at the current block inside the CellStore mapping if
+ * the block was written with the <code>none</code> codec, avoiding both the
+ * read and the copy into a separate buffer.  Compressed blocks, and blocks
+ * that fail validation, are left to the regular read path, which retries
+ * through the DFS broker.
+ *
+ * @param mapping Memory mapping of the CellStore file
+ * @param lenp Address of variable to hold the length of the block data
+ * @return true if the block was loaded from the mapping, false otherwise
+ */
+template <typename IndexT>
+bool CellStoreScannerIntervalBlockIndex<IndexT>::load_mapped_block(CellStoreMapping *mapping,
+                                                                   uint32_t *lenp) {
+  if (!mapping->contains(m_block.offset, m_block.zlength))
+    return false;
+
+  const uint8_t *ptr = mapping->base() + m_block.offset;
+  size_t remaining = m_block.zlength;
+  BlockCompressionHeader header;
+
+  try {
+    header.decode(&ptr, &remaining);
+
+    if (header.get_compression_type() != BlockCompressionCodec::NONE)
+      return false;
+
+    if (!header.check_magic(CellStore::DATA_BLOCK_MAGIC))
+      HT_THROW(Error::BLOCK_COMPRESSOR_BAD_MAGIC,
+               "Error loading mapped cell store block - magic string mismatch");
+
+    if (header.get_data_zlength() > remaining ||
+        header.get_data_length() != header.get_data_zlength())
+      HT_THROWF(Error::BLOCK_COMPRESSOR_BAD_HEADER, "Mapped block header "
+                "length=%lu zlength=%lu, actual=%lu",
+                (Lu)header.get_data_length(), (Lu)header.get_data_zlength(),
+                (Lu)remaining);
+
+    uint32_t checksum = header.compute_checksum(ptr, header.get_data_zlength());
+    if (checksum != header.get_data_checksum())
+      HT_THROWF(Error::BLOCK_COMPRESSOR_CHECKSUM_MISMATCH, "Mapped block "
+                "checksum mismatch header=%lx, computed=%lx",
+                (Lu)header.get_data_checksum(), (Lu)checksum);
+  }
+  catch (Exception &e) {
+    HT_WARN_OUT << "Error loading mapped cell store block (file="
+                << m_cellstore->get_filename() << ", offset="
+                << m_block.offset << ") : " << e << HT_END;
+    return false;
+  }
+
+  m_block.base = ptr;
+  *lenp = header.get_data_length();
+  m_disk_read += *lenp;
+  MaintenanceThrottle::read(m_block.zlength);
+  return true;
+}
+
+
+/**
+ * Advances m_iter past blocks whose timestamp and revision bounds show that
+ * none of their keys can be returned by the scan.  If such a block lies
+ * entirely beyond the end row, so do all of the blocks that follow it, in
+ * which case m_iter is set to the end of the index.
+ */
+template <typename IndexT>
+void CellStoreScannerIntervalBlockIndex<IndexT>::skip_excluded_blocks() {
+  const CellStoreBlockStats *stats;
+
+  while (m_iter != m_index->end()) {
+    stats = m_index->block_stats(m_iter.value());
+    if (stats == 0 || !stats->excludes(m_scan_ctx->time_interval.first,
+                                       m_scan_ctx->time_interval.second,
+                                       m_scan_ctx->revision))
+      return;
+    if (strcmp(m_iter.key().row(), m_end_row) > 0) {
+      m_iter = m_index->end();
+      return;
+    }
+    ++m_iter;
+    if (m_rowset.size()) {
+      while (m_iter != m_index->end() && strcmp(*m_rowset.begin(), m_iter.key().row()) > 0)
+        ++m_iter;
+    }
+  }
+}
+
+
 template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<uint32_t> >;
 template class CellStoreScannerIntervalBlockIndex<CellStoreBlockIndexArray<int64_t> >;
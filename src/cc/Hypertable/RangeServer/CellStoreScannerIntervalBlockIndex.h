@@ -32,6 +32,7 @@ namespace Hypertable {
 
   class BlockCompressionCodec;
   class CellStore;
+  class CellStoreMapping;
 
   template <typename IndexT>
   class CellStoreScannerIntervalBlockIndex : public CellStoreScannerInterval {
@@ -48,6 +49,8 @@ namespace Hypertable {
   private:
 
     bool fetch_next_block(bool eob=false);
+    void skip_excluded_blocks();
+    bool load_mapped_block(CellStoreMapping *mapping, uint32_t *lenp);
 
     CellStorePtr          m_cellstore;
     IndexT               *m_index;
@@ -64,6 +67,7 @@ namespace Hypertable {
     KeyDecompressor      *m_key_decompressor;
     int32_t               m_fd;
     bool                  m_cached;
+    bool                  m_mapped;
     bool                  m_check_for_range_end;
     int                   m_file_id;
     ScanContextPtr        m_scan_ctx;
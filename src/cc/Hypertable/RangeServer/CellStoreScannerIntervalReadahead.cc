@@ -43,7 +43,7 @@ namespace {
 template <typename IndexT>
 CellStoreScannerIntervalReadahead<IndexT>::CellStoreScannerIntervalReadahead(CellStore *cellstore,
      IndexT *index, SerializedKey start_key, SerializedKey end_key, ScanContextPtr &scan_ctx) :
-  m_cellstore(cellstore), m_end_key(end_key), m_zcodec(0), m_fd(-1), m_offset(0),
+  m_cellstore(cellstore), m_index(index), m_end_key(end_key), m_zcodec(0), m_fd(-1), m_offset(0),
   m_end_offset(0), m_check_for_range_end(false), m_eos(false), m_scan_ctx(scan_ctx),
   m_oflags(0) {
   int64_t start_offset;
@@ -109,6 +109,7 @@ CellStoreScannerIntervalReadahead<IndexT>::CellStoreScannerIntervalReadahead(Cel
 
   if (start_key) {
     const uint8_t *ptr;
+    m_cur_value.ptr = m_key_decompressor->seek(m_block.base, start_key);
     while (m_key_decompressor->less_than(start_key)) {
       ptr = m_cur_value.ptr + m_cur_value.length();
       if (ptr >= m_block.end) {
@@ -246,6 +247,7 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
     uint32_t len;
     uint32_t nread;
 
+  next_block:
     m_block.offset = m_offset;
 
     /** Read header **/
@@ -275,6 +277,18 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
         m_check_for_range_end = true;
       m_offset += input_buf.fill();
 
+      MaintenanceThrottle::read(input_buf.fill());
+
+      // The buffered reader can't seek, so blocks that can't match the scan
+      // are still read, but they don't get inflated
+      if (block_excluded(m_block.offset)) {
+        if (m_offset >= m_end_offset) {
+          m_eos = true;
+          return false;
+        }
+        goto next_block;
+      }
+
       m_zcodec->inflate(input_buf, expand_buf, header);
 
       m_disk_read += expand_buf.fill();
@@ -296,7 +310,8 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
     len = fill;
 
     m_key_decompressor->reset();
-    m_block.end = m_block.base + len;
+    m_block.end = m_key_decompressor->load_block(m_block.base,
+                                                 m_block.base + len);
     m_cur_value.ptr = m_key_decompressor->add(m_block.base);
 
     return true;
@@ -304,5 +319,23 @@ bool CellStoreScannerIntervalReadahead<IndexT>::fetch_next_block_readahead(bool
   return false;
 }
 
+
+/**
+ * Checks the timestamp and revision bounds of the block at
+ * <code>offset</code> against the scan.
+ *
+ * @param offset offset of block in CellStore file
+ * @return true if none of the keys in the block can be returned by the scan
+ */
+template <typename IndexT>
+bool CellStoreScannerIntervalReadahead<IndexT>::block_excluded(int64_t offset) {
+  if (m_index == 0)
+    return false;
+  const CellStoreBlockStats *stats = m_index->block_stats(offset);
+  return stats && stats->excludes(m_scan_ctx->time_interval.first,
+                                  m_scan_ctx->time_interval.second,
+                                  m_scan_ctx->revision);
+}
+
 template class CellStoreScannerIntervalReadahead<CellStoreBlockIndexArray<uint32_t> >;
 template class CellStoreScannerIntervalReadahead<CellStoreBlockIndexArray<int64_t> >;
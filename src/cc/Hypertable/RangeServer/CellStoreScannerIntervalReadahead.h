@@ -48,8 +48,10 @@ namespace Hypertable {
   private:
 
     bool fetch_next_block_readahead(bool eob=false);
+    bool block_excluded(int64_t offset);
 
     CellStorePtr           m_cellstore;
+    IndexT                *m_index;
     BlockInfo              m_block;
     Key                    m_key;
     SerializedKey          m_end_key;
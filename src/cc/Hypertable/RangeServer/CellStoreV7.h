@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CellStoreV7.
+ * This file contains the type declarations for CellStoreV7, a class for
+ * creating and loading version 7 cell store files.
+ */
+
+#ifndef HYPERTABLE_CELLSTOREV7_H
+#define HYPERTABLE_CELLSTOREV7_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#ifdef _GOOGLE_SPARSE_HASH
+#include <google/sparse_hash_set>
+#else
+#include <ext/hash_set>
+#endif
+
+#include "CellStoreBlockIndexArray.h"
+
+#include "AsyncComm/DispatchHandlerSynchronizer.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/BloomFilterWithChecksum.h"
+#include "Common/BlobHashSet.h"
+
+#include "Hypertable/Lib/BlockCompressionCodec.h"
+#include "Hypertable/Lib/SerializedKey.h"
+
+#include "CellStore.h"
+#include "CellStoreTrailerV7.h"
+#include "KeyCompressor.h"
+
+
+/**
+ * Forward declarations
+ */
+namespace Hypertable {
+  class BlockCompressionCodec;
+  class Client;
+  class Protocol;
+}
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /**
+   * Version 7 cell store.  Same layout as CellStoreV6, except that key
+   * compression within each data block is restarted every
+   * <code>restart_interval</code> key/value pairs and each block ends with
+   * the offsets of its restart points (see KeyDecompressorPrefixRestart).
+   * This allows scanners to binary search for their start key within a
+   * block instead of decompressing every key that precedes it.  If the
+   * block compression codec uses a dictionary (see
+   * BlockCompressionCodec::get_dictionary_size), one is trained from the
+   * first blocks written and stored after the bloom filter; the blocks that
+   * follow, and the block indexes, are compressed with it.  Files with the
+   * CellStoreTrailerV7::BLOCK_STATS flag store the minimum and maximum
+   * timestamp and revision of the inserts in each block, and whether it
+   * holds any deletes (see CellStoreBlockStats), in a third index block that
+   * directly follows the variable index, which lets scanners skip blocks
+   * outside of the scan's time interval or revision.
+   */
+  class CellStoreV7 : public CellStore {
+
+    class IndexBuilder {
+    public:
+      IndexBuilder() : m_bigint(false) { }
+      void add_entry(KeyCompressorPtr &key_compressor, int64_t offset,
+                     const CellStoreBlockStats &block_stats);
+      DynamicBuffer &fixed_buf() { return m_fixed; }
+      DynamicBuffer &variable_buf() { return m_variable; }
+      DynamicBuffer &stats_buf() { return m_stats; }
+      bool big_int() { return m_bigint; }
+      void chop();
+      void release_fixed_buf() { delete [] m_fixed.release(); }
+      void release_stats_buf() { delete [] m_stats.release(); }
+    private:
+      DynamicBuffer m_fixed;
+      DynamicBuffer m_variable;
+      DynamicBuffer m_stats;
+      bool m_bigint;
+    };
+
+  public:
+    CellStoreV7(Filesystem *filesys, Schema *schema=0);
+    virtual ~CellStoreV7();
+
+    virtual void create(const char *fname, size_t max_entries,
+                        PropertiesPtr &props,
+                        const TableIdentifier *table_id=0);
+    virtual void add(const Key &key, const ByteString value);
+    virtual void finalize(TableIdentifier *table_identifier);
+    virtual void open(const String &fname, const String &start_row,
+                      const String &end_row, int32_t fd, int64_t file_length,
+                      CellStoreTrailer *trailer);
+    virtual void rescope(const String &start_row, const String &end_row);
+    virtual int64_t get_blocksize() { return m_trailer.blocksize; }
+    virtual bool may_contain(ScanContextPtr &);
+    virtual uint64_t disk_usage() { return m_disk_usage; }
+    virtual float compression_ratio() { return m_trailer.compression_ratio; }
+    virtual void split_row_estimate_data(SplitRowDataMapT &split_row_data);
+
+    /** Populates <code>scanner</code> with key/value pairs generated from
+     * CellStore index.  This method will first load the CellStore block 
+     * index into memory, if it is not already loaded, and then it will call
+     * the CellStoreBlockIndexArray::populate_pseudo_table_scanner method
+     * to populate <code>scanner</code> with synthesized <i>.cellstore.index</i>
+     * pseudo-table cells.
+     * @param scanner Pointer to CellListScannerBuffer to receive key/value
+     * pairs
+     */
+    virtual void populate_index_pseudo_table_scanner(CellListScannerBuffer *scanner);
+
+    virtual int64_t get_total_entries() { return m_trailer.total_entries; }
+    virtual std::string &get_filename() { return m_filename; }
+    virtual int get_file_id() { return m_file_id; }
+    virtual CellListScanner *create_scanner(ScanContextPtr &scan_ctx);
+    virtual BlockCompressionCodec *create_block_compression_codec();
+    virtual KeyDecompressor *create_key_decompressor();
+    virtual void display_block_info();
+    virtual int64_t end_of_last_block() { return m_trailer.fix_index_offset; }
+
+    virtual size_t bloom_filter_size() {
+      ScopedLock lock(m_mutex);
+      return m_bloom_filter ? m_bloom_filter->size() : 0;
+    }
+
+    virtual int64_t bloom_filter_memory_used() {
+      ScopedLock lock(m_mutex);
+      return m_index_stats.bloom_filter_memory;
+    }
+
+    virtual int64_t block_index_memory_used() {
+      ScopedLock lock(m_mutex);
+      return m_index_stats.block_index_memory;
+    }
+
+    virtual uint64_t purge_indexes();
+    virtual bool restricted_range() { return m_restricted_range; }
+    virtual const std::vector<String> &get_replaced_files();
+
+    virtual int32_t get_fd() {
+      ScopedLock lock(m_mutex);
+      return m_fd;
+    }
+
+    virtual int32_t reopen_fd() {
+      ScopedLock lock(m_mutex);
+      if (m_fd != -1)
+        m_filesys->close(m_fd);
+      m_fd = m_filesys->open(m_filename, 0);
+      return m_fd;
+    }
+
+    virtual CellStoreMapping *get_mapping() { return m_mapping.get(); }
+
+    virtual CellStoreTrailer *get_trailer() { return &m_trailer; }
+
+  protected:
+    void create_bloom_filter(bool is_approx = false);
+    void load_bloom_filter();
+    void load_block_index();
+    void load_replaced_files();
+    void add_restart_index();
+    void add_dictionary_sample();
+    void load_dictionary();
+    void create_inflate_dictionary();
+    void map_file();
+
+    typedef BlobHashSet<> BloomFilterItems;
+
+    Filesystem            *m_filesys;
+    SchemaPtr              m_schema;
+    int32_t                m_fd;
+    std::string            m_filename;
+    bool                   m_64bit_index;
+    CellStoreTrailerV7     m_trailer;
+    BlockCompressionCodec *m_compressor;
+    DynamicBuffer          m_buffer;
+    IndexBuilder           m_index_builder;
+    DispatchHandlerSynchronizer  m_sync_handler;
+    uint32_t               m_outstanding_appends;
+    int64_t                m_offset;
+    int64_t                m_file_length;
+    int64_t                m_disk_usage;
+    int                    m_file_id;
+    float                  m_uncompressed_data;
+    float                  m_compressed_data;
+    int64_t                m_uncompressed_blocksize;
+    BlockCompressionCodec::Args m_compressor_args;
+    size_t                 m_max_entries;
+
+    BloomFilterMode        m_bloom_filter_mode;
+    BloomFilterItems      *m_bloom_filter_items;
+    int64_t                m_max_approx_items;
+    float                  m_bloom_bits_per_item;
+    float                  m_filter_false_positive_prob;
+    uint32_t               m_restart_interval;
+    uint32_t               m_block_entries;
+    CellStoreBlockStats    m_block_stats;
+    std::vector<uint32_t>  m_restarts;
+    KeyCompressorPtr       m_key_compressor;
+    DynamicBuffer          m_dictionary;
+    BlockCompressionDictionaryPtr m_inflate_dictionary;
+    int64_t                m_dictionary_memory;
+    DynamicBuffer          m_dictionary_samples;
+    std::vector<size_t>    m_dictionary_sample_sizes;
+    size_t                 m_dictionary_samples_target;
+    bool                   m_restricted_range;
+    int64_t               *m_column_ttl;
+    bool                   m_replaced_files_loaded;
+    CellStoreMappingPtr    m_mapping;
+
+    // Member that require mutex protection
+
+    /// Bloom filter
+    BloomFilterWithChecksum *m_bloom_filter;
+
+    /// 32-bit block index
+    CellStoreBlockIndexArray<uint32_t> m_index_map32;
+
+    /// 64-bit block index
+    CellStoreBlockIndexArray<int64_t> m_index_map64;
+  };
+
+  /// Smart pointer to CellStoreV7 type
+  typedef intrusive_ptr<CellStoreV7> CellStoreV7Ptr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_CELLSTOREV7_H
@@ -0,0 +1,336 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+
+#include <cstring>
+#include <map>
+
+#include "Common/Error.h"
+#include "Common/Logger.h"
+
+#include "Hypertable/Lib/CompressorFactory.h"
+#include "Hypertable/Lib/Key.h"
+
+#include "CommitLogReplayer.h"
+
+using namespace Hypertable;
+using namespace std;
+
+
+CommitLogReplayer::Batch::~Batch() {
+  for (size_t i=0; i<blocks.size(); i++)
+    delete blocks[i];
+}
+
+
+CommitLogReplayer::CommitLogReplayer(TableInfoMap &replay_map,
+                                     int worker_count)
+  : m_replay_map(replay_map), m_outstanding(0), m_shutdown(false),
+    m_error(Error::OK) {
+  if (worker_count < 1)
+    worker_count = 1;
+  for (int i=0; i<worker_count; i++)
+    m_threads.create_thread(Worker(this));
+}
+
+
+CommitLogReplayer::~CommitLogReplayer() {
+  {
+    ScopedLock lock(m_mutex);
+    m_shutdown = true;
+    m_cond.notify_all();
+  }
+  m_threads.join_all();
+}
+
+
+uint32_t CommitLogReplayer::replay(CommitLogReader *log_reader) {
+  Batch batches[3];
+  vector<Batch *> free_batches;
+  Batch *inflated = 0;
+  Batch *read = 0;
+  Batch *next;
+  bool eof = false;
+  uint32_t block_count = 0;
+
+  for (size_t i=0; i<3; i++)
+    free_batches.push_back(&batches[i]);
+
+  do {
+
+    // Apply the batch inflated in the previous round and inflate the batch
+    // read in the previous round, while reading the next one
+    if (inflated) {
+      partition(inflated);
+      dispatch(TASK_APPLY, inflated, inflated->range_runs.size());
+    }
+    if (read)
+      dispatch(TASK_INFLATE, read, read->block_count);
+
+    next = 0;
+    if (!eof) {
+      next = free_batches.back();
+      free_batches.pop_back();
+      try {
+        if (!read_batch(log_reader, next)) {
+          free_batches.push_back(next);
+          next = 0;
+          eof = true;
+        }
+      }
+      catch (Exception &e) {
+        // the workers still reference the batches
+        wait();
+        throw;
+      }
+    }
+
+    wait();
+
+    if (m_error != Error::OK)
+      HT_THROW(m_error, m_error_msg);
+
+    if (inflated) {
+      for (size_t i=0; i<inflated->block_count; i++) {
+        if (inflated->blocks[i]->replayed)
+          block_count++;
+      }
+      free_batches.push_back(inflated);
+    }
+    inflated = read;
+    read = next;
+
+  } while (inflated || read);
+
+  return block_count;
+}
+
+
+bool CommitLogReplayer::read_batch(CommitLogReader *log_reader,
+                                   Batch *batch) {
+  size_t bytes = 0;
+  Block *block;
+
+  batch->block_count = 0;
+
+  while (bytes < BATCH_BYTES) {
+    if (batch->block_count == batch->blocks.size())
+      batch->blocks.push_back(new Block());
+    block = batch->blocks[batch->block_count];
+    if (!log_reader->next_compressed(block->zblock, &block->header))
+      break;
+    bytes += block->zblock.fill();
+    batch->block_count++;
+  }
+
+  return batch->block_count > 0;
+}
+
+
+void CommitLogReplayer::dispatch(int type, Batch *batch, size_t count) {
+  Task task;
+  task.type = type;
+  task.batch = batch;
+  ScopedLock lock(m_mutex);
+  for (size_t i=0; i<count; i++) {
+    task.index = i;
+    m_tasks.push_back(task);
+  }
+  m_outstanding += count;
+  m_cond.notify_all();
+}
+
+
+void CommitLogReplayer::wait() {
+  ScopedLock lock(m_mutex);
+  while (m_outstanding > 0)
+    m_done_cond.wait(lock);
+}
+
+
+void CommitLogReplayer::worker() {
+  CompressorMap compressors;
+  Task task;
+
+  while (true) {
+
+    {
+      ScopedLock lock(m_mutex);
+      while (m_tasks.empty() && !m_shutdown)
+        m_cond.wait(lock);
+      if (m_tasks.empty())
+        return;
+      task = m_tasks.front();
+      m_tasks.pop_front();
+    }
+
+    try {
+      if (task.type == TASK_INFLATE)
+        inflate(task.batch->blocks[task.index], compressors);
+      else
+        apply(task.batch->range_runs[task.index]);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << e << HT_END;
+      ScopedLock lock(m_mutex);
+      if (m_error == Error::OK) {
+        m_error = e.code();
+        m_error_msg = e.what();
+      }
+    }
+
+    {
+      ScopedLock lock(m_mutex);
+      if (--m_outstanding == 0)
+        m_done_cond.notify_all();
+    }
+  }
+}
+
+
+void CommitLogReplayer::inflate(Block *block, CompressorMap &compressors) {
+  uint16_t ztype = block->header.get_compression_type();
+
+  block->replayed = false;
+  block->runs.clear();
+  block->block.clear();
+
+  try {
+    if (ztype >= BlockCompressionCodec::COMPRESSION_TYPE_LIMIT)
+      HT_THROWF(Error::BLOCK_COMPRESSOR_UNSUPPORTED_TYPE,
+                "Invalid compression type '%d'", (int)ztype);
+    BlockCompressionCodecPtr &compressor = compressors[ztype];
+    if (!compressor)
+      compressor = CompressorFactory::create_block_codec(
+          (BlockCompressionCodec::Type)ztype);
+    compressor->inflate(block->zblock, block->block, block->header);
+  }
+  catch (Exception &e) {
+    HT_ERRORF("Inflate error in CommitLog block with revision %lld "
+              "(block len = %lld) - %s", (Lld)block->header.get_revision(),
+              (Lld)block->zblock.fill(), Error::get_text(e.code()));
+    return;
+  }
+
+  split(block);
+}
+
+
+void CommitLogReplayer::split(Block *block) {
+  const uint8_t *ptr = block->block.base;
+  const uint8_t *end = block->block.base + block->block.fill();
+  size_t remaining = block->block.fill();
+  TableIdentifier table_id;
+  TableInfoPtr table_info;
+  SerializedKey key;
+  ByteString value;
+  RangePtr range;
+  String start_row, end_row;
+  Range *current = 0;
+  Range *target;
+  const char *row;
+  Run run;
+
+  table_id.decode(&ptr, &remaining);
+
+  if (!m_replay_map.lookup(table_id.id, table_info))
+    return;
+
+  block->replayed = true;
+  run.range = 0;
+
+  while (ptr < end) {
+
+    // extract the key
+    key.ptr = ptr;
+    ptr += key.length();
+    if (ptr > end)
+      HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
+
+    // extract the value
+    value.ptr = ptr;
+    ptr += value.length();
+    if (ptr > end)
+      HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
+
+    // Look for containing range, checking the last one found first
+    row = key.row();
+    if (current && strcmp(row, start_row.c_str()) > 0 &&
+        strcmp(row, end_row.c_str()) <= 0)
+      target = current;
+    else if (table_info->find_containing_range(row, range, start_row, end_row))
+      target = current = range.get();
+    else
+      target = current = 0;
+
+    if (target != run.range) {
+      if (run.range)
+        block->runs.push_back(run);
+      run.range = target;
+      run.base = key.ptr;
+    }
+    run.end = ptr;
+  }
+
+  if (run.range)
+    block->runs.push_back(run);
+}
+
+
+void CommitLogReplayer::partition(Batch *batch) {
+  map<Range *, size_t> index;
+  map<Range *, size_t>::iterator iter;
+
+  batch->range_runs.clear();
+
+  for (size_t i=0; i<batch->block_count; i++) {
+    foreach_ht (Run &run, batch->blocks[i]->runs) {
+      if ((iter = index.find(run.range)) == index.end()) {
+        iter = index.insert(make_pair(run.range,
+                                      batch->range_runs.size())).first;
+        batch->range_runs.push_back(vector<Run>());
+      }
+      batch->range_runs[iter->second].push_back(run);
+    }
+  }
+}
+
+
+void CommitLogReplayer::apply(vector<Run> &runs) {
+  SerializedKey serkey;
+  ByteString bsvalue;
+  Key key;
+  const uint8_t *ptr;
+
+  foreach_ht (Run &run, runs) {
+    Locker<Range> lock(*run.range);
+    ptr = run.base;
+    while (ptr < run.end) {
+      serkey.ptr = ptr;
+      ptr += serkey.length();
+      bsvalue.ptr = ptr;
+      ptr += bsvalue.length();
+      key.load(serkey);
+      run.range->add(key, bsvalue);
+    }
+  }
+}
@@ -0,0 +1,135 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_COMMITLOGREPLAYER_H
+#define HYPERTABLE_COMMITLOGREPLAYER_H
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread/condition.hpp>
+
+#include "Common/DynamicBuffer.h"
+#include "Common/HashMap.h"
+#include "Common/Mutex.h"
+#include "Common/String.h"
+#include "Common/Thread.h"
+
+#include "Hypertable/Lib/BlockCompressionCodec.h"
+#include "Hypertable/Lib/BlockCompressionHeaderCommitLog.h"
+#include "Hypertable/Lib/CommitLogReader.h"
+
+#include "Range.h"
+#include "TableInfoMap.h"
+
+namespace Hypertable {
+
+  /**
+   * Replays a commit log into the ranges of a TableInfoMap using a pool of
+   * worker threads.  Blocks are read from the log sequentially in batches.
+   * While one batch is being read, the workers inflate the blocks of the
+   * previous batch and split them into runs of cells by range, and apply the
+   * batch before that to its ranges.  All cells of a batch destined for a
+   * given range are applied by a single task in log order, so each range
+   * sees its updates in the order in which they were committed.
+   */
+  class CommitLogReplayer {
+  public:
+    CommitLogReplayer(TableInfoMap &replay_map, int worker_count);
+    ~CommitLogReplayer();
+
+    /** Replays the log.  Cells whose rows do not fall within one of the
+     * ranges in the replay map are skipped.
+     *
+     * @param log_reader reader positioned at the start of the log
+     * @return number of blocks replayed
+     */
+    uint32_t replay(CommitLogReader *log_reader);
+
+  private:
+
+    /// Stop reading a batch once it holds this many compressed bytes
+    enum { BATCH_BYTES = 16 * 1024 * 1024 };
+
+    enum { TASK_INFLATE, TASK_APPLY };
+
+    /// Consecutive cells of a block that fall within the same range
+    struct Run {
+      Range *range;
+      const uint8_t *base;
+      const uint8_t *end;
+    };
+
+    struct Block {
+      Block() : replayed(false) { }
+      BlockCompressionHeaderCommitLog header;
+      DynamicBuffer zblock;
+      DynamicBuffer block;
+      std::vector<Run> runs;
+      bool replayed;
+    };
+
+    struct Batch {
+      Batch() : block_count(0) { }
+      ~Batch();
+      std::vector<Block *> blocks;
+      size_t block_count;
+      std::vector<std::vector<Run> > range_runs;
+    };
+
+    struct Task {
+      int type;
+      Batch *batch;
+      size_t index;
+    };
+
+    struct Worker {
+      Worker(CommitLogReplayer *replayer) : replayer(replayer) { }
+      void operator()() { replayer->worker(); }
+      CommitLogReplayer *replayer;
+    };
+
+    typedef hash_map<uint16_t, BlockCompressionCodecPtr> CompressorMap;
+
+    void worker();
+    bool read_batch(CommitLogReader *log_reader, Batch *batch);
+    void inflate(Block *block, CompressorMap &compressors);
+    void split(Block *block);
+    void partition(Batch *batch);
+    void apply(std::vector<Run> &runs);
+    void dispatch(int type, Batch *batch, size_t count);
+    void wait();
+
+    TableInfoMap &m_replay_map;
+    Mutex m_mutex;
+    boost::condition m_cond;
+    boost::condition m_done_cond;
+    std::deque<Task> m_tasks;
+    size_t m_outstanding;
+    bool m_shutdown;
+    int m_error;
+    String m_error_msg;
+    ThreadGroup m_threads;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMMITLOGREPLAYER_H
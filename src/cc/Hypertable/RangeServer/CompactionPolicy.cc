@@ -0,0 +1,72 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CompactionPolicy.
+ * This file contains the method definitions for CompactionPolicy, an
+ * abstract base class for the policies that choose which CellStores of an
+ * access group get merged by a merging compaction.
+ */
+
+#include "Common/Compat.h"
+
+#include "CompactionPolicy.h"
+
+using namespace Hypertable;
+
+bool
+CompactionPolicy::choose_merge_run(const std::vector<StoreInfo> &stores,
+                                   int64_t now, size_t *indexp,
+                                   size_t *lenp) const {
+  std::vector<StoreInfo> collapsed;
+  std::vector<size_t> offsets;
+  size_t index, length;
+
+  collapsed.reserve(stores.size());
+  offsets.reserve(stores.size() + 1);
+
+  for (size_t i=0; i<stores.size(); i++) {
+    if (i > 0 && stores[i].shard && stores[i-1].shard) {
+      StoreInfo &set = collapsed.back();
+      set.disk_usage += stores[i].disk_usage;
+      if (stores[i].timestamp_max > set.timestamp_max)
+        set.timestamp_max = stores[i].timestamp_max;
+    }
+    else {
+      collapsed.push_back(stores[i]);
+      offsets.push_back(i);
+    }
+  }
+  offsets.push_back(stores.size());
+
+  if (!find_merge_run(collapsed, now, &index, &length))
+    return false;
+
+  // Merging a shard set on its own would just undo the sharding
+  if (length == 1 && collapsed[index].shard)
+    return false;
+
+  if (indexp)
+    *indexp = offsets[index];
+  if (lenp)
+    *lenp = offsets[index+length] - offsets[index];
+  return true;
+}
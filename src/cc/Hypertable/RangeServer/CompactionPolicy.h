@@ -0,0 +1,113 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CompactionPolicy.
+ * This file contains the type declarations for CompactionPolicy, an abstract
+ * base class for the policies that choose which CellStores of an access
+ * group get merged by a merging compaction.
+ */
+
+#ifndef HYPERTABLE_COMPACTIONPOLICY_H
+#define HYPERTABLE_COMPACTIONPOLICY_H
+
+#include <vector>
+
+#include "Common/ReferenceCount.h"
+#include "Common/String.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Chooses CellStores to merge.
+   * An access group keeps its CellStores ordered from oldest to newest and a
+   * merging compaction replaces an adjacent run of them with a single
+   * CellStore in the same position, so a policy picks such a run.  How
+   * often data gets rewritten on its way into larger CellStores, and
+   * therefore the write amplification of the access group, is determined by
+   * the policy.  Implementations are stateless and shared by all access
+   * groups.
+   *
+   * A sharded compaction leaves a <i>shard set</i> of adjacent CellStores
+   * with disjoint row ranges that together hold the output of one
+   * compaction.  choose_merge_run() presents each shard set to the policy
+   * as a single CellStore, so shards are only ever merged together with
+   * other CellStores and never back into one another.
+   */
+  class CompactionPolicy : public ReferenceCount {
+  public:
+
+    /** Size and age of a CellStore. */
+    struct StoreInfo {
+      StoreInfo(int64_t size=0, int64_t ts_max=0, bool is_shard=false)
+        : disk_usage(size), timestamp_max(ts_max), shard(is_shard) { }
+      /// Disk usage of the CellStore
+      int64_t disk_usage;
+      /// Newest timestamp in the CellStore (nanoseconds since the epoch)
+      int64_t timestamp_max;
+      /// <i>true</i> if the CellStore is part of a shard set
+      bool shard;
+    };
+
+    virtual ~CompactionPolicy() { }
+
+    /** Returns the name of the policy. */
+    virtual const char *name() const = 0;
+
+    /** Finds a run of adjacent CellStores to merge.
+     * @param stores CellStores of the access group, oldest first
+     * @param now Current time in nanoseconds since the epoch
+     * @param indexp Address of variable to hold index of first CellStore in
+     * run (may be 0)
+     * @param lenp Address of variable to hold length of run (may be 0)
+     * @return <i>true</i> if a merge is needed, <i>false</i> otherwise
+     */
+    virtual bool find_merge_run(const std::vector<StoreInfo> &stores,
+                                int64_t now, size_t *indexp,
+                                size_t *lenp) const = 0;
+
+    /** Finds a run of adjacent CellStores to merge, treating each shard set
+     * as one CellStore.  Adjacent CellStores marked as shards form a shard
+     * set.  The run returned by find_merge_run() for the collapsed list is
+     * mapped back to <code>stores</code>; a run consisting of a single
+     * shard set is rejected.
+     * @param stores CellStores of the access group, oldest first
+     * @param now Current time in nanoseconds since the epoch
+     * @param indexp Address of variable to hold index of first CellStore in
+     * run (may be 0)
+     * @param lenp Address of variable to hold length of run (may be 0)
+     * @return <i>true</i> if a merge is needed, <i>false</i> otherwise
+     */
+    bool choose_merge_run(const std::vector<StoreInfo> &stores, int64_t now,
+                          size_t *indexp, size_t *lenp) const;
+  };
+
+  /// Smart pointer to CompactionPolicy
+  typedef intrusive_ptr<CompactionPolicy> CompactionPolicyPtr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMPACTIONPOLICY_H
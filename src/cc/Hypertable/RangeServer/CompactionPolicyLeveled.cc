@@ -0,0 +1,94 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CompactionPolicyLeveled.
+ * This file contains the method definitions for CompactionPolicyLeveled, a
+ * CompactionPolicy that keeps few, geometrically sized CellStores.
+ */
+
+#include "Common/Compat.h"
+
+#include "CompactionPolicyLeveled.h"
+
+using namespace Hypertable;
+
+int32_t CompactionPolicyLeveled::level(int64_t size) const {
+  if (size < m_level0_size)
+    return 0;
+  int32_t level = 1;
+  int64_t bound = m_level0_size * m_fanout;
+  while (size >= bound && bound <= INT64_MAX / m_fanout) {
+    bound *= m_fanout;
+    level++;
+  }
+  return level;
+}
+
+bool
+CompactionPolicyLeveled::find_merge_run(const std::vector<StoreInfo> &stores,
+                                        int64_t now, size_t *indexp,
+                                        size_t *lenp) const {
+  size_t count = stores.size();
+
+  if (count < 2)
+    return false;
+
+  // Total size of the CellStores newer than each CellStore
+  std::vector<int64_t> newer(count, 0);
+  for (size_t i=count-1; i>0; i--)
+    newer[i-1] = newer[i] + stores[i].disk_usage;
+
+  // Merge the oldest CellStore whose newer data has caught up with its level
+  for (size_t i=0; i<count-1; i++) {
+    int32_t store_level = level(stores[i].disk_usage);
+    if (store_level > 0 && level(newer[i]) >= store_level) {
+      if (indexp)
+        *indexp = i;
+      if (lenp)
+        *lenp = count - i;
+      return true;
+    }
+  }
+
+  // Merge a run of level 0 CellStores that is long or large enough
+  size_t index = 0;
+  int64_t running_total = 0;
+  for (size_t i=0; i<=count; i++) {
+    if (i < count && level(stores[i].disk_usage) == 0) {
+      running_total += stores[i].disk_usage;
+      continue;
+    }
+    size_t run_length = i - index;
+    if (run_length >= (size_t)m_level0_run_length ||
+        (run_length > 1 && running_total >= m_level0_size)) {
+      if (indexp)
+        *indexp = index;
+      if (lenp)
+        *lenp = run_length;
+      return true;
+    }
+    index = i + 1;
+    running_total = 0;
+  }
+
+  return false;
+}
@@ -0,0 +1,86 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CompactionPolicyLeveled.
+ * This file contains the type declarations for CompactionPolicyLeveled, a
+ * CompactionPolicy that keeps few, geometrically sized CellStores.
+ */
+
+#ifndef HYPERTABLE_COMPACTIONPOLICYLEVELED_H
+#define HYPERTABLE_COMPACTIONPOLICYLEVELED_H
+
+#include "CompactionPolicy.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Keeps at most one CellStore per size level.
+   * CellStores smaller than <code>level0_size</code> are at level 0 and a
+   * CellStore whose size lies in [<code>level0_size</code> *
+   * <code>fanout</code>^(<i>n</i>-1), <code>level0_size</code> *
+   * <code>fanout</code>^<i>n</i>) is at level <i>n</i>.  A CellStore is
+   * merged with all of the CellStores that are newer than it as soon as
+   * their combined size reaches its level, so levels decrease from the
+   * oldest CellStore to the newest.  Runs of level 0 CellStores are merged
+   * once they are <code>level0_run_length</code> long or have reached level
+   * 1 in total.  This bounds the number of CellStores, and with it read
+   * amplification, to the number of levels, at the cost of rewriting data
+   * about <code>fanout</code> times per level.
+   */
+  class CompactionPolicyLeveled : public CompactionPolicy {
+  public:
+
+    /** Constructor.
+     * @param level0_size Size at which CellStores leave level 0
+     * @param fanout Size ratio between adjacent levels
+     * @param level0_run_length Number of level 0 CellStores that triggers
+     * a merge
+     */
+    CompactionPolicyLeveled(int64_t level0_size, int32_t fanout,
+                            int32_t level0_run_length)
+      : m_level0_size(level0_size > 0 ? level0_size : 1),
+        m_fanout(fanout > 1 ? fanout : 2),
+        m_level0_run_length(level0_run_length > 1 ? level0_run_length : 2) { }
+
+    virtual const char *name() const { return "leveled"; }
+
+    virtual bool find_merge_run(const std::vector<StoreInfo> &stores,
+                                int64_t now, size_t *indexp,
+                                size_t *lenp) const;
+
+    /** Returns the level of a CellStore of the given size. */
+    int32_t level(int64_t size) const;
+
+  private:
+    int64_t m_level0_size;
+    int32_t m_fanout;
+    int32_t m_level0_run_length;
+  };
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMPACTIONPOLICYLEVELED_H
@@ -0,0 +1,76 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CompactionPolicyRunLength.
+ * This file contains the method definitions for CompactionPolicyRunLength,
+ * the default CompactionPolicy.
+ */
+
+#include "Common/Compat.h"
+
+#include "CompactionPolicyRunLength.h"
+
+using namespace Hypertable;
+
+bool
+CompactionPolicyRunLength::find_merge_run(const std::vector<StoreInfo> &stores,
+                                          int64_t now, size_t *indexp,
+                                          size_t *lenp) const {
+  size_t index = 0;
+  size_t i = 0;
+  size_t count;
+  int64_t running_total = 0;
+
+  if (stores.empty())
+    return false;
+
+  do {
+    running_total += stores[i].disk_usage;
+
+    if (running_total >= m_target_min) {
+      count = i - index;
+      if (running_total < m_target_max)
+        count++;
+      if (count >= (size_t)m_run_length_threshold) {
+        if (indexp)
+          *indexp = index;
+        if (lenp)
+          *lenp = count;
+        return true;
+      }
+      // Otherwise, move the index forward by one and try again
+      running_total -= stores[index].disk_usage;
+      index++;
+    }
+    i++;
+  } while (i < stores.size());
+
+  if ((i-index) > (size_t)m_run_length_threshold) {
+    if (indexp)
+      *indexp = index;
+    if (lenp)
+      *lenp = i-index;
+    return true;
+  }
+
+  return false;
+}
@@ -0,0 +1,77 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CompactionPolicyRunLength.
+ * This file contains the type declarations for CompactionPolicyRunLength,
+ * the default CompactionPolicy.
+ */
+
+#ifndef HYPERTABLE_COMPACTIONPOLICYRUNLENGTH_H
+#define HYPERTABLE_COMPACTIONPOLICYRUNLENGTH_H
+
+#include "CompactionPolicy.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Merges runs of small CellStores into CellStores of a target size.
+   * Looks for the first run of adjacent CellStores whose combined size falls
+   * within [<code>target_min</code>, <code>target_max</code>) and merges it
+   * once it is at least <code>run_length_threshold</code> long.  A trailing
+   * run that is longer than the threshold is merged regardless of its size.
+   * CellStores are not merged again once they reach the target size, so
+   * write amplification is low, but the number of CellStores grows with the
+   * size of the access group.
+   */
+  class CompactionPolicyRunLength : public CompactionPolicy {
+  public:
+
+    /** Constructor.
+     * @param target_min Target minimum CellStore size
+     * @param target_max Target maximum CellStore size
+     * @param run_length_threshold Minimum number of CellStores to merge
+     */
+    CompactionPolicyRunLength(int64_t target_min, int64_t target_max,
+                              int32_t run_length_threshold)
+      : m_target_min(target_min), m_target_max(target_max),
+        m_run_length_threshold(run_length_threshold) { }
+
+    virtual const char *name() const { return "runlength"; }
+
+    virtual bool find_merge_run(const std::vector<StoreInfo> &stores,
+                                int64_t now, size_t *indexp,
+                                size_t *lenp) const;
+
+  private:
+    int64_t m_target_min;
+    int64_t m_target_max;
+    int32_t m_run_length_threshold;
+  };
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMPACTIONPOLICYRUNLENGTH_H
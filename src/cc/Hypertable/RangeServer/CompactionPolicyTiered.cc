@@ -0,0 +1,84 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CompactionPolicyTiered.
+ * This file contains the method definitions for CompactionPolicyTiered, a
+ * size-tiered CompactionPolicy.
+ */
+
+#include "Common/Compat.h"
+
+#include "CompactionPolicyTiered.h"
+
+using namespace Hypertable;
+
+bool CompactionPolicyTiered::in_tier(int64_t size, int64_t average) const {
+  if (size < m_small_size && average < m_small_size)
+    return true;
+  int64_t window = (average / 100) * m_bucket_window;
+  return size >= average - window && size <= average + window;
+}
+
+bool
+CompactionPolicyTiered::find_merge_run(const std::vector<StoreInfo> &stores,
+                                       int64_t now, size_t *indexp,
+                                       size_t *lenp) const {
+  size_t count = stores.size();
+  std::vector<bool> too_old(count, false);
+  bool found = false;
+  size_t best_index = 0, best_length = 0;
+  int64_t best_average = 0;
+
+  if (m_max_age) {
+    for (size_t i=0; i<count; i++)
+      too_old[i] = now - stores[i].timestamp_max > m_max_age;
+  }
+
+  for (size_t i=0; i<count; i++) {
+    if (too_old[i])
+      continue;
+    int64_t total = stores[i].disk_usage;
+    int64_t average = total;
+    size_t j = i + 1;
+    while (j < count && j - i < (size_t)m_max_threshold && !too_old[j] &&
+           in_tier(stores[j].disk_usage, average)) {
+      total += stores[j].disk_usage;
+      average = total / (int64_t)(j - i + 1);
+      j++;
+    }
+    if (j - i >= (size_t)m_min_threshold &&
+        (!found || average < best_average)) {
+      found = true;
+      best_index = i;
+      best_length = j - i;
+      best_average = average;
+    }
+  }
+
+  if (found) {
+    if (indexp)
+      *indexp = best_index;
+    if (lenp)
+      *lenp = best_length;
+  }
+  return found;
+}
@@ -0,0 +1,93 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CompactionPolicyTiered.
+ * This file contains the type declarations for CompactionPolicyTiered, a
+ * size-tiered CompactionPolicy.
+ */
+
+#ifndef HYPERTABLE_COMPACTIONPOLICYTIERED_H
+#define HYPERTABLE_COMPACTIONPOLICYTIERED_H
+
+#include "CompactionPolicy.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Merges runs of similarly sized CellStores.
+   * A run of adjacent CellStores forms a tier if each of their sizes is
+   * within <code>bucket_window</code> percent of the average size of the
+   * run, or if they are all smaller than <code>small_size</code>.  The tier
+   * with the smallest average size that holds at least
+   * <code>min_threshold</code> CellStores is merged, up to
+   * <code>max_threshold</code> of them at a time.  Data is rewritten about
+   * once per tier, which keeps write amplification low at the cost of
+   * keeping up to <code>min_threshold</code> - 1 CellStores per tier.  If
+   * <code>max_age</code> is non-zero, CellStores whose newest data is older
+   * than that are left alone, since time-series data rarely benefits from
+   * having old CellStores rewritten.
+   */
+  class CompactionPolicyTiered : public CompactionPolicy {
+  public:
+
+    /** Constructor.
+     * @param small_size Size below which CellStores are all in one tier
+     * @param min_threshold Minimum number of CellStores to merge
+     * @param max_threshold Maximum number of CellStores to merge
+     * @param bucket_window Percentage by which sizes within a tier may
+     * differ from the tier's average size
+     * @param max_age Age in nanoseconds after which CellStores are no longer
+     * merged, or 0 to merge CellStores of any age
+     */
+    CompactionPolicyTiered(int64_t small_size, int32_t min_threshold,
+                           int32_t max_threshold, int32_t bucket_window,
+                           int64_t max_age)
+      : m_small_size(small_size),
+        m_min_threshold(min_threshold > 1 ? min_threshold : 2),
+        m_max_threshold(max_threshold > m_min_threshold ? max_threshold
+                        : m_min_threshold),
+        m_bucket_window(bucket_window), m_max_age(max_age) { }
+
+    virtual const char *name() const { return "tiered"; }
+
+    virtual bool find_merge_run(const std::vector<StoreInfo> &stores,
+                                int64_t now, size_t *indexp,
+                                size_t *lenp) const;
+
+  private:
+    bool in_tier(int64_t size, int64_t average) const;
+
+    int64_t m_small_size;
+    int32_t m_min_threshold;
+    int32_t m_max_threshold;
+    int32_t m_bucket_window;
+    int64_t m_max_age;
+  };
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMPACTIONPOLICYTIERED_H
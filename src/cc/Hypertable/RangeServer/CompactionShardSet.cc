@@ -0,0 +1,153 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for CompactionShardSet.
+ * This file contains the method definitions for CompactionShardSet, a class
+ * that splits a major compaction into row range shards written in parallel.
+ */
+
+#include "Common/Compat.h"
+
+#include "CellStoreTrailerV7.h"
+#include "CompactionShardSet.h"
+#include "Global.h"
+
+using namespace Hypertable;
+
+CompactionShardSet::CompactionShardSet(PropertiesPtr &props,
+    TableIdentifier *identifier, uint32_t trailer_flags,
+    MaintenanceThrottle::Task task)
+  : m_props(props), m_identifier(*identifier),
+    m_trailer_flags(trailer_flags), m_task(task) {
+}
+
+
+CompactionShardSet::~CompactionShardSet() {
+  for (size_t i=0; i<m_shards.size(); i++)
+    delete m_shards[i].spec;
+}
+
+
+void CompactionShardSet::choose_split_rows(CellList::SplitRowDataMapT &split_row_data,
+                                           size_t shards,
+                                           std::vector<String> &rows) {
+  int64_t total = 0;
+  for (CellList::SplitRowDataMapT::iterator iter = split_row_data.begin();
+       iter != split_row_data.end(); ++iter)
+    total += iter->second;
+
+  rows.clear();
+  if (shards < 2 || total == 0)
+    return;
+
+  // The last row is never chosen, the shard after it would be empty
+  CellList::SplitRowDataMapT::iterator last = split_row_data.end();
+  --last;
+
+  int64_t cumulative = 0;
+  size_t shard = 1;
+  for (CellList::SplitRowDataMapT::iterator iter = split_row_data.begin();
+       iter != last && shard < shards; ++iter) {
+    cumulative += iter->second;
+    if (cumulative >= (total * (int64_t)shard) / (int64_t)shards) {
+      rows.push_back(iter->first);
+      // skip targets passed by a single large row
+      while (shard < shards &&
+             cumulative >= (total * (int64_t)shard) / (int64_t)shards)
+        shard++;
+    }
+  }
+}
+
+
+void CompactionShardSet::add(ScanSpecBuilder *spec, MergeScanner *scanner,
+                             CellStorePtr &cellstore, const String &filename,
+                             size_t max_entries) {
+  Shard shard;
+  shard.spec = spec;
+  shard.mscanner = scanner;
+  shard.scanner = scanner;
+  shard.cellstore = cellstore;
+  shard.filename = filename;
+  shard.max_entries = max_entries;
+  shard.started = false;
+  m_shards.push_back(shard);
+}
+
+
+void CompactionShardSet::get_cellstores(std::vector<CellStorePtr> &cellstores) {
+  cellstores.clear();
+  for (size_t i=0; i<m_shards.size(); i++)
+    cellstores.push_back(m_shards[i].cellstore);
+}
+
+
+void CompactionShardSet::remove_files() {
+  for (size_t i=0; i<m_shards.size(); i++) {
+    if (!m_shards[i].started)
+      continue;
+    try {
+      Global::dfs->remove(m_shards[i].filename);
+    }
+    catch (Exception &e) {
+      HT_ERROR_OUT << "Problem removing '" << m_shards[i].filename << "' "
+                   << e << HT_END;
+    }
+  }
+}
+
+
+void CompactionShardSet::get_io_accounting_data(uint64_t *inbytesp,
+                                                uint64_t *outbytesp) {
+  uint64_t input_bytes, output_bytes;
+  *inbytesp = *outbytesp = 0;
+  for (size_t i=0; i<m_shards.size(); i++) {
+    m_shards[i].mscanner->get_io_accounting_data(&input_bytes, &output_bytes);
+    *inbytesp += input_bytes;
+    *outbytesp += output_bytes;
+  }
+}
+
+
+void CompactionShardSet::run_job(size_t i) {
+  Shard &shard = m_shards[i];
+  ByteString value;
+  Key key;
+
+  MaintenanceThrottle::Scope throttle_scope(Global::maintenance_throttle.get(),
+                                            m_task);
+
+  shard.started = true;
+  shard.cellstore->create(shard.filename.c_str(), shard.max_entries, m_props,
+                          &m_identifier);
+
+  while (shard.scanner->get(key, value)) {
+    shard.cellstore->add(key, value);
+    shard.scanner->forward();
+  }
+
+  CellStoreTrailerV7 *trailer =
+    dynamic_cast<CellStoreTrailerV7 *>(shard.cellstore->get_trailer());
+  trailer->flags |= m_trailer_flags;
+
+  shard.cellstore->finalize(&m_identifier);
+}
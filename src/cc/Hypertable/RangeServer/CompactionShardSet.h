@@ -0,0 +1,153 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for CompactionShardSet.
+ * This file contains the type declarations for CompactionShardSet, a class
+ * that splits a major compaction into row range shards written in parallel.
+ */
+
+#ifndef HYPERTABLE_COMPACTIONSHARDSET_H
+#define HYPERTABLE_COMPACTIONSHARDSET_H
+
+#include <vector>
+
+#include "Common/Properties.h"
+
+#include "Hypertable/Lib/ScanSpec.h"
+#include "Hypertable/Lib/Types.h"
+
+#include "CellList.h"
+#include "CellStore.h"
+#include "MaintenanceJobSet.h"
+#include "MaintenanceThrottle.h"
+#include "MergeScanner.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Shards of a major compaction.
+   * A major compaction of a large access group merges everything into one
+   * CellStore on one thread.  Since deletes and versions only ever affect
+   * cells of the same row, the merge can just as well be split at row
+   * boundaries into shards that are merged independently, each one into a
+   * CellStore of its own.  Each shard is a job of a MaintenanceJobSet, so
+   * the shards are merged in parallel by the maintenance threads.  The
+   * caller installs the resulting CellStores together.
+   */
+  class CompactionShardSet : public MaintenanceJobSet {
+  public:
+
+    /** Constructor.
+     * @param props CellStore properties
+     * @param identifier Table identifier
+     * @param trailer_flags Flags to set in the trailers of the CellStores
+     * @param task Maintenance task to charge the I/O to
+     */
+    CompactionShardSet(PropertiesPtr &props, TableIdentifier *identifier,
+                       uint32_t trailer_flags, MaintenanceThrottle::Task task);
+
+    virtual ~CompactionShardSet();
+
+    /** Chooses the rows at which to split a compaction into shards of about
+     * the same number of cells.
+     * @param split_row_data Row and cell count estimates
+     * @param shards Desired number of shards
+     * @param rows Vector to hold the split rows, each one the last row of a
+     * shard (at most <code>shards</code>-1 rows, empty if the data can't be
+     * split)
+     */
+    static void choose_split_rows(CellList::SplitRowDataMapT &split_row_data,
+                                  size_t shards, std::vector<String> &rows);
+
+    /** Adds a shard.  The scan spec of the shard's scan context must be
+     * <code>spec</code>.
+     * @param spec Scan spec restricting the scan to the rows of the shard,
+     * ownership is transferred to this object
+     * @param scanner Merge scanner for the rows of the shard
+     * @param cellstore CellStore to write the shard to
+     * @param filename Name of CellStore file
+     * @param max_entries Estimate of the number of cells in the shard
+     */
+    void add(ScanSpecBuilder *spec, MergeScanner *scanner,
+             CellStorePtr &cellstore, const String &filename,
+             size_t max_entries);
+
+    /** Returns the CellStores written, in row order */
+    void get_cellstores(std::vector<CellStorePtr> &cellstores);
+
+    /** Removes the CellStore files of the shards that were started.  Called
+     * when run() fails, since none of the shards gets installed then.
+     */
+    void remove_files();
+
+    /** Returns the I/O accounting data summed over all shards.
+     * @param inbytesp Address of variable to hold input bytes
+     * @param outbytesp Address of variable to hold output bytes
+     */
+    void get_io_accounting_data(uint64_t *inbytesp, uint64_t *outbytesp);
+
+  protected:
+
+    virtual size_t job_count() const { return m_shards.size(); }
+
+    virtual void run_job(size_t i);
+
+  private:
+
+    /** A shard. */
+    struct Shard {
+      ScanSpecBuilder *spec;
+      MergeScanner *mscanner;
+      CellListScannerPtr scanner;
+      CellStorePtr cellstore;
+      String filename;
+      size_t max_entries;
+      bool started;
+    };
+
+    /// CellStore properties
+    PropertiesPtr m_props;
+
+    /// Table identifier
+    TableIdentifierManaged m_identifier;
+
+    /// Trailer flags
+    uint32_t m_trailer_flags;
+
+    /// Maintenance task
+    MaintenanceThrottle::Task m_task;
+
+    /// Shards
+    std::vector<Shard> m_shards;
+  };
+
+  /// Smart pointer to CompactionShardSet
+  typedef intrusive_ptr<CompactionShardSet> CompactionShardSetPtr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_COMPACTIONSHARDSET_H
@@ -28,26 +28,61 @@
 using namespace Hypertable;
 using std::pair;
 
+namespace {
+  /** Block size assumed when sizing the frequency sketches */
+  const int64_t NOMINAL_BLOCK_SIZE = 65536;
+}
+
 atomic_t FileBlockCache::ms_next_file_id = ATOMIC_INIT(0);
 
+FileBlockCache::FileBlockCache(int64_t min_memory, int64_t max_memory,
+                               bool compressed, size_t shard_count,
+                               bool frequency_admission)
+  : m_shard_count(shard_count ? shard_count : 1), m_min_memory(min_memory),
+    m_max_memory(max_memory), m_limit(max_memory), m_available(max_memory),
+    m_compressed(compressed) {
+  HT_ASSERT(min_memory <= max_memory);
+  atomic_set(&m_next_victim_shard, 0);
+  m_shards = new Shard [m_shard_count];
+  if (frequency_admission) {
+    size_t capacity = (size_t)((max_memory / NOMINAL_BLOCK_SIZE)
+                               / (int64_t)m_shard_count);
+    for (size_t i=0; i<m_shard_count; i++)
+      m_shards[i].sketch = new FrequencySketch(capacity);
+  }
+}
+
 FileBlockCache::~FileBlockCache() {
-  ScopedLock lock(m_mutex);
-  for (BlockCache::const_iterator iter = m_cache.begin();
-       iter != m_cache.end(); ++iter)
-    delete [] (*iter).block;
-  m_cache.clear();
+  for (size_t i=0; i<m_shard_count; i++) {
+    ScopedLock lock(m_shards[i].mutex);
+    BlockCache &cache = m_shards[i].cache;
+    for (BlockCache::const_iterator iter = cache.begin();
+         iter != cache.end(); ++iter)
+      delete [] (*iter).block;
+    cache.clear();
+  }
+  delete [] m_shards;
+}
+
+FileBlockCache::Shard &FileBlockCache::get_shard(int64_t key) {
+  uint64_t h = (uint64_t)key * 0x9E3779B97F4A7C15ULL;
+  return m_shards[(size_t)(h >> 32) % m_shard_count];
 }
 
 bool
 FileBlockCache::checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
                          uint32_t *lengthp) {
-  ScopedLock lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  ScopedLock lock(shard.mutex);
+  HashIndex &hash_index = shard.cache.get<1>();
   HashIndex::iterator iter;
 
-  m_accesses++;
+  shard.accesses++;
+  if (shard.sketch)
+    shard.sketch->increment(key);
 
-  if ((iter = hash_index.find(make_key(file_id, file_offset))) == hash_index.end())
+  if ((iter = hash_index.find(key)) == hash_index.end())
     return false;
 
   BlockCacheEntry entry = *iter;
@@ -55,23 +90,25 @@ FileBlockCache::checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
 
   hash_index.erase(iter);
 
-  pair<Sequence::iterator, bool> insert_result = m_cache.push_back(entry);
+  pair<Sequence::iterator, bool> insert_result = shard.cache.push_back(entry);
   assert(insert_result.second);
 
   *blockp = (*insert_result.first).block;
   *lengthp = (*insert_result.first).length;
 
-  m_hits++;
+  shard.hits++;
   return true;
 }
 
 
 void FileBlockCache::checkin(int file_id, uint64_t file_offset) {
-  ScopedLock lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  ScopedLock lock(shard.mutex);
+  HashIndex &hash_index = shard.cache.get<1>();
   HashIndex::iterator iter;
 
-  iter = hash_index.find(make_key(file_id, file_offset));
+  iter = hash_index.find(key);
 
   assert(iter != hash_index.end() && (*iter).ref_count > 0);
 
@@ -79,25 +116,57 @@ void FileBlockCache::checkin(int file_id, uint64_t file_offset) {
 }
 
 
+/**
+ * Memory is reserved under #m_mutex while the shard lock is held.  If
+ * there isn't enough available, room is made by evicting from the target
+ * shard and then, without waiting, from any other shard whose lock is
+ * free; blocking on a second shard lock here could deadlock with an insert
+ * into that shard.
+ */
 bool
 FileBlockCache::insert(int file_id, uint64_t file_offset,
 		       uint8_t *block, uint32_t length, bool checkout) {
-  ScopedLock lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  ScopedLock lock(shard.mutex);
+  HashIndex &hash_index = shard.cache.get<1>();
+  int64_t needed;
 
-  if (hash_index.find(make_key(file_id, file_offset)) != hash_index.end())
+  if (hash_index.find(key) != hash_index.end())
     return false;
 
-  if (m_available < length)
-    make_room(length);
+  {
+    ScopedLock lock(m_mutex);
+    needed = (int64_t)length - m_available;
+    if (needed <= 0)
+      m_available -= length;
+  }
+
+  if (needed > 0) {
+    int64_t amount_freed = 0;
+
+    if (shard.sketch == 0 || admit(shard, key)) {
+      amount_freed = evict(shard, needed);
+      for (size_t i=1; amount_freed < needed && i<m_shard_count; i++) {
+        Shard &other = m_shards[(&shard - m_shards + i) % m_shard_count];
+        if (other.mutex.try_lock()) {
+          amount_freed += evict(other, needed - amount_freed);
+          other.mutex.unlock();
+        }
+      }
+    }
 
-  if (m_available < length) {
-    if ((length-m_available) <= (m_max_memory-m_limit)) {
-      m_limit += (length-m_available);
-      m_available += (length-m_available);
+    ScopedLock lock(m_mutex);
+    m_available += amount_freed;
+    if (m_available < length) {
+      if ((length-m_available) <= (m_max_memory-m_limit)) {
+        m_limit += (length-m_available);
+        m_available += (length-m_available);
+      }
+      else
+        return false;
     }
-    else
-      return false;
+    m_available -= length;
   }
 
   BlockCacheEntry entry(file_id, file_offset);
@@ -105,23 +174,23 @@ FileBlockCache::insert(int file_id, uint64_t file_offset,
   entry.length = length;
   entry.ref_count = checkout ? 1 : 0;
 
-  pair<Sequence::iterator, bool> insert_result = m_cache.push_back(entry);
+  pair<Sequence::iterator, bool> insert_result = shard.cache.push_back(entry);
   assert(insert_result.second);
   (void)insert_result;
 
-  m_available -= length;
-
   return true;
 }
 
 
 bool FileBlockCache::contains(int file_id, uint64_t file_offset) {
-  ScopedLock lock(m_mutex);
-  HashIndex &hash_index = m_cache.get<1>();
-  m_accesses++;
-
-  if (hash_index.find(make_key(file_id, file_offset)) != hash_index.end()) {
-    m_hits++;
+  int64_t key = make_key(file_id, file_offset);
+  Shard &shard = get_shard(key);
+  ScopedLock lock(shard.mutex);
+  HashIndex &hash_index = shard.cache.get<1>();
+  shard.accesses++;
+
+  if (hash_index.find(key) != hash_index.end()) {
+    shard.hits++;
     return true;
   }
   else
@@ -140,32 +209,51 @@ void FileBlockCache::increase_limit(int64_t amount) {
 
 
 int64_t FileBlockCache::decrease_limit(int64_t amount) {
-  ScopedLock lock(m_mutex);
   int64_t memory_freed = 0;
-  if (m_available < amount) {
-    if (amount > (m_limit - m_min_memory))
-      amount = m_limit - m_min_memory;
-    memory_freed = make_room(amount);
-    if (m_available < amount)
-      amount = m_available;
+  bool need_room = false;
+  {
+    ScopedLock lock(m_mutex);
+    if (m_available < amount) {
+      if (amount > (m_limit - m_min_memory))
+        amount = m_limit - m_min_memory;
+      need_room = m_available < amount;
+    }
   }
+  if (need_room)
+    memory_freed = make_room(amount);
+  ScopedLock lock(m_mutex);
+  if (m_available < amount)
+    amount = m_available;
   m_available -= amount;
   m_limit -= amount;
   return memory_freed;
 }
 
 
-int64_t FileBlockCache::make_room(int64_t amount) {
-  BlockCache::iterator iter = m_cache.begin();
+/**
+ * Compares the estimated access frequency of the block being inserted with
+ * that of the block the shard would evict first; the new block is only
+ * admitted if it has been accessed more often.
+ */
+bool FileBlockCache::admit(Shard &shard, int64_t key) {
+  for (BlockCache::iterator iter = shard.cache.begin();
+       iter != shard.cache.end(); ++iter) {
+    if ((*iter).ref_count == 0)
+      return shard.sketch->frequency(key) >
+        shard.sketch->frequency((*iter).key());
+  }
+  return true;
+}
+
+
+int64_t FileBlockCache::evict(Shard &shard, int64_t amount) {
+  BlockCache::iterator iter = shard.cache.begin();
   int64_t amount_freed = 0;
-  while (iter != m_cache.end()) {
+  while (amount_freed < amount && iter != shard.cache.end()) {
     if ((*iter).ref_count == 0) {
-      m_available += (*iter).length;
       amount_freed += (*iter).length;
       delete [] (*iter).block;
-      iter = m_cache.erase(iter);
-      if (m_available >= amount)
-	break;
+      iter = shard.cache.erase(iter);
     }
     else
       ++iter;
@@ -173,11 +261,46 @@ int64_t FileBlockCache::make_room(int64_t amount) {
   return amount_freed;
 }
 
+
+/**
+ * Evicts blocks, visiting the shards round-robin starting from a rotating
+ * position, until at least <code>amount</code> bytes are available.  Must
+ * be called without holding any lock.
+ */
+int64_t FileBlockCache::make_room(int64_t amount) {
+  size_t start = (size_t)atomic_inc_return(&m_next_victim_shard);
+  int64_t amount_freed = 0;
+  for (size_t i=0; i<m_shard_count; i++) {
+    Shard &shard = m_shards[(start + i) % m_shard_count];
+    ScopedLock shard_lock(shard.mutex);
+    int64_t needed;
+    {
+      ScopedLock lock(m_mutex);
+      needed = amount - m_available;
+    }
+    if (needed <= 0)
+      break;
+    int64_t freed = evict(shard, needed);
+    if (freed) {
+      ScopedLock lock(m_mutex);
+      m_available += freed;
+      amount_freed += freed;
+    }
+  }
+  return amount_freed;
+}
+
 void FileBlockCache::get_stats(uint64_t *max_memoryp, uint64_t *available_memoryp,
                                uint64_t *accessesp, uint64_t *hitsp) {
-  ScopedLock lock(m_mutex);
-  *max_memoryp = m_limit;
-  *available_memoryp = m_available;
-  *accessesp = m_accesses;
-  *hitsp = m_hits;
+  {
+    ScopedLock lock(m_mutex);
+    *max_memoryp = m_limit;
+    *available_memoryp = m_available;
+  }
+  *accessesp = *hitsp = 0;
+  for (size_t i=0; i<m_shard_count; i++) {
+    ScopedLock lock(m_shards[i].mutex);
+    *accessesp += m_shards[i].accesses;
+    *hitsp += m_shards[i].hits;
+  }
 }
@@ -27,21 +27,44 @@
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/sequenced_index.hpp>
 
+#include "Common/FrequencySketch.h"
 #include "Common/Mutex.h"
 #include "Common/atomic.h"
 
 namespace Hypertable {
   using namespace boost::multi_index;
 
+  /**
+   * Cache of file blocks read by CellStore scanners.  Blocks are spread
+   * over a set of independently locked shards by hashing their
+   * (file_id, offset) key, so scanner threads working on different blocks
+   * rarely contend.  Within a shard blocks are evicted in LRU order.  When
+   * frequency admission is enabled, a block that would force an eviction is
+   * only admitted if its recent access frequency, as estimated by a
+   * per-shard FrequencySketch, is higher than that of the shard's eviction
+   * victim (TinyLFU).  This keeps a large one-pass scan from flushing the
+   * hot working set.  The memory limit and available memory are global to
+   * the cache and protected by #m_mutex; a shard lock may be held while
+   * acquiring #m_mutex, but never the reverse.
+   */
   class FileBlockCache {
 
     static atomic_t ms_next_file_id;
 
   public:
-    FileBlockCache(int64_t min_memory, int64_t max_memory, bool compressed)
-      : m_min_memory(min_memory), m_max_memory(max_memory), m_limit(max_memory),
-	m_available(max_memory), m_accesses(0), m_hits(0), m_compressed(compressed)
-    { HT_ASSERT(min_memory <= max_memory); }
+
+    /**
+     * Constructor.  The default arguments give a single shard with plain
+     * LRU replacement.
+     *
+     * @param min_memory Minimum memory limit
+     * @param max_memory Maximum memory limit
+     * @param compressed Whether or not compressed blocks are cached
+     * @param shard_count Number of independently locked shards
+     * @param frequency_admission Enables TinyLFU admission
+     */
+    FileBlockCache(int64_t min_memory, int64_t max_memory, bool compressed,
+                   size_t shard_count=1, bool frequency_admission=false);
     ~FileBlockCache();
 
     bool compressed() { return m_compressed; }
@@ -49,6 +72,14 @@ namespace Hypertable {
     bool checkout(int file_id, uint64_t file_offset, uint8_t **blockp,
                   uint32_t *lengthp);
     void checkin(int file_id, uint64_t file_offset);
+
+    /**
+     * Inserts a block into the cache.  On success, the cache takes
+     * ownership of <code>block</code>.  Returns false if the block is
+     * already cached, if there isn't enough memory for it, or if it was
+     * rejected by the admission policy, in which case the caller retains
+     * ownership.
+     */
     bool insert(int file_id, uint64_t file_offset,
 		uint8_t *block, uint32_t length, bool checkout=false);
     bool contains(int file_id, uint64_t file_offset);
@@ -104,8 +135,6 @@ namespace Hypertable {
                    uint64_t *accessesp, uint64_t *hitsp);
   private:
 
-    int64_t make_room(int64_t amount);
-
     inline static int64_t make_key(int file_id, uint64_t file_offset) {
       return ((int64_t)file_id << 32) | (int64_t)file_offset;
     }
@@ -149,14 +178,36 @@ namespace Hypertable {
     typedef BlockCache::nth_index<0>::type Sequence;
     typedef BlockCache::nth_index<1>::type HashIndex;
 
+    /**
+     * Independently locked portion of the cache.  Access statistics are
+     * kept per shard so that checkout() and contains() only need the shard
+     * lock.
+     */
+    class Shard {
+    public:
+      Shard() : sketch(0), accesses(0), hits(0) { }
+      ~Shard() { delete sketch; }
+      Mutex            mutex;
+      BlockCache       cache;
+      FrequencySketch *sketch;
+      uint64_t         accesses;
+      uint64_t         hits;
+    };
+
+    Shard &get_shard(int64_t key);
+
+    bool admit(Shard &shard, int64_t key);
+    int64_t evict(Shard &shard, int64_t amount);
+    int64_t make_room(int64_t amount);
+
     Mutex         m_mutex;
-    BlockCache    m_cache;
+    Shard        *m_shards;
+    size_t       m_shard_count;
+    atomic_t     m_next_victim_shard;
     int64_t      m_min_memory;
     int64_t      m_max_memory;
     int64_t      m_limit;
     int64_t      m_available;
-    uint64_t     m_accesses;
-    uint64_t     m_hits;
     bool         m_compressed;
   };
 
@@ -22,10 +22,166 @@
 #include "Common/Compat.h"
 #include "FillScanBlock.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <vector>
+
 namespace Hypertable {
 
+  namespace {
+
+    /** Running aggregate for one column family */
+    struct Aggregate {
+      Aggregate() : value(0), timestamp(TIMESTAMP_MIN),
+                    revision(TIMESTAMP_MIN), valid(false) { }
+      int64_t value;
+      int64_t timestamp;
+      int64_t revision;
+      bool valid;
+    };
+
+    /** Parses a decimal cell value; returns false if it is not an integer */
+    bool parse_value(const uint8_t *ptr, size_t len, int64_t *valuep) {
+      char buf[32];
+      char *end;
+      if (len == 0 || len >= sizeof(buf))
+        return false;
+      memcpy(buf, ptr, len);
+      buf[len] = 0;
+      errno = 0;
+      *valuep = (int64_t)strtoll(buf, &end, 10);
+      return errno == 0 && *end == 0;
+    }
+
+    /** Appends one cell per column family in <code>codes</code> holding its
+     * aggregate, and resets the aggregates */
+    void append_aggregates(DynamicBuffer &dbuf, const char *row,
+                           std::vector<uint8_t> &codes,
+                           Aggregate *aggregates) {
+      char numbuf[24];
+      std::sort(codes.begin(), codes.end());
+      foreach_ht (uint8_t code, codes) {
+        Aggregate &agg = aggregates[code];
+        if (agg.valid) {
+          create_key_and_append(dbuf, FLAG_INSERT, row, code, "",
+                                agg.timestamp, agg.revision);
+          sprintf(numbuf, "%lld", (Lld)agg.value);
+          append_as_byte_string(dbuf, numbuf, strlen(numbuf));
+        }
+        agg = Aggregate();
+      }
+      codes.clear();
+    }
+
+    /** Fills a scan block with the aggregates described by the scan spec.
+     * Per-row aggregates are emitted as each row completes and the block is
+     * cut at a row boundary once it reaches <code>buffer_size</code>.  A
+     * whole-range aggregate is emitted once the scanner is exhausted, as a
+     * single cell per column family keyed by the last row aggregated (which
+     * keeps it inside the client's scan interval); the client combines these
+     * partial aggregates across ranges.
+     */
+    bool fill_aggregate_block(CellListScannerPtr &scanner, DynamicBuffer &dbuf,
+                              int64_t buffer_size, size_t trailer_size) {
+      ScanContext *scan_context = scanner->scan_context();
+      uint32_t function = scan_context->spec->aggregate;
+      bool by_row = scan_context->spec->aggregate_by_row;
+      Aggregate aggregates[256];
+      std::vector<uint8_t> codes;
+      Key key;
+      ByteString value;
+      String row, last_row, last_qualifier;
+      int64_t last_timestamp = TIMESTAMP_NULL;
+      int last_family = -1;
+      bool more = true;
+      int64_t cell_value;
+      uint8_t *ptr;
+
+      dbuf.reserve(4 + buffer_size + trailer_size);
+      dbuf.ptr = dbuf.base + 4;
+
+      while ((more = scanner->get(key, value))) {
+
+        // drop duplicates
+        if (key.timestamp == last_timestamp &&
+            (int)key.column_family_code == last_family &&
+            key.row_len == last_row.length() &&
+            key.column_qualifier_len == last_qualifier.length() &&
+            !strcmp(key.row, last_row.c_str()) &&
+            !strcmp(key.column_qualifier, last_qualifier.c_str())) {
+          scanner->forward();
+          continue;
+        }
+
+        if (by_row && (key.row_len != row.length() ||
+                       strcmp(key.row, row.c_str()))) {
+          if (!codes.empty()) {
+            append_aggregates(dbuf, row.c_str(), codes, aggregates);
+            if ((int64_t)dbuf.fill() - 4 >= buffer_size)
+              break;
+          }
+          row = key.row;
+        }
+
+        last_row = key.row;
+        last_qualifier = key.column_qualifier;
+        last_timestamp = key.timestamp;
+        last_family = key.column_family_code;
+
+        if (function == ScanSpec::AGGREGATE_COUNT)
+          cell_value = 1;
+        else {
+          const uint8_t *vptr;
+          size_t vlen = value.decode_length(&vptr);
+          if (scan_context->family_info[key.column_family_code].counter) {
+            if (vlen != 8)
+              HT_FATAL_OUT << "Expected counter to be encoded 64 bit int but "
+                  "remain=" << vlen << " ,key=" << key << HT_END;
+            cell_value = (int64_t)Serialization::decode_i64(&vptr, &vlen);
+          }
+          else if (!parse_value(vptr, vlen, &cell_value)) {
+            scanner->forward();
+            continue;
+          }
+        }
+
+        Aggregate &agg = aggregates[key.column_family_code];
+        if (!agg.valid) {
+          codes.push_back(key.column_family_code);
+          agg.value = cell_value;
+          agg.valid = true;
+        }
+        else if (function == ScanSpec::AGGREGATE_COUNT ||
+                 function == ScanSpec::AGGREGATE_SUM)
+          agg.value += cell_value;
+        else if (function == ScanSpec::AGGREGATE_MIN)
+          agg.value = std::min(agg.value, cell_value);
+        else
+          agg.value = std::max(agg.value, cell_value);
+        agg.timestamp = std::max(agg.timestamp, key.timestamp);
+        agg.revision = std::max(agg.revision, key.revision);
+
+        scanner->forward();
+      }
+
+      if (!more && !codes.empty())
+        append_aggregates(dbuf, by_row ? row.c_str() : last_row.c_str(),
+                          codes, aggregates);
+
+      dbuf.ensure(trailer_size);
+
+      ptr = dbuf.base;
+      Serialization::encode_i32(&ptr, dbuf.fill() - 4);
+
+      return more;
+    }
+
+  }
+
   bool
-  FillScanBlock(CellListScannerPtr &scanner, DynamicBuffer &dbuf, int64_t buffer_size) {
+  FillScanBlock(CellListScannerPtr &scanner, DynamicBuffer &dbuf,
+                int64_t buffer_size, size_t trailer_size) {
     Key key, last_key;
     ByteString value;
     size_t value_len;
@@ -43,6 +199,9 @@ namespace Hypertable {
 
     assert(dbuf.base == 0);
 
+    if (scan_context->spec->aggregate != ScanSpec::AGGREGATE_NONE)
+      return fill_aggregate_block(scanner, dbuf, buffer_size, trailer_size);
+
     memset(&last_key, 0, sizeof(last_key));
 
     while ((more = scanner->get(key, value))) {
@@ -101,7 +260,7 @@ namespace Hypertable {
           limit = key.length + value_len;
           remaining = limit;
         }
-        dbuf.reserve(4 + limit);
+        dbuf.reserve(4 + limit + trailer_size);
         // skip encoded length
         dbuf.ptr = dbuf.base + 4;
       }
@@ -126,7 +285,7 @@ namespace Hypertable {
     }
 
     if (dbuf.base == 0) {
-      dbuf.reserve(4);
+      dbuf.reserve(4 + trailer_size);
       dbuf.ptr = dbuf.base + 4;
     }
 
@@ -28,8 +28,20 @@
 
 namespace Hypertable {
 
+  /** Fills a scan block with cells from a scanner.
+   * The block is written into <code>dbuf</code> as a 32-bit length followed
+   * by the serialized key/value pairs.  If <code>trailer_size</code> is
+   * non-zero, that many bytes are reserved past the end of the block so the
+   * caller can append data without reallocating, allowing the buffer to be
+   * handed to the response CommBuf as-is.
+   * @param scanner Scanner from which to read cells
+   * @param dbuf Buffer to fill (must be empty)
+   * @param buffer_size Target block size
+   * @param trailer_size Extra bytes to reserve after the block
+   * @return <i>true</i> if there are more cells to be returned
+   */
   bool FillScanBlock(CellListScannerPtr &scanner, DynamicBuffer &dbuf,
-                     int64_t buffer_size);
+                     int64_t buffer_size, size_t trailer_size = 0);
 
 }
 
@@ -72,8 +72,14 @@ namespace Hypertable {
   uint64_t               Global::access_counter = 0;
   bool                   Global::enable_shadow_cache = true;
   std::string            Global::toplevel_dir;
+  std::string            Global::cellstore_mmap_root;
   int32_t                Global::metrics_interval = 0;
   int32_t                Global::merge_cellstore_run_length_threshold = 0;
+  CompactionPolicyPtr    Global::compaction_policy;
+  MaintenanceThrottlePtr Global::maintenance_throttle;
+  int32_t                Global::access_group_compaction_concurrency = 0;
+  int32_t                Global::subcompaction_max_shards = 0;
+  int64_t                Global::subcompaction_min_shard_size = 0;
   bool                   Global::ignore_clock_skew_errors = false;
   ConnectionManagerPtr   Global::conn_manager;
   std::vector<MetaLog::EntityTaskPtr>  Global::work_queue;
@@ -42,9 +42,11 @@
 #include "Hypertable/Lib/Client.h"
 #include "Hypertable/Lib/Types.h"
 
+#include "CompactionPolicy.h"
 #include "FileBlockCache.h"
 #include "LocationInitializer.h"
 #include "MaintenanceQueue.h"
+#include "MaintenanceThrottle.h"
 #include "MemoryTracker.h"
 #include "MetaLogEntityTask.h"
 #include "MetaLogEntityRemoveOkLogs.h"
@@ -102,8 +104,14 @@ namespace Hypertable {
     static uint64_t       access_counter;
     static bool           enable_shadow_cache;
     static std::string    toplevel_dir;
+    static std::string    cellstore_mmap_root;
     static int32_t        metrics_interval;
     static int32_t        merge_cellstore_run_length_threshold;
+    static CompactionPolicyPtr compaction_policy;
+    static MaintenanceThrottlePtr maintenance_throttle;
+    static int32_t        access_group_compaction_concurrency;
+    static int32_t        subcompaction_max_shards;
+    static int64_t        subcompaction_min_shard_size;
     static bool           ignore_clock_skew_errors;
     static ConnectionManagerPtr conn_manager;
     static std::vector<MetaLog::EntityTaskPtr> work_queue;
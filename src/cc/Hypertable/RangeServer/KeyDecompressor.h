@@ -35,6 +35,34 @@ namespace Hypertable {
     virtual const uint8_t *add(const uint8_t *ptr) = 0;
     virtual bool less_than(SerializedKey serialized_key) = 0;
     virtual void load(Key &key) = 0;
+
+    /**
+     * Returns the end of the key/value pairs in a block.  Block formats
+     * that append an index to the key/value pairs override this to parse
+     * the index and return its start.
+     *
+     * @param base Start of the uncompressed block
+     * @param end End of the uncompressed block
+     * @return End of the key/value pairs
+     */
+    virtual const uint8_t *load_block(const uint8_t *base, const uint8_t *end) {
+      return end;
+    }
+
+    /**
+     * Positions the decompressor at a key/value pair in the block most
+     * recently passed to load_block() from which a linear search for
+     * <code>key</code> may start, and decompresses that key.  The default
+     * implementation starts at the first pair in the block.
+     *
+     * @param base Start of the uncompressed block
+     * @param key Key being searched for
+     * @return Pointer to the value of the decompressed key
+     */
+    virtual const uint8_t *seek(const uint8_t *base, SerializedKey key) {
+      reset();
+      return add(base);
+    }
   };
   typedef intrusive_ptr<KeyDecompressor> KeyDecompressorPtr;
 
@@ -0,0 +1,85 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/Serialization.h"
+
+#include "KeyDecompressorPrefixRestart.h"
+
+using namespace Hypertable;
+
+
+const uint8_t *
+KeyDecompressorPrefixRestart::load_block(const uint8_t *base,
+                                         const uint8_t *end) {
+  const uint8_t *ptr;
+  size_t remaining = 4;
+
+  if (end - base < 4)
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE,
+              "Block too short (%d bytes) for restart index", (int)(end-base));
+
+  ptr = end - 4;
+  m_restart_count = Serialization::decode_i32(&ptr, &remaining);
+
+  if ((size_t)(end - base) < 4 + (4 * m_restart_count))
+    HT_THROWF(Error::RANGESERVER_CORRUPT_CELLSTORE,
+              "Bad restart point count (%u) in %d byte block",
+              (unsigned)m_restart_count, (int)(end-base));
+
+  m_restarts = end - 4 - (4 * m_restart_count);
+  return m_restarts;
+}
+
+
+uint32_t KeyDecompressorPrefixRestart::restart_offset(size_t i) {
+  const uint8_t *ptr = m_restarts + (4 * i);
+  size_t remaining = 4;
+  return Serialization::decode_i32(&ptr, &remaining);
+}
+
+
+/**
+ * Finds the last restart point whose key is less than <code>key</code>;
+ * the pair at that point is the closest one from which a linear search
+ * for the first key >= <code>key</code> can start.
+ */
+const uint8_t *
+KeyDecompressorPrefixRestart::seek(const uint8_t *base, SerializedKey key) {
+  size_t low = 0;
+  size_t high = m_restart_count;
+
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    reset();
+    add(base + restart_offset(mid));
+    if (less_than(key))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  reset();
+  if (low == 0)
+    return add(base);
+  return add(base + restart_offset(low - 1));
+}
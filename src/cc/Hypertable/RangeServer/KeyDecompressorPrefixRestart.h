@@ -0,0 +1,51 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_KEYDECOMPRESSORPREFIXRESTART_H
+#define HYPERTABLE_KEYDECOMPRESSORPREFIXRESTART_H
+
+#include "KeyDecompressorPrefix.h"
+
+namespace Hypertable {
+
+  /**
+   * Prefix key decompressor for blocks that carry restart points.  Every
+   * restart point is a key/value pair whose key was compressed without
+   * reference to the previous key.  The block ends with the offsets of the
+   * restart points, each a 32-bit integer relative to the start of the
+   * block, followed by a 32-bit count of restart points.  seek() binary
+   * searches the restart points so that a lookup only needs to decompress
+   * the keys following the closest restart point.
+   */
+  class KeyDecompressorPrefixRestart : public KeyDecompressorPrefix {
+  public:
+    KeyDecompressorPrefixRestart() : m_restarts(0), m_restart_count(0) { }
+    virtual const uint8_t *load_block(const uint8_t *base, const uint8_t *end);
+    virtual const uint8_t *seek(const uint8_t *base, SerializedKey key);
+  private:
+    uint32_t restart_offset(size_t i);
+    const uint8_t *m_restarts;
+    size_t m_restart_count;
+  };
+
+}
+
+#endif // HYPERTABLE_KEYDECOMPRESSORPREFIXRESTART_H
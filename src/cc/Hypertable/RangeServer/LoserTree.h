@@ -0,0 +1,209 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#ifndef HYPERTABLE_LOSERTREE_H
+#define HYPERTABLE_LOSERTREE_H
+
+#include <algorithm>
+#include <vector>
+
+#include "Common/ByteString.h"
+
+#include "Hypertable/Lib/Key.h"
+
+#include "CellListScanner.h"
+
+
+namespace Hypertable {
+
+  /**
+   * Tournament (loser) tree used by MergeScanner to merge the cells of its
+   * input scanners in key order.  Each internal node holds the input that
+   * lost the match played there, so replacing the winner costs one
+   * comparison per level instead of the two per level of a binary heap.
+   * The first eight comparable bytes of every input's current key are
+   * cached as an integer so that most comparisons never touch the keys
+   * themselves.  After a replay that leaves the same input on top, the
+   * runner-up is remembered, and as long as the winner's next key stays
+   * below it the winner is replaced without replaying at all.  Inputs with
+   * equal keys are ordered by the position in which they were added.
+   */
+  class LoserTree {
+  public:
+    struct Entry {
+      CellListScanner *scanner;
+      Key key;
+      ByteString value;
+    };
+
+    LoserTree() : m_runner_up(-1) { }
+
+    /** Removes all inputs */
+    void clear() {
+      m_entries.clear();
+      m_prefixes.clear();
+      m_tree.clear();
+      m_runner_up = -1;
+    }
+
+    /** Adds an input.  All inputs must be added before build() is called.
+     *
+     * @param entry Input scanner positioned on its first cell
+     */
+    void add(const Entry &entry) {
+      m_entries.push_back(entry);
+      m_prefixes.push_back(Prefix());
+      compute_prefix(m_entries.size() - 1);
+    }
+
+    /** Plays the initial tournament over the inputs added with add() */
+    void build() {
+      size_t k = m_entries.size();
+      m_tree.assign(k ? k : 1, 0);
+      m_runner_up = -1;
+      if (k <= 1)
+        return;
+      std::vector<int> winners(2 * k);
+      for (size_t i = 0; i < k; i++)
+        winners[k + i] = (int)i;
+      for (size_t i = k - 1; i > 0; i--) {
+        int a = winners[2 * i], b = winners[2 * i + 1];
+        if (less(a, b)) {
+          winners[i] = a;
+          m_tree[i] = b;
+        }
+        else {
+          winners[i] = b;
+          m_tree[i] = a;
+        }
+      }
+      m_tree[0] = winners[1];
+    }
+
+    /** Returns true if every input is exhausted */
+    bool empty() const {
+      return m_entries.empty() || !m_prefixes[m_tree[0]].live;
+    }
+
+    /** Returns the input with the smallest current key */
+    const Entry &top() const { return m_entries[m_tree[0]]; }
+
+    /** Advances the winning input to its next cell and restores order */
+    void forward_top() {
+      m_entries[m_tree[0]].scanner->forward();
+      refresh_top();
+    }
+
+    /** Reloads the winning input's current cell, which may have been
+     * advanced outside of the tree, and restores order */
+    void refresh_top() {
+      int winner = m_tree[0];
+      Entry &entry = m_entries[winner];
+      m_prefixes[winner].live = entry.scanner->get(entry.key, entry.value);
+      compute_prefix(winner);
+
+      // fast path: still ahead of everyone else
+      if (m_runner_up >= 0 && less(winner, m_runner_up))
+        return;
+
+      replay(winner);
+    }
+
+  private:
+
+    struct Prefix {
+      Prefix() : bytes(0), valid(false), live(true) { }
+      uint64_t bytes;
+      bool valid;
+      bool live;
+    };
+
+    /** Caches the leading comparable bytes of an input's key.  The cached
+     * value is only used when both keys have at least eight bytes that
+     * SerializedKey::compare always examines, in which case comparing the
+     * integers gives the same answer as comparing the keys.
+     */
+    void compute_prefix(int i) {
+      Prefix &prefix = m_prefixes[i];
+      prefix.valid = false;
+      if (!prefix.live)
+        return;
+      const uint8_t *ptr;
+      int len = m_entries[i].key.serial.decode_length(&ptr) - 1;
+      if (*ptr >= 0x80 && *ptr != 0xD0)
+        len -= 8;
+      if (len < 8)
+        return;
+      uint64_t bytes = 0;
+      for (int j = 1; j <= 8; j++)
+        bytes = (bytes << 8) | ptr[j];
+      prefix.bytes = bytes;
+      prefix.valid = true;
+    }
+
+    /** Returns true if input <code>a</code> should be merged before input
+     * <code>b</code>; exhausted inputs sort after everything else */
+    bool less(int a, int b) const {
+      const Prefix &pa = m_prefixes[a];
+      const Prefix &pb = m_prefixes[b];
+      if (!pa.live || !pb.live) {
+        if (pa.live != pb.live)
+          return pa.live;
+        return a < b;
+      }
+      if (pa.valid && pb.valid && pa.bytes != pb.bytes)
+        return pa.bytes < pb.bytes;
+      int cmp = m_entries[a].key.serial.compare(m_entries[b].key.serial);
+      if (cmp)
+        return cmp < 0;
+      return a < b;
+    }
+
+    /** Replays the matches on the path from input <code>i</code> to the
+     * root.  If <code>i</code> remains the winner, the best of the inputs
+     * it beat along the way becomes the new runner-up. */
+    void replay(int i) {
+      size_t k = m_entries.size();
+      int candidate = i;
+      for (size_t node = (k + i) / 2; node > 0; node /= 2) {
+        if (less(m_tree[node], candidate))
+          std::swap(m_tree[node], candidate);
+      }
+      m_tree[0] = candidate;
+      m_runner_up = -1;
+      if (candidate == i && k > 1) {
+        int best = m_tree[(k + i) / 2];
+        for (size_t node = (k + i) / 4; node > 0; node /= 2)
+          if (less(m_tree[node], best))
+            best = m_tree[node];
+        m_runner_up = best;
+      }
+    }
+
+    std::vector<Entry>  m_entries;
+    std::vector<Prefix> m_prefixes;
+    std::vector<int>    m_tree;
+    int                 m_runner_up;
+  };
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_LOSERTREE_H
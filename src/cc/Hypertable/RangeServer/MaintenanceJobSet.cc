@@ -0,0 +1,146 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for MaintenanceJobSet.
+ * This file contains the method definitions for MaintenanceJobSet, an
+ * abstract base class for maintenance work that is split into independent
+ * jobs run in parallel by the maintenance threads.
+ */
+
+#include "Common/Compat.h"
+
+#include <exception>
+#include <new>
+
+#include "Global.h"
+#include "MaintenanceJobSet.h"
+#include "MaintenanceTask.h"
+
+using namespace Hypertable;
+
+Mutex MaintenanceJobSet::ms_mutex;
+int32_t MaintenanceJobSet::ms_helpers = 0;
+
+namespace Hypertable {
+
+  /** Maintenance task that runs jobs of a MaintenanceJobSet.
+   */
+  class MaintenanceTaskJobSetHelper : public MaintenanceTask {
+  public:
+    MaintenanceTaskJobSetHelper(MaintenanceJobSet *job_set)
+      : MaintenanceTask(0, 0, "MAINTENANCE HELPER"), m_job_set(job_set) { }
+    virtual ~MaintenanceTaskJobSetHelper() {
+      MaintenanceJobSet::release_helper();
+    }
+    virtual void execute() {
+      m_job_set->run_jobs();
+    }
+  private:
+    MaintenanceJobSetPtr m_job_set;
+  };
+
+}
+
+
+void MaintenanceJobSet::run() {
+
+  if (job_count() > 1 && Global::maintenance_queue) {
+    size_t helpers = reserve_helpers(job_count() - 1);
+    for (size_t i=0; i<helpers; i++)
+      Global::maintenance_queue->add_helper(new MaintenanceTaskJobSetHelper(this));
+  }
+
+  run_jobs();
+
+  ScopedLock lock(m_mutex);
+  while (m_completed < m_next)
+    m_cond.wait(lock);
+
+  if (m_error != Error::OK)
+    HT_THROW(m_error, m_error_msg);
+}
+
+
+void MaintenanceJobSet::run_jobs() {
+  size_t i;
+
+  while (true) {
+
+    {
+      ScopedLock lock(m_mutex);
+      if (m_next == job_count() || m_error != Error::OK)
+        break;
+      i = m_next++;
+    }
+
+    try {
+      run_job(i);
+    }
+    catch (Exception &e) {
+      record_error(e.code(), e.what());
+    }
+    catch (std::bad_alloc &e) {
+      record_error(Error::BAD_MEMORY_ALLOCATION, "bad memory allocation");
+    }
+    catch (std::exception &e) {
+      record_error(Error::EXTERNAL,
+                   format("caught std::exception: %s", e.what()));
+    }
+    catch (...) {
+      record_error(Error::EXTERNAL, "caught unknown exception");
+    }
+
+    {
+      ScopedLock lock(m_mutex);
+      m_completed++;
+      m_cond.notify_all();
+    }
+  }
+}
+
+
+void MaintenanceJobSet::record_error(int error, const String &msg) {
+  ScopedLock lock(m_mutex);
+  if (m_error == Error::OK) {
+    m_error = error;
+    m_error_msg = msg;
+  }
+}
+
+
+size_t MaintenanceJobSet::reserve_helpers(size_t count) {
+  ScopedLock lock(ms_mutex);
+  int32_t available = Global::access_group_compaction_concurrency - ms_helpers;
+  if (available <= 0)
+    return 0;
+  if ((size_t)available < count)
+    count = available;
+  ms_helpers += count;
+  return count;
+}
+
+
+void MaintenanceJobSet::release_helper() {
+  ScopedLock lock(ms_mutex);
+  HT_ASSERT(ms_helpers > 0);
+  ms_helpers--;
+}
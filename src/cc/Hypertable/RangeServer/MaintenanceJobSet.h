@@ -0,0 +1,136 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for MaintenanceJobSet.
+ * This file contains the type declarations for MaintenanceJobSet, an
+ * abstract base class for maintenance work that is split into independent
+ * jobs run in parallel by the maintenance threads.
+ */
+
+#ifndef HYPERTABLE_MAINTENANCEJOBSET_H
+#define HYPERTABLE_MAINTENANCEJOBSET_H
+
+#include <boost/thread/condition.hpp>
+
+#include "Common/Error.h"
+#include "Common/Mutex.h"
+#include "Common/ReferenceCount.h"
+#include "Common/String.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Independent jobs run in parallel by the maintenance threads.
+   * The thread calling run() works through the jobs itself and, to speed
+   * things up, queues helper tasks on the maintenance queue that pick up
+   * jobs the calling thread hasn't started yet.  Since the calling thread
+   * never waits for a job that hasn't been started, this can't deadlock when
+   * all maintenance threads are busy.  The number of helper tasks
+   * outstanding is limited server-wide by
+   * Global::access_group_compaction_concurrency.
+   */
+  class MaintenanceJobSet : public ReferenceCount {
+  public:
+
+    MaintenanceJobSet() : m_next(0), m_completed(0), m_error(Error::OK) { }
+
+    virtual ~MaintenanceJobSet() { }
+
+    /** Runs the jobs and waits for all of them to finish.  If a job throws
+     * an exception, jobs that haven't been started yet are skipped and, once
+     * the jobs in progress have finished, the first error is rethrown as an
+     * Exception.  Exceptions other than Exception are reported as
+     * Error::EXTERNAL (or Error::BAD_MEMORY_ALLOCATION for
+     * <code>std::bad_alloc</code>).
+     * @throws Exception First error encountered
+     */
+    void run();
+
+    /** Runs jobs until there are none left to start.  Called by the helper
+     * tasks. */
+    void run_jobs();
+
+  protected:
+
+    /** Returns the number of jobs */
+    virtual size_t job_count() const = 0;
+
+    /** Runs a job.
+     * @param i Index of job
+     */
+    virtual void run_job(size_t i) = 0;
+
+  private:
+
+    /** Records the first error encountered by a job.
+     * @param error Error code
+     * @param msg Error message
+     */
+    void record_error(int error, const String &msg);
+
+    /** Reserves up to <code>count</code> helper tasks under the server-wide
+     * limit.
+     * @return Number of helper tasks reserved
+     */
+    static size_t reserve_helpers(size_t count);
+
+    /** Releases a helper task reserved with reserve_helpers() */
+    static void release_helper();
+
+    friend class MaintenanceTaskJobSetHelper;
+
+    /// %Mutex protecting the members below
+    Mutex m_mutex;
+
+    /// Signalled when a job completes
+    boost::condition m_cond;
+
+    /// Index of next job to start (number of jobs started)
+    size_t m_next;
+
+    /// Number of jobs completed
+    size_t m_completed;
+
+    /// Code of first error
+    int m_error;
+
+    /// Message of first error
+    String m_error_msg;
+
+    /// %Mutex protecting #ms_helpers
+    static Mutex ms_mutex;
+
+    /// Number of helper tasks outstanding server-wide
+    static int32_t ms_helpers;
+  };
+
+  /// Smart pointer to MaintenanceJobSet
+  typedef intrusive_ptr<MaintenanceJobSet> MaintenanceJobSetPtr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_MAINTENANCEJOBSET_H
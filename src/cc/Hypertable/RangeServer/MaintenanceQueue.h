@@ -291,6 +291,23 @@ namespace Hypertable {
       m_state.cond.notify_one();
     }
 
+    /** Adds a task that helps a task in flight finish its work.  The task
+     * is not associated with a range.  It is given the lowest level in
+     * flight and the highest priority, so it is executed before other queued
+     * tasks of that level without holding back tasks of the levels in
+     * flight.
+     * @param task Maintenance task to add
+     */
+    void add_helper(MaintenanceTask *task) {
+      ScopedLock lock(m_state.mutex);
+      HT_ASSERT(task->get_range() == 0);
+      if (m_state.inflight)
+        task->level = m_state.inflight_level;
+      task->priority = 0;
+      m_state.queue.push(task);
+      m_state.cond.notify_one();
+    }
+
     /** Returns the size of the queue.
      * The size is computed as the queue size plus the number of tasks
      * <i>in flight</i>.
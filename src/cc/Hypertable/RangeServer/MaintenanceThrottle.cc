@@ -0,0 +1,118 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Definitions for MaintenanceThrottle.
+ * This file contains the method definitions for MaintenanceThrottle, which
+ * limits the rate of CellStore I/O performed by compactions.
+ */
+
+#include "Common/Compat.h"
+
+#include "MaintenanceThrottle.h"
+
+using namespace Hypertable;
+
+namespace {
+  /** Scopes live on the stack of their thread, so they must not be deleted
+   * when the thread exits. */
+  void no_cleanup(MaintenanceThrottle::Scope *) { }
+
+  const char *task_names[MaintenanceThrottle::TASK_COUNT] = {
+    "minor compaction",
+    "merging compaction",
+    "major compaction",
+    "gc compaction",
+    "inmemory compaction"
+  };
+}
+
+boost::thread_specific_ptr<MaintenanceThrottle::Scope>
+MaintenanceThrottle::ms_scope(no_cleanup);
+
+
+MaintenanceThrottle::Scope::Scope(MaintenanceThrottle *throttle, Task task,
+                                  bool throttled)
+  : m_throttle(throttle), m_task(task), m_throttled(throttled),
+    m_previous(ms_scope.get()) {
+  if (m_throttle)
+    ms_scope.reset(this);
+}
+
+
+MaintenanceThrottle::Scope::~Scope() {
+  if (m_throttle)
+    ms_scope.reset(m_previous);
+}
+
+
+MaintenanceThrottle::MaintenanceThrottle(int64_t max_rate, int64_t min_rate,
+                                         int64_t burst)
+  : m_bucket(max_rate, burst), m_max_rate(max_rate), m_min_rate(min_rate) {
+}
+
+
+const char *MaintenanceThrottle::task_name(int task) {
+  HT_ASSERT(task >= 0 && task < TASK_COUNT);
+  return task_names[task];
+}
+
+
+void MaintenanceThrottle::adjust(int64_t foreground_rate) {
+  if (m_max_rate == 0)
+    return;
+  int64_t rate = m_max_rate - foreground_rate;
+  if (rate < m_min_rate)
+    rate = m_min_rate;
+  m_bucket.set_rate(rate);
+}
+
+
+void MaintenanceThrottle::get_stats(std::vector<TaskStats> &stats) {
+  ScopedLock lock(m_mutex);
+  stats.clear();
+  for (int i=0; i<TASK_COUNT; i++) {
+    stats.push_back(m_stats[i]);
+    m_stats[i] = TaskStats();
+  }
+}
+
+
+void MaintenanceThrottle::charge(size_t bytes, bool write) {
+  Scope *scope = ms_scope.get();
+  if (scope == 0)
+    return;
+  MaintenanceThrottle *throttle = scope->m_throttle;
+  int64_t throttled_micros = 0;
+  // I/O of unthrottled tasks still counts against the rate, it just
+  // delays the throttled ones
+  if (scope->m_throttled)
+    throttled_micros = throttle->m_bucket.consume(bytes);
+  else
+    throttle->m_bucket.reserve(bytes);
+  ScopedLock lock(throttle->m_mutex);
+  TaskStats &stats = throttle->m_stats[scope->m_task];
+  if (write)
+    stats.write_bytes += bytes;
+  else
+    stats.read_bytes += bytes;
+  stats.throttled_micros += throttled_micros;
+}
@@ -0,0 +1,164 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+/** @file
+ * Declarations for MaintenanceThrottle.
+ * This file contains the type declarations for MaintenanceThrottle, which
+ * limits the rate of CellStore I/O performed by compactions.
+ */
+
+#ifndef HYPERTABLE_MAINTENANCETHROTTLE_H
+#define HYPERTABLE_MAINTENANCETHROTTLE_H
+
+#include <vector>
+
+#include <boost/thread/tss.hpp>
+
+#include "Common/Mutex.h"
+#include "Common/ReferenceCount.h"
+#include "Common/TokenBucket.h"
+
+namespace Hypertable {
+
+  /** @addtogroup RangeServer
+   * @{
+   */
+
+  /** Server-wide throttle for maintenance I/O.
+   * Compactions read and rewrite CellStores in bulk and, left alone, can use
+   * all of the disk bandwidth and drive up the latency of foreground scans.
+   * All maintenance tasks share one TokenBucket.  A task declares itself by
+   * creating a Scope object for the duration of its work; CellStore code
+   * then calls read() and write() for every block it transfers, which blocks
+   * the calling thread if the task is throttled and the server is over its
+   * rate.  Calls made outside of a Scope (i.e. by foreground scans) return
+   * immediately.  The rate is re-adjusted every maintenance interval to
+   * leave room for the foreground scan load, see adjust().
+   */
+  class MaintenanceThrottle : public ReferenceCount {
+  public:
+
+    /** Types of maintenance task */
+    enum Task {
+      MINOR_COMPACTION = 0,
+      MERGING_COMPACTION,
+      MAJOR_COMPACTION,
+      GC_COMPACTION,
+      INMEMORY_COMPACTION,
+      TASK_COUNT
+    };
+
+    /** I/O performed by one type of task */
+    struct TaskStats {
+      TaskStats() : read_bytes(0), write_bytes(0), throttled_micros(0) { }
+      uint64_t read_bytes;
+      uint64_t write_bytes;
+      uint64_t throttled_micros;
+    };
+
+    /** Marks the calling thread as running a maintenance task.  I/O reported
+     * by the thread while the object exists is charged to the task.
+     */
+    class Scope {
+    public:
+      /** Constructor.
+       * @param throttle Throttle to charge (may be 0, then nothing is done)
+       * @param task Type of task
+       * @param throttled If <i>false</i>, the task's I/O takes tokens from
+       * the bucket but is never delayed
+       */
+      Scope(MaintenanceThrottle *throttle, Task task, bool throttled=true);
+      ~Scope();
+    private:
+      friend class MaintenanceThrottle;
+      MaintenanceThrottle *m_throttle;
+      Task m_task;
+      bool m_throttled;
+      Scope *m_previous;
+    };
+
+    /** Constructor.
+     * @param max_rate Maximum rate in bytes/s (0 means unlimited)
+     * @param min_rate Rate guaranteed to maintenance no matter how busy the
+     * server is
+     * @param burst Bytes that may be transferred at once after an idle period
+     */
+    MaintenanceThrottle(int64_t max_rate, int64_t min_rate, int64_t burst);
+
+    /** Returns the name of a task type */
+    static const char *task_name(int task);
+
+    /** Charges bytes read to the task of the calling thread.
+     * @param bytes Number of bytes read
+     */
+    static void read(size_t bytes) { charge(bytes, false); }
+
+    /** Charges bytes written to the task of the calling thread.
+     * @param bytes Number of bytes written
+     */
+    static void write(size_t bytes) { charge(bytes, true); }
+
+    /** Adjusts the rate to the foreground load.  The rate becomes the maximum
+     * rate minus the foreground scan rate, but no less than the minimum rate.
+     * @param foreground_rate Bytes/s returned by scans
+     */
+    void adjust(int64_t foreground_rate);
+
+    /** Returns the current rate in bytes/s (0 means unlimited) */
+    int64_t get_rate() { return m_bucket.get_rate(); }
+
+    /** Returns the I/O performed by each type of task since the last call.
+     * @param stats Vector to hold stats, indexed by Task
+     */
+    void get_stats(std::vector<TaskStats> &stats);
+
+  private:
+
+    /** Charges I/O to the current scope of the calling thread, if any. */
+    static void charge(size_t bytes, bool write);
+
+    /// Mutex protecting #m_stats
+    Mutex m_mutex;
+
+    /// Bucket shared by all maintenance tasks
+    TokenBucket m_bucket;
+
+    /// Maximum rate
+    int64_t m_max_rate;
+
+    /// Minimum rate
+    int64_t m_min_rate;
+
+    /// I/O performed by each type of task
+    TaskStats m_stats[TASK_COUNT];
+
+    /// Innermost scope of each thread
+    static boost::thread_specific_ptr<Scope> ms_scope;
+  };
+
+  /// Smart pointer to MaintenanceThrottle
+  typedef intrusive_ptr<MaintenanceThrottle> MaintenanceThrottlePtr;
+
+  /** @}*/
+
+} // namespace Hypertable
+
+#endif // HYPERTABLE_MAINTENANCETHROTTLE_H
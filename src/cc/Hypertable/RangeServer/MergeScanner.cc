@@ -85,15 +85,15 @@ MergeScanner::initialize() {
 
   assert(m_initialized==false);
 
-  while (!m_queue.empty())
-    m_queue.pop();
+  m_queue.clear();
 
   for (size_t i=0; i<m_scanners.size(); i++) {
     if (m_scanners[i]->get(sstate.key, sstate.value)) {
       sstate.scanner = m_scanners[i];
-      m_queue.push(sstate);
+      m_queue.add(sstate);
     }
   }
+  m_queue.build();
 
   do_initialize();
   m_initialized = true;
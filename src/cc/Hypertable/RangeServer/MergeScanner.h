@@ -22,7 +22,6 @@
 #ifndef HYPERTABLE_MERGESCANNER_H
 #define HYPERTABLE_MERGESCANNER_H
 
-#include <queue>
 #include <string>
 #include <vector>
 #include <set>
@@ -32,23 +31,14 @@
 
 #include "CellListScanner.h"
 #include "CellStoreReleaseCallback.h"
+#include "LoserTree.h"
 
 
 namespace Hypertable {
 
   class MergeScanner : public CellListScanner {
   public:
-    struct ScannerState {
-      CellListScanner *scanner;
-      Key key;
-      ByteString value;
-    };
-
-    struct LtScannerState {
-      bool operator()(const ScannerState &ss1, const ScannerState &ss2) const {
-        return ss1.key.serial > ss2.key.serial;
-      }
-    };
+    typedef LoserTree::Entry ScannerState;
 
     MergeScanner(ScanContextPtr &scan_ctx);
 
@@ -95,8 +85,7 @@ namespace Hypertable {
     bool          m_done;
     bool          m_initialized;
     std::vector<CellListScanner *>  m_scanners;
-    std::priority_queue<ScannerState, std::vector<ScannerState>,
-        LtScannerState> m_queue;
+    LoserTree     m_queue;
 
     CellStoreReleaseCallback m_release_callback;
 
@@ -121,10 +121,7 @@ MergeScannerAccessGroup::do_initialize()
         || (sstate.key.timestamp < m_start_timestamp)) {
       if (m_index_updater && sstate.key.flag == FLAG_INSERT)
         purge_from_index(sstate.key, sstate.value);
-      m_queue.pop();
-      sstate.scanner->forward();
-      if (sstate.scanner->get(sstate.key, sstate.value))
-        m_queue.push(sstate);
+      m_queue.forward_top();
       continue;
     }
     else if (sstate.key.flag == FLAG_DELETE_ROW) {
@@ -165,10 +162,7 @@ MergeScannerAccessGroup::do_initialize()
             && (!m_return_deletes || sstate.key.flag == FLAG_INSERT))) {
         if (m_index_updater && sstate.key.flag == FLAG_INSERT)
           purge_from_index(sstate.key, sstate.value);
-        m_queue.pop();
-        sstate.scanner->forward();
-        if (sstate.scanner->get(sstate.key, sstate.value))
-          m_queue.push(sstate);
+        m_queue.forward_top();
         continue;
       }
 
@@ -194,10 +188,7 @@ MergeScannerAccessGroup::do_initialize()
       if (m_revs_limit && m_revs_count > m_revs_limit && !counter) {
         if (m_index_updater && sstate.key.flag == FLAG_INSERT)
           purge_from_index(sstate.key, sstate.value);
-        m_queue.pop();
-        sstate.scanner->forward();
-        if (sstate.scanner->get(sstate.key, sstate.value))
-          m_queue.push(sstate);
+        m_queue.forward_top();
         continue;
       }
 
@@ -208,10 +199,7 @@ MergeScannerAccessGroup::do_initialize()
             && (cmp = strcmp(*m_scan_context->rowset.begin(), sstate.key.row)) < 0)
           m_scan_context->rowset.erase(m_scan_context->rowset.begin());
         if (cmp > 0) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+          m_queue.forward_top();
           continue;
         }
       }
@@ -220,10 +208,7 @@ MergeScannerAccessGroup::do_initialize()
         const uint8_t *dptr;
         if (!cfi.column_predicate_matches(sstate.value.str(),
                 sstate.value.decode_length(&dptr))) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+          m_queue.forward_top();
           continue;
         }
       }
@@ -231,31 +216,21 @@ MergeScannerAccessGroup::do_initialize()
       if (m_scan_context->row_regexp)
         if (!RE2::PartialMatch(sstate.key.row, 
             *(m_scan_context->row_regexp))) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+          m_queue.forward_top();
           continue;
         }
       // column qualifier doesn't match
       if (!cfi.qualifier_matches(sstate.key.column_qualifier, 
                   sstate.key.column_qualifier_len)) {
-        m_queue.pop();
-        sstate.scanner->forward();
-        if (sstate.scanner->get(sstate.key, sstate.value))
-          m_queue.push(sstate);
+        m_queue.forward_top();
         continue;
       }
       // filter by value regexp last since its probly the most expensive
       if (m_scan_context->value_regexp && !counter) {
         const uint8_t *dptr;
-        if (!RE2::PartialMatch(re2::StringPiece((const char *)sstate.value.str(),
-                            sstate.value.decode_length(&dptr)), 
-                            *(m_scan_context->value_regexp))) {
-          m_queue.pop();
-          sstate.scanner->forward();
-          if (sstate.scanner->get(sstate.key, sstate.value))
-            m_queue.push(sstate);
+        if (!m_scan_context->value_matches((const char *)sstate.value.str(),
+                                           sstate.value.decode_length(&dptr))) {
+          m_queue.forward_top();
           continue;
         }
       }
@@ -299,12 +274,10 @@ MergeScannerAccessGroup::do_forward()
 
   sstate = m_queue.top();
 
-  // while the queue is not empty: pop the top element, forward it, 
-  // re-insert it back into the queue
+  // while the queue is not empty: forward the top element and let it
+  // find its new place in the queue
   while (true) {
     while (true) {
-      m_queue.pop();
-
       // In some cases the forward might already be done and so the 
       // scanner shdn't be forwarded again. For example you know a counter 
       // is done only after forwarding to the 1st post counter cell or 
@@ -312,10 +285,7 @@ MergeScannerAccessGroup::do_forward()
       if (m_no_forward)
         m_no_forward = false;
       else
-        sstate.scanner->forward();
-
-      if (sstate.scanner->get(sstate.key, sstate.value))
-        m_queue.push(sstate);
+        m_queue.forward_top();
 
       if (m_queue.empty()) {
         // scan ended on a counter
@@ -530,9 +500,8 @@ MergeScannerAccessGroup::do_forward()
         // filter but value regexp last since its probly the most expensive
         if (m_scan_context->value_regexp && !counter) {
           const uint8_t *dptr;
-          if (!RE2::PartialMatch(re2::StringPiece(sstate.value.str(),
-                            sstate.value.decode_length(&dptr)), 
-                            *(m_scan_context->value_regexp)))
+          if (!m_scan_context->value_matches(sstate.value.str(),
+                                             sstate.value.decode_length(&dptr)))
             continue;
         }
         break;
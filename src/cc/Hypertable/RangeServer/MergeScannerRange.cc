@@ -119,18 +119,14 @@ forward:
     return;
   sstate = m_queue.top();
 
-  // while the queue is not empty: pop the top element, forward it
-  // and then re-insert it back into the queue
+  // while the queue is not empty: forward the top element and let it
+  // find its new place in the queue
   while (true) {
     bool new_row = false;
     bool new_cf = false;
     bool new_cq = false;
 
-    m_queue.pop();
-
-    sstate.scanner->forward();
-    if (sstate.scanner->get(sstate.key, sstate.value))
-      m_queue.push(sstate);
+    m_queue.forward_top();
 
     // empty queue? return to caller
     if (m_queue.empty())
@@ -52,6 +52,7 @@ extern "C" {
 #include "Hypertable/Lib/CommitLog.h"
 #include "Hypertable/Lib/CommitLogReader.h"
 
+#include "AccessGroupCompactionSet.h"
 #include "CellStoreFactory.h"
 #include "Global.h"
 #include "MergeScannerRange.h"
@@ -798,8 +799,10 @@ void Range::relinquish_compact_and_finish() {
      * Perform minor compactions
      */
     std::vector<AccessGroup::Hints> hints(ag_vector.size());
+    AccessGroupCompactionSetPtr compactions = new AccessGroupCompactionSet(false);
     for (size_t i=0; i<ag_vector.size(); i++)
-      ag_vector[i]->run_compaction(MaintenanceFlag::COMPACT_MINOR, &hints[i]);
+      compactions->add(ag_vector[i], MaintenanceFlag::COMPACT_MINOR, &hints[i]);
+    compactions->run();
     m_hints_file.write(hints);
 
     {
@@ -1158,9 +1161,12 @@ void Range::split_compact_and_shrink() {
    * Perform major compactions
    */
   std::vector<AccessGroup::Hints> hints(ag_vector.size());
+  AccessGroupCompactionSetPtr compactions = new AccessGroupCompactionSet(false);
   for (size_t i=0; i<ag_vector.size(); i++)
-    ag_vector[i]->run_compaction(MaintenanceFlag::COMPACT_MAJOR|MaintenanceFlag::SPLIT,
-                                 &hints[i]);
+    compactions->add(ag_vector[i],
+                     MaintenanceFlag::COMPACT_MAJOR|MaintenanceFlag::SPLIT,
+                     &hints[i]);
+  compactions->run();
   m_hints_file.write(hints);
 
   String files;
@@ -1454,6 +1460,7 @@ void Range::compact(MaintenanceFlag::Map &subtask_map) {
 
     // do compactions
     std::vector<AccessGroup::Hints> hints(ag_vector.size());
+    AccessGroupCompactionSetPtr compactions = new AccessGroupCompactionSet(true);
     for (size_t i=0; i<ag_vector.size(); i++) {
 
       if (m_metalog_entity->get_needs_compaction())
@@ -1461,18 +1468,12 @@ void Range::compact(MaintenanceFlag::Map &subtask_map) {
       else
         flags = subtask_map.flags(ag_vector[i].get());
 
-      if (flags & MaintenanceFlag::COMPACT) {
-        try {
-          ag_vector[i]->run_compaction(flags, &hints[i]);
-        }
-        catch (Exception &e) {
-          ag_vector[i]->unstage_compaction();
-          ag_vector[i]->load_hints(&hints[i]);
-        }
-      }
+      if (flags & MaintenanceFlag::COMPACT)
+        compactions->add(ag_vector[i], flags, &hints[i]);
       else
         ag_vector[i]->load_hints(&hints[i]);
     }
+    compactions->run();
     m_hints_file.write(hints);
 
   }
@@ -54,6 +54,7 @@ extern "C" {
 #include "Common/FileUtils.h"
 #include "Common/HashMap.h"
 #include "Common/md5.h"
+#include "Common/Path.h"
 #include "Common/Random.h"
 #include "Common/StringExt.h"
 #include "Common/SystemInfo.h"
@@ -70,6 +71,10 @@ extern "C" {
 
 #include "DfsBroker/Lib/Client.h"
 
+#include "CommitLogReplayer.h"
+#include "CompactionPolicyLeveled.h"
+#include "CompactionPolicyRunLength.h"
+#include "CompactionPolicyTiered.h"
 #include "FillScanBlock.h"
 #include "Global.h"
 #include "GroupCommit.h"
@@ -99,7 +104,9 @@ using namespace Hypertable::Property;
 
 RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
     ApplicationQueuePtr &app_queue, Hyperspace::SessionPtr &hyperspace)
-  : m_update_commit_queue_count(0), m_root_replay_finished(false),
+  : m_update_commit_streams(1), m_update_commit_next_stream(0),
+    m_update_commit_sequence(0), m_update_response_sequence(0),
+    m_root_replay_finished(false),
     m_metadata_replay_finished(false), m_system_replay_finished(false),
     m_replay_finished(false), m_props(props), m_verbose(false),
     m_shutdown(false), m_comm(conn_mgr->get_comm()), m_conn_manager(conn_mgr),
@@ -133,7 +140,9 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   Global::pseudo_tables = PseudoTables::instance();
   m_scanner_buffer_size = cfg.get_i64("Scanner.BufferSize");
   port = cfg.get_i16("Port");
-  m_update_coalesce_limit = cfg.get_i64("UpdateCoalesceLimit");
+  m_update_commit_streams = std::max(cfg.get_i32("CommitLog.Streams"), 1);
+  m_update_commit_queue.resize(m_update_commit_streams);
+  m_update_sync_queue.resize(m_update_commit_streams);
   m_maintenance_pause_interval = cfg.get_i32("Testing.MaintenanceNeeded.PauseInterval");
 
   m_control_file_check_interval = cfg.get_i32("ControlFile.CheckInterval");
@@ -147,6 +156,9 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
     if (maintenance_threads < 2)
       maintenance_threads = 2;
     maintenance_threads = cfg.get_i32("MaintenanceThreads", maintenance_threads);
+    Global::access_group_compaction_concurrency =
+      cfg.get_i32("Maintenance.AccessGroupCompactionConcurrency",
+                  maintenance_threads);
     cout << "drive count = " << disk_count << "\nmaintenance threads = "
         << maintenance_threads << endl;
   }
@@ -156,8 +168,54 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   Global::toplevel_dir = String("/") + Global::toplevel_dir;
 
   Global::merge_cellstore_run_length_threshold = cfg.get_i32("CellStore.Merge.RunLengthThreshold");
+  {
+    String policy = cfg.get_str("CellStore.Merge.Policy");
+    if (policy == "runlength")
+      Global::compaction_policy =
+        new CompactionPolicyRunLength(Global::cellstore_target_size_min,
+                                      Global::cellstore_target_size_max,
+                                      Global::merge_cellstore_run_length_threshold);
+    else if (policy == "leveled")
+      Global::compaction_policy =
+        new CompactionPolicyLeveled(Global::cellstore_target_size_min,
+                                    cfg.get_i32("CellStore.Merge.Leveled.Fanout"),
+                                    Global::merge_cellstore_run_length_threshold);
+    else if (policy == "tiered")
+      Global::compaction_policy =
+        new CompactionPolicyTiered(Global::cellstore_target_size_min,
+                                   cfg.get_i32("CellStore.Merge.Tiered.MinThreshold"),
+                                   cfg.get_i32("CellStore.Merge.Tiered.MaxThreshold"),
+                                   cfg.get_i32("CellStore.Merge.Tiered.BucketWindow"),
+                                   (int64_t)cfg.get_i32("CellStore.Merge.Tiered.MaxAge") * 1000000000LL);
+    else
+      HT_THROWF(Error::CONFIG_BAD_VALUE,
+                "Invalid value for Hypertable.RangeServer.CellStore.Merge.Policy"
+                " (%s), must be runlength, leveled or tiered", policy.c_str());
+  }
   Global::ignore_clock_skew_errors = cfg.get_bool("IgnoreClockSkewErrors");
 
+  Global::subcompaction_max_shards = cfg.get_i32("Maintenance.SubCompaction.MaxShards");
+  Global::subcompaction_min_shard_size = cfg.get_i64("Maintenance.SubCompaction.MinShardSize");
+  if (Global::subcompaction_min_shard_size <= 0)
+    HT_THROWF(Error::CONFIG_BAD_VALUE, "Invalid value for "
+              "Hypertable.RangeServer.Maintenance.SubCompaction.MinShardSize "
+              "(%lld), must be positive",
+              (Lld)Global::subcompaction_min_shard_size);
+
+  {
+    int64_t max_rate = cfg.get_i64("Maintenance.IOThrottle.MaxRate");
+    int64_t min_rate = cfg.get_i64("Maintenance.IOThrottle.MinRate");
+    if (max_rate < 0 || min_rate <= 0)
+      HT_THROWF(Error::CONFIG_BAD_VALUE, "Invalid value for "
+                "Hypertable.RangeServer.Maintenance.IOThrottle.%s, must be "
+                "positive", (max_rate < 0) ? "MaxRate" : "MinRate");
+    if (max_rate && min_rate > max_rate)
+      min_rate = max_rate;
+    Global::maintenance_throttle =
+      new MaintenanceThrottle(max_rate, min_rate,
+                              cfg.get_i64("Maintenance.IOThrottle.Burst"));
+  }
+
   std::vector<int64_t> collector_periods(2);
   int64_t interval = (int64_t)cfg.get_i32("Maintenance.Interval");
   collector_periods[RSStats::STATS_COLLECTOR_MAINTENANCE] = interval;
@@ -229,9 +287,18 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   if (block_cache_min > block_cache_max)
     block_cache_min = block_cache_max;
 
-  if (block_cache_max > 0)
+  if (block_cache_max > 0) {
+    String admission = cfg.get_str("BlockCache.Admission");
+    if (admission != "lru" && admission != "tinylfu")
+      HT_THROWF(Error::CONFIG_BAD_VALUE,
+                "Invalid value for Hypertable.RangeServer.BlockCache.Admission"
+                " (%s), must be lru or tinylfu", admission.c_str());
+    int32_t shards = cfg.get_i32("BlockCache.Shards");
     Global::block_cache = new FileBlockCache(block_cache_min, block_cache_max,
-					     cfg.get_bool("BlockCache.Compressed"));
+					     cfg.get_bool("BlockCache.Compressed"),
+                                             shards > 0 ? (size_t)shards : 1,
+                                             admission == "tinylfu");
+  }
 
   int64_t query_cache_memory = cfg.get_i64("QueryCache.MaxMemory");
   if (query_cache_memory > 0) {
@@ -261,6 +328,18 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
 
   Global::dfs = dfsclient;
 
+  // Resolve the local broker root the same way LocalBroker does
+  if (cfg.get_bool("CellStore.Mmap")) {
+    Path root = props->get_str("DfsBroker.Local.Root", "");
+    if (!root.is_complete()) {
+      Path data_dir = props->get_str("Hypertable.DataDirectory");
+      root = data_dir / root;
+    }
+    Global::cellstore_mmap_root = root.string();
+    HT_INFOF("Memory mapping CellStores from local broker root %s",
+             Global::cellstore_mmap_root.c_str());
+  }
+
   m_log_roll_limit = cfg.get_i64("CommitLog.RollLimit");
 
   m_dropped_table_id_cache = new TableIdCache(50);
@@ -348,8 +427,9 @@ RangeServer::RangeServer(PropertiesPtr &props, ConnectionManagerPtr &conn_mgr,
   // Install maintenance timer
   m_timer_handler = new TimerHandler(m_comm, this);
 
-  // Create "update" threads
-  for (int i=0; i<3; i++)
+  // Create "update" threads, one commit thread and one sync thread per user
+  // commit log stream
+  for (size_t i=0; i<2+2*m_update_commit_streams; i++)
     m_update_threads.push_back( new Thread(UpdateThread(this, i)) );
 
   local_recover();
@@ -393,6 +473,7 @@ void RangeServer::shutdown() {
     m_shutdown = true;
     m_update_qualify_queue_cond.notify_all();
     m_update_commit_queue_cond.notify_all();
+    m_update_sync_queue_cond.notify_all();
     m_update_response_queue_cond.notify_all();
     foreach_ht (Thread *thread, m_update_threads)
       thread->join();
@@ -857,7 +938,8 @@ void RangeServer::local_recover() {
       m_live_map->merge(&replay_map);
 
       Global::user_log = new CommitLog(Global::log_dfs, Global::log_dir
-                                       + "/user", m_props, user_log_reader.get(), false);
+                                       + "/user", m_props, user_log_reader.get(), false,
+                                       m_update_commit_streams);
 
       {
         ScopedLock lock(m_mutex);
@@ -895,7 +977,8 @@ void RangeServer::local_recover() {
             + "/system", m_props, system_log_reader.get());
 
       Global::user_log = new CommitLog(Global::log_dfs, Global::log_dir
-          + "/user", m_props, user_log_reader.get(), false);
+          + "/user", m_props, user_log_reader.get(), false,
+          m_update_commit_streams);
 
       Global::rsml_writer = new MetaLog::Writer(Global::log_dfs, rsml_definition,
                                                 Global::log_dir + "/" + rsml_definition->name(),
@@ -1004,70 +1087,12 @@ RangeServer::replay_load_range(TableInfoMap &replay_map,
 
 void RangeServer::replay_log(TableInfoMap &replay_map,
                              CommitLogReaderPtr &log_reader) {
-  BlockCompressionHeaderCommitLog header;
-  uint8_t *base;
-  size_t len;
-  TableIdentifier table_id;
-  DynamicBuffer dbuf;
-  const uint8_t *ptr, *end;
-  int64_t revision;
-  TableInfoPtr table_info;
-  SerializedKey key;
-  ByteString value;
-  uint32_t block_count = 0;
-
-  while (log_reader->next((const uint8_t **)&base, &len, &header)) {
-
-    revision = header.get_revision();
+  int32_t replay_threads =
+    m_props->get_i32("Hypertable.RangeServer.CommitLog.ReplayThreads",
+                     (int32_t)m_cores);
+  CommitLogReplayer replayer(replay_map, replay_threads);
 
-    ptr = base;
-    end = base + len;
-
-    table_id.decode(&ptr, &len);
-
-    // Fetch table info
-    if (!replay_map.lookup(table_id.id, table_info))
-      continue;
-
-    dbuf.clear();
-    dbuf.ensure(table_id.encoded_length() + 12 + len);
-
-    dbuf.ptr += 4;  // skip size
-    encode_i64(&dbuf.ptr, revision);
-    table_id.encode(&dbuf.ptr);
-    base = dbuf.ptr;
-
-    while (ptr < end) {
-
-      // extract the key
-      key.ptr = ptr;
-      ptr += key.length();
-      if (ptr > end)
-        HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
-
-      // extract the value
-      value.ptr = ptr;
-      ptr += value.length();
-      if (ptr > end)
-        HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
-
-      // Look for containing range, add to stop mods if not found
-      if (!table_info->includes_row(key.row()))
-        continue;
-
-      // add key/value pair to buffer
-      memcpy(dbuf.ptr, key.ptr, ptr-key.ptr);
-      dbuf.ptr += ptr-key.ptr;
-
-    }
-
-    uint32_t block_size = dbuf.ptr - base;
-    base = dbuf.base;
-    encode_i32(&base, block_size);
-
-    replay_update(replay_map, dbuf.base, dbuf.fill());
-    block_count++;
-  }
+  uint32_t block_count = replayer.replay(log_reader.get());
 
   HT_INFOF("Replayed %u blocks of updates from '%s'", block_count,
            log_reader->get_log_dir().c_str());
@@ -1456,7 +1481,13 @@ RangeServer::create_scanner(ResponseCallbackCreateScanner *cb,
 
     uint64_t cells_scanned, cells_returned, bytes_scanned, bytes_returned;
 
-    more = FillScanBlock(scanner, rbuf, m_scanner_buffer_size);
+    // Leave room for the query cache row key and table ID so the block can
+    // be cached and sent without copying it
+    size_t trailer_size = 0;
+    if (cache_key && m_query_cache && !table->is_metadata())
+      trailer_size = strlen(scan_spec->cache_key()) + strlen(table->id) + 2;
+
+    more = FillScanBlock(scanner, rbuf, m_scanner_buffer_size, trailer_size);
 
     MergeScanner *mscanner = dynamic_cast<MergeScanner*>(scanner.get());
 
@@ -1493,18 +1524,18 @@ RangeServer::create_scanner(ResponseCallbackCreateScanner *cb,
     if (cache_key && m_query_cache && !table->is_metadata() && !more) {
       const char *cache_row_key = scan_spec->cache_key();
       char *row_key_ptr, *tablename_ptr;
-      uint8_t *buffer = new uint8_t [ rbuf.fill() + strlen(cache_row_key) + strlen(table->id) + 2 ];
-      memcpy(buffer, rbuf.base, rbuf.fill());
-      row_key_ptr = (char *)buffer + rbuf.fill();
+      size_t block_len;
+      HT_ASSERT(rbuf.remaining() >= trailer_size);
+      row_key_ptr = (char *)rbuf.ptr;
       strcpy(row_key_ptr, cache_row_key);
       tablename_ptr = row_key_ptr + strlen(row_key_ptr) + 1;
       strcpy(tablename_ptr, table->id);
-      boost::shared_array<uint8_t> ext_buffer(buffer);
-      if ((error = cb->response(1, id, ext_buffer, rbuf.fill(),
+      boost::shared_array<uint8_t> ext_buffer(rbuf.release(&block_len));
+      if ((error = cb->response(1, id, ext_buffer, block_len,
              skipped_rows, skipped_cells)) != Error::OK) {
         HT_ERRORF("Problem sending OK response - %s", Error::get_text(error));
       }
-      m_query_cache->insert(cache_key, tablename_ptr, row_key_ptr, ext_buffer, rbuf.fill());
+      m_query_cache->insert(cache_key, tablename_ptr, row_key_ptr, ext_buffer, block_len);
     }
     else {
       short moreflag = more ? 0 : 1;
@@ -2590,6 +2621,14 @@ void RangeServer::update_qualify_and_transform() {
 
     uc->last_revision = m_last_revision;
 
+    // Updates that touch the ROOT, METADATA or system logs are committed by
+    // the stream 0 thread, user-only updates are spread over all streams
+    bool user_only = uc->root_buf.empty();
+    foreach_ht (TableUpdate *table_update, uc->updates) {
+      if (!table_update->id.is_user())
+        user_only = false;
+    }
+
     // Enqueue update
     {
       ScopedLock lock(m_update_commit_queue_mutex);
@@ -2599,18 +2638,22 @@ void RangeServer::update_qualify_and_transform() {
         uc->qualify_time = xtime_diff_millis(uc->start_time, now);
         uc->start_time = now;
       }
-      m_update_commit_queue.push_back(uc);
+      if (user_only) {
+        uc->stream = m_update_commit_next_stream;
+        m_update_commit_next_stream = (m_update_commit_next_stream + 1)
+          % m_update_commit_streams;
+      }
+      uc->sequence = m_update_commit_sequence++;
+      m_update_commit_queue[uc->stream].push_back(uc);
       m_update_commit_queue_cond.notify_all();
-      m_update_commit_queue_count++;
     }
   }
 }
 
-void RangeServer::update_commit() {
+void RangeServer::update_commit(size_t stream) {
   UpdateContext *uc;
   SerializedKey key;
-  std::list<UpdateContext *> coalesce_queue;
-  uint64_t coalesce_amount = 0;
+  std::list<UpdateContext *> response_queue;
   int error = Error::OK;
   uint32_t committed_transfer_data;
   bool user_log_needs_syncing;
@@ -2620,13 +2663,12 @@ void RangeServer::update_commit() {
     // Dequeue next update
     {
       ScopedLock lock(m_update_commit_queue_mutex);
-      while (m_update_commit_queue.empty() && !m_shutdown)
+      while (m_update_commit_queue[stream].empty() && !m_shutdown)
         m_update_commit_queue_cond.wait(lock);
       if (m_shutdown)
         return;
-      uc = m_update_commit_queue.front();
-      m_update_commit_queue.pop_front();
-      m_update_commit_queue_count--;
+      uc = m_update_commit_queue[stream].front();
+      m_update_commit_queue[stream].pop_front();
     }
 
     committed_transfer_data = 0;
@@ -2644,8 +2686,6 @@ void RangeServer::update_commit() {
 
     foreach_ht (TableUpdate *table_update, uc->updates) {
 
-      coalesce_amount += table_update->total_buffer_size;
-
       // Iterate through all of the ranges, committing any transferring updates
       for (hash_map<Range *, RangeUpdateList *>::iterator iter = table_update->range_map.begin(); iter != table_update->range_map.end(); ++iter) {
         if ((*iter).second->transfer_buf.ptr > (*iter).second->transfer_buf.mark) {
@@ -2671,7 +2711,7 @@ void RangeServer::update_commit() {
 
         bool sync = false;
         if (table_update->id.is_user()) {
-          log = Global::user_log;
+          log = Global::user_log->get_stream(stream);
           if ((table_update->flags & RangeServerProtocol::UPDATE_FLAG_NO_LOG_SYNC) == 0)
             user_log_needs_syncing = true;
         }
@@ -2695,54 +2735,85 @@ void RangeServer::update_commit() {
           continue;
         }
       }
-      else if (table_update->sync)
-        user_log_needs_syncing = true;
+      else if (table_update->sync) {
+        // Earlier unsynced updates may sit in any stream, so with several
+        // streams the sync is done once everything before it is committed
+        if (m_update_commit_streams > 1)
+          uc->sync_all_streams = true;
+        else
+          user_log_needs_syncing = true;
+      }
 
     }
 
-    bool do_sync = false;
+    // Hand the update to the stream's sync thread, which syncs on behalf of
+    // everything queued while the previous sync was in flight.  Meanwhile
+    // this thread goes on writing the next update.
     if (user_log_needs_syncing) {
-      if (m_update_commit_queue_count > 0 && coalesce_amount < m_update_coalesce_limit) {
-        coalesce_queue.push_back(uc);
-        continue;
-      }
-      do_sync = true;
-    }
-    else if (!coalesce_queue.empty())
-      do_sync = true;
-
-    // Now sync the USER commit log if needed
-    if (do_sync) {
-      size_t retry_count = 0;
-      uc->total_syncs++;
-      while ((error = Global::user_log->sync()) != Error::OK) {
-        HT_ERRORF("Problem sync'ing user log fragment (%s) - %s",
-                  Global::user_log->get_current_fragment_file().c_str(),
-                  Error::get_text(error));
-        if (++retry_count == 6)
-          break;
-        poll(0, 0, 10000);
-      }
+      ScopedLock lock(m_update_sync_queue_mutex);
+      m_update_sync_queue[stream].push_back(uc);
+      m_update_sync_queue_cond.notify_all();
+      continue;
     }
 
-    // Enqueue update
+    // Enqueue update.  If earlier updates are still waiting on a sync, the
+    // response thread holds this one back until they are done.
+    response_queue.push_back(uc);
+    enqueue_update_responses(response_queue);
+  }
+}
+
+void RangeServer::update_sync(size_t stream) {
+  std::list<UpdateContext *> sync_queue;
+
+  while (true) {
+
+    // Take all of the updates that are waiting, they have all been written
     {
-      ScopedLock lock(m_update_response_queue_mutex);
-      coalesce_queue.push_back(uc);
-      while (!coalesce_queue.empty()) {
-        uc = coalesce_queue.front();
-        if (m_profile_query) {
-          boost::xtime now;
-          boost::xtime_get(&now, TIME_UTC_);
-          uc->commit_time = xtime_diff_millis(uc->start_time, now);
-          uc->start_time = now;
-        }
-        coalesce_queue.pop_front();
-        m_update_response_queue.push_back(uc);
-      }
-      coalesce_amount = 0;
-      m_update_response_queue_cond.notify_all();
+      ScopedLock lock(m_update_sync_queue_mutex);
+      while (m_update_sync_queue[stream].empty() && !m_shutdown)
+        m_update_sync_queue_cond.wait(lock);
+      if (m_shutdown)
+        return;
+      sync_queue.swap(m_update_sync_queue[stream]);
+    }
+
+    // One sync of the USER commit log covers the whole group
+    sync_queue.front()->total_syncs++;
+    sync_user_log(Global::user_log->get_stream(stream));
+
+    enqueue_update_responses(sync_queue);
+  }
+}
+
+void RangeServer::enqueue_update_responses(std::list<UpdateContext *> &ucs) {
+  UpdateContext *uc;
+  ScopedLock lock(m_update_response_queue_mutex);
+  while (!ucs.empty()) {
+    uc = ucs.front();
+    if (m_profile_query) {
+      boost::xtime now;
+      boost::xtime_get(&now, TIME_UTC_);
+      uc->commit_time = xtime_diff_millis(uc->start_time, now);
+      uc->start_time = now;
     }
+    ucs.pop_front();
+    m_update_response_queue[uc->sequence] = uc;
+  }
+  m_update_response_queue_cond.notify_all();
+}
+
+void RangeServer::sync_user_log(CommitLog *log) {
+  size_t retry_count = 0;
+  int error;
+
+  while ((error = log->sync()) != Error::OK) {
+    HT_ERRORF("Problem sync'ing user log fragment (%s) - %s",
+              log->get_current_fragment_file().c_str(),
+              Error::get_text(error));
+    if (++retry_count == 6)
+      break;
+    poll(0, 0, 10000);
   }
 }
 
@@ -2755,13 +2826,25 @@ void RangeServer::update_add_and_respond() {
 
     // Dequeue next update
     {
+      // Updates committed to different streams can complete out of order,
+      // so wait for the next one in sequence
       ScopedLock lock(m_update_response_queue_mutex);
-      while (m_update_response_queue.empty() && !m_shutdown)
+      while ((m_update_response_queue.empty() ||
+              m_update_response_queue.begin()->first != m_update_response_sequence)
+             && !m_shutdown)
         m_update_response_queue_cond.wait(lock);
       if (m_shutdown)
         return;
-      uc = m_update_response_queue.front();
-      m_update_response_queue.pop_front();
+      uc = m_update_response_queue.begin()->second;
+      m_update_response_queue.erase(m_update_response_queue.begin());
+      m_update_response_sequence++;
+    }
+
+    if (uc->sync_all_streams) {
+      for (size_t i=0; i<Global::user_log->get_stream_count(); i++) {
+        uc->total_syncs++;
+        sync_user_log(Global::user_log->get_stream(i));
+      }
     }
 
     /**
@@ -3207,6 +3290,20 @@ void RangeServer::get_statistics(ResponseCallbackGetStatistics *cb) {
     m_stats->block_cache_hits = 0;
   }
 
+  m_stats->maintenance_io.clear();
+  if (Global::maintenance_throttle) {
+    std::vector<MaintenanceThrottle::TaskStats> task_stats;
+    Global::maintenance_throttle->get_stats(task_stats);
+    m_stats->maintenance_io_rate = Global::maintenance_throttle->get_rate();
+    for (size_t i=0; i<task_stats.size(); i++) {
+      StatsMaintenanceIO io;
+      io.task = MaintenanceThrottle::task_name(i);
+      io.read_bytes = task_stats[i].read_bytes;
+      io.write_bytes = task_stats[i].write_bytes;
+      io.throttled_millis = task_stats[i].throttled_micros / 1000;
+      m_stats->maintenance_io.push_back(io);
+    }
+  }
 
   TableMutatorPtr mutator;
   if (now > m_next_metrics_update) {
@@ -3414,100 +3511,6 @@ void RangeServer::get_statistics(ResponseCallbackGetStatistics *cb) {
 }
 
 
-void
-RangeServer::replay_update(TableInfoMap &replay_map,
-                           const uint8_t *data, size_t len) {
-  TableIdentifier table_identifier;
-  TableInfoPtr table_info;
-  SerializedKey serkey;
-  ByteString bsvalue;
-  Key key;
-  const uint8_t *ptr = data;
-  const uint8_t *end = data + len;
-  const uint8_t *block_end;
-  uint32_t block_size;
-  size_t remaining = len;
-  const char *row;
-  String err_msg;
-  int64_t revision;
-  RangePtr range;
-  String start_row, end_row;
-
-  //HT_DEBUGF("replay_update - length=%ld", len);
-
-  try {
-
-    while (ptr < end) {
-
-      // decode key/value block size + revision
-      block_size = decode_i32(&ptr, &remaining);
-      revision = decode_i64(&ptr, &remaining);
-
-      // decode table identifier
-      table_identifier.decode(&ptr, &remaining);
-
-      if (block_size > remaining)
-        HT_THROWF(Error::MALFORMED_REQUEST, "Block (size=%lu) exceeds EOM",
-                  (Lu)block_size);
-
-      block_end = ptr + block_size;
-
-      // Fetch table info
-      if (!replay_map.lookup(table_identifier.id, table_info))
-        HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND, "Unable to find "
-                  "table info for table name='%s'",
-                  table_identifier.id);
-
-      while (ptr < block_end) {
-
-        row = SerializedKey(ptr).row();
-
-        // Look for containing range, add to stop mods if not found
-        if (!table_info->find_containing_range(row, range, start_row, end_row))
-          HT_THROWF(Error::RANGESERVER_RANGE_NOT_FOUND, "Unable to find "
-                    "range for row '%s'", row);
-
-        serkey.ptr = ptr;
-
-        while (ptr < block_end && (end_row.empty() || (strcmp(row, end_row.c_str()) <= 0))) {
-
-          // extract the key
-          ptr += serkey.length();
-
-          if (ptr > end)
-            HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding key");
-
-          bsvalue.ptr = ptr;
-          ptr += bsvalue.length();
-
-          if (ptr > end)
-            HT_THROW(Error::REQUEST_TRUNCATED, "Problem decoding value");
-
-          key.load(serkey);
-
-          {
-            Locker<Range> lock(*range);
-            range->add(key, bsvalue);
-          }
-          serkey.ptr = ptr;
-
-          if (ptr < block_end)
-            row = serkey.row();
-        }
-      }
-    }
-
-  }
-  catch (Exception &e) {
-    if (e.code() == Error::RANGESERVER_RANGE_NOT_FOUND)
-      HT_INFOF("Range not found - %s", e.what());
-    else
-      HT_ERROR_OUT << e << HT_END;
-    HT_THROW(e.code(), e.what());
-  }
-}
-
-
 void
 RangeServer::drop_range(ResponseCallback *cb, const TableIdentifier *table,
         const RangeSpec *range_spec) {
@@ -4419,6 +4422,14 @@ void RangeServer::do_maintenance() {
     // Recompute stats
     m_server_stats->recompute(RSStats::STATS_COLLECTOR_MAINTENANCE);
 
+    // Leave the foreground scans their share of the I/O bandwidth
+    {
+      int collector_id = RSStats::STATS_COLLECTOR_MAINTENANCE;
+      int64_t period_millis = m_server_stats->get_measurement_period(collector_id);
+      if (period_millis > 0)
+        Global::maintenance_throttle->adjust((int64_t)((m_server_stats->get_scan_bytes(collector_id) * 1000) / period_millis));
+    }
+
     // Schedule maintenance
     m_maintenance_scheduler->schedule();
 
@@ -196,8 +196,11 @@ namespace Hypertable {
     friend class UpdateThread;
 
     void update_qualify_and_transform();
-    void update_commit();
+    void update_commit(size_t stream);
+    void update_sync(size_t stream);
+    size_t get_update_commit_streams() { return m_update_commit_streams; }
     void update_add_and_respond();
+    void sync_user_log(CommitLog *log);
 
   private:
 
@@ -210,7 +213,6 @@ namespace Hypertable {
     void replay_load_range(TableInfoMap &replay_map,
                            MetaLogEntityRange *range_entity);
     void replay_log(TableInfoMap &replay_map, CommitLogReaderPtr &log_reader);
-    void replay_update(TableInfoMap &replay_map, const uint8_t *data, size_t len);
 
     void verify_schema(TableInfoPtr &, uint32_t generation, const TableSchemaMap *table_schemas=0);
     void transform_key(ByteString &bskey, DynamicBuffer *dest_bufp,
@@ -223,7 +225,8 @@ namespace Hypertable {
     class UpdateContext {
     public:
       UpdateContext(std::vector<TableUpdate *> &tu, boost::xtime xt) : updates(tu), expire_time(xt),
-          total_updates(0), total_added(0), total_syncs(0), total_bytes_added(0) { }
+          total_updates(0), total_added(0), total_syncs(0), total_bytes_added(0),
+          stream(0), sequence(0), sync_all_streams(false) { }
       ~UpdateContext() {
         foreach_ht(TableUpdate *u, updates)
           delete u;
@@ -242,18 +245,29 @@ namespace Hypertable {
       uint32_t qualify_time;
       uint32_t commit_time;
       uint32_t add_time;
+      size_t stream;
+      uint64_t sequence;
+      bool sync_all_streams;
     };
 
+    void enqueue_update_responses(std::list<UpdateContext *> &ucs);
+
     Mutex                      m_update_qualify_queue_mutex;
     boost::condition           m_update_qualify_queue_cond;
     std::list<UpdateContext *> m_update_qualify_queue;
     Mutex                      m_update_commit_queue_mutex;
     boost::condition           m_update_commit_queue_cond;
-    int32_t                    m_update_commit_queue_count;
-    std::list<UpdateContext *> m_update_commit_queue;
+    std::vector<std::list<UpdateContext *> > m_update_commit_queue;
+    size_t                     m_update_commit_streams;
+    size_t                     m_update_commit_next_stream;
+    uint64_t                   m_update_commit_sequence;
+    Mutex                      m_update_sync_queue_mutex;
+    boost::condition           m_update_sync_queue_cond;
+    std::vector<std::list<UpdateContext *> > m_update_sync_queue;
     Mutex                      m_update_response_queue_mutex;
     boost::condition           m_update_response_queue_cond;
-    std::list<UpdateContext *> m_update_response_queue;
+    std::map<uint64_t, UpdateContext *> m_update_response_queue;
+    uint64_t                   m_update_response_sequence;
     std::vector<Thread *>      m_update_threads;
 
     Mutex                  m_mutex;
@@ -287,7 +301,6 @@ namespace Hypertable {
     int32_t                m_max_clock_skew;
     uint64_t               m_bytes_loaded;
     uint64_t               m_log_roll_limit;
-    uint64_t               m_update_coalesce_limit;
     TableIdCachePtr        m_dropped_table_id_cache;
 
     StatsRangeServerPtr    m_stats;
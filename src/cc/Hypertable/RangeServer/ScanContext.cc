@@ -35,65 +35,6 @@ using namespace std;
 using namespace Hypertable;
 
 
-const uint8_t* CellFilterInfo::memfind(
-  const uint8_t* block,        // Block containing data
-  size_t         block_size,   // Size of block in bytes
-  const uint8_t* pattern,      // Pattern to search for
-  size_t         pattern_size, // Size of pattern block
-  size_t*        shift,        // Shift table (search buffer)
-  bool*          repeat_find)  // true: search buffer already init
-{
-  assert(block);
-  assert(pattern);
-  assert(shift);
-  if (block == 0 || pattern == 0 || shift == 0)
-    return 0;
-
-  // Pattern must be smaller or equal in size to string
-  if (block_size < pattern_size)
-    return 0;
-
-  if (pattern_size == 0)
-    return block;
-
-  // Build the shift table unless we're continuing a previous search.
-  // The shift table determines how far to shift before trying to match
-  // again, if a match at this point fails.  If the byte after where the
-  // end of our pattern falls is not in our pattern, then we start to
-  // match again after that byte; otherwise we line up the last occurence 
-  // of that byte in our pattern under that byte, and try match again.
-  if (!repeat_find || !*repeat_find) {
-    for (size_t byte_nbr = 0; byte_nbr < 256; byte_nbr++)
-      shift[byte_nbr] = pattern_size + 1;
-    for (size_t byte_nbr = 0; byte_nbr < pattern_size; byte_nbr++)
-      shift[(uint8_t) pattern[byte_nbr]] = pattern_size - byte_nbr;
-
-    if (repeat_find)
-      *repeat_find = true;
-  }
-
-  // Search for the block, each time jumping up by the amount
-  // computed in the shift table
-  const uint8_t* limit = block + (block_size - pattern_size + 1);
-  assert(limit > block);
-
-  for (const uint8_t* match_base = block;
-    match_base < limit;
-    match_base += shift[*(match_base + pattern_size)]) {
-    const uint8_t* match_ptr  = match_base;
-    size_t match_size = 0;
-    // Compare pattern until it all matches, or we find a difference
-    while (*match_ptr++ == pattern[match_size++]) {
-      assert(match_size <= pattern_size && match_ptr == (match_base + match_size));
-
-      // If we found a match, return the start address
-      if (match_size >= pattern_size)
-        return match_base;
-    }
-  }
-  return 0;
-}
-
 void
 ScanContext::initialize(int64_t rev, const ScanSpec *ss,
     const RangeSpec *range_spec, SchemaPtr &sp) {
@@ -221,6 +162,7 @@ ScanContext::initialize(int64_t rev, const ScanSpec *ss,
   has_start_cf_qualifier = false;
   start_inclusive = end_inclusive = true;
   restricted_range = true;
+  compaction = false;
 
   if (spec) {
     const char *ptr = 0;
@@ -425,6 +367,12 @@ ScanContext::initialize(int64_t rev, const ScanSpec *ss,
         HT_THROW(Error::BAD_SCAN_SPEC, (String)"Can't convert value_regexp "
             + spec->value_regexp + " to regexp -" + value_regexp->error_arg());
       }
+      // a regexp without metacharacters is a plain substring search
+      if (strpbrk(spec->value_regexp, "\\.^$|?*+()[]{}") == 0) {
+        value_regexp_literal = true;
+        value_search.set_pattern(spec->value_regexp,
+                                 strlen(spec->value_regexp));
+      }
     }
 
     foreach_ht (const ColumnPredicate& cp, spec->column_predicates) {
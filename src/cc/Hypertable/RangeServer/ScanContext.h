@@ -32,6 +32,7 @@
 #include "Common/Error.h"
 #include "Common/ReferenceCount.h"
 #include "Common/StringExt.h"
+#include "Common/SubstringSearch.h"
 
 #include "Hypertable/Lib/Key.h"
 #include "Hypertable/Lib/Schema.h"
@@ -63,7 +64,7 @@ namespace Hypertable {
       }
       prefix_qualifiers = other.prefix_qualifiers;
       column_predicates = other.column_predicates;
-      search_buf_column_predicates = other.search_buf_column_predicates;
+      column_predicate_searches = other.column_predicate_searches;
       filter_by_exact_qualifier = other.filter_by_exact_qualifier;
       filter_by_prefix_qualifier = other.filter_by_prefix_qualifier;
       filter_by_regexp_qualifier = other.filter_by_regexp_qualifier;
@@ -141,7 +142,7 @@ namespace Hypertable {
     bool has_qualifier_regexp_filter() const { return filter_by_regexp_qualifier;}
 
     bool column_predicate_matches(const char* value, uint32_t value_len) {
-      int ncp = 0;
+      size_t ncp = 0;
       foreach_ht (const ColumnPredicate& cp, column_predicates) {
         if (cp.value && value) {
           switch (cp.operation) {
@@ -156,15 +157,8 @@ namespace Hypertable {
                 return true;
               break;
             case Hypertable::ColumnPredicate::CONTAINS:
-              if (cp.value_len <= value_len) {
-                while (search_buf_column_predicates.size() < column_predicates.size()) {
-                  search_buf_column_predicates.push_back(search_buf_t());
-                }
-                search_buf_t& buf = search_buf_column_predicates[ncp];
-                if (memfind((const uint8_t*)value, value_len, (const uint8_t*)cp.value,
-                      cp.value_len, buf.shift, &buf.repeat) != 0)
-                  return true;
-              }
+              if (column_predicate_searches[ncp].matches(value, value_len))
+                return true;
               break;
             default:
               break;
@@ -179,6 +173,9 @@ namespace Hypertable {
 
     void add_column_predicate( const ColumnPredicate& cp ) {
       column_predicates.push_back( cp );
+      column_predicate_searches.push_back(SubstringSearch());
+      if (cp.operation == ColumnPredicate::CONTAINS && cp.value)
+        column_predicate_searches.back().set_pattern(cp.value, cp.value_len);
     }
 
     bool has_column_predicate_filter( ) const {
@@ -201,24 +198,11 @@ namespace Hypertable {
     CstrSet exact_qualifiers_set;
     StringSet prefix_qualifiers;
     std::vector<ColumnPredicate> column_predicates;
-    struct search_buf_t {
-      size_t shift[256];
-      bool repeat;
-      search_buf_t() : repeat( false ) { }
-    };
-    std::vector<search_buf_t> search_buf_column_predicates;
+    // CONTAINS searches, parallel to column_predicates
+    std::vector<SubstringSearch> column_predicate_searches;
     bool filter_by_exact_qualifier;
     bool filter_by_regexp_qualifier;
     bool filter_by_prefix_qualifier;
-
-    // Searches for a pattern in a block of memory using the Boyer- Moore-Horspool-Sunday algorithm
-    static const uint8_t* memfind(
-      const uint8_t* block,        // Block containing data
-      size_t         block_size,   // Size of block in bytes
-      const uint8_t* pattern,      // Pattern to search for
-      size_t         pattern_size, // Size of pattern block
-      size_t*        shift,        // Shift table (search buffer)
-      bool*          repeat_find); // true, search buffer already initialized
   };
 
   /**
@@ -241,12 +225,17 @@ namespace Hypertable {
     bool has_cell_interval;
     bool has_start_cf_qualifier;
     bool restricted_range;
+    /** Scan feeds a compaction; cell stores are read with readahead,
+     * bypassing the block cache and memory mappings */
+    bool compaction;
     int64_t revision;
     pair<int64_t, int64_t> time_interval;
     bool family_mask[256];
     vector<CellFilterInfo> family_info;
     RE2 *row_regexp;
     RE2 *value_regexp;
+    bool value_regexp_literal;
+    SubstringSearch value_search;
     typedef std::set<const char *, LtCstr, CstrAlloc> CstrRowSet;
     CstrRowSet rowset;
     uint32_t timeout_ms;
@@ -261,7 +250,9 @@ namespace Hypertable {
      */
     ScanContext(int64_t rev, const ScanSpec *ss, const RangeSpec *range,
                 SchemaPtr &schema) : family_info(256), row_regexp(0),
-                                     value_regexp(0), timeout_ms(0) {
+                                     value_regexp(0),
+                                     value_regexp_literal(false),
+                                     timeout_ms(0) {
       initialize(rev, ss, range, schema);
     }
 
@@ -272,7 +263,8 @@ namespace Hypertable {
      * @param schema smart pointer to schema object
      */
     ScanContext(int64_t rev, SchemaPtr &schema)
-      : family_info(256), row_regexp(0), value_regexp(0), timeout_ms(0) {
+      : family_info(256), row_regexp(0), value_regexp(0),
+        value_regexp_literal(false), timeout_ms(0) {
       initialize(rev, 0, 0, schema);
     }
 
@@ -282,7 +274,8 @@ namespace Hypertable {
      * @param rev scan revision
      */
     ScanContext(int64_t rev=TIMESTAMP_MAX) 
-      : family_info(256), row_regexp(0), value_regexp(0), timeout_ms(0) {
+      : family_info(256), row_regexp(0), value_regexp(0),
+        value_regexp_literal(false), timeout_ms(0) {
       SchemaPtr schema;
       initialize(rev, 0, 0, schema);
     }
@@ -293,7 +286,8 @@ namespace Hypertable {
      * @param schema smart pointer to schema object
      */
     ScanContext(SchemaPtr &schema) 
-      : family_info(256), row_regexp(0), value_regexp(0), timeout_ms(0) {
+      : family_info(256), row_regexp(0), value_regexp(0),
+        value_regexp_literal(false), timeout_ms(0) {
       initialize(TIMESTAMP_MAX, 0, 0, schema);
     }
 
@@ -306,6 +300,20 @@ namespace Hypertable {
       }
     }
 
+    /**
+     * Checks if a value matches the value regexp.  A regexp without any
+     * metacharacters is matched with a substring search instead of RE2.
+     *
+     * @param value pointer to value
+     * @param len length of value
+     * @return <i>true</i> if the value matches
+     */
+    bool value_matches(const char *value, size_t len) const {
+      if (value_regexp_literal)
+        return value_search.matches(value, len);
+      return RE2::PartialMatch(re2::StringPiece(value, len), *value_regexp);
+    }
+
     void deep_copy_specs() {
       scan_spec_builder = *spec;
       spec = &scan_spec_builder.get();
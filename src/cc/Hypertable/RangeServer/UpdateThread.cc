@@ -37,7 +37,14 @@ void UpdateThread::operator()() {
       m_range_server->update_add_and_respond();
       break;
     default:
-      m_range_server->update_commit();
+      {
+        size_t streams = m_range_server->get_update_commit_streams();
+        size_t i = m_sequence_number - 2;
+        if (i < streams)
+          m_range_server->update_commit(i);
+        else
+          m_range_server->update_sync(i - streams);
+      }
     }
   }
   catch (Exception &e) {
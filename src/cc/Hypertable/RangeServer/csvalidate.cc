@@ -52,8 +52,10 @@
 #include "CellStore.h"
 #include "CellStoreFactory.h"
 #include "CellStoreTrailerV6.h"
+#include "CellStoreTrailerV7.h"
 #include "Global.h"
 #include "KeyDecompressorPrefix.h"
+#include "KeyDecompressorPrefixRestart.h"
 
 using namespace Hypertable;
 using namespace Config;
@@ -139,7 +141,9 @@ namespace {
     remaining = 2;
     version = Serialization::decode_i16(&ptr, &remaining);
 
-    if (version == 6)
+    if (version == 7)
+      state.trailer = new CellStoreTrailerV7();
+    else if (version == 6)
       state.trailer = new CellStoreTrailerV6();
     else {
       cout << "unsupported CellStore version (" << version << ")" << endl;
@@ -152,7 +156,10 @@ namespace {
 
     uint16_t compression_type = boost::any_cast<uint16_t>(state.trailer->get("compression_type"));
     state.compressor = CompressorFactory::create_block_codec((BlockCompressionCodec::Type)compression_type);
-    state.key_decompressor = new KeyDecompressorPrefix();
+    if (version == 7)
+      state.key_decompressor = new KeyDecompressorPrefixRestart();
+    else
+      state.key_decompressor = new KeyDecompressorPrefix();
   }
   
 
@@ -225,6 +232,8 @@ namespace {
     int64_t filter_items_actual = boost::any_cast<int64_t>(state.trailer->get("filter_items_actual"));
     uint8_t bloom_filter_hash_count = boost::any_cast<uint8_t>(state.trailer->get("bloom_filter_hash_count"));
     uint8_t bloom_filter_mode = boost::any_cast<uint8_t>(state.trailer->get("bloom_filter_mode"));
+    uint32_t flags = boost::any_cast<uint32_t>(state.trailer->get("flags"));
+    BloomFilterWithChecksum::Mode mode = BloomFilterWithChecksum::STANDARD;
 
     if ((BloomFilterMode)bloom_filter_mode == BLOOM_FILTER_DISABLED) {
       state.bloom_filter = 0;
@@ -238,8 +247,13 @@ namespace {
 
     HT_ASSERT((BloomFilterMode)bloom_filter_mode == BLOOM_FILTER_ROWS);
 
+    if (boost::any_cast<uint16_t>(state.trailer->get("version")) >= 7)
+      if (flags & CellStoreTrailerV7::BLOCKED_BLOOM_FILTER)
+        mode = BloomFilterWithChecksum::BLOCKED;
+
     state.bloom_filter = new BloomFilterWithChecksum(filter_items_actual, filter_items_actual,
-                                                     filter_length, bloom_filter_hash_count);
+                                                     filter_length, bloom_filter_hash_count,
+                                                     mode);
     memcpy(state.bloom_filter->base(), state.base+filter_offset, state.bloom_filter->total_size());
     try {
       state.bloom_filter->validate(state.fname);
@@ -316,11 +330,19 @@ namespace {
       ByteString value;
       BlockEntry be;
       const uint8_t *ptr;
-      const uint8_t *end = buf.base + buf.fill();
+      const uint8_t *end;
 
       be.sequence = sequence;
       be.offset = offset;
 
+      try {
+        end = state.key_decompressor->load_block(buf.base,
+                                                 buf.base + buf.fill());
+      }
+      catch (Exception &e) {
+        return false;
+      }
+
       state.key_decompressor->reset();
       value.ptr = state.key_decompressor->add(buf.base);
       ptr = value.ptr + value.length();
@@ -37,6 +37,7 @@
 #include "AsyncComm/ConnectionManager.h"
 #include "AsyncComm/ReactorFactory.h"
 #include "AsyncComm/ReactorRunner.h"
+#include "AsyncComm/WorkStealingApplicationQueue.h"
 
 #include "Config.h"
 #include "ConnectionHandler.h"
@@ -81,7 +82,11 @@ int main(int argc, char **argv) {
     Global::conn_manager = conn_manager;
 
     int worker_count = get_i32("Hypertable.RangeServer.Workers");
-    ApplicationQueuePtr app_queue = new ApplicationQueue(worker_count);
+    ApplicationQueuePtr app_queue;
+    if (get_bool("Comm.UseWorkStealingQueue"))
+      app_queue = new WorkStealingApplicationQueue(worker_count);
+    else
+      app_queue = new ApplicationQueue(worker_count);
 
     /**
      * Connect to Hyperspace
@@ -0,0 +1,260 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Config.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Init.h"
+#include "Common/Thread.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../CellCache.h"
+#include "../CellCacheSkipList.h"
+#include "../Global.h"
+#include "../MemoryTracker.h"
+
+using namespace Hypertable;
+using namespace Config;
+using namespace std;
+
+namespace {
+
+  const char *schema_str =
+  "<Schema>\n"
+  "  <AccessGroup name=\"default\" cellCache=\"skiplist\">\n"
+  "    <ColumnFamily id=\"1\">\n"
+  "      <Generation>1</Generation>\n"
+  "      <Name>tag</Name>\n"
+  "    </ColumnFamily>\n"
+  "  </AccessGroup>\n"
+  "</Schema>";
+
+  const int NUM_WRITERS = 4;
+  const int NUM_CELLS = 40000;
+
+  struct TestCell {
+    DynamicBuffer key;
+    DynamicBuffer value;
+  };
+
+  vector<TestCell *> cells;
+
+  void make_cell(TestCell *cell, int row, int64_t revision, const char *value) {
+    char row_buf[32];
+    sprintf(row_buf, "row%08d", row);
+    create_key_and_append(cell->key, FLAG_INSERT, row_buf, 1, "q",
+                          revision, revision);
+    append_as_byte_string(cell->value, value, strlen(value));
+  }
+
+  void add_cell(CellCache *cache, TestCell *cell) {
+    Key key;
+    ByteString value;
+    key.load(SerializedKey(cell->key.base));
+    value.ptr = cell->value.base;
+    cache->add(key, value);
+  }
+
+  class Writer {
+  public:
+    Writer(CellCache *cache, int id) : m_cache(cache), m_id(id) { }
+    void operator()() {
+      for (size_t i=m_id; i<cells.size(); i+=NUM_WRITERS)
+        add_cell(m_cache, cells[i]);
+    }
+  private:
+    CellCache *m_cache;
+    int m_id;
+  };
+
+  /**
+   * Scans the cache while writers are running and verifies that the cells
+   * come back in strictly ascending order.
+   */
+  class Reader {
+  public:
+    Reader(CellCache *cache, SchemaPtr &schema)
+      : m_cache(cache), m_schema(schema) { }
+    void operator()() {
+      for (int i=0; i<20; i++) {
+        ScanContextPtr scan_ctx = new ScanContext(m_schema);
+        CellListScannerPtr scanner = m_cache->create_scanner(scan_ctx);
+        Key key;
+        ByteString value;
+        SerializedKey last;
+        while (scanner->get(key, value)) {
+          if (last.ptr && last.compare(key.serial) >= 0) {
+            HT_ERROR("Skip list scanner returned keys out of order");
+            _exit(1);
+          }
+          last = key.serial;
+          scanner->forward();
+        }
+      }
+    }
+  private:
+    CellCache *m_cache;
+    SchemaPtr m_schema;
+  };
+
+  const int HEIGHT_ROUNDS = 500;
+  const int HEIGHT_CELLS = 2000;
+
+  /**
+   * Adds its share of <code>cells</code> to a fresh list once all writers
+   * are ready, so that the list height is raised while other writers are
+   * in the middle of an insert.
+   */
+  class HeightWriter {
+  public:
+    HeightWriter(CellCache *cache, boost::barrier *barrier, size_t count,
+                 int id)
+      : m_cache(cache), m_barrier(barrier), m_count(count), m_id(id) { }
+    void operator()() {
+      m_barrier->wait();
+      for (size_t i=m_id; i<m_count; i+=NUM_WRITERS)
+        add_cell(m_cache, cells[i]);
+    }
+  private:
+    CellCache *m_cache;
+    boost::barrier *m_barrier;
+    size_t m_count;
+    int m_id;
+  };
+
+  /**
+   * Verifies that every level of <code>skip_list</code> is ordered and
+   * that a search through the upper levels finds every cell.
+   */
+  void check_levels(CellCacheSkipList *skip_list) {
+    CellCacheSkipList::Node *node;
+    size_t count = 0;
+    for (node = skip_list->first(); node; node = node->next[0]) {
+      HT_ASSERT(node->height >= 1 &&
+                node->height <= CellCacheSkipList::MAX_HEIGHT);
+      for (int i=0; i<node->height; i++) {
+        CellCacheSkipList::Node *next = node->next[i];
+        HT_ASSERT(next == 0 || SerializedKey(node->entry).compare(
+                      SerializedKey(next->entry)) < 0);
+      }
+      HT_ASSERT(skip_list->lower_bound(SerializedKey(node->entry)) == node);
+      count++;
+    }
+    HT_ASSERT(count == skip_list->size());
+  }
+
+  void compare_scans(CellCache *expected, CellCache *actual,
+                     SchemaPtr &schema) {
+    ScanContextPtr scan_ctx = new ScanContext(schema);
+    CellListScannerPtr expected_scanner = expected->create_scanner(scan_ctx);
+    CellListScannerPtr actual_scanner = actual->create_scanner(scan_ctx);
+    Key expected_key, actual_key;
+    ByteString expected_value, actual_value;
+    size_t count = 0;
+
+    while (expected_scanner->get(expected_key, expected_value)) {
+      HT_ASSERT(actual_scanner->get(actual_key, actual_value));
+      HT_ASSERT(expected_key.serial == actual_key.serial);
+      HT_ASSERT(expected_value.length() == actual_value.length() &&
+                !memcmp(expected_value.ptr, actual_value.ptr,
+                        expected_value.length()));
+      expected_scanner->forward();
+      actual_scanner->forward();
+      count++;
+    }
+    HT_ASSERT(!actual_scanner->get(actual_key, actual_value));
+    HT_ASSERT(count == expected->size());
+    HT_ASSERT(count == actual->size());
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  init_with_policy<DefaultPolicy>(argc, argv);
+
+  Global::memory_tracker = new MemoryTracker(0, 0);
+  Global::cell_cache_scanner_cache_size =
+    properties->get_i32("Hypertable.RangeServer.AccessGroup.CellCache.ScannerCacheSize");
+
+  SchemaPtr schema = Schema::new_instance(schema_str, strlen(schema_str));
+  if (!schema->is_valid()) {
+    HT_ERRORF("Schema Parse Error: %s", schema->get_error_string());
+    return 1;
+  }
+  HT_ASSERT(schema->get_access_group("default")->cell_cache == "skiplist");
+
+  srandom(1);
+  for (int i=0; i<NUM_CELLS; i++) {
+    TestCell *cell = new TestCell();
+    make_cell(cell, random() % (NUM_CELLS/4), i+1, "value");
+    cells.push_back(cell);
+  }
+
+  CellCachePtr map_cache = new CellCache();
+  CellCachePtr skip_list = new CellCacheSkipList();
+
+  for (size_t i=0; i<cells.size(); i++)
+    add_cell(map_cache.get(), cells[i]);
+
+  {
+    ThreadGroup threads;
+    threads.create_thread(Reader(skip_list.get(), schema));
+    for (int i=0; i<NUM_WRITERS; i++)
+      threads.create_thread(Writer(skip_list.get(), i));
+    threads.join_all();
+  }
+
+  compare_scans(map_cache.get(), skip_list.get(), schema);
+
+  // Writers racing on a fresh list raise its height concurrently
+  for (int round=0; round<HEIGHT_ROUNDS; round++) {
+    CellCacheSkipListPtr fresh = new CellCacheSkipList();
+    boost::barrier barrier(NUM_WRITERS);
+    ThreadGroup threads;
+    for (int i=0; i<NUM_WRITERS; i++)
+      threads.create_thread(HeightWriter(fresh.get(), &barrier,
+                                         HEIGHT_CELLS, i));
+    threads.join_all();
+    check_levels(fresh.get());
+  }
+
+  // Inserting an existing key replaces its value
+  TestCell update;
+  make_cell(&update, 0, NUM_CELLS+1, "first");
+  add_cell(map_cache.get(), &update);
+  add_cell(skip_list.get(), &update);
+  update.value.clear();
+  append_as_byte_string(update.value, "second", 6);
+  add_cell(map_cache.get(), &update);
+  add_cell(skip_list.get(), &update);
+
+  compare_scans(map_cache.get(), skip_list.get(), schema);
+
+  for (size_t i=0; i<cells.size(); i++)
+    delete cells[i];
+
+  return 0;
+}
@@ -0,0 +1,144 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "Hypertable/Lib/Key.h"
+
+#include "../CellStoreBlockIndexArray.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const int NUM_BLOCKS = 8;
+  const int KEYS_PER_BLOCK = 10;
+  const int BLOCK_SIZE = 1000;
+
+  /**
+   * Builds the fixed, variable and block stats index buffers the way
+   * CellStoreV7 does for NUM_BLOCKS blocks.  Block <i>i</i> holds keys with
+   * timestamps [100*i, 100*i+KEYS_PER_BLOCK) and revisions offset by 1000.
+   * Block 6 also starts with a row delete at timestamp and revision 5.
+   */
+  void build_index(DynamicBuffer &fixed, DynamicBuffer &variable,
+                   DynamicBuffer &stats) {
+    char row[32];
+    DynamicBuffer key_buf;
+    Key key;
+
+    for (int i=0; i<NUM_BLOCKS; i++) {
+      CellStoreBlockStats block_stats;
+      sprintf(row, "row-%02d", i);
+      if (i == 6) {
+        key_buf.clear();
+        create_key_and_append(key_buf, FLAG_DELETE_ROW, row, 0, "", 5, 5);
+        key.load(SerializedKey(key_buf.base));
+        block_stats.update(key);
+      }
+      for (int j=0; j<KEYS_PER_BLOCK; j++) {
+        key_buf.clear();
+        create_key_and_append(key_buf, FLAG_INSERT, row, 1, "",
+                              100*i + j, 1000 + 100*i + j);
+        key.load(SerializedKey(key_buf.base));
+        block_stats.update(key);
+      }
+      // the index entry holds the last key of the block
+      variable.add(key_buf.base, key_buf.fill());
+      uint32_t offset = i * BLOCK_SIZE;
+      fixed.add(&offset, sizeof(offset));
+      stats.ensure(CellStoreBlockStats::ENCODED_LENGTH);
+      block_stats.encode(&stats.ptr);
+    }
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  DynamicBuffer fixed, variable, stats;
+  CellStoreBlockIndexArray<uint32_t> index;
+  const CellStoreBlockStats *block_stats;
+
+  build_index(fixed, variable, stats);
+  index.load(fixed, variable, NUM_BLOCKS * BLOCK_SIZE, "", "", &stats);
+  HT_ASSERT(index.index_entries() == NUM_BLOCKS);
+
+  for (int i=0; i<NUM_BLOCKS; i++) {
+    block_stats = index.block_stats(i * BLOCK_SIZE);
+    HT_ASSERT(block_stats);
+    HT_ASSERT(block_stats->timestamp_min == 100*i);
+    HT_ASSERT(block_stats->timestamp_max == 100*i + KEYS_PER_BLOCK - 1);
+    HT_ASSERT(block_stats->revision_min == 1000 + 100*i);
+    HT_ASSERT(block_stats->revision_max == 1000 + 100*i + KEYS_PER_BLOCK - 1);
+  }
+  HT_ASSERT(index.block_stats(BLOCK_SIZE / 2) == 0);
+  HT_ASSERT(index.block_stats(NUM_BLOCKS * BLOCK_SIZE) == 0);
+
+  // Block 2 holds timestamps [200,209] and revisions [1200,1209]
+  block_stats = index.block_stats(2 * BLOCK_SIZE);
+  HT_ASSERT(!block_stats->has_deletes);
+  HT_ASSERT(!block_stats->excludes(TIMESTAMP_MIN, TIMESTAMP_MAX,
+                                   TIMESTAMP_MAX));
+  HT_ASSERT(!block_stats->excludes(209, 210, TIMESTAMP_MAX));
+  HT_ASSERT(block_stats->excludes(210, TIMESTAMP_MAX, TIMESTAMP_MAX));
+  HT_ASSERT(block_stats->excludes(TIMESTAMP_MIN, 200, TIMESTAMP_MAX));
+  HT_ASSERT(!block_stats->excludes(TIMESTAMP_MIN, TIMESTAMP_MAX, 1200));
+  HT_ASSERT(block_stats->excludes(TIMESTAMP_MIN, TIMESTAMP_MAX, 1199));
+
+  // Block 6 also holds a delete, which is left out of the bounds but keeps
+  // the block from ever being excluded
+  block_stats = index.block_stats(6 * BLOCK_SIZE);
+  HT_ASSERT(block_stats->has_deletes);
+  HT_ASSERT(block_stats->timestamp_max == 600 + KEYS_PER_BLOCK - 1);
+  HT_ASSERT(block_stats->revision_min == 1600);
+  HT_ASSERT(!block_stats->excludes(TIMESTAMP_MIN, 200, TIMESTAMP_MAX));
+  HT_ASSERT(!block_stats->excludes(TIMESTAMP_MIN, TIMESTAMP_MAX, 1000));
+
+  // Stats follow their blocks when the index is rescoped
+  index.rescope("row-02", "row-05");
+  HT_ASSERT(index.block_stats(2 * BLOCK_SIZE) == 0);
+  for (int i=3; i<=5; i++) {
+    block_stats = index.block_stats(i * BLOCK_SIZE);
+    HT_ASSERT(block_stats);
+    HT_ASSERT(block_stats->timestamp_min == 100*i);
+    HT_ASSERT(block_stats->revision_max == 1000 + 100*i + KEYS_PER_BLOCK - 1);
+  }
+
+  // Without stats (e.g. older CellStores) no block can be excluded
+  {
+    DynamicBuffer fixed2, variable2, stats2;
+    CellStoreBlockIndexArray<uint32_t> index2;
+    build_index(fixed2, variable2, stats2);
+    index2.load(fixed2, variable2, NUM_BLOCKS * BLOCK_SIZE);
+    HT_ASSERT(index2.index_entries() == NUM_BLOCKS);
+    HT_ASSERT(index2.block_stats(0) == 0);
+  }
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Error.h"
+#include "Common/FileUtils.h"
+#include "Common/Logger.h"
+
+#include <cstdio>
+#include <cstring>
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include "../CellStoreMapping.h"
+
+using namespace Hypertable;
+
+namespace {
+  const char *data = "0123456789abcdefghijklmnopqrstuvwxyz";
+}
+
+
+int main(int argc, char **argv) {
+  char dir[] = "/tmp/cellstore_mapping_test.XXXXXX";
+  HT_ASSERT(mkdtemp(dir));
+  String root = dir;
+  String fname = "/tables/1/default/AB2A0D28DE6B77FFDD6C72AF/cs0";
+
+  HT_ASSERT(CellStoreMapping::local_path(root, fname) == root + fname);
+  HT_ASSERT(CellStoreMapping::local_path(root, "cs0") == root + "/cs0");
+
+  String path = CellStoreMapping::local_path(root, "cs0");
+  String contents = data;
+  HT_ASSERT(FileUtils::write(path, contents) == (ssize_t)contents.length());
+
+  {
+    CellStoreMappingPtr mapping = new CellStoreMapping(path, strlen(data));
+    HT_ASSERT(mapping->length() == (int64_t)strlen(data));
+    HT_ASSERT(!memcmp(mapping->base(), data, strlen(data)));
+    HT_ASSERT(mapping->contains(0, strlen(data)));
+    HT_ASSERT(mapping->contains(10, 26));
+    HT_ASSERT(!mapping->contains(10, 27));
+    HT_ASSERT(!mapping->contains(-1, 1));
+
+    // The mapping stays readable after the file is removed
+    HT_ASSERT(FileUtils::unlink(path));
+    HT_ASSERT(!memcmp(mapping->base() + 10, "abcdef", 6));
+  }
+
+  // Missing files and files shorter than expected can't be mapped
+  try {
+    CellStoreMapping mapping(path, strlen(data));
+    HT_ASSERT(!"missing file mapped");
+  }
+  catch (Exception &e) {
+    HT_ASSERT(e.code() == Error::LOCAL_IO_ERROR);
+  }
+
+  contents = contents.substr(0, 10);
+  HT_ASSERT(FileUtils::write(path, contents) == 10);
+  try {
+    CellStoreMapping mapping(path, strlen(data));
+    HT_ASSERT(!"short file mapped");
+  }
+  catch (Exception &e) {
+    HT_ASSERT(e.code() == Error::LOCAL_IO_ERROR);
+  }
+
+  FileUtils::unlink(path);
+  rmdir(dir);
+  return 0;
+}
@@ -38,7 +38,7 @@
 #include "Hypertable/Lib/Schema.h"
 #include "Hypertable/Lib/SerializedKey.h"
 
-#include "../CellStoreV6.h"
+#include "../CellStoreV7.h"
 #include "../Global.h"
 
 #include <cstdlib>
@@ -539,7 +539,7 @@ int main(int argc, char **argv) {
     PropertiesPtr cs_props = new Properties();
     // make sure blocks are small so only one key value pair fits in a block
     cs_props->set("blocksize", uint32_t(32));
-    cs = new CellStoreV6(Global::dfs.get(), schema.get());
+    cs = new CellStoreV7(Global::dfs.get(), schema.get());
     HT_TRY("creating cellstore", cs->create(csname.c_str(), 24000, cs_props, &table_id));
 
     DynamicBuffer dbuf(512000);
@@ -896,6 +896,31 @@ int main(int argc, char **argv) {
     scanner = cs->create_scanner(scan_ctx);
     display_scan(scanner, out);
 
+    /**
+     * The merge scanner applies deletes whatever their timestamp, so blocks
+     * holding them must not be skipped by the scan's time interval
+     */
+    out << "[delete-large-time-interval]\n";
+    ssbuilder.clear();
+    row = delete_large;
+    column = (String)"tag:" + qualifier;
+    ssbuilder.add_cell(row.c_str(), column.c_str());
+    ssbuilder.set_time_interval(1, 100);
+    scan_ctx = new ScanContext(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                               schema);
+    scanner = cs->create_scanner(scan_ctx);
+    display_scan(scanner, out);
+
+    out << "[delete-cell-version-time-interval]\n";
+    ssbuilder.clear();
+    ssbuilder.add_row_interval(delete_cell_version.c_str(), true,
+                               delete_cf.c_str(), true);
+    ssbuilder.set_time_interval(1, 100);
+    scan_ctx = new ScanContext(TIMESTAMP_MAX, &(ssbuilder.get()), &range,
+                               schema);
+    scanner = cs->create_scanner(scan_ctx);
+    display_scan(scanner, out);
+
     int64_t delete_count = boost::any_cast<int64_t>(cs->get_trailer()->get("delete_count"));
     out << "trailer.delete_count= " << delete_count << "\n";
     if (delete_count != num_deletes) {
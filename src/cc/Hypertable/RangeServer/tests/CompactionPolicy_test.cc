@@ -0,0 +1,235 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Logger.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "../CompactionPolicyLeveled.h"
+#include "../CompactionPolicyRunLength.h"
+#include "../CompactionPolicyTiered.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  typedef CompactionPolicy::StoreInfo StoreInfo;
+
+  const int64_t MB = 1024LL * 1024LL;
+  const int64_t SECOND = 1000000000LL;
+
+  /** Results of running a policy against a stream of flushes. */
+  struct Simulation {
+    Simulation() : ingested(0), written(0), max_stores(0) { }
+    double write_amplification() { return (double)written / (double)ingested; }
+    std::vector<StoreInfo> stores;
+    int64_t ingested;
+    int64_t written;
+    size_t max_stores;
+  };
+
+  /**
+   * Adds <code>flushes</code> CellStores of <code>flush_size</code> bytes,
+   * one per second, and performs the merges chosen by
+   * <code>policy</code> after each one, the way AccessGroup does.
+   */
+  void simulate(CompactionPolicy &policy, int flushes, int64_t flush_size,
+                Simulation &sim) {
+    size_t index, length;
+    for (int i=0; i<flushes; i++) {
+      int64_t now = (int64_t)(i+1) * SECOND;
+      sim.stores.push_back(StoreInfo(flush_size, now));
+      sim.ingested += flush_size;
+      sim.written += flush_size;
+      while (policy.find_merge_run(sim.stores, now, &index, &length)) {
+        HT_ASSERT(length > 1 && index + length <= sim.stores.size());
+        StoreInfo merged(0, 0);
+        for (size_t j=index; j<index+length; j++) {
+          merged.disk_usage += sim.stores[j].disk_usage;
+          if (sim.stores[j].timestamp_max > merged.timestamp_max)
+            merged.timestamp_max = sim.stores[j].timestamp_max;
+        }
+        sim.written += merged.disk_usage;
+        sim.stores.erase(sim.stores.begin() + index,
+                         sim.stores.begin() + index + length);
+        sim.stores.insert(sim.stores.begin() + index, merged);
+      }
+      if (sim.stores.size() > sim.max_stores)
+        sim.max_stores = sim.stores.size();
+    }
+  }
+
+  void test_run_length() {
+    CompactionPolicyRunLength policy(10*MB, 40*MB, 3);
+    std::vector<StoreInfo> stores;
+    size_t index, length;
+
+    HT_ASSERT(!policy.find_merge_run(stores, 0, &index, &length));
+
+    // Three small stores reaching the target size form a run
+    stores.push_back(StoreInfo(50*MB));
+    stores.push_back(StoreInfo(4*MB));
+    stores.push_back(StoreInfo(4*MB));
+    HT_ASSERT(!policy.find_merge_run(stores, 0, &index, &length));
+    stores.push_back(StoreInfo(4*MB));
+    HT_ASSERT(policy.find_merge_run(stores, 0, &index, &length));
+    HT_ASSERT(index == 1 && length == 3);
+
+    // A long trailing run of tiny stores is merged regardless of size
+    stores.clear();
+    for (int i=0; i<4; i++)
+      stores.push_back(StoreInfo(1*MB));
+    HT_ASSERT(policy.find_merge_run(stores, 0, &index, &length));
+    HT_ASSERT(index == 0 && length == 4);
+  }
+
+  void test_leveled() {
+    CompactionPolicyLeveled policy(10*MB, 10, 4);
+
+    HT_ASSERT(policy.level(1*MB) == 0);
+    HT_ASSERT(policy.level(10*MB) == 1);
+    HT_ASSERT(policy.level(99*MB) == 1);
+    HT_ASSERT(policy.level(100*MB) == 2);
+    HT_ASSERT(policy.level(1000*MB) == 3);
+
+    std::vector<StoreInfo> stores;
+    size_t index, length;
+
+    // Newer data that reaches the level of an older store is merged into it
+    stores.push_back(StoreInfo(150*MB));
+    stores.push_back(StoreInfo(40*MB));
+    stores.push_back(StoreInfo(5*MB));
+    HT_ASSERT(!policy.find_merge_run(stores, 0, &index, &length));
+    stores.push_back(StoreInfo(6*MB));
+    HT_ASSERT(policy.find_merge_run(stores, 0, &index, &length));
+    HT_ASSERT(index == 1 && length == 3);
+
+    // After a steady stream of flushes, levels decrease from oldest to newest
+    Simulation sim;
+    simulate(policy, 1000, 2*MB, sim);
+    for (size_t i=1; i<sim.stores.size(); i++) {
+      int32_t older = policy.level(sim.stores[i-1].disk_usage);
+      int32_t newer = policy.level(sim.stores[i].disk_usage);
+      HT_ASSERT(newer < older || newer == 0);
+    }
+    HT_ASSERT(sim.max_stores <= 8);
+    cout << "leveled: stores=" << sim.stores.size() << " max_stores="
+         << sim.max_stores << " write_amplification="
+         << sim.write_amplification() << endl;
+  }
+
+  void test_tiered() {
+    CompactionPolicyTiered policy(10*MB, 4, 32, 50, 0);
+    std::vector<StoreInfo> stores;
+    size_t index, length;
+
+    // Three similar stores aren't enough, a fourth one makes a tier
+    stores.push_back(StoreInfo(400*MB));
+    stores.push_back(StoreInfo(100*MB));
+    stores.push_back(StoreInfo(110*MB));
+    stores.push_back(StoreInfo(90*MB));
+    HT_ASSERT(!policy.find_merge_run(stores, 0, &index, &length));
+    stores.push_back(StoreInfo(105*MB));
+    HT_ASSERT(policy.find_merge_run(stores, 0, &index, &length));
+    HT_ASSERT(index == 1 && length == 4);
+
+    // The tier with the smallest stores is merged first
+    for (int i=0; i<5; i++)
+      stores.push_back(StoreInfo(1*MB));
+    HT_ASSERT(policy.find_merge_run(stores, 0, &index, &length));
+    HT_ASSERT(index == 5 && length == 5);
+
+    // Stores older than the maximum age are left alone
+    CompactionPolicyTiered aged(10*MB, 4, 32, 50, 10*SECOND);
+    stores.clear();
+    for (int i=0; i<4; i++)
+      stores.push_back(StoreInfo(1*MB, (int64_t)i * SECOND));
+    HT_ASSERT(aged.find_merge_run(stores, 5*SECOND, &index, &length));
+    HT_ASSERT(!aged.find_merge_run(stores, 12*SECOND, &index, &length));
+
+    // Size-tiered rewrites data less often than leveled
+    CompactionPolicyLeveled leveled(10*MB, 10, 4);
+    Simulation tiered_sim, leveled_sim;
+    simulate(policy, 1000, 2*MB, tiered_sim);
+    simulate(leveled, 1000, 2*MB, leveled_sim);
+    cout << "tiered: stores=" << tiered_sim.stores.size() << " max_stores="
+         << tiered_sim.max_stores << " write_amplification="
+         << tiered_sim.write_amplification() << endl;
+    HT_ASSERT(tiered_sim.write_amplification() <
+              leveled_sim.write_amplification());
+  }
+
+  /**
+   * A shard set left by a sharded compaction is never merged back together
+   * on its own, but is merged as a whole along with other CellStores.
+   */
+  void test_shard_set() {
+    CompactionPolicyRunLength run_length(10*MB, 40*MB, 3);
+    CompactionPolicyLeveled leveled(10*MB, 10, 4);
+    CompactionPolicyTiered tiered(10*MB, 4, 32, 50, 0);
+    CompactionPolicy *policies[] = { &run_length, &leveled, &tiered, 0 };
+    std::vector<StoreInfo> stores;
+    size_t index, length;
+
+    for (int i=0; policies[i]; i++) {
+      CompactionPolicy &policy = *policies[i];
+
+      // Shards of similar size would look like a run to merge
+      stores.clear();
+      for (int j=0; j<4; j++)
+        stores.push_back(StoreInfo(2*MB, SECOND, true));
+      HT_ASSERT(policy.find_merge_run(stores, 0, &index, &length));
+      HT_ASSERT(!policy.choose_merge_run(stores, 0, &index, &length));
+
+      // Newer CellStores are merged with the whole shard set or not at all
+      for (int j=0; j<4; j++)
+        stores.push_back(StoreInfo(2*MB, 2*SECOND));
+      HT_ASSERT(policy.choose_merge_run(stores, 0, &index, &length));
+      HT_ASSERT(index + length == stores.size());
+      HT_ASSERT(index == 0 || index >= 4);
+    }
+
+    // Without shards choose_merge_run() agrees with find_merge_run()
+    stores.clear();
+    stores.push_back(StoreInfo(50*MB));
+    for (int j=0; j<3; j++)
+      stores.push_back(StoreInfo(4*MB));
+    size_t chosen_index, chosen_length;
+    HT_ASSERT(run_length.find_merge_run(stores, 0, &index, &length));
+    HT_ASSERT(run_length.choose_merge_run(stores, 0, &chosen_index,
+                                          &chosen_length));
+    HT_ASSERT(index == chosen_index && length == chosen_length);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  test_run_length();
+  test_leveled();
+  test_tiered();
+  test_shard_set();
+  return 0;
+}
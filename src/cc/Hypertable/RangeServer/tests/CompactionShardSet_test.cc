@@ -0,0 +1,88 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Logger.h"
+
+#include <cstdio>
+#include <vector>
+
+#include "../CompactionShardSet.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  typedef CellList::SplitRowDataMapT SplitRowDataMapT;
+  typedef CellList::SplitRowDataAlloc SplitRowDataAlloc;
+
+  const char *rows[] = { "a", "b", "c", "d", "e", "f", "g", "h", 0 };
+
+}
+
+
+int main(int argc, char **argv) {
+  StlArena arena(4096);
+  std::vector<String> split_rows;
+
+  // Eight rows of equal weight split into four shards of two rows each
+  {
+    SplitRowDataMapT data = SplitRowDataMapT(LtCstr(), SplitRowDataAlloc(arena));
+    for (int i=0; rows[i]; i++)
+      data[rows[i]] = 100;
+    CompactionShardSet::choose_split_rows(data, 4, split_rows);
+    HT_ASSERT(split_rows.size() == 3);
+    HT_ASSERT(split_rows[0] == "b" && split_rows[1] == "d" &&
+              split_rows[2] == "f");
+
+    // One shard means no split
+    CompactionShardSet::choose_split_rows(data, 1, split_rows);
+    HT_ASSERT(split_rows.empty());
+
+    // More shards than rows, the last row is never a split row
+    CompactionShardSet::choose_split_rows(data, 16, split_rows);
+    HT_ASSERT(split_rows.size() == 7);
+    HT_ASSERT(split_rows.back() == "g");
+  }
+
+  // A single large row takes up several shards worth of cells
+  {
+    SplitRowDataMapT data = SplitRowDataMapT(LtCstr(), SplitRowDataAlloc(arena));
+    for (int i=0; rows[i]; i++)
+      data[rows[i]] = 10;
+    data["b"] = 1000;
+    CompactionShardSet::choose_split_rows(data, 4, split_rows);
+    HT_ASSERT(split_rows.size() == 1);
+    HT_ASSERT(split_rows[0] == "b");
+  }
+
+  // Nothing to split
+  {
+    SplitRowDataMapT data = SplitRowDataMapT(LtCstr(), SplitRowDataAlloc(arena));
+    CompactionShardSet::choose_split_rows(data, 4, split_rows);
+    HT_ASSERT(split_rows.empty());
+    data["a"] = 100;
+    CompactionShardSet::choose_split_rows(data, 4, split_rows);
+    HT_ASSERT(split_rows.empty());
+  }
+
+  return 0;
+}
@@ -66,6 +66,65 @@ namespace {
       return br1.file_id < br2.file_id;
     }
   };
+
+  void access_block(FileBlockCache &cache, int file_id, int64_t offset,
+                    uint32_t length) {
+    uint8_t *block;
+    if (cache.checkout(file_id, offset, &block, &length))
+      cache.checkin(file_id, offset);
+    else {
+      block = new uint8_t [ length ];
+      if (!cache.insert(file_id, offset, block, length))
+        delete [] block;
+    }
+  }
+
+  /**
+   * Fills a sharded cache with a working set that keeps being accessed
+   * while a one-pass scan reads twenty times the cache size.  Under LRU the
+   * scan would push the working set out; with TinyLFU admission it must
+   * survive.
+   */
+  bool test_scan_resistance() {
+    const int64_t block_size = 65536;
+    const int64_t cache_memory = 256 * block_size;
+    const int hot_blocks = 200;
+    FileBlockCache cache(0, cache_memory, false, 8, true);
+
+    for (int pass=0; pass<4; pass++) {
+      for (int i=0; i<hot_blocks; i++)
+        access_block(cache, 1, i*block_size, block_size);
+    }
+
+    for (int i=0; i<20*hot_blocks; i++) {
+      access_block(cache, 2, i*block_size, block_size);
+      access_block(cache, 1, (i%hot_blocks)*block_size, block_size);
+      if (cache.memory_used() > cache.get_limit()) {
+        HT_ERROR("block cache memory use exceeds limit");
+        return false;
+      }
+    }
+
+    int survivors = 0;
+    for (int i=0; i<hot_blocks; i++) {
+      if (cache.contains(1, i*block_size))
+        survivors++;
+    }
+    if (survivors < (hot_blocks * 9) / 10) {
+      HT_ERRORF("only %d of %d hot blocks survived scan", survivors,
+                hot_blocks);
+      return false;
+    }
+
+    int64_t memory_used = cache.memory_used();
+    int64_t freed = cache.decrease_limit(cache_memory);
+    if (cache.get_limit() != 0 || cache.memory_used() != 0 ||
+        freed != memory_used) {
+      HT_ERROR("decrease_limit did not release cached blocks");
+      return false;
+    }
+    return true;
+  }
 }
 
 #define TOTAL_ALLOC_LIMIT 100000000
@@ -176,5 +235,8 @@ int main(int argc, char **argv) {
 
   delete cache;
 
+  if (!test_scan_resistance())
+    return 1;
+
   return 0;
 }
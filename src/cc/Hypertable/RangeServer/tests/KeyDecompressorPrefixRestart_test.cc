@@ -0,0 +1,147 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+#include "Common/Serialization.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Hypertable/Lib/Key.h"
+
+#include "../KeyCompressorPrefix.h"
+#include "../KeyDecompressorPrefixRestart.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  const int NUM_KEYS = 2000;
+  const int RESTART_INTERVAL = 16;
+
+  /**
+   * Builds a block the way CellStoreV7::add() does: the key compressor is
+   * reset every RESTART_INTERVAL pairs and the block ends with the restart
+   * offsets followed by their count.
+   */
+  void build_block(vector<DynamicBuffer *> &keys, DynamicBuffer &block) {
+    KeyCompressorPrefix compressor;
+    vector<uint32_t> restarts;
+    Key key;
+
+    for (size_t i=0; i<keys.size(); i++) {
+      if (i % RESTART_INTERVAL == 0) {
+        compressor.reset();
+        restarts.push_back((uint32_t)block.fill());
+      }
+      key.load(SerializedKey(keys[i]->base));
+      compressor.add(key);
+      block.ensure(compressor.length() + 2);
+      compressor.write(block.ptr);
+      block.ptr += compressor.length();
+      append_as_byte_string(block, "v", 1);
+    }
+
+    block.ensure(4 * (restarts.size() + 1));
+    for (size_t i=0; i<restarts.size(); i++)
+      Serialization::encode_i32(&block.ptr, restarts[i]);
+    Serialization::encode_i32(&block.ptr, (uint32_t)restarts.size());
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  vector<DynamicBuffer *> keys;
+  DynamicBuffer block;
+  char row[32];
+
+  for (int i=0; i<NUM_KEYS; i++) {
+    // rows share long prefixes so that prefix compression kicks in
+    sprintf(row, "row-%08d", i*2);
+    keys.push_back(new DynamicBuffer());
+    create_key_and_append(*keys.back(), FLAG_INSERT, row, 1, "qualifier",
+                          i, i);
+  }
+
+  build_block(keys, block);
+
+  KeyDecompressorPrefixRestart decompressor;
+  const uint8_t *end = decompressor.load_block(block.base, block.ptr);
+  ByteString value;
+  Key key;
+
+  // A linear walk of the block returns every key in order
+  decompressor.reset();
+  value.ptr = decompressor.add(block.base);
+  for (int i=0; i<NUM_KEYS; i++) {
+    decompressor.load(key);
+    HT_ASSERT(key.serial.compare(SerializedKey(keys[i]->base)) == 0);
+    const uint8_t *ptr = value.ptr + value.length();
+    if (i < NUM_KEYS-1) {
+      HT_ASSERT(ptr < end);
+      value.ptr = decompressor.add(ptr);
+    }
+    else
+      HT_ASSERT(ptr == end);
+  }
+
+  /*
+   * Seeking to both present and absent keys lands no more than
+   * RESTART_INTERVAL keys before the first key that is >= the target
+   */
+  for (int target=-1; target<2*NUM_KEYS+1; target++) {
+    DynamicBuffer target_key;
+    sprintf(row, "row-%08d", target < 0 ? 0 : target);
+    create_key_and_append(target_key, FLAG_INSERT, target < 0 ? "" : row,
+                          1, "qualifier", TIMESTAMP_MAX, TIMESTAMP_MAX);
+    SerializedKey serkey(target_key.base);
+    int expected = target < 0 ? 0 : (target+1) / 2;
+    int steps = 0;
+
+    value.ptr = decompressor.seek(block.base, serkey);
+    while (decompressor.less_than(serkey)) {
+      const uint8_t *ptr = value.ptr + value.length();
+      if (ptr >= end)
+        break;
+      value.ptr = decompressor.add(ptr);
+      steps++;
+    }
+    HT_ASSERT(steps <= RESTART_INTERVAL);
+
+    if (expected < NUM_KEYS) {
+      decompressor.load(key);
+      HT_ASSERT(key.serial.compare(SerializedKey(keys[expected]->base)) == 0);
+    }
+    else
+      HT_ASSERT(decompressor.less_than(serkey));
+  }
+
+  for (size_t i=0; i<keys.size(); i++)
+    delete keys[i];
+
+  return 0;
+}
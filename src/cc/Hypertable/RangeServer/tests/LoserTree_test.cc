@@ -0,0 +1,142 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include "Common/Compat.h"
+#include "Common/DynamicBuffer.h"
+#include "Common/Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "Hypertable/Lib/Key.h"
+
+#include "../LoserTree.h"
+
+using namespace Hypertable;
+using namespace std;
+
+namespace {
+
+  /**
+   * Scanner over a sorted list of serialized keys
+   */
+  class VectorScanner : public CellListScanner {
+  public:
+    VectorScanner() : m_next(0) { }
+    virtual void forward() { m_next++; }
+    virtual bool get(Key &key, ByteString &value) {
+      if (m_next >= m_keys.size())
+        return false;
+      key.load(SerializedKey(m_keys[m_next]));
+      value.ptr = 0;
+      return true;
+    }
+    virtual uint64_t get_disk_read() { return 0; }
+    vector<const uint8_t *> m_keys;
+    size_t m_next;
+  };
+
+  bool key_less(const uint8_t *a, const uint8_t *b) {
+    return SerializedKey(a) < SerializedKey(b);
+  }
+
+  void test_merge(vector<DynamicBuffer *> &keys, size_t num_scanners,
+                  bool runs) {
+    vector<VectorScanner *> scanners;
+    for (size_t i=0; i<num_scanners; i++)
+      scanners.push_back(new VectorScanner());
+
+    // either scatter keys randomly or hand out long runs to exercise the
+    // path that keeps draining the current winner
+    for (size_t i=0; i<keys.size(); i++) {
+      size_t which = runs ? (i / 97) % num_scanners : random() % num_scanners;
+      scanners[which]->m_keys.push_back(keys[i]->base);
+    }
+
+    vector<const uint8_t *> expected;
+    for (size_t i=0; i<num_scanners; i++) {
+      sort(scanners[i]->m_keys.begin(), scanners[i]->m_keys.end(), key_less);
+      expected.insert(expected.end(), scanners[i]->m_keys.begin(),
+                      scanners[i]->m_keys.end());
+    }
+    sort(expected.begin(), expected.end(), key_less);
+
+    LoserTree tree;
+    LoserTree::Entry entry;
+    for (size_t i=0; i<num_scanners; i++) {
+      if (scanners[i]->get(entry.key, entry.value)) {
+        entry.scanner = scanners[i];
+        tree.add(entry);
+      }
+    }
+    tree.build();
+
+    size_t count = 0;
+    while (!tree.empty()) {
+      HT_ASSERT(count < expected.size());
+      HT_ASSERT(tree.top().key.serial == SerializedKey(expected[count]));
+      tree.forward_top();
+      count++;
+    }
+    HT_ASSERT(count == expected.size());
+
+    for (size_t i=0; i<num_scanners; i++)
+      delete scanners[i];
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+  vector<DynamicBuffer *> keys;
+  char row[32];
+
+  srandom(1);
+
+  // short and long rows, so that some keys are too short for the cached
+  // prefix, plus duplicate rows that only differ in timestamp
+  for (int i=0; i<5000; i++) {
+    int r = random() % 3000;
+    if (r % 3 == 0)
+      sprintf(row, "%d", r);
+    else
+      sprintf(row, "row%012d", r);
+    DynamicBuffer *buf = new DynamicBuffer();
+    create_key_and_append(*buf, FLAG_INSERT, row, 1 + (i % 3), "qual",
+                          random() % 1000, i + 1);
+    keys.push_back(buf);
+  }
+
+  size_t counts[] = { 1, 2, 3, 5, 8, 13, 64 };
+  for (size_t i=0; i<sizeof(counts)/sizeof(size_t); i++) {
+    test_merge(keys, counts[i], false);
+    test_merge(keys, counts[i], true);
+  }
+
+  for (size_t i=0; i<keys.size(); i++)
+    delete keys[i];
+
+  return 0;
+}
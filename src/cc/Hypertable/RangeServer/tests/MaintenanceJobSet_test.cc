@@ -0,0 +1,170 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+
+#include "Common/Compat.h"
+#include "Common/Logger.h"
+
+#include <poll.h>
+
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+#include "../Global.h"
+#include "../MaintenanceJobSet.h"
+#include "../MaintenanceQueue.h"
+
+using namespace Hypertable;
+
+namespace {
+
+  /** Job set that counts how often each job runs and which threads ran
+   * them, optionally failing one of the jobs.
+   */
+  class TestJobSet : public MaintenanceJobSet {
+  public:
+    enum { NONE, EXCEPTION, STD_EXCEPTION, UNKNOWN };
+
+    TestJobSet(size_t count, int delay_ms=0, size_t failing_job=0,
+               int failure=NONE)
+      : m_runs(count, 0), m_delay_ms(delay_ms), m_failing_job(failing_job),
+        m_failure(failure) { }
+
+    std::vector<int> m_runs;
+    std::set<boost::thread::id> m_threads;
+
+  protected:
+    virtual size_t job_count() const { return m_runs.size(); }
+
+    virtual void run_job(size_t i) {
+      {
+        ScopedLock lock(m_mutex);
+        m_runs[i]++;
+        m_threads.insert(boost::this_thread::get_id());
+      }
+      if (m_delay_ms)
+        poll(0, 0, m_delay_ms);
+      if (i == m_failing_job) {
+        if (m_failure == EXCEPTION)
+          HT_THROW(Error::RANGESERVER_ROW_OVERFLOW, "job failed");
+        else if (m_failure == STD_EXCEPTION)
+          throw std::runtime_error("job failed");
+        else if (m_failure == UNKNOWN)
+          throw 42;
+      }
+    }
+
+  private:
+    Mutex m_mutex;
+    int m_delay_ms;
+    size_t m_failing_job;
+    int m_failure;
+  };
+
+  typedef intrusive_ptr<TestJobSet> TestJobSetPtr;
+
+  /** Runs a job set whose second job fails and checks the error reported
+   * and that no job was left waiting for.
+   */
+  void test_failure(int failure, int expected_error) {
+    TestJobSetPtr job_set = new TestJobSet(4, 0, 1, failure);
+    int error = Error::OK;
+    try {
+      job_set->run();
+    }
+    catch (Exception &e) {
+      error = e.code();
+    }
+    HT_ASSERT(error == expected_error);
+    // jobs not yet started when the job failed are skipped
+    HT_ASSERT(job_set->m_runs[0] == 1 && job_set->m_runs[1] == 1);
+    HT_ASSERT(job_set->m_runs[2] == 0 && job_set->m_runs[3] == 0);
+  }
+
+}
+
+
+int main(int argc, char **argv) {
+
+  // Without a maintenance queue the calling thread runs every job
+  {
+    TestJobSetPtr job_set = new TestJobSet(8);
+    job_set->run();
+    for (size_t i=0; i<8; i++)
+      HT_ASSERT(job_set->m_runs[i] == 1);
+    HT_ASSERT(job_set->m_threads.size() == 1);
+  }
+
+  // Errors of any kind are reported by run() instead of hanging it
+  test_failure(TestJobSet::EXCEPTION, Error::RANGESERVER_ROW_OVERFLOW);
+  test_failure(TestJobSet::STD_EXCEPTION, Error::EXTERNAL);
+  test_failure(TestJobSet::UNKNOWN, Error::EXTERNAL);
+
+  Global::maintenance_queue = new MaintenanceQueue(4);
+
+  // Helper tasks pick up jobs the calling thread hasn't started
+  {
+    Global::access_group_compaction_concurrency = 2;
+    TestJobSetPtr job_set = new TestJobSet(12, 20);
+    job_set->run();
+    for (size_t i=0; i<12; i++)
+      HT_ASSERT(job_set->m_runs[i] == 1);
+    HT_ASSERT(job_set->m_threads.size() > 1);
+    HT_ASSERT(job_set->m_threads.size() <= 3);
+  }
+
+  // With no helpers allowed, the calling thread runs every job
+  {
+    Global::access_group_compaction_concurrency = 0;
+    TestJobSetPtr job_set = new TestJobSet(4, 5);
+    job_set->run();
+    for (size_t i=0; i<4; i++)
+      HT_ASSERT(job_set->m_runs[i] == 1);
+    HT_ASSERT(job_set->m_threads.size() == 1);
+  }
+
+  // A failure in a helper is reported to the caller
+  {
+    Global::access_group_compaction_concurrency = 2;
+    for (size_t failing=0; failing<6; failing++) {
+      TestJobSetPtr job_set =
+        new TestJobSet(6, 10, failing, TestJobSet::STD_EXCEPTION);
+      int error = Error::OK;
+      try {
+        job_set->run();
+      }
+      catch (Exception &e) {
+        error = e.code();
+      }
+      HT_ASSERT(error == Error::EXTERNAL);
+      HT_ASSERT(job_set->m_runs[failing] == 1);
+    }
+  }
+
+  Global::maintenance_queue->shutdown();
+  Global::maintenance_queue->join();
+  Global::maintenance_queue = 0;
+
+  return 0;
+}
@@ -0,0 +1,89 @@
+/** -*- c++ -*-
+ * Copyright (C) 2007-2013 Hypertable, Inc.
+ *
+ * This file is part of Hypertable.
+ *
+ * Hypertable is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; version 3 of the
+ * License, or any later version.
+ *
+ * Hypertable is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include "Common/Compat.h"
+#include "Common/Logger.h"
+
+#include <vector>
+
+#include "../MaintenanceThrottle.h"
+
+using namespace Hypertable;
+
+namespace {
+  typedef MaintenanceThrottle::TaskStats TaskStats;
+  const int64_t MB = 1024LL * 1024LL;
+}
+
+
+int main(int argc, char **argv) {
+  MaintenanceThrottle throttle(4*MB, 1*MB, 1*MB);
+  std::vector<TaskStats> stats;
+
+  // I/O outside of a maintenance task (e.g. foreground scans) isn't charged
+  MaintenanceThrottle::read(10*MB);
+  throttle.get_stats(stats);
+  HT_ASSERT(stats.size() == MaintenanceThrottle::TASK_COUNT);
+  for (size_t i=0; i<stats.size(); i++)
+    HT_ASSERT(stats[i].read_bytes == 0 && stats[i].write_bytes == 0);
+
+  {
+    MaintenanceThrottle::Scope scope(&throttle,
+                                     MaintenanceThrottle::MAJOR_COMPACTION);
+    MaintenanceThrottle::read(1*MB);
+    MaintenanceThrottle::write(1*MB);
+    {
+      // minor compactions take tokens but are never delayed
+      MaintenanceThrottle::Scope inner(&throttle,
+          MaintenanceThrottle::MINOR_COMPACTION, false);
+      MaintenanceThrottle::write(2*MB);
+    }
+    // the major compaction is behind the minor one's 2MB
+    MaintenanceThrottle::write(1*MB);
+  }
+  MaintenanceThrottle::write(1*MB);
+
+  throttle.get_stats(stats);
+  const TaskStats &major = stats[MaintenanceThrottle::MAJOR_COMPACTION];
+  const TaskStats &minor = stats[MaintenanceThrottle::MINOR_COMPACTION];
+  HT_ASSERT(major.read_bytes == (uint64_t)1*MB);
+  HT_ASSERT(major.write_bytes == (uint64_t)2*MB);
+  HT_ASSERT(major.throttled_micros > 500000);
+  HT_ASSERT(minor.write_bytes == (uint64_t)2*MB);
+  HT_ASSERT(minor.throttled_micros == 0);
+
+  // stats are reset by get_stats()
+  throttle.get_stats(stats);
+  HT_ASSERT(stats[MaintenanceThrottle::MAJOR_COMPACTION].write_bytes == 0);
+
+  // the rate yields to foreground scans down to the minimum
+  throttle.adjust(1*MB);
+  HT_ASSERT(throttle.get_rate() == 3*MB);
+  throttle.adjust(100*MB);
+  HT_ASSERT(throttle.get_rate() == 1*MB);
+
+  // an unlimited throttle stays unlimited
+  MaintenanceThrottle unlimited(0, 1*MB, 1*MB);
+  unlimited.adjust(100*MB);
+  HT_ASSERT(unlimited.get_rate() == 0);
+
+  return 0;
+}
@@ -29,6 +29,14 @@ import org.hypertable.Common.HypertableException;
 
 public class CommHeader {
 
+    /** Highest protocol version understood.  Version 2 headers are
+     * checksummed with CRC-32C, version 1 headers with fletcher32 */
+    public static final byte PROTOCOL_VERSION = 2;
+
+    /** Protocol version of new request headers.  Servers that predate
+     * version 2 reject CRC-32C checksummed headers, so this stays at 1
+     * until every server has been upgraded.  Responses use the version of
+     * the request they answer. */
     public static byte VERSION = 1;
 
     public static byte FIXED_LENGTH = 38;
@@ -86,7 +94,8 @@ public class CommHeader {
         byte [] header_buffer = new byte [ header_length ];
         buf.position(saved_position);
         buf.get(header_buffer, 0, header_length);
-        header_checksum = Checksum.fletcher32(header_buffer, 0, header_length);
+        header_checksum = Checksum.compute(checksum_type(), header_buffer, 0,
+                                           header_length);
         buf.position(checksum_position);
         buf.putInt(header_checksum);
         buf.position(saved_position + header_length);
@@ -114,8 +123,9 @@ public class CommHeader {
         byte [] header_buffer = new byte [ header_length ];
         buf.position(saved_position);
         buf.get(header_buffer, 0, header_length);
-        int computed_checksum = Checksum.fletcher32(header_buffer, 0,
-                                                    header_length);
+        int computed_checksum = Checksum.compute(checksum_type(),
+                                                 header_buffer, 0,
+                                                 header_length);
         if (computed_checksum != header_checksum)
             throw new HypertableException(Error.COMM_HEADER_CHECKSUM_MISMATCH);
         buf.position(saved_position + header_length);
@@ -123,7 +133,12 @@ public class CommHeader {
 
     public void set_total_length(int len) { total_len = len; }
 
+    public int checksum_type() {
+        return version >= 2 ? Checksum.CRC32C : Checksum.FLETCHER32;
+    }
+
     public void initialize_from_request_header(CommHeader req_header) {
+      version = req_header.version;
       flags = req_header.flags;
       id = req_header.id;
       gid = req_header.gid;
@@ -25,6 +25,33 @@ import java.io.IOException;
 
 public class Checksum {
 
+    public static final int FLETCHER32 = 0;
+    public static final int CRC32C = 1;
+
+    private static final int [] crc32c_table = new int [256];
+
+    static {
+        for (int n = 0; n < 256; n++) {
+            int crc = n;
+            for (int k = 0; k < 8; k++)
+                crc = ((crc & 1) != 0) ? (crc >>> 1) ^ 0x82f63b78 : crc >>> 1;
+            crc32c_table[n] = crc;
+        }
+    }
+
+    public static int compute(int type, byte [] data, int offset, int len) {
+        if (type == CRC32C)
+            return crc32c(data, offset, len);
+        return fletcher32(data, offset, len);
+    }
+
+    public static int crc32c(byte [] data, int offset, int len) {
+        int crc = 0xffffffff;
+        for (int i = offset; i < offset + len; i++)
+            crc = crc32c_table[(crc ^ data[i]) & 0xff] ^ (crc >>> 8);
+        return ~crc;
+    }
+
     public static int fletcher32(byte [] data, int offset, int len) {
 
         /* data may not be aligned properly and would segfault on
@@ -80,6 +107,7 @@ public class Checksum {
         "Supported Algorithms:",
         "",
         "  fletcher32",
+        "  crc32c",
         "",
         null
     };
@@ -95,6 +123,11 @@ public class Checksum {
             int checksum = fletcher32(data, 0, data.length);
             java.lang.System.out.println(checksum);
         }
+        else if (args[0].equals("crc32c")) {
+            byte [] data = FileUtils.FileToBuffer( new File(args[1]) );
+            int checksum = crc32c(data, 0, data.length);
+            java.lang.System.out.println(checksum);
+        }
         else
             Usage.DumpAndExit(usage);
     }
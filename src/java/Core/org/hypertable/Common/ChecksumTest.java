@@ -68,6 +68,14 @@ public class ChecksumTest {
             data[28] = 4;
             assertTrue(Checksum.fletcher32(data, 0, 36) == -630191864);
 
+            // test 3 (RFC 3720, appendix B.4)
+            byte [] check = "123456789".getBytes("US-ASCII");
+            assertTrue(Checksum.crc32c(check, 0, 9) == 0xe3069283);
+            Arrays.fill(data, 0, 32, (byte)0);
+            assertTrue(Checksum.crc32c(data, 0, 32) == 0x8a9136aa);
+            Arrays.fill(data, 0, 32, (byte)0xff);
+            assertTrue(Checksum.crc32c(data, 0, 32) == 0x62a8ab43);
+
         }
         catch (Exception e) {
             e.printStackTrace();